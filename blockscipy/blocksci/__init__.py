@@ -16,6 +16,7 @@ import copy
 import io
 import re
 import heapq
+import warnings
 import operator
 import time
 from functools import reduce
@@ -32,6 +33,7 @@ from .currency import *
 from .blockchain_info import *
 from .opreturn import label_application
 from .pickler import *
+from .export import export_table
 
 VERSION = "0.7.0"
 CPU_COUNT = 64
@@ -243,41 +245,22 @@ def filter_txes_legacy(
         self, map_func, reduce_func, MISSING_PARAM, start, end, cpu_count
     )
 
-def get_spliterator(keys, workers):
-    split = len(keys) // workers
-    return [((i - 1) * split, i * split) for i in range(1, workers + 1)] + [(workers * split, workers * split + len(keys) % split)]
-
-
-
-def map_spliterator(self, map_func, keys, data_directory, workers, **kwargs):
+def map_spliterator(self, map_func, keys, data_directory=None, workers=None, **kwargs):
     """
-    Create a pool for map function on keys and events
-    @param map_func: a function that takes one argument (start, stop)
-    @param keys: what to iterate over
-    @param events: what to keep as a global state for the workers
-    @param workers: (64) how many workers (dies on Aura for > 70)
+    Call map_func(tx, **kwargs) on the transactions with the given hashes, skipping hashes that are not in the chain
+    @param map_func: a function that takes a transaction
+    @param keys: the transaction hashes
+    @param data_directory: unused, kept for compatibility
+    @param workers: unused, kept for compatibility
+
+    Returns a list holding the list of results. Deprecated: use txes_with_hashes, which resolves the hashes in
+    parallel without starting worker processes, and apply a query to the returned range.
     """
-    
-    def basic_map_func(iterator_range):
-        start, stop = iterator_range
-        chain = Blockchain(data_directory)
-        results = []
-        for i in range(start, stop):
-            current = keys[i]
-            try:
-                tx = chain.tx_with_hash(current)
-            except Exception:
-                continue
-            
-            results.append(map_func(tx, **kwargs))
-
-        return results
-
-    with Pool(workers) as pool:  # Adjust number of processes according to your system
-        all_results_future = pool.map_async(basic_map_func, get_spliterator(keys, workers))
-        print("the tasks are planned...")
-        all_results = all_results_future.get()
-    return all_results
+    warnings.warn(
+        "map_spliterator is deprecated, use chain.txes_with_hashes(keys).apply(...) instead",
+        DeprecationWarning,
+    )
+    return [[map_func(tx, **kwargs) for tx in self.txes_with_hashes(keys)]]
 
 
 Blockchain.map_blocks = map_blocks
@@ -350,17 +333,32 @@ def new_init(self, loc, max_block=0):
 
 
 def most_valuable_addresses(self, nlargest=100):
-    current_address_vals = self.blocks.outputs.where(lambda o: ~o.is_spent) \
-    .group_by( \
+    # Grouping through the proxy of the block range runs on all cores
+    unspent_outputs = self.blocks._self_proxy.outputs.where(lambda o: ~o.is_spent)
+    current_address_vals = unspent_outputs.group_by( \
         lambda output: output.address, \
         lambda outputs: outputs.value.sum \
-    )
+    )(self.blocks)
     return heapq.nlargest(nlargest, current_address_vals.items(), key=operator.itemgetter(1))
 
+def address_balances_chunked(self, address_nums, address_types, heights=(-1,), chunk_size=100000):
+    """
+    Calculate the balances of a large set of addresses chunk by chunk. Yields tuples of the
+    offset of the chunk in address_nums and the balance matrix of the chunk as returned by
+    address_balances.
+    """
+    for start in range(0, len(address_nums), chunk_size):
+        stop = start + chunk_size
+        yield start, self.address_balances(
+            address_nums[start:stop], address_types[start:stop], list(heights)
+        )
+
 Blockchain.__init__ = new_init
 Blockchain.range = block_range
 Blockchain.heights_to_dates = heights_to_dates
 Blockchain.most_valuable_addresses = most_valuable_addresses
+Blockchain.address_balances_chunked = address_balances_chunked
+Blockchain.export_table = export_table
 
 def traverse(proxy_func, val):
     return _traverse(proxy_func(val._self_proxy), val)
@@ -410,9 +408,16 @@ def setup_sequence_map_funcs():
         p = func(r._self_proxy.nested_proxy)
         return r._self_proxy._all(p)(r)
 
+    def range_apply_func(r, func):
+        nested_proxy = r._self_proxy.nested_proxy
+        p = func if hasattr(func, 'ptype') else func(nested_proxy)
+        return apply_map(r._self_proxy, p)(r)
+
     def range_group_by_func(r, grouper_func, evaler_func):
         grouper = grouper_func(r._self_proxy.nested_proxy)
         evaler = evaler_func(r._self_proxy.nested_proxy.range_proxy)
+        if isinstance(r, BlockRange):
+            return r._self_proxy._group_by(grouper, evaler, r)
         return r._group_by(grouper, evaler)
 
     iterator_and_range_cls = [x for x in globals() if ('Iterator' in x or 'Range' in x) and x[0].isupper()]
@@ -420,6 +425,7 @@ def setup_sequence_map_funcs():
     for cl in iterator_and_range_cls:
         globals()[cl].map = range_map_func
         globals()[cl].select = range_map_func
+        globals()[cl].apply = range_apply_func
         globals()[cl].where = range_where_func
         globals()[cl].group_by = range_group_by_func
         globals()[cl].max = range_max_func
@@ -452,6 +458,11 @@ def setup_sequence_proxy_map_funcs():
         p = func(r.nested_proxy)
         return r._all(p)
 
+    def range_group_by_func(r, grouper_func, evaler_func):
+        grouper = grouper_func(r.nested_proxy)
+        evaler = evaler_func(r.nested_proxy.range_proxy)
+        return lambda val: r._group_by(grouper, evaler, val)
+
     iterator_and_range_cls = [x for x in dir(proxy) if ('Iterator' in x or 'Range' in x) and x[0].isupper()]
 
     for cl in iterator_and_range_cls:
@@ -462,6 +473,8 @@ def setup_sequence_proxy_map_funcs():
         getattr(proxy, cl).min = range_min_func
         getattr(proxy, cl).any = range_any_func
         getattr(proxy, cl).all = range_all_func
+        if hasattr(getattr(proxy, cl), '_group_by'):
+            getattr(proxy, cl).group_by = range_group_by_func
 
 non_copying_methods = set(["ptype", "iterator_proxy", "range_proxy", "optional_proxy", "output_type_name"])
 
@@ -0,0 +1,135 @@
+import concurrent.futures
+import datetime
+
+import numpy as np
+import pandas as pd
+
+EXPORT_TABLES = ("txes", "inputs", "outputs")
+EXPORT_FORMATS = ("parquet", "arrow")
+
+# Column of block_columns holding the number of rows each block contributes to a table
+_ROW_COUNT_COLUMNS = {"txes": "tx_count", "inputs": "input_count", "outputs": "output_count"}
+
+
+def _is_date_only(value, timestamp):
+    """Whether a date was given without a time of day"""
+    if isinstance(value, datetime.datetime):
+        return False
+    if isinstance(value, datetime.date):
+        return True
+    return isinstance(value, str) and ":" not in value and timestamp == timestamp.normalize()
+
+
+def _block_height(chain, timestamps, value, is_end):
+    """Convert a height or a date (UTC) into a block height, dates select blocks mined on or after the start and on or
+    before the end"""
+    if value is None:
+        return len(chain) if is_end else 0
+    if isinstance(value, (int, np.integer)):
+        height = int(value)
+        return height + len(chain) if height < 0 else height
+    timestamp = pd.Timestamp(value)
+    if is_end:
+        if _is_date_only(value, timestamp):
+            # The whole end day is included
+            matches = np.nonzero(timestamps < (timestamp + pd.Timedelta(days=1)).timestamp())[0]
+        else:
+            matches = np.nonzero(timestamps <= timestamp.timestamp())[0]
+        return int(matches[-1]) + 1 if len(matches) > 0 else 0
+    matches = np.nonzero(timestamps >= timestamp.timestamp())[0]
+    return int(matches[0]) if len(matches) > 0 else len(chain)
+
+
+def _batch_bounds(row_counts, start, stop, batch_rows):
+    """Split the blocks [start, stop) into consecutive ranges with about batch_rows rows each"""
+    if start >= stop:
+        return [(start, stop)]
+    ends = np.cumsum(row_counts[start:stop], dtype=np.int64)
+    bounds = []
+    batch_start = start
+    while batch_start < stop:
+        consumed = ends[batch_start - start - 1] if batch_start > start else 0
+        # At least one block per batch, blocks are never split
+        batch_stop = start + int(np.searchsorted(ends, consumed + batch_rows, side="right"))
+        batch_stop = min(max(batch_stop, batch_start + 1), stop)
+        bounds.append((batch_start, batch_stop))
+        batch_start = batch_stop
+    return bounds
+
+
+def _arrow_table(arrays, columns):
+    import pyarrow as pa
+
+    fields = []
+    for name in columns:
+        values = arrays[name]
+        if name == "hash":
+            fields.append(pa.array(values).cast(pa.string()))
+        elif name == "time":
+            fields.append(pa.array(values).cast(pa.timestamp("s", tz="UTC")))
+        else:
+            fields.append(pa.array(values))
+    return pa.Table.from_arrays(fields, names=list(columns))
+
+
+def _open_writer(path, schema, file_format):
+    if file_format == "parquet":
+        import pyarrow.parquet as pq
+
+        return pq.ParquetWriter(path, schema)
+    import pyarrow as pa
+
+    return pa.ipc.new_file(path, schema)
+
+
+def export_table(
+    self, table, path, columns=None, start=None, end=None, file_format="parquet", clusters=None, batch_rows=1000000
+):
+    """
+    Write a table of the chain to a Parquet or Arrow IPC file, one row per transaction, input or output in chain order
+    @param table: txes, inputs or outputs
+    @param path: the file to write
+    @param columns: the columns to export, all columns of the table by default (see export_column_names)
+    @param start: the first block, given as a height or a date
+    @param end: the end of the exported blocks, a height (exclusive) or a date (inclusive), the end of the chain by default
+    @param file_format: parquet or arrow
+    @param clusters: a ClusterManager providing the cluster column of inputs and outputs
+    @param batch_rows: approximate number of rows that are held in memory and written as one row group
+
+    The blocks are exported in batches of about batch_rows rows. Each batch is computed natively in parallel segments,
+    and the next batch is computed while the previous one is written, so at most two batches are held in memory. Dates
+    are interpreted as UTC and the time column holds the UTC timestamp of the block. Requires pyarrow.
+    """
+    if table not in EXPORT_TABLES:
+        raise ValueError("Unknown table {}, expected one of {}".format(table, EXPORT_TABLES))
+    if file_format not in EXPORT_FORMATS:
+        raise ValueError("Unknown format {}, expected one of {}".format(file_format, EXPORT_FORMATS))
+    if columns is None:
+        columns = [name for name in self.export_column_names(table) if name != "cluster" or clusters is not None]
+    columns = list(columns)
+
+    blocks = self.block_columns()
+    first = _block_height(self, blocks["timestamp"], start, False)
+    stop = _block_height(self, blocks["timestamp"], end, True)
+    if not 0 <= first <= len(self) or not 0 <= stop <= len(self):
+        raise IndexError("Block range [{}, {}) is outside of the chain".format(first, stop))
+    bounds = _batch_bounds(blocks[_ROW_COUNT_COLUMNS[table]], first, min(max(first, stop), len(self)), batch_rows)
+
+    def compute_batch(batch):
+        return self.export_columns(table, columns, batch[0], batch[1], clusters)
+
+    writer = None
+    try:
+        with concurrent.futures.ThreadPoolExecutor(max_workers=1) as executor:
+            pending = executor.submit(compute_batch, bounds[0])
+            for i in range(len(bounds)):
+                arrays = pending.result()
+                if i + 1 < len(bounds):
+                    pending = executor.submit(compute_batch, bounds[i + 1])
+                batch_table = _arrow_table(arrays, columns)
+                if writer is None:
+                    writer = _open_writer(path, batch_table.schema, file_format)
+                writer.write_table(batch_table)
+    finally:
+        if writer is not None:
+            writer.close()
@@ -15,10 +15,21 @@
 #include <blocksci/chain/access.hpp>
 #include <blocksci/scripts/script_range.hpp>
 #include <blocksci/cluster/cluster.hpp>
+#include <blocksci/cluster/cluster_manager.hpp>
+#include <blocksci/chain/table_export.hpp>
+#include <algorithm>
 #include <unordered_map>
 #include <blocksci/heuristics/tx_identification.hpp>
 #include "../external/json/single_include/nlohmann/json.hpp"
 
+#include <pybind11/numpy.h>
+
+#include <range/v3/view/iota.hpp>
+#include <range/v3/view/transform.hpp>
+
+#include <cstring>
+#include <memory>
+
 namespace py = pybind11;
 
 using namespace blocksci;
@@ -38,6 +49,145 @@ namespace {
             })};
         }
     };
+    
+    py::dict mempoolColumnArrays(py::object self, const std::vector<MempoolColumn> &columns) {
+        py::dict arrays;
+        for (auto &column : columns) {
+            // The arrays are read-only views of the memory-mapped columns and keep the Blockchain alive
+            py::array array;
+            if (column.width == 1) {
+                array = py::array(py::dtype(column.format), {column.size}, {column.stride}, column.data, self);
+            } else {
+                array = py::array(py::dtype(column.format), {column.size, static_cast<uint64_t>(column.width)}, {column.stride, column.itemSize}, column.data, self);
+            }
+            array.attr("setflags")(py::arg("write") = false);
+            arrays[py::str(column.name)] = array;
+        }
+        return arrays;
+    }
+    
+    template <typename T>
+    py::array columnViewArray(py::object self, const ColumnView<T> &column) {
+        // Read-only view of the memory-mapped column that keeps the Blockchain alive
+        py::array_t<T> array({column.size}, {sizeof(T)}, column.data, self);
+        array.attr("setflags")(py::arg("write") = false);
+        return array;
+    }
+    
+    py::array hashArray(py::object self, const uint256 *data, size_t size, size_t stride) {
+        // Hashes are exposed as rows of 32 raw bytes in the internal byte order. Fixed-size byte strings would lose
+        // trailing zero bytes, which numpy strips from their elements.
+        auto array = py::array(py::dtype("u1"), {size, sizeof(uint256)}, {stride, size_t{1}}, data, self);
+        array.attr("setflags")(py::arg("write") = false);
+        return array;
+    }
+    
+    template <typename T>
+    py::array blockFieldArray(py::object self, const ColumnView<RawBlock> &blocks, const T RawBlock::*field) {
+        // Strided read-only view of one field of the memory-mapped blocks
+        py::array_t<T> array({blocks.size}, {sizeof(RawBlock)}, blocks.empty() ? nullptr : &(blocks.data->*field), self);
+        array.attr("setflags")(py::arg("write") = false);
+        return array;
+    }
+    
+    BlockRange checkedBlockRange(Blockchain &chain, BlockHeight start, ranges::optional<BlockHeight> stop) {
+        auto end = stop.value_or(chain.size());
+        if (start < 0 || start > end || end > chain.size()) {
+            throw pybind11::index_error();
+        }
+        return chain[{start, end}];
+    }
+    
+    template <typename T>
+    py::array vectorArray(std::vector<T> &&values) {
+        // The array takes ownership of the vector instead of copying it
+        auto owner = new std::vector<T>(std::move(values));
+        py::capsule freeOwner(owner, [](void *vector) { delete reinterpret_cast<std::vector<T> *>(vector); });
+        return py::array_t<T>({owner->size()}, {sizeof(T)}, owner->data(), freeOwner);
+    }
+    
+    ExportTable::Enum exportTableFromName(const std::string &name) {
+        if (name == "txes") {
+            return ExportTable::Txes;
+        } else if (name == "inputs") {
+            return ExportTable::Inputs;
+        } else if (name == "outputs") {
+            return ExportTable::Outputs;
+        }
+        throw std::invalid_argument("Unknown table " + name + ", expected txes, inputs or outputs");
+    }
+    
+    py::array exportColumnArray(ExportColumn &&column) {
+        // The array takes ownership of the column data instead of copying it
+        auto owner = new std::vector<char>(std::move(column.data));
+        py::capsule freeOwner(owner, [](void *data) { delete reinterpret_cast<std::vector<char> *>(data); });
+        return py::array(py::dtype(column.format), {owner->size() / column.itemSize}, {column.itemSize}, owner->data(), freeOwner);
+    }
+    
+    std::vector<ranges::optional<uint32_t>> lookupTxIndexes(Blockchain &chain, const py::object &hashObjects) {
+        // Accepts numpy arrays as well as lists of hashes
+        auto hashes = py::array::ensure(hashObjects);
+        if (!hashes) {
+            throw std::invalid_argument("tx_hashes must be a one-dimensional array");
+        }
+        auto hashSize = static_cast<py::ssize_t>(sizeof(uint256));
+        auto kind = hashes.dtype().kind();
+        bool byteRows = hashes.ndim() == 2 && hashes.shape(1) == hashSize && kind == 'u' && hashes.itemsize() == 1;
+        bool byteStrings = hashes.ndim() == 1 && (kind == 'S' || kind == 'V') && hashes.itemsize() == hashSize;
+        if (!byteRows && hashes.ndim() != 1) {
+            throw std::invalid_argument("tx_hashes must be a one-dimensional array or an array of 32 byte rows");
+        }
+        auto count = static_cast<size_t>(hashes.shape(0));
+        if (byteRows || byteStrings) {
+            // 32 raw bytes in the internal byte order, as in the hash arrays of tx_columns
+            auto contiguous = py::array::ensure(hashes, py::array::c_style);
+            std::vector<uint256> txHashes(count);
+            if (count > 0) {
+                memcpy(txHashes.data(), contiguous.data(), count * sizeof(uint256));
+            }
+            py::gil_scoped_release release;
+            return getTxIndexes(txHashes, chain.getAccess());
+        }
+        std::vector<std::string> txHashes;
+        txHashes.reserve(count);
+        for (auto hash : hashes) {
+            txHashes.push_back(hash.cast<std::string>());
+        }
+        py::gil_scoped_release release;
+        return getTxIndexes(txHashes, chain.getAccess());
+    }
+    
+    std::vector<ranges::optional<uint32_t>> txIndexesFromHashes(Blockchain &chain, const py::object &hashObjects) {
+        auto txIndexes = lookupTxIndexes(chain, hashObjects);
+        // The hash index also holds the transactions after the last block of a chain that was loaded with max_block
+        auto chainTxCount = txCount(chain);
+        for (auto &txIndex : txIndexes) {
+            if (txIndex && *txIndex >= chainTxCount) {
+                txIndex = ranges::nullopt;
+            }
+        }
+        return txIndexes;
+    }
+    
+    using AddressNumArray = py::array_t<uint32_t, py::array::c_style | py::array::forcecast>;
+    using AddressTypeArray = py::array_t<uint8_t, py::array::c_style | py::array::forcecast>;
+    
+    std::vector<RawAddress> rawAddressesFromArrays(const AddressNumArray &addressNums, const AddressTypeArray &addressTypes) {
+        if (addressNums.ndim() != 1 || addressTypes.ndim() != 1 || addressNums.size() != addressTypes.size()) {
+            throw std::invalid_argument("address_nums and address_types must be one-dimensional arrays of the same length");
+        }
+        std::vector<RawAddress> addresses;
+        addresses.reserve(static_cast<size_t>(addressNums.size()));
+        auto nums = addressNums.data();
+        auto types = addressTypes.data();
+        for (py::ssize_t i = 0; i < addressNums.size(); i++) {
+            if (types[i] >= AddressType::size) {
+                throw std::invalid_argument("Invalid address type " + std::to_string(types[i]));
+            }
+            addresses.emplace_back(nums[i], static_cast<AddressType::Enum>(types[i]));
+        }
+        return addresses;
+    }
 }
 
 void init_blockchain(py::class_<Blockchain> &cl) {
@@ -87,6 +237,89 @@ void init_blockchain(py::class_<Blockchain> &cl) {
         "Get an upper bound of the number of address of a given type (This reflects the number of type equivlant addresses of that type).",
         pybind11::arg("address_type")
     )
+    .def("mempool_observations", [](py::object self) {
+        return mempoolColumnArrays(self, self.cast<Blockchain &>().mempoolObservations());
+    }, "Return a dictionary mapping the columns recorded by the mempool recorder (tx_index, first_seen, fee_rate, removed, replaced_count) to numpy arrays. "
+    "Rows with a first_seen of 0 were not observed, a first_seen of 1 marks transactions that were already in the mempool when the recorder started.")
+    .def("mempool_events", [](py::object self) {
+        return mempoolColumnArrays(self, self.cast<Blockchain &>().mempoolEvents());
+    }, "Return a dictionary mapping the fields of the mempool event log (time, tx_hash, other_tx_hash, fee_rate, type) to numpy arrays. "
+    "Hashes are arrays of 32 bytes in reversed hex order, the type is 1 when a transaction entered the mempool, 2 when it was replaced by other_tx_hash and 3 when it was removed.")
+    .def("inout_columns", [](py::object self, BlockHeight start, ranges::optional<BlockHeight> stop) {
+        auto range = checkedBlockRange(self.cast<Blockchain &>(), start, stop);
+        py::dict arrays;
+        arrays["output_value"] = columnViewArray(self, range.outputValues());
+        arrays["output_type"] = columnViewArray(self, range.outputTypes());
+        arrays["output_address"] = columnViewArray(self, range.outputAddressNums());
+        arrays["output_spent_tx"] = columnViewArray(self, range.outputSpendingTxNums());
+        arrays["input_value"] = columnViewArray(self, range.inputValues());
+        arrays["input_type"] = columnViewArray(self, range.inputTypes());
+        arrays["input_address"] = columnViewArray(self, range.inputAddressNums());
+        arrays["input_spent_tx"] = columnViewArray(self, range.inputSpentTxNums());
+        return arrays;
+    }, py::arg("start") = 0, py::arg("stop") = ranges::nullopt,
+    "Return a dictionary mapping the fields of all outputs and inputs in the blocks [start, stop) to numpy arrays ordered by output and input number. "
+    "The arrays are read-only views of the columns written by blocksci_parser inout-columns-update. The type is the address type, "
+    "output_spent_tx is the spending transaction of an output (0 if unspent) and input_spent_tx the transaction containing the spent output.")
+    .def("block_columns", [](py::object self, BlockHeight start, ranges::optional<BlockHeight> stop) {
+        auto blocks = checkedBlockRange(self.cast<Blockchain &>(), start, stop).rawBlocks();
+        py::dict arrays;
+        arrays["hash"] = hashArray(self, blocks.empty() ? nullptr : &blocks.data->hash, blocks.size, sizeof(RawBlock));
+        arrays["height"] = blockFieldArray(self, blocks, &RawBlock::height);
+        arrays["first_tx"] = blockFieldArray(self, blocks, &RawBlock::firstTxIndex);
+        arrays["tx_count"] = blockFieldArray(self, blocks, &RawBlock::txCount);
+        arrays["input_count"] = blockFieldArray(self, blocks, &RawBlock::inputCount);
+        arrays["output_count"] = blockFieldArray(self, blocks, &RawBlock::outputCount);
+        arrays["version"] = blockFieldArray(self, blocks, &RawBlock::version);
+        arrays["timestamp"] = blockFieldArray(self, blocks, &RawBlock::timestamp);
+        arrays["bits"] = blockFieldArray(self, blocks, &RawBlock::bits);
+        arrays["nonce"] = blockFieldArray(self, blocks, &RawBlock::nonce);
+        arrays["size"] = blockFieldArray(self, blocks, &RawBlock::realSize);
+        arrays["base_size"] = blockFieldArray(self, blocks, &RawBlock::baseSize);
+        return arrays;
+    }, py::arg("start") = 0, py::arg("stop") = ranges::nullopt,
+    "Return a dictionary mapping the header fields of the blocks [start, stop) to numpy arrays. The arrays are read-only strided views "
+    "of the memory-mapped block file. Hashes are rows of 32 bytes in reversed hex order, bytes(hash[i][::-1]).hex() is the hex string of a hash.")
+    .def("tx_columns", [](py::object self, BlockHeight start, ranges::optional<BlockHeight> stop) {
+        auto range = checkedBlockRange(self.cast<Blockchain &>(), start, stop);
+        auto hashes = range.txHashes();
+        py::dict arrays;
+        arrays["hash"] = hashArray(self, hashes.data, hashes.size, sizeof(uint256));
+        arrays["version"] = columnViewArray(self, range.txVersions());
+        arrays["first_input"] = columnViewArray(self, range.txFirstInputNums());
+        arrays["first_output"] = columnViewArray(self, range.txFirstOutputNums());
+        arrays["input_sequence"] = columnViewArray(self, range.inputSequenceNums());
+        arrays["input_spent_output"] = columnViewArray(self, range.inputSpentOutputNums());
+        return arrays;
+    }, py::arg("start") = 0, py::arg("stop") = ranges::nullopt,
+    "Return a dictionary mapping the fields of all transactions and inputs in the blocks [start, stop) to numpy arrays. The arrays are read-only "
+    "views of the memory-mapped chain files and need no extra parser step. The hash, version, first_input and first_output arrays are ordered by "
+    "transaction number, with first_input and first_output holding blockchain-wide input and output numbers. The input_sequence and "
+    "input_spent_output arrays are ordered by input number, input_spent_output is the position of the spent output in its transaction. "
+    "Hashes are rows of 32 bytes in reversed hex order.")
+    .def("export_column_names", [](Blockchain &, const std::string &table) {
+        return exportColumnNames(exportTableFromName(table));
+    }, "Return the names of the columns of the table (txes, inputs or outputs) that export_columns can produce",
+    py::arg("table"))
+    .def("export_columns", [](Blockchain &chain, const std::string &table, const std::vector<std::string> &columns, BlockHeight start, ranges::optional<BlockHeight> stop, const ClusterManager *clusters) {
+        auto range = checkedBlockRange(chain, start, stop);
+        auto exportTable = exportTableFromName(table);
+        std::vector<ExportColumn> exported;
+        {
+            py::gil_scoped_release release;
+            exported = exportTableColumns(range, exportTable, columns, clusters);
+        }
+        py::dict arrays;
+        for (auto &column : exported) {
+            auto name = column.name;
+            arrays[py::str(name)] = exportColumnArray(std::move(column));
+        }
+        return arrays;
+    }, py::arg("table"), py::arg("columns"), py::arg("start") = 0, py::arg("stop") = ranges::nullopt, py::arg("clusters") = nullptr,
+    "Return a dictionary mapping the given columns of the table (txes, inputs or outputs) in the blocks [start, stop) to numpy arrays "
+    "with one row per transaction, input or output in chain order. The blocks are processed in parallel segments without holding the GIL. "
+    "Hashes are hex strings, cluster requires a ClusterManager. See export_column_names for the available columns and blocksci.export "
+    "for writing whole tables to Parquet or Arrow files.")
     .def_property_readonly("blocks",
         +[](Blockchain &chain) -> Range<Block> {
         return ranges::any_view<Block, random_access_sized>{chain};
@@ -97,6 +330,33 @@ void init_blockchain(py::class_<Blockchain> &cl) {
     .def("tx_with_hash", [](Blockchain &chain, const std::string &hash) {
         return Transaction{hash, chain.getAccess()};
     },"This functions gets the transaction with given hash.", pybind11::arg("tx_hash"))
+    .def("tx_indexes_from_hashes", [](Blockchain &chain, py::object hashes) {
+        auto txIndexes = txIndexesFromHashes(chain, hashes);
+        py::array_t<int64_t> array(txIndexes.size());
+        auto data = array.mutable_data();
+        for (size_t i = 0; i < txIndexes.size(); i++) {
+            data[i] = txIndexes[i] ? static_cast<int64_t>(*txIndexes[i]) : -1;
+        }
+        return array;
+    }, "Look up many transaction hashes at once. Takes an array or list of hex strings, or an array of 32 byte hashes in the internal "
+    "byte order (eg. the (n, 32) uint8 hash array of tx_columns) and returns a numpy array with the index of each transaction, -1 for hashes "
+    "that are not in the chain. The hash index is queried in batches on all cores.", pybind11::arg("tx_hashes"))
+    .def("txes_with_hashes", [](Blockchain &chain, py::object hashes) -> Range<Transaction> {
+        auto txIndexes = txIndexesFromHashes(chain, hashes);
+        auto txNums = std::make_shared<std::vector<uint32_t>>();
+        txNums->reserve(txIndexes.size());
+        for (auto &txIndex : txIndexes) {
+            if (txIndex) {
+                txNums->push_back(*txIndex);
+            }
+        }
+        auto &access = chain.getAccess();
+        return RawRange<Transaction>{ranges::views::transform(ranges::views::iota(size_t{0}, txNums->size()), [txNums, &access](size_t i) {
+            return Transaction{(*txNums)[i], access};
+        })};
+    }, "Return the range of transactions with the given hashes in the order of the hashes, skipping hashes that are not "
+    "in the chain. Takes the same arrays as tx_indexes_from_hashes. Use apply on the range to evaluate a query on all "
+    "transactions in parallel.", pybind11::arg("tx_hashes"))
     .def("address_from_index", [](Blockchain &chain, uint32_t index, AddressType::Enum type) {
         return Address{index, type, chain.getAccess()};
     }, "Construct an address object from an address num and type", pybind11::arg("index"), pybind11::arg("type"))
@@ -108,6 +368,79 @@ void init_blockchain(py::class_<Blockchain> &cl) {
             return ranges::nullopt;
         }
     }, "Construct an address object from an address string", pybind11::arg("address_string"))
+    .def("utxo_set", [](Blockchain &chain, BlockHeight height) {
+        UtxoSet utxos;
+        {
+            py::gil_scoped_release release;
+            utxos = chain.utxoSet(height);
+        }
+        py::dict arrays;
+        arrays["tx_index"] = vectorArray(std::move(utxos.txNums));
+        arrays["output_index"] = vectorArray(std::move(utxos.outputNums));
+        arrays["value"] = vectorArray(std::move(utxos.values));
+        arrays["address_type"] = vectorArray(std::move(utxos.addressTypes));
+        arrays["address_num"] = vectorArray(std::move(utxos.addressNums));
+        return arrays;
+    }, "Return the unspent outputs after the block at the given height (-1 for the last block) as a dict of numpy arrays "
+    "(tx_index, output_index, value, address_type, address_num) sorted by output. The set is derived from the closest UTXO "
+    "snapshot written by the parser's utxo-snapshots-update command, or from the start of the chain if there are none.",
+    pybind11::arg("height") = -1)
+    .def_property_readonly("utxo_snapshot_heights", &Blockchain::utxoSnapshotHeights, "Heights of the available UTXO snapshots")
+    .def("address_strings", [](Blockchain &chain, AddressNumArray addressNums, AddressTypeArray addressTypes) {
+        auto addresses = rawAddressesFromArrays(addressNums, addressTypes);
+        std::vector<std::string> addressStrings;
+        {
+            py::gil_scoped_release release;
+            addressStrings = getAddressStrings(addresses, chain.getAccess());
+        }
+        size_t width = 1;
+        for (auto &addressString : addressStrings) {
+            width = std::max(width, addressString.size());
+        }
+        // Fixed width unicode array, address strings are ASCII
+        py::array array(py::dtype("<U" + std::to_string(width)), {addressStrings.size()});
+        auto data = static_cast<uint32_t *>(array.mutable_data());
+        std::fill(data, data + addressStrings.size() * width, 0);
+        for (size_t i = 0; i < addressStrings.size(); i++) {
+            std::copy(addressStrings[i].begin(), addressStrings[i].end(), data + i * width);
+        }
+        return array;
+    }, "Return a numpy array of the address strings of the addresses with the given numbers and types (eg. the output_address "
+    "and output_type arrays of inout_columns). Address types without an address string result in an empty string.",
+    pybind11::arg("address_nums"), pybind11::arg("address_types"))
+    .def("address_balances", [](Blockchain &chain, AddressNumArray addressNums, AddressTypeArray addressTypes, std::vector<BlockHeight> heights) {
+        auto addresses = rawAddressesFromArrays(addressNums, addressTypes);
+        py::array_t<int64_t> matrix({addresses.size(), heights.size()});
+        auto data = matrix.mutable_data();
+        {
+            py::gil_scoped_release release;
+            auto balances = calculateBalances(addresses, heights, chain.getAccess());
+            std::copy(balances.begin(), balances.end(), data);
+        }
+        return matrix;
+    }, "Return a numpy matrix with the balance of every address (rows) at every block height (columns). A height of -1 "
+    "stands for the current balance. The outputs of all addresses are collected from the address index and scanned in "
+    "one parallel pass, which is much faster than calling balance() on each address. See address_balances_chunked for "
+    "watchlists that are too large to hold all outputs in memory at once.",
+    pybind11::arg("address_nums"), pybind11::arg("address_types"), pybind11::arg("heights") = std::vector<BlockHeight>{-1})
+    .def("addresses_from_strings", [](Blockchain &chain, const std::vector<std::string> &addressStrings) {
+        std::vector<ranges::optional<Address>> addresses;
+        {
+            py::gil_scoped_release release;
+            addresses = getAddressesFromStrings(addressStrings, chain.getAccess());
+        }
+        py::array_t<uint32_t> addressNums(addresses.size());
+        py::array_t<uint8_t> addressTypes(addresses.size());
+        auto nums = addressNums.mutable_data();
+        auto types = addressTypes.mutable_data();
+        for (size_t i = 0; i < addresses.size(); i++) {
+            nums[i] = addresses[i] ? addresses[i]->scriptNum : 0;
+            types[i] = static_cast<uint8_t>(addresses[i] ? addresses[i]->type : AddressType::NONSTANDARD);
+        }
+        return py::make_tuple(addressNums, addressTypes);
+    }, "Look up many address strings at once. Returns a tuple of numpy arrays (address_nums, address_types), "
+    "the address number is 0 for strings that are invalid or belong to addresses which never appeared in the chain.",
+    pybind11::arg("address_strings"))
     .def("addresses_with_prefix", [](Blockchain &chain, const std::string &addressPrefix) {
         pybind11::list pyAddresses;
         auto addresses = getAddressesWithPrefix(addressPrefix, chain.getAccess());
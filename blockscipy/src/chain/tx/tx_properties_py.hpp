@@ -39,6 +39,9 @@ struct AddTransactionMethods {
         func(property_tag, "observed_in_mempool", &Transaction::observedInMempool, "Returns whether this transaction was seen in the mempool by the recorder");
         func(property_tag, "time_seen", &Transaction::getTimeSeen, "If recorded by the mempool recorder, the time that this transaction was first seen by your node");
         func(property_tag, "timestamp_seen", &Transaction::getTimestampSeen, "If recorded by the mempool recorder, the time that this transaction was first seen by your node");
+        func(property_tag, "fee_rate_seen", &Transaction::getFeeRateSeen, "If recorded by the mempool recorder, the fee rate in satoshi per 1000 virtual bytes when this transaction was first seen by your node");
+        func(property_tag, "timestamp_removed", &Transaction::getTimestampRemoved, "If recorded by the mempool recorder, the last time that this transaction left the mempool of your node without being mined");
+        func(property_tag, "replaced_count", &Transaction::getReplacedCount, "Number of mempool transactions that this transaction replaced according to the mempool recorder");
         func(property_tag, "block", &Transaction::block, "The block that this transaction was in");
         func(property_tag, "index", +[](const Transaction &tx) { return tx.txNum; }, "The internal index of this transaction");
         func(property_tag, "hash", &Transaction::getHash, "The 256-bit hash of this transaction");
@@ -42,6 +42,11 @@ struct AddClusterMethods {
         }, "Return the number of transactions where this cluster was an input");
 
         func(method_tag, "count_of_type", &Cluster::countOfType, "Return the number of addresses of the given type in the cluster", pybind11::arg("address_type"));
+        func(property_tag, "first_activity_height", &Cluster::firstActivityHeight, "The height of the first block in which this cluster received or spent outputs");
+        func(property_tag, "last_activity_height", &Cluster::lastActivityHeight, "The height of the last block in which this cluster received or spent outputs");
+        func(method_tag, "received_value", &Cluster::receivedValue, "Return the total value received by this cluster in blocks [start, stop)", pybind11::arg("start") = 0, pybind11::arg("stop") = -1);
+        func(method_tag, "spent_value", &Cluster::spentValue, "Return the total value spent by this cluster in blocks [start, stop)", pybind11::arg("start") = 0, pybind11::arg("stop") = -1);
+        func(method_tag, "active_tx_count", &Cluster::activeTxCount, "Return the number of transactions in blocks [start, stop) in which this cluster received or spent outputs", pybind11::arg("start") = 0, pybind11::arg("stop") = -1);
     }
 };
 
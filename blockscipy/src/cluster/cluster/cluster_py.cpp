@@ -10,6 +10,7 @@
 #include "cluster_properties_py.hpp"
 #include "ranges_py.hpp"
 #include "caster_py.hpp"
+#include "proxy.hpp"
 #include "proxy_utils.hpp"
 #include "self_apply_py.hpp"
 
@@ -21,7 +22,10 @@
 
 #include <range/v3/range_for.hpp>
 
+#include <sstream>
+
 #include <pybind11/iostream.h>
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 
 namespace py = pybind11;
@@ -52,6 +56,67 @@ void init_cluster_manager(pybind11::module &s) {
     ;
 
     
+    py::class_<ClusteringRuleStats>(s, "ClusteringRuleStats", "Link statistics of a single clustering rule")
+    .def_readonly("name", &ClusteringRuleStats::name, "The name of the rule")
+    .def_readonly("transactions", &ClusteringRuleStats::transactions, "The number of transactions the rule linked addresses in, or excluded for exclusion rules")
+    .def_readonly("unions", &ClusteringRuleStats::unions, "The number of links that merged two separate clusters")
+    .def_readonly("redundant", &ClusteringRuleStats::redundant, "The number of links between addresses that were already in the same cluster")
+    .def("__repr__", [](const ClusteringRuleStats &stats) {
+        std::stringstream ss;
+        ss << "ClusteringRuleStats(name=" << stats.name << ", transactions=" << stats.transactions << ", unions=" << stats.unions << ", redundant=" << stats.redundant << ")";
+        return ss.str();
+    })
+    ;
+    
+    py::class_<ClusteringPipeline>(s, "ClusteringPipeline", "Class describing the rules used to link addresses into clusters. Exclusion rules are evaluated first, followed by the multi-input rule and the change rules in the order they were added")
+    .def(py::init<>())
+    .def_static("standard", &ClusteringPipeline::standard, py::arg("heuristic") = heuristics::ChangeHeuristic{heuristics::NoChange{}}, py::arg("ignore_coinjoin") = true,
+    "Return the pipeline used by create_clustering when only a change heuristic is given")
+    .def("add_multi_input", &ClusteringPipeline::addMultiInput, py::arg("name") = "multi_input", py::return_value_policy::reference_internal,
+    "Link all inputs of a transaction")
+    .def("add_change", &ClusteringPipeline::addChange, py::arg("heuristic"), py::arg("name"), py::return_value_policy::reference_internal,
+    "Link the outputs selected by the change heuristic to the inputs of a transaction")
+    .def("add_exclusion", [](ClusteringPipeline &pipeline, Proxy<bool> &filter, const std::string &name) -> ClusteringPipeline & {
+        return pipeline.addExclusion([filter](const Transaction &tx) {
+            return filter(tx);
+        }, name);
+    }, py::arg("filter"), py::arg("name"), py::return_value_policy::reference_internal,
+    "Skip all transactions matched by the filter, e.g. blocksci.heuristics.is_coinjoin")
+    .def("exclude_address_type", &ClusteringPipeline::excludeAddressType, py::arg("address_type"), py::return_value_policy::reference_internal,
+    "Never link addresses of the given type")
+    .def_property_readonly("rule_names", &ClusteringPipeline::ruleNames, "The names of all rules in evaluation order")
+    ;
+    
+    py::class_<ClusterChange>(s, "ClusterChange", "A cluster whose addresses belong to several clusters of another clustering")
+    .def_readonly("index", &ClusterChange::clusterNum, "The index of the cluster in the clustering it belongs to")
+    .def_readonly("other_cluster_count", &ClusterChange::otherClusterCount, "The number of clusters of the other clustering sharing addresses with this cluster")
+    .def_readonly("size", &ClusterChange::size, "The number of compared addresses in the cluster")
+    ;
+    
+    py::class_<ClusteringComparison>(s, "ClusteringComparison", "Differences between two clusterings of the same chain")
+    .def_readonly("first_cluster_count", &ClusteringComparison::firstClusterCount, "The number of clusters in the first clustering")
+    .def_readonly("second_cluster_count", &ClusteringComparison::secondClusterCount, "The number of clusters in the second clustering")
+    .def_readonly("compared_address_count", &ClusteringComparison::comparedAddressCount, "The number of (type equivalent) addresses that are part of both clusterings")
+    .def_readonly("unmatched_address_count", &ClusteringComparison::unmatchedAddressCount, "The number of (type equivalent) addresses that are only part of one clustering")
+    .def_readonly("merged_cluster_count", &ClusteringComparison::mergedClusterCount, "The number of clusters of the second clustering formed from several clusters of the first")
+    .def_readonly("split_cluster_count", &ClusteringComparison::splitClusterCount, "The number of clusters of the first clustering split over several clusters of the second")
+    .def_readonly("largest_merges", &ClusteringComparison::largestMerges, "The largest merged clusters of the second clustering")
+    .def_readonly("largest_splits", &ClusteringComparison::largestSplits, "The largest split clusters of the first clustering")
+    .def_readonly("moved_address_count", &ClusteringComparison::movedAddressCount, "The number of addresses that are not in the cluster which received most addresses of their former cluster")
+    .def_readonly("moved_addresses", &ClusteringComparison::movedAddresses, "The first of the moved addresses, at most moved_address_limit of them")
+    .def_property_readonly("contingency", [](const ClusteringComparison &comparison) {
+        auto size = comparison.contingency.size();
+        py::array_t<uint32_t> first(size), second(size), count(size);
+        auto firstData = first.mutable_data(), secondData = second.mutable_data(), countData = count.mutable_data();
+        for (size_t i = 0; i < size; i++) {
+            firstData[i] = comparison.contingency[i].first;
+            secondData[i] = comparison.contingency[i].second;
+            countData[i] = comparison.contingency[i].count;
+        }
+        return py::make_tuple(first, second, count);
+    }, "Return the non-zero entries of the contingency table as three numpy arrays: the cluster index in the first clustering, the cluster index in the second clustering and the number of shared addresses")
+    ;
+    
     py::class_<ClusterManager>(s, "ClusterManager", "Class managing the cluster dat")
     .def(py::init([](std::string arg, blocksci::Blockchain &chain) {
        return ClusterManager(arg, chain.getAccess());
@@ -65,6 +130,17 @@ void init_cluster_manager(pybind11::module &s) {
         return ClusterManager::createClustering(range, heuristic, location, shouldOverwrite, ignoreCoinJoin);
     }, py::arg("location"), py::arg("chain"), py::arg("start") = 0, py::arg("stop") = -1,
     py::arg("heuristic") = heuristics::ChangeHeuristic{heuristics::NoChange{}}, py::arg("should_overwrite") = false, py::arg("ignore_coinjoin") = true)
+    .def_static("create_clustering", [](const std::string &location, Blockchain &chain, const ClusteringPipeline &pipeline, BlockHeight start, BlockHeight stop, bool shouldOverwrite) {
+        py::scoped_ostream_redirect stream(std::cout, py::module::import("sys").attr("stdout"));
+        if (stop == -1) {
+            stop = chain.size();
+        }
+        auto range = chain[{start, stop}];
+        return ClusterManager::createClustering(range, pipeline, location, shouldOverwrite);
+    }, py::arg("location"), py::arg("chain"), py::arg("pipeline"), py::arg("start") = 0, py::arg("stop") = -1, py::arg("should_overwrite") = false,
+    "Create a clustering using the rules of the given ClusteringPipeline")
+    .def_static("compare_clusterings", &ClusterManager::compareClusterings, py::arg("first"), py::arg("second"), py::arg("top_k") = 10, py::arg("moved_address_limit") = 1000,
+    "Compare two clusterings of the same chain, reporting merged and split clusters as well as the number of addresses that moved between clusters and a sample of them")
     .def("cluster_with_address", [](const ClusterManager &cm, const Address &address) -> Cluster {
        return cm.getCluster(address);
     }, py::arg("address"), "Return the cluster containing the given address")
@@ -74,6 +150,23 @@ void init_cluster_manager(pybind11::module &s) {
     .def("tagged_clusters", [](ClusterManager &cm, const std::unordered_map<blocksci::Address, std::string> &tags) -> Iterator<TaggedCluster> {
         return cm.taggedClusters(tags);
     }, py::arg("tagged_addresses"), "Given a dictionary of tags, return a list of TaggedCluster objects for any clusters containing tagged scripts")
+    .def("tagged_clusters", [](ClusterManager &cm, const std::string &tagSetName) -> Iterator<TaggedCluster> {
+        return cm.taggedClusters(tagSetName);
+    }, py::arg("tag_set_name"), "Return a list of TaggedCluster objects for the tag set with the given name that was stored using save_tags")
+    .def("save_tags", &ClusterManager::saveTags, py::arg("tagged_addresses"), py::arg("tag_set_name"), py::arg("should_overwrite") = false,
+    "Resolve a dictionary of tags against this clustering and store it in the cluster directory so it can be reused with tagged_clusters")
+    .def("rule_stats", &ClusterManager::getRuleStats, "Return the link statistics of every rule that was used to create the clustering")
+    .def("cluster_stats", [](py::object self) {
+        auto &cm = self.cast<ClusterManager &>();
+        py::dict stats;
+        for (auto &column : cm.getClusterStats()) {
+            // The arrays are read-only views of the memory-mapped columns and keep the ClusterManager alive
+            py::array array(py::dtype(column.format), {column.size}, {column.itemSize}, column.data, self);
+            array.attr("setflags")(py::arg("write") = false);
+            stats[py::str(column.name)] = array;
+        }
+        return stats;
+    }, "Return a dictionary mapping statistic names (address_count, type_equiv_count, <address type>_count, total_received, first_height, last_height, tx_count) to numpy arrays indexed by cluster number")
     ;
 }
 
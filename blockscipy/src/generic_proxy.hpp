@@ -15,6 +15,7 @@
 
 #include <any>
 #include <functional>
+#include <memory>
 
 struct GenericProxy {
 	virtual std::function<std::any(std::any &)> getGenericAny() const = 0;
@@ -22,6 +23,11 @@ struct GenericProxy {
 	virtual ProxyTypeInfo getSourceType() const = 0;
 	virtual ProxyTypeInfo getDestType() const = 0;
 	virtual ~GenericProxy() = default;
+
+	// Vectorized form of the proxy, null if it can only be evaluated by calling it (see proxy/vectorized.hpp)
+	std::shared_ptr<const VectorPlan> vectorPlan;
+	// True if the proxy only touches C++ values, so it can be called on several threads without the GIL (see proxy/parallel.hpp)
+	bool threadSafe = false;
 };
 
 struct IteratorProxy : public GenericProxy {
@@ -11,6 +11,8 @@
 #include "proxy.hpp"
 #include "proxy_utils.hpp"
 #include "caster_py.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 #include <range/v3/distance.hpp>
 #include <range/v3/algorithm/any_of.hpp>
@@ -31,29 +33,29 @@ void applyProxyIteratorFuncs(pybind11::class_<IteratorProxy, GenericProxy> &cl,
 
     cl
 	.def_property_readonly("size", [](IteratorProxy &p) -> Proxy<int64_t> {
-		return liftGeneric(p, [](auto && seq) -> int64_t {
+		return withThreadSafety(withVectorPlan(liftGeneric(p, [](auto && seq) -> int64_t {
 			return mpark::visit(ranges::distance, std::forward<decltype(seq)>(seq).var);
-		});
+		}), reduceVectorPlan(VectorOp::Count, p.vectorPlan)), p.threadSafe);
 	})
 	.def("_any", [](IteratorProxy &p, Proxy<bool> &p2) -> Proxy<bool> {
-		return liftGeneric(p, [p2](auto && seq) -> bool {
+		return withThreadSafety(withVectorPlan(liftGeneric(p, [p2](auto && seq) -> bool {
 			return mpark::visit([p2](auto && r) -> bool {
 				return ranges::any_of(std::forward<decltype(r)>(r), [p2](auto && item) {
 					return p2(std::forward<decltype(item)>(item));
 				});
 			}, std::forward<decltype(seq)>(seq).var);
 			
-		});
+		}), reduceVectorPlan(VectorOp::Any, p.vectorPlan, p2.vectorPlan)), p.threadSafe && p2.threadSafe);
 	})
 	.def("_all", [](IteratorProxy &p, Proxy<bool> &p2) -> Proxy<bool> {
-		return liftGeneric(p, [p2](auto && seq) -> bool {
+		return withThreadSafety(withVectorPlan(liftGeneric(p, [p2](auto && seq) -> bool {
 			return mpark::visit([p2](auto && r) -> bool {
 				return ranges::all_of(std::forward<decltype(r)>(r), [p2](auto && item) {
 					return p2(std::forward<decltype(item)>(item));
 				});
 			}, std::forward<decltype(seq)>(seq).var);
 			
-		});
+		}), reduceVectorPlan(VectorOp::All, p.vectorPlan, p2.vectorPlan)), p.threadSafe && p2.threadSafe);
 	})
 	;
 
@@ -86,9 +88,9 @@ void applyProxyRangeFuncs(pybind11::class_<RangeProxy, IteratorProxy> &cl) {
 
     cl
 	.def_property_readonly("size", [](RangeProxy &p) -> Proxy<int64_t> {
-		return liftGeneric(p, [](auto && seq) -> int64_t {
+		return withThreadSafety(withVectorPlan(liftGeneric(p, [](auto && seq) -> int64_t {
 			return mpark::visit(ranges::distance, std::forward<decltype(seq)>(seq).var);
-		});
+		}), reduceVectorPlan(VectorOp::Count, p.vectorPlan)), p.threadSafe);
 	})
 	;
 }
\ No newline at end of file
@@ -11,15 +11,17 @@
 
 #include "proxy.hpp"
 #include "proxy_utils.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 #include <range/v3/view/join.hpp>
 #include <range/v3/view/transform.hpp>
 
 template<typename R>
 Proxy<RawIterator<R>> mapSequence(IteratorProxy &p, Proxy<RawIterator<R>> &p2) {
-	return liftGeneric(p, [p2](auto && seq) -> RawIterator<R> {
+	return withThreadSafety(withVectorPlan(liftGeneric(p, [p2](auto && seq) -> RawIterator<R> {
 		return ranges::views::join(ranges::views::transform(std::forward<decltype(seq)>(seq).toAnySequence(), p2));
-	});
+	}), mapSequenceVectorPlan(p.vectorPlan, p2.vectorPlan)), p.threadSafe && p2.threadSafe);
 }
 
 #endif /* proxy_range_map_optional_hpp */
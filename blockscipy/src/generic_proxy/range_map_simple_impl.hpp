@@ -12,6 +12,8 @@
 #include "proxy.hpp"
 #include "proxy_py.hpp"
 #include "proxy_utils.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 #include <blocksci/chain/block.hpp>
 #include <blocksci/scripts/script_variant.hpp>
@@ -20,9 +22,9 @@
 
 template<ranges::category range_cat, typename R>
 Proxy<ranges::any_view<R, range_cat>> mapSimple(proxy_sequence<range_cat> &p, Proxy<R> &p2) {
-	return liftGeneric(p, [p2](auto && seq) -> ranges::any_view<R, range_cat> {
+	return withThreadSafety(withVectorPlan(liftGeneric(p, [p2](auto && seq) -> ranges::any_view<R, range_cat> {
 		return ranges::views::transform(std::forward<decltype(seq)>(seq).toAnySequence(), p2);
-	});
+	}), mapVectorPlan(p.vectorPlan, p2.vectorPlan)), p.threadSafe && p2.threadSafe);
 }
 
 template <ranges::category range_cat, typename Class>
@@ -24,6 +24,8 @@ struct SequenceProxy {
 
 	virtual ProxyTypeInfo getSourceType() const = 0;
 	virtual ProxyTypeInfo getDestType() const = 0;
+	virtual std::shared_ptr<const VectorPlan> getVectorPlan() const = 0;
+	virtual bool isThreadSafe() const = 0;
 };
 
 template <ranges::category range_cat>
@@ -163,6 +165,14 @@ struct Proxy<RawRange<T>> : public SequenceProxy<T>, public RangeProxy {
 	ProxyTypeInfo getDestType() const override {
 		return createProxyTypeInfo<output_t>();
 	}
+
+	std::shared_ptr<const VectorPlan> getVectorPlan() const override {
+		return this->vectorPlan;
+	}
+
+	bool isThreadSafe() const override {
+		return this->threadSafe;
+	}
 };
 
 template<typename T>
@@ -199,6 +209,14 @@ struct Proxy<RawIterator<T>> : public SequenceProxy<T>, public IteratorProxy {
 	ProxyTypeInfo getDestType() const override {
 		return createProxyTypeInfo<output_t>();
 	}
+
+	std::shared_ptr<const VectorPlan> getVectorPlan() const override {
+		return this->vectorPlan;
+	}
+
+	bool isThreadSafe() const override {
+		return this->threadSafe;
+	}
 };
 
 template<blocksci::AddressType::Enum type>
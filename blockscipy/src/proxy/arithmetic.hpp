@@ -10,6 +10,8 @@
 #define proxy_arithmetic_hpp
 
 #include "proxy.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 template<typename Class>
 void addProxyArithMethods(Class &cl) {
@@ -18,29 +20,29 @@ void addProxyArithMethods(Class &cl) {
 	using P2 = Proxy<ranges::optional<T>>;
 	cl
 	.def("__add__", [](P &p1, P &p2) -> P {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> T {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> T {
 			return std::forward<decltype(v1)>(v1) + std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Add, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__sub__", [](P &p1, P &p2) -> P {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> T {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> T {
 			return std::forward<decltype(v1)>(v1) - std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Sub, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__mul__", [](P &p1, P &p2) -> P {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> T {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> T {
 			return std::forward<decltype(v1)>(v1) * std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Mul, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__floordiv__", [](P &p1, P &p2) -> P {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> T {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> T {
 			return std::forward<decltype(v1)>(v1) / std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Div, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__mod__", [](P &p1, P &p2) -> P {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> T {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> T {
 			return std::forward<decltype(v1)>(v1) % std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Mod, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 
 	.def("__add__", [](P &p1, P2 &p2) -> P2 {
@@ -10,6 +10,8 @@
 #define proxy_arithmetic_range_hpp
 
 #include "proxy.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 #include <range/v3/algorithm/max.hpp>
 #include <range/v3/algorithm/min.hpp>
@@ -19,19 +21,19 @@ template<typename T>
 void addProxyArithRangeMethods(pybind11::class_<SequenceProxy<T>> &cl) {
 	cl
 	.def_property_readonly("min", [](SequenceProxy<T> &p) -> Proxy<int64_t> {
-		return liftSequence(p, [](auto && seq) -> int64_t {
+		return withThreadSafety(withVectorPlan(liftSequence(p, [](auto && seq) -> int64_t {
 			return ranges::min(std::forward<decltype(seq)>(seq));
-		});
+		}), reduceVectorPlan(VectorOp::Min, p.getVectorPlan())), p.isThreadSafe());
 	})
 	.def_property_readonly("max", [](SequenceProxy<T> &p) -> Proxy<int64_t> {
-		return liftSequence(p, [](auto && seq) -> int64_t {
+		return withThreadSafety(withVectorPlan(liftSequence(p, [](auto && seq) -> int64_t {
 			return ranges::max(std::forward<decltype(seq)>(seq));
-		});
+		}), reduceVectorPlan(VectorOp::Max, p.getVectorPlan())), p.isThreadSafe());
 	})
 	.def_property_readonly("sum", [](SequenceProxy<T> &p) -> Proxy<int64_t> {
-		return liftSequence(p, [](auto && seq) -> int64_t {
+		return withThreadSafety(withVectorPlan(liftSequence(p, [](auto && seq) -> int64_t {
 			return ranges::accumulate(std::forward<decltype(seq)>(seq), int64_t(0));
-		});
+		}), reduceVectorPlan(VectorOp::Sum, p.getVectorPlan())), p.isThreadSafe());
 	})
 	;
 }
@@ -11,6 +11,8 @@
 
 #include "proxy.hpp"
 #include "proxy_create.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 #include "caster_py.hpp"
 #include "generic_sequence.hpp"
 #include "python_range_conversion.hpp"
@@ -24,6 +26,9 @@ struct AddProxyMethods {
 	void operator()(pybind11::class_<Proxy<T>, BaseSimple> &cl) {
 		cl
 		.def("__call__", [](Proxy<T> &p, std::any &val) -> T {
+			if (auto vectorized = evaluateVectorized<T>(p, val)) {
+				return std::move(*vectorized);
+			}
 			return p(val);
 		})
 		.def("__call__", compose<T>)
@@ -63,6 +68,12 @@ struct AddProxyMethods {
 		using return_type = decltype(convertPythonRange(std::declval<typename Proxy<RawIterator<T>>::output_t>()));
 		cl
 		.def("__call__", [](Proxy<RawIterator<T>> &p, std::any &val) -> return_type {
+			if (auto vectorized = evaluateVectorized<RawIterator<T>>(p, val)) {
+				return convertPythonRange(std::move(*vectorized));
+			}
+			if (auto parallel = evaluateParallel<T>(p, val)) {
+				return convertPythonRange(std::move(*parallel));
+			}
 			return convertPythonRange(p(val));
 		})
 		.def("__call__", compose<RawIterator<T>>)
@@ -80,6 +91,12 @@ struct AddProxyMethods {
 		using return_type = decltype(convertPythonRange(std::declval<typename Proxy<RawRange<T>>::output_t>()));
 		cl
 		.def("__call__", [](Proxy<RawRange<T>> &p, std::any &val) -> return_type {
+			if (auto vectorized = evaluateVectorized<RawRange<T>>(p, val)) {
+				return convertPythonRange(std::move(*vectorized));
+			}
+			if (auto parallel = evaluateParallel<T>(p, val)) {
+				return convertPythonRange(std::move(*parallel));
+			}
 			return convertPythonRange(p(val));
 		})
 		.def("__call__", compose<RawRange<T>>)
@@ -11,6 +11,8 @@
 
 #include "proxy.hpp"
 #include "proxy_type_check.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 template<typename Class>
 void addProxyBooleanMethods(Class &cl) {
@@ -20,21 +22,23 @@ void addProxyBooleanMethods(Class &cl) {
 	.def("__and__", [](P &p1, P &p2) -> P {
 		// Use this instead of lift to take advantage of short-circuit
 		p1.getSourceType().checkMatch(p2.getSourceType());
-		return {std::function<bool(std::any &)>{[p1, p2](std::any &v) -> bool {
+		P p{std::function<bool(std::any &)>{[p1, p2](std::any &v) -> bool {
 			return p1(v) && p2(v);
 		}}, p1.getSourceType()};
+		return withThreadSafety(withVectorPlan(std::move(p), combineVectorPlans(VectorOp::And, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__or__", [](P &p1, P &p2) -> P {
 		// Use this instead of lift to take advantage of short-circuit
 		p1.getSourceType().checkMatch(p2.getSourceType());
-		return {std::function<bool(std::any &)>{[p1, p2](std::any &v) -> bool {
+		P p{std::function<bool(std::any &)>{[p1, p2](std::any &v) -> bool {
 			return p1(v) || p2(v);
 		}}, p1.getSourceType()};
+		return withThreadSafety(withVectorPlan(std::move(p), combineVectorPlans(VectorOp::Or, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__invert__", [](P &p) -> P {
-		return lift(p, [](auto && v) -> T {
+		return withThreadSafety(withVectorPlan(lift(p, [](auto && v) -> T {
 			return !std::forward<decltype(v)>(v);
-		});
+		}), invertVectorPlan(p.vectorPlan)), p.threadSafe);
 	})
 	;
 }
@@ -10,30 +10,32 @@
 #define proxy_comparison_hpp
 
 #include "proxy.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 template<typename Class>
 void addProxyComparisonMethods(Class &cl) {
 	using P = typename Class::type;
 	cl
 	.def("__lt__", [](P &p1, P &p2) -> Proxy<bool> {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> bool {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> bool {
 			return std::forward<decltype(v1)>(v1) < std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Lt, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__le__", [](P &p1, P &p2) -> Proxy<bool> {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> bool {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> bool {
 			return std::forward<decltype(v1)>(v1) <= std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Le, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__gt__", [](P &p1, P &p2) -> Proxy<bool> {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> bool {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> bool {
 			return std::forward<decltype(v1)>(v1) > std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Gt, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__ge__", [](P &p1, P &p2) -> Proxy<bool> {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> bool {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> bool {
 			return std::forward<decltype(v1)>(v1) >= std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Ge, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	;
 }
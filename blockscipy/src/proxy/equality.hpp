@@ -10,20 +10,22 @@
 #define proxy_equality_hpp
 
 #include "proxy.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 template<typename Class>
 void addProxyEqualityMethods(Class &cl) {
 	using P = typename Class::type;
 	cl
 	.def("__eq__", [](P &p1, P &p2) -> Proxy<bool> {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> bool {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> bool {
 			return std::forward<decltype(v1)>(v1) == std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Eq, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	.def("__ne__", [](P &p1, P &p2) -> Proxy<bool> {
-		return lift(p1, p2, [](auto && v1, auto && v2) -> bool {
+		return withThreadSafety(withVectorPlan(lift(p1, p2, [](auto && v1, auto && v2) -> bool {
 			return std::forward<decltype(v1)>(v1) != std::forward<decltype(v2)>(v2);
-		});
+		}), combineVectorPlans(VectorOp::Ne, p1.vectorPlan, p2.vectorPlan)), p1.threadSafe && p2.threadSafe);
 	})
 	;
 }
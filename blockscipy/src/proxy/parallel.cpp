@@ -0,0 +1,57 @@
+//
+//  parallel.cpp
+//  blocksci
+//
+
+#include "proxy/parallel.hpp"
+
+#include <range/v3/range/access.hpp>
+#include <range/v3/range/primitives.hpp>
+
+#include <atomic>
+
+namespace {
+	std::atomic<bool> parallelEnabled{true};
+	std::atomic<uint64_t> parallelCount{0};
+}
+
+void setParallelExecution(bool enabled) {
+	parallelEnabled = enabled;
+}
+
+bool parallelExecution() {
+	return parallelEnabled;
+}
+
+uint64_t parallelExecutionCount() {
+	return parallelCount;
+}
+
+void countParallelExecution() {
+	++parallelCount;
+}
+
+ranges::optional<blocksci::BlockRange> contiguousBlockRange(std::any &val) {
+	auto rng = std::any_cast<RawRange<blocksci::Block>>(&val);
+	if (rng == nullptr || ranges::empty(*rng)) {
+		return ranges::nullopt;
+	}
+	auto first = *ranges::begin(*rng);
+	auto height = first.height();
+	for (auto block : *rng) {
+		if (block.height() != height) {
+			return ranges::nullopt;
+		}
+		++height;
+	}
+	return blocksci::BlockRange{{first.height(), height}, &first.getAccess()};
+}
+
+ranges::optional<RawRange<blocksci::Transaction>> parallelTxRange(std::any &val) {
+	auto rng = std::any_cast<RawRange<blocksci::Transaction>>(&val);
+	// Smaller ranges are evaluated on a single thread by parallelForChunks anyway
+	if (rng == nullptr || static_cast<size_t>(ranges::size(*rng)) < 2 * blocksci::parallelChunkSize) {
+		return ranges::nullopt;
+	}
+	return *rng;
+}
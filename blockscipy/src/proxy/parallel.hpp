@@ -0,0 +1,284 @@
+//
+//  parallel.hpp
+//  blocksci
+//
+
+#ifndef proxy_parallel_hpp
+#define proxy_parallel_hpp
+
+#include "python_fwd.hpp"
+#include "proxy.hpp"
+#include "blocksci_type.hpp"
+
+#include <blocksci/chain/block.hpp>
+#include <blocksci/chain/block_range.hpp>
+#include <blocksci/chain/parallel.hpp>
+#include <blocksci/chain/transaction.hpp>
+#include <blocksci/core/address_types.hpp>
+#include <blocksci/core/bitcoin_uint256.hpp>
+
+#include <pybind11/pybind11.h>
+
+#include <range/v3/range/conversion.hpp>
+#include <range/v3/range_for.hpp>
+#include <range/v3/utility/optional.hpp>
+#include <range/v3/view/iota.hpp>
+#include <range/v3/view/slice.hpp>
+#include <range/v3/view/transform.hpp>
+
+#include <any>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** Whether values of type T can be created, copied and destroyed without holding the GIL
+ *
+ * Types other than numbers have to opt in below, proxies of any other type are evaluated on a single thread.
+ */
+template <typename T>
+struct ThreadSafeValue : std::bool_constant<std::is_arithmetic<T>::value || std::is_enum<T>::value> {};
+
+/** Marks T as thread safe, Python objects never are since copying them changes their reference count */
+template <typename T>
+struct ThreadSafeOptIn : std::true_type {
+	static_assert(!std::is_base_of<pybind11::handle, T>::value, "Python objects must not be used without holding the GIL");
+};
+
+template <> struct ThreadSafeValue<blocksci::Block> : ThreadSafeOptIn<blocksci::Block> {};
+template <> struct ThreadSafeValue<blocksci::Transaction> : ThreadSafeOptIn<blocksci::Transaction> {};
+template <> struct ThreadSafeValue<blocksci::Input> : ThreadSafeOptIn<blocksci::Input> {};
+template <> struct ThreadSafeValue<blocksci::Output> : ThreadSafeOptIn<blocksci::Output> {};
+template <> struct ThreadSafeValue<blocksci::Address> : ThreadSafeOptIn<blocksci::Address> {};
+template <> struct ThreadSafeValue<blocksci::AnyScript> : ThreadSafeOptIn<blocksci::AnyScript> {};
+template <> struct ThreadSafeValue<blocksci::EquivAddress> : ThreadSafeOptIn<blocksci::EquivAddress> {};
+template <> struct ThreadSafeValue<blocksci::Cluster> : ThreadSafeOptIn<blocksci::Cluster> {};
+template <> struct ThreadSafeValue<blocksci::TaggedCluster> : ThreadSafeOptIn<blocksci::TaggedCluster> {};
+template <> struct ThreadSafeValue<blocksci::TaggedAddress> : ThreadSafeOptIn<blocksci::TaggedAddress> {};
+template <> struct ThreadSafeValue<blocksci::script::Pubkey> : ThreadSafeOptIn<blocksci::script::Pubkey> {};
+template <> struct ThreadSafeValue<blocksci::script::PubkeyHash> : ThreadSafeOptIn<blocksci::script::PubkeyHash> {};
+template <> struct ThreadSafeValue<blocksci::script::WitnessPubkeyHash> : ThreadSafeOptIn<blocksci::script::WitnessPubkeyHash> {};
+template <> struct ThreadSafeValue<blocksci::script::MultisigPubkey> : ThreadSafeOptIn<blocksci::script::MultisigPubkey> {};
+template <> struct ThreadSafeValue<blocksci::script::Multisig> : ThreadSafeOptIn<blocksci::script::Multisig> {};
+template <> struct ThreadSafeValue<blocksci::script::ScriptHash> : ThreadSafeOptIn<blocksci::script::ScriptHash> {};
+template <> struct ThreadSafeValue<blocksci::script::WitnessScriptHash> : ThreadSafeOptIn<blocksci::script::WitnessScriptHash> {};
+template <> struct ThreadSafeValue<blocksci::script::OpReturn> : ThreadSafeOptIn<blocksci::script::OpReturn> {};
+template <> struct ThreadSafeValue<blocksci::script::Nonstandard> : ThreadSafeOptIn<blocksci::script::Nonstandard> {};
+template <> struct ThreadSafeValue<blocksci::script::WitnessUnknown> : ThreadSafeOptIn<blocksci::script::WitnessUnknown> {};
+template <> struct ThreadSafeValue<std::chrono::system_clock::time_point> : ThreadSafeOptIn<std::chrono::system_clock::time_point> {};
+template <> struct ThreadSafeValue<blocksci::uint160> : ThreadSafeOptIn<blocksci::uint160> {};
+template <> struct ThreadSafeValue<blocksci::uint256> : ThreadSafeOptIn<blocksci::uint256> {};
+template <> struct ThreadSafeValue<std::string> : ThreadSafeOptIn<std::string> {};
+
+template <typename T>
+struct ThreadSafeValue<ranges::optional<T>> : ThreadSafeValue<T> {};
+
+template <typename T>
+struct ThreadSafeValue<RawIterator<T>> : ThreadSafeValue<T> {};
+
+template <typename T>
+struct ThreadSafeValue<RawRange<T>> : ThreadSafeValue<T> {};
+
+/** Element types of sequences that are evaluated in parallel
+ *
+ * The Python conversion copies sequences of these types into numpy arrays or lists anyway, so collecting them up front
+ * costs no extra pass. Sequences of transactions, inputs or outputs stay lazy, collecting them would hold the whole
+ * range in memory.
+ */
+template <typename T>
+struct ParallelElement : std::is_arithmetic<T> {};
+
+template <>
+struct ParallelElement<std::chrono::system_clock::time_point> : std::true_type {};
+
+template <>
+struct ParallelElement<blocksci::uint160> : std::true_type {};
+
+template <>
+struct ParallelElement<blocksci::uint256> : std::true_type {};
+
+template <>
+struct ParallelElement<blocksci::AddressType::Enum> : std::true_type {};
+
+template <>
+struct ParallelElement<std::string> : std::true_type {};
+
+template <>
+struct ParallelElement<blocksci::Block> : std::true_type {};
+
+void setParallelExecution(bool enabled);
+bool parallelExecution();
+/** Number of proxy calls that were evaluated on several threads */
+uint64_t parallelExecutionCount();
+void countParallelExecution();
+
+/** Blocks held by val if it is a range of consecutive blocks, nullopt otherwise */
+ranges::optional<blocksci::BlockRange> contiguousBlockRange(std::any &val);
+
+/** Transactions held by val if it is a range of transactions that is large enough to be split over several threads */
+ranges::optional<RawRange<blocksci::Transaction>> parallelTxRange(std::any &val);
+
+template <typename P>
+P withThreadSafety(P proxy, bool threadSafe) {
+	proxy.threadSafe = threadSafe && ThreadSafeValue<typename P::output_t>::value;
+	return proxy;
+}
+
+/** Splits the blocks into segments with about the same number of transactions and calls mapFunc on each segment in parallel
+ *
+ * The segments are passed to mapFunc as a RawRange<blocksci::Block> in a std::any, the way proxies receive them, and
+ * the results are combined with reduceFunc in the order of the segments.
+ */
+template <typename ResultType, typename MapFunc, typename ReduceFunc>
+ResultType mapReduceSegments(blocksci::BlockRange &blocks, MapFunc mapFunc, ReduceFunc reduceFunc) {
+	auto segmentFunc = [&mapFunc](const blocksci::BlockRange &segment) -> ResultType {
+		std::any segmentBlocks = RawRange<blocksci::Block>{segment};
+		return mapFunc(segmentBlocks);
+	};
+	return blocks.mapReduce<ResultType>(segmentFunc, reduceFunc);
+}
+
+/** Calls mapFunc on consecutive slices of the transactions in parallel and concatenates the results in order
+ *
+ * The slices are passed to mapFunc as a RawRange<blocksci::Transaction> in a std::any, the way proxies receive them.
+ */
+template <typename T, typename MapFunc>
+std::vector<T> mapTxChunks(const RawRange<blocksci::Transaction> &txes, MapFunc mapFunc) {
+	std::mutex mutex;
+	std::map<size_t, std::vector<T>> chunkItems;
+	blocksci::parallelForChunks(static_cast<size_t>(ranges::size(txes)), [&](size_t begin, size_t end) {
+		auto chunkTxes = txes;
+		std::any chunk = RawRange<blocksci::Transaction>{chunkTxes | ranges::views::slice(static_cast<std::ptrdiff_t>(begin), static_cast<std::ptrdiff_t>(end))};
+		auto items = mapFunc(chunk);
+		std::lock_guard<std::mutex> lock(mutex);
+		chunkItems.emplace(begin, std::move(items));
+	});
+	std::vector<T> items;
+	for (auto &chunk : chunkItems) {
+		items.insert(items.end(), std::make_move_iterator(chunk.second.begin()), std::make_move_iterator(chunk.second.end()));
+	}
+	return items;
+}
+
+template <typename T, typename Sequence>
+Sequence sharedSequence(std::vector<T> &&items) {
+	auto values = std::make_shared<std::vector<T>>(std::move(items));
+	return ranges::views::transform(ranges::views::iota(size_t{0}, values->size()), [values](size_t i) -> T {
+		return (*values)[i];
+	});
+}
+
+/** Output of the sequence proxy p for val computed segment by segment on all cores
+ *
+ * Returns nullopt if p touches Python objects, val is neither a contiguous range of blocks nor a large range of
+ * transactions or the elements are not collected up front (see ParallelElement). The caller then calls the proxy
+ * instead. The GIL is released while the segments are evaluated and the results keep the order of val.
+ */
+template <typename T, typename P>
+ranges::optional<typename P::output_t> evaluateParallel(const P &p, std::any &val) {
+	if constexpr (ParallelElement<T>::value) {
+		if (p.threadSafe && parallelExecution()) {
+			if (auto blocks = contiguousBlockRange(val)) {
+				countParallelExecution();
+				std::vector<T> items;
+				{
+					pybind11::gil_scoped_release release;
+					items = mapReduceSegments<std::vector<T>>(*blocks, [&p](std::any &segment) {
+						return p(segment) | ranges::to_vector;
+					}, [](std::vector<T> &items1, std::vector<T> &items2) -> std::vector<T> & {
+						items1.reserve(items1.size() + items2.size());
+						items1.insert(items1.end(), std::make_move_iterator(items2.begin()), std::make_move_iterator(items2.end()));
+						return items1;
+					});
+				}
+				return sharedSequence<T, typename P::output_t>(std::move(items));
+			}
+			if (auto txes = parallelTxRange(val)) {
+				countParallelExecution();
+				std::vector<T> items;
+				{
+					pybind11::gil_scoped_release release;
+					items = mapTxChunks<T>(*txes, [&p](std::any &chunk) {
+						return p(chunk) | ranges::to_vector;
+					});
+				}
+				return sharedSequence<T, typename P::output_t>(std::move(items));
+			}
+		}
+	}
+	return ranges::nullopt;
+}
+
+/** Items grouped by a key, each group keeps the order of the sequence */
+template <typename T>
+using GroupedItems = std::unordered_map<BlocksciType, std::vector<T>>;
+
+template <typename T>
+void groupItems(RawIterator<T> &&rng, const std::function<BlocksciType(std::any &)> &grouper, GroupedItems<T> &grouped) {
+	RANGES_FOR(auto item, rng) {
+		std::any anyItem = item;
+		auto group = grouper(anyItem);
+		grouped[group].emplace_back(std::move(item));
+	}
+}
+
+/** Groups the items of the sequence proxy p for val by grouper and applies eval to the range of items in each group
+ *
+ * If all proxies are thread safe and val is a contiguous range of blocks, the blocks are grouped segment by segment on
+ * all cores, the partial groups are concatenated in the order of the segments and the groups are evaluated in
+ * parallel, all without holding the GIL.
+ */
+template <typename T>
+pybind11::dict groupSequence(SequenceProxy<T> &p, SimpleProxy &grouper, SimpleProxy &eval, std::any &val) {
+	auto func = p.getIteratorFunc();
+	auto genericGrouper = grouper.getGenericSimple();
+	auto genericEval = eval.getGenericSimple();
+	std::vector<std::pair<BlocksciType, std::vector<T>>> groups;
+	std::vector<ranges::optional<BlocksciType>> results;
+	auto blocks = contiguousBlockRange(val);
+	if (blocks && parallelExecution() && p.isThreadSafe() && grouper.threadSafe && eval.threadSafe) {
+		countParallelExecution();
+		pybind11::gil_scoped_release release;
+		auto grouped = mapReduceSegments<GroupedItems<T>>(*blocks, [&](std::any &segment) {
+			GroupedItems<T> segmentGroups;
+			groupItems(func(segment), genericGrouper, segmentGroups);
+			return segmentGroups;
+		}, [](GroupedItems<T> &grouped1, GroupedItems<T> &grouped2) -> GroupedItems<T> & {
+			for (auto &group : grouped2) {
+				auto &items = grouped1[group.first];
+				items.insert(items.end(), std::make_move_iterator(group.second.begin()), std::make_move_iterator(group.second.end()));
+			}
+			return grouped1;
+		});
+		groups.assign(std::make_move_iterator(grouped.begin()), std::make_move_iterator(grouped.end()));
+		results.resize(groups.size());
+		blocksci::parallelForChunks(groups.size(), [&](size_t begin, size_t end) {
+			for (auto i = begin; i < end; i++) {
+				std::any range = RawRange<T>{groups[i].second};
+				results[i] = genericEval(range);
+			}
+		});
+	} else {
+		GroupedItems<T> grouped;
+		groupItems(func(val), genericGrouper, grouped);
+		groups.assign(std::make_move_iterator(grouped.begin()), std::make_move_iterator(grouped.end()));
+		for (auto &group : groups) {
+			std::any range = RawRange<T>{group.second};
+			results.emplace_back(genericEval(range));
+		}
+	}
+	pybind11::dict dict;
+	for (size_t i = 0; i < groups.size(); i++) {
+		dict[groups[i].first.toObject()] = results[i]->toObject();
+	}
+	return dict;
+}
+
+#endif /* proxy_parallel_hpp */
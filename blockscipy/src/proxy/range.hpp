@@ -11,6 +11,8 @@
 
 #include "proxy_py.hpp"
 #include "proxy_utils.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 #include <range/v3/view/filter.hpp>
 #include <range/v3/view/stride.hpp>
@@ -21,16 +23,16 @@ template <typename T, typename BaseSimple>
 void setupRangesProxy(AllProxyClasses<T, BaseSimple> &cls) {
 	cls.sequence
 	.def("_where", [](SequenceProxy<T> &p, Proxy<bool> &p2) -> Proxy<RawIterator<T>> {
-		return liftSequence(p, [p2](auto && seq) -> RawIterator<T> {
+		return withThreadSafety(withVectorPlan(liftSequence(p, [p2](auto && seq) -> RawIterator<T> {
 			return ranges::views::filter(std::forward<decltype(seq)>(seq), [p2](T item) {
 				return p2(std::move(item));
 			});
-		});
+		}), filterVectorPlan(p.getVectorPlan(), p2.vectorPlan)), p.isThreadSafe() && p2.threadSafe);
 	})
 	.def("_max", [](SequenceProxy<T> &p, Proxy<int64_t> &p2) -> Proxy<ranges::optional<T>> {
 		// Copied and modified from range/v3/algorithm/max.hpp
 		// Testing whether input range was empty required modification
-		return liftSequence(p, [p2](auto && rng) -> ranges::optional<T> {
+		return withThreadSafety(liftSequence(p, [p2](auto && rng) -> ranges::optional<T> {
 			auto begin = ranges::begin(rng);
             auto end = ranges::end(rng);
             if (begin == end) {
@@ -45,12 +47,12 @@ void setupRangesProxy(AllProxyClasses<T, BaseSimple> &cls) {
                 }
             }
             return result;
-		});
+		}), p.isThreadSafe() && p2.threadSafe);
 	})
 	.def("_min", [](SequenceProxy<T> &p, Proxy<int64_t> &p2) -> Proxy<ranges::optional<T>> {
 		// Copied and modified from range/v3/algorithm/min.hpp
 		// Testing whether input range was empty required modification
-		return liftSequence(p, [p2](auto && rng) -> ranges::optional<T> {
+		return withThreadSafety(liftSequence(p, [p2](auto && rng) -> ranges::optional<T> {
 			auto begin = ranges::begin(rng);
             auto end = ranges::end(rng);
             if (begin == end) {
@@ -65,7 +67,10 @@ void setupRangesProxy(AllProxyClasses<T, BaseSimple> &cls) {
                 }
             }
             return result;
-		});
+		}), p.isThreadSafe() && p2.threadSafe);
+	})
+	.def("_group_by", [](SequenceProxy<T> &p, SimpleProxy &grouper, SimpleProxy &eval, std::any &val) -> pybind11::dict {
+		return groupSequence(p, grouper, eval, val);
 	})
 	;
 
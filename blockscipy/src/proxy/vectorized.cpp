@@ -0,0 +1,956 @@
+//
+//  vectorized.cpp
+//  blocksci
+//
+
+#include "vectorized.hpp"
+#include "parallel.hpp"
+
+#include <blocksci/chain/block_range.hpp>
+#include <blocksci/chain/input.hpp>
+#include <blocksci/chain/output.hpp>
+#include <blocksci/core/raw_block.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+	std::atomic<bool> vectorizedEnabled{true};
+	std::atomic<uint64_t> vectorizedCount{0};
+
+	// Number of transactions, inputs and outputs that are loaded together, a batch always holds at least one block
+	constexpr uint64_t vectorBatchRows = 1 << 16;
+
+	// Thrown while executing a plan that cannot be evaluated column-at-a-time, the proxy function is called instead
+	struct VectorFallback {};
+
+	VectorNodePtr makeNode(VectorNode node) {
+		return std::make_shared<const VectorNode>(std::move(node));
+	}
+
+	VectorNodePtr selfNode() {
+		return makeNode(VectorNode{VectorNode::Kind::Self});
+	}
+
+	VectorNodePtr constantNode(int64_t value) {
+		VectorNode node{VectorNode::Kind::Constant};
+		node.constant = value;
+		return makeNode(std::move(node));
+	}
+
+	VectorNodePtr fieldNode(VectorField field) {
+		VectorNode node{VectorNode::Kind::Field};
+		node.field = field;
+		return makeNode(std::move(node));
+	}
+
+	VectorNodePtr unaryNode(VectorOp op, VectorNodePtr arg) {
+		VectorNode node{VectorNode::Kind::Unary};
+		node.op = op;
+		node.lhs = std::move(arg);
+		return makeNode(std::move(node));
+	}
+
+	VectorNodePtr binaryNode(VectorOp op, VectorNodePtr lhs, VectorNodePtr rhs) {
+		VectorNode node{VectorNode::Kind::Binary};
+		node.op = op;
+		node.lhs = std::move(lhs);
+		node.rhs = std::move(rhs);
+		return makeNode(std::move(node));
+	}
+
+	VectorNodePtr broadcastNode(VectorLevel level, VectorNodePtr arg) {
+		VectorNode node{VectorNode::Kind::Broadcast};
+		node.level = level;
+		node.lhs = std::move(arg);
+		return makeNode(std::move(node));
+	}
+
+	VectorNodePtr reduceNode(VectorOp op, VectorLevel level, VectorNodePtr values, VectorNodePtr mask) {
+		VectorNode node{VectorNode::Kind::Reduce};
+		node.op = op;
+		node.level = level;
+		node.lhs = std::move(values);
+		node.rhs = std::move(mask);
+		return makeNode(std::move(node));
+	}
+
+	VectorNodePtr andMasks(const VectorNodePtr &mask1, const VectorNodePtr &mask2) {
+		if (!mask1) {
+			return mask2;
+		}
+		if (!mask2) {
+			return mask1;
+		}
+		return binaryNode(VectorOp::And, mask1, mask2);
+	}
+
+	// Replaces the references to the value of a nested int or bool proxy with the expression computing that value
+	VectorNodePtr substituteSelf(const VectorNodePtr &node, const VectorNodePtr &self) {
+		if (!node) {
+			return node;
+		}
+		if (node->kind == VectorNode::Kind::Self) {
+			return self;
+		}
+		if (!node->lhs && !node->rhs) {
+			return node;
+		}
+		VectorNode copy = *node;
+		copy.lhs = substituteSelf(node->lhs, self);
+		copy.rhs = substituteSelf(node->rhs, self);
+		return makeNode(std::move(copy));
+	}
+
+	VectorPlanPtr simplePlan(VectorLevel source, VectorNodePtr value) {
+		VectorPlan plan;
+		plan.source = source;
+		plan.value = std::move(value);
+		return std::make_shared<const VectorPlan>(std::move(plan));
+	}
+
+	VectorPlanPtr sequencePlan(VectorLevel source, VectorLevel elementLevel, VectorNodePtr value, VectorNodePtr mask) {
+		VectorPlan plan;
+		plan.source = source;
+		plan.sequence = true;
+		plan.elementLevel = elementLevel;
+		plan.value = std::move(value);
+		plan.mask = std::move(mask);
+		return std::make_shared<const VectorPlan>(std::move(plan));
+	}
+
+	// Returns whether a nested plan can be applied to the elements of the sequence
+	bool fitsElements(const VectorPlan &sequence, const VectorPlan &func) {
+		auto elementSource = sequence.value ? VectorLevel::Value : sequence.elementLevel;
+		return !func.sequence && (func.source == VectorLevel::Any || func.source == elementSource);
+	}
+
+	// Expression of a nested plan evaluated at the element level of the sequence
+	VectorNodePtr elementValue(const VectorPlan &sequence, const VectorNodePtr &value) {
+		return sequence.value ? substituteSelf(value, sequence.value) : value;
+	}
+
+	VectorLevel parentLevel(VectorLevel level) {
+		switch (level) {
+			case VectorLevel::Block:
+				return VectorLevel::Range;
+			case VectorLevel::Tx:
+				return VectorLevel::Block;
+			case VectorLevel::Input:
+			case VectorLevel::Output:
+				return VectorLevel::Tx;
+			default:
+				return VectorLevel::None;
+		}
+	}
+
+	VectorLevel fieldLevel(VectorField field) {
+		if (field <= VectorField::BlockTotalSize) {
+			return VectorLevel::Block;
+		} else if (field <= VectorField::TxTotalSize) {
+			return VectorLevel::Tx;
+		} else if (field <= VectorField::InputIndex) {
+			return VectorLevel::Input;
+		} else {
+			return VectorLevel::Output;
+		}
+	}
+
+	using PropertyPlans = std::unordered_map<std::string, VectorPlanPtr>;
+
+	VectorNodePtr sumOf(VectorLevel level, VectorField field) {
+		return reduceNode(VectorOp::Sum, level, fieldNode(field), nullptr);
+	}
+
+	VectorNodePtr weightOf(VectorField baseSize, VectorField totalSize) {
+		return binaryNode(VectorOp::Add, binaryNode(VectorOp::Mul, fieldNode(baseSize), constantNode(3)), fieldNode(totalSize));
+	}
+
+	VectorNodePtr virtualSizeOf(VectorField baseSize, VectorField totalSize) {
+		return binaryNode(VectorOp::Div, binaryNode(VectorOp::Add, weightOf(baseSize, totalSize), constantNode(3)), constantNode(4));
+	}
+
+	// Fee of a transaction, coinbase transactions pay no fee
+	VectorNodePtr txFee() {
+		auto paid = binaryNode(VectorOp::Sub, sumOf(VectorLevel::Input, VectorField::InputValue), sumOf(VectorLevel::Output, VectorField::OutputValue));
+		return binaryNode(VectorOp::Mul, paid, binaryNode(VectorOp::Ne, fieldNode(VectorField::TxInputCount), constantNode(0)));
+	}
+
+	PropertyPlans blockPropertyPlans() {
+		auto plan = [](VectorNodePtr value) {
+			return simplePlan(VectorLevel::Block, std::move(value));
+		};
+		return {
+			{"height", plan(fieldNode(VectorField::BlockHeight))},
+			{"tx_count", plan(fieldNode(VectorField::BlockTxCount))},
+			{"input_count", plan(fieldNode(VectorField::BlockInputCount))},
+			{"output_count", plan(fieldNode(VectorField::BlockOutputCount))},
+			{"timestamp", plan(fieldNode(VectorField::BlockTimestamp))},
+			{"version", plan(fieldNode(VectorField::BlockVersion))},
+			{"bits", plan(fieldNode(VectorField::BlockBits))},
+			{"nonce", plan(fieldNode(VectorField::BlockNonce))},
+			{"base_size", plan(fieldNode(VectorField::BlockBaseSize))},
+			{"total_size", plan(fieldNode(VectorField::BlockTotalSize))},
+			{"size_bytes", plan(fieldNode(VectorField::BlockTotalSize))},
+			{"weight", plan(weightOf(VectorField::BlockBaseSize, VectorField::BlockTotalSize))},
+			{"virtual_size", plan(virtualSizeOf(VectorField::BlockBaseSize, VectorField::BlockTotalSize))},
+			{"input_value", plan(sumOf(VectorLevel::Input, VectorField::InputValue))},
+			{"output_value", plan(sumOf(VectorLevel::Output, VectorField::OutputValue))},
+			{"fee", plan(reduceNode(VectorOp::Sum, VectorLevel::Tx, txFee(), nullptr))},
+			{"txes", sequencePlan(VectorLevel::Block, VectorLevel::Tx, nullptr, nullptr)},
+			{"inputs", sequencePlan(VectorLevel::Block, VectorLevel::Input, nullptr, nullptr)},
+			{"outputs", sequencePlan(VectorLevel::Block, VectorLevel::Output, nullptr, nullptr)}
+		};
+	}
+
+	PropertyPlans txPropertyPlans() {
+		auto plan = [](VectorNodePtr value) {
+			return simplePlan(VectorLevel::Tx, std::move(value));
+		};
+		return {
+			{"index", plan(fieldNode(VectorField::TxIndex))},
+			{"block_height", plan(broadcastNode(VectorLevel::Block, fieldNode(VectorField::BlockHeight)))},
+			{"input_count", plan(fieldNode(VectorField::TxInputCount))},
+			{"output_count", plan(fieldNode(VectorField::TxOutputCount))},
+			{"version", plan(fieldNode(VectorField::TxVersion))},
+			{"locktime", plan(fieldNode(VectorField::TxLocktime))},
+			{"base_size", plan(fieldNode(VectorField::TxBaseSize))},
+			{"total_size", plan(fieldNode(VectorField::TxTotalSize))},
+			{"size_bytes", plan(fieldNode(VectorField::TxTotalSize))},
+			{"weight", plan(weightOf(VectorField::TxBaseSize, VectorField::TxTotalSize))},
+			{"virtual_size", plan(virtualSizeOf(VectorField::TxBaseSize, VectorField::TxTotalSize))},
+			{"input_value", plan(sumOf(VectorLevel::Input, VectorField::InputValue))},
+			{"output_value", plan(sumOf(VectorLevel::Output, VectorField::OutputValue))},
+			{"fee", plan(txFee())},
+			{"is_coinbase", plan(binaryNode(VectorOp::Eq, fieldNode(VectorField::TxInputCount), constantNode(0)))},
+			{"ins", sequencePlan(VectorLevel::Tx, VectorLevel::Input, nullptr, nullptr)},
+			{"inputs", sequencePlan(VectorLevel::Tx, VectorLevel::Input, nullptr, nullptr)},
+			{"outs", sequencePlan(VectorLevel::Tx, VectorLevel::Output, nullptr, nullptr)},
+			{"outputs", sequencePlan(VectorLevel::Tx, VectorLevel::Output, nullptr, nullptr)}
+		};
+	}
+
+	PropertyPlans inputPropertyPlans() {
+		auto plan = [](VectorNodePtr value) {
+			return simplePlan(VectorLevel::Input, std::move(value));
+		};
+		return {
+			{"value", plan(fieldNode(VectorField::InputValue))},
+			{"address_type", plan(fieldNode(VectorField::InputAddressType))},
+			{"sequence_num", plan(fieldNode(VectorField::InputSequenceNum))},
+			{"spent_tx_index", plan(fieldNode(VectorField::InputSpentTxIndex))},
+			{"index", plan(fieldNode(VectorField::InputIndex))},
+			{"tx_index", plan(broadcastNode(VectorLevel::Tx, fieldNode(VectorField::TxIndex)))}
+		};
+	}
+
+	PropertyPlans outputPropertyPlans() {
+		auto plan = [](VectorNodePtr value) {
+			return simplePlan(VectorLevel::Output, std::move(value));
+		};
+		return {
+			{"value", plan(fieldNode(VectorField::OutputValue))},
+			{"address_type", plan(fieldNode(VectorField::OutputAddressType))},
+			{"is_spent", plan(fieldNode(VectorField::OutputIsSpent))},
+			{"index", plan(fieldNode(VectorField::OutputIndex))},
+			{"tx_index", plan(broadcastNode(VectorLevel::Tx, fieldNode(VectorField::TxIndex)))}
+		};
+	}
+
+	template <typename F>
+	void combineColumns(std::vector<int64_t> &values, const std::vector<int64_t> &other, F f) {
+		for (size_t i = 0; i < values.size(); i++) {
+			values[i] = f(values[i], other[i]);
+		}
+	}
+
+	void checkDivisors(const std::vector<int64_t> &divisors) {
+		if (std::find(divisors.begin(), divisors.end(), 0) != divisors.end()) {
+			throw VectorFallback{};
+		}
+	}
+
+	void applyBinary(VectorOp op, std::vector<int64_t> &values, const std::vector<int64_t> &other) {
+		switch (op) {
+			case VectorOp::Add:
+				combineColumns(values, other, std::plus<>{});
+				break;
+			case VectorOp::Sub:
+				combineColumns(values, other, std::minus<>{});
+				break;
+			case VectorOp::Mul:
+				combineColumns(values, other, std::multiplies<>{});
+				break;
+			case VectorOp::Div:
+				checkDivisors(other);
+				combineColumns(values, other, std::divides<>{});
+				break;
+			case VectorOp::Mod:
+				checkDivisors(other);
+				combineColumns(values, other, std::modulus<>{});
+				break;
+			case VectorOp::Eq:
+				combineColumns(values, other, std::equal_to<>{});
+				break;
+			case VectorOp::Ne:
+				combineColumns(values, other, std::not_equal_to<>{});
+				break;
+			case VectorOp::Lt:
+				combineColumns(values, other, std::less<>{});
+				break;
+			case VectorOp::Le:
+				combineColumns(values, other, std::less_equal<>{});
+				break;
+			case VectorOp::Gt:
+				combineColumns(values, other, std::greater<>{});
+				break;
+			case VectorOp::Ge:
+				combineColumns(values, other, std::greater_equal<>{});
+				break;
+			case VectorOp::And:
+				combineColumns(values, other, [](int64_t a, int64_t b) { return a != 0 && b != 0; });
+				break;
+			case VectorOp::Or:
+				combineColumns(values, other, [](int64_t a, int64_t b) { return a != 0 || b != 0; });
+				break;
+			default:
+				throw VectorFallback{};
+		}
+	}
+
+	int64_t applyBinary(VectorOp op, int64_t value1, int64_t value2) {
+		std::vector<int64_t> values{value1};
+		applyBinary(op, values, {value2});
+		return values.front();
+	}
+
+	// Reduction of a part of a sequence, sequences can span several batches
+	struct VectorPartial {
+		int64_t value = 0;
+		bool empty = true;
+	};
+
+	void accumulate(VectorOp op, VectorPartial &partial, int64_t value) {
+		if (partial.empty) {
+			partial.value = value;
+			partial.empty = false;
+			return;
+		}
+		switch (op) {
+			case VectorOp::Sum:
+			case VectorOp::Count:
+				partial.value += value;
+				break;
+			case VectorOp::Min:
+				partial.value = std::min(partial.value, value);
+				break;
+			case VectorOp::Max:
+				partial.value = std::max(partial.value, value);
+				break;
+			case VectorOp::Any:
+				partial.value = partial.value || value;
+				break;
+			case VectorOp::All:
+				partial.value = partial.value && value;
+				break;
+			default:
+				throw VectorFallback{};
+		}
+	}
+
+	VectorPartial reduceSegment(VectorOp op, const std::vector<int64_t> &values, const std::vector<int64_t> &mask, uint64_t begin, uint64_t end) {
+		VectorPartial partial;
+		for (auto i = begin; i < end; i++) {
+			if (!mask.empty() && mask[i] == 0) {
+				continue;
+			}
+			if (op == VectorOp::Count) {
+				accumulate(op, partial, 1);
+			} else if (op == VectorOp::Any || op == VectorOp::All) {
+				accumulate(op, partial, values[i] != 0);
+			} else {
+				accumulate(op, partial, values[i]);
+			}
+		}
+		return partial;
+	}
+
+	int64_t finishPartial(VectorOp op, const VectorPartial &partial) {
+		if (!partial.empty) {
+			return partial.value;
+		}
+		switch (op) {
+			case VectorOp::Min:
+			case VectorOp::Max:
+				// The proxy function decides what the minimum of an empty sequence is
+				throw VectorFallback{};
+			case VectorOp::All:
+				return 1;
+			default:
+				return 0;
+		}
+	}
+
+	/** Columns of the blocks, transactions, inputs and outputs of a batch of contiguous blocks
+	 *
+	 * Rows of each level are ordered by their position in the chain, so the children of a row are a contiguous run of
+	 * rows of the level below. Fields and the offsets of these runs are loaded when they are first used.
+	 */
+	class VectorBatch {
+		blocksci::BlockRange blocks;
+		blocksci::ColumnView<blocksci::RawBlock> rawBlocks;
+		bool inoutColumns;
+		uint64_t txCount = 0;
+		uint64_t inputCount = 0;
+		uint64_t outputCount = 0;
+		std::map<VectorField, std::vector<int64_t>> fields;
+		std::map<std::pair<VectorLevel, VectorLevel>, std::vector<uint64_t>> offsets;
+
+		template <typename F>
+		std::vector<int64_t> blockColumn(F f) const {
+			std::vector<int64_t> values;
+			values.reserve(rawBlocks.size);
+			for (auto &block : rawBlocks) {
+				values.push_back(f(block));
+			}
+			return values;
+		}
+
+		template <typename F>
+		std::vector<int64_t> txColumn(F f) const {
+			std::vector<int64_t> values;
+			values.reserve(txCount);
+			for (auto block : blocks) {
+				for (auto tx : block) {
+					f(tx, values);
+				}
+			}
+			return values;
+		}
+
+		template <typename F>
+		std::vector<int64_t> inputColumn(F f) const {
+			return txColumn([&](const blocksci::Transaction &tx, std::vector<int64_t> &values) {
+				for (auto input : tx.inputs()) {
+					values.push_back(f(input));
+				}
+			});
+		}
+
+		template <typename F>
+		std::vector<int64_t> outputColumn(F f) const {
+			return txColumn([&](const blocksci::Transaction &tx, std::vector<int64_t> &values) {
+				for (auto output : tx.outputs()) {
+					values.push_back(f(output));
+				}
+			});
+		}
+
+		template <typename T>
+		static std::vector<int64_t> column(const blocksci::ColumnView<T> &view) {
+			return std::vector<int64_t>(view.begin(), view.end());
+		}
+
+		std::vector<int64_t> childCounts(VectorLevel child) {
+			auto &childOffsets = offsetsOf(VectorLevel::Tx, child);
+			std::vector<int64_t> counts;
+			counts.reserve(txCount);
+			for (size_t i = 0; i + 1 < childOffsets.size(); i++) {
+				counts.push_back(static_cast<int64_t>(childOffsets[i + 1] - childOffsets[i]));
+			}
+			return counts;
+		}
+
+		std::vector<int64_t> childPositions(VectorLevel child) {
+			auto &childOffsets = offsetsOf(VectorLevel::Tx, child);
+			std::vector<int64_t> positions;
+			positions.reserve(rowCount(child));
+			for (size_t i = 0; i + 1 < childOffsets.size(); i++) {
+				for (auto j = childOffsets[i]; j < childOffsets[i + 1]; j++) {
+					positions.push_back(static_cast<int64_t>(j - childOffsets[i]));
+				}
+			}
+			return positions;
+		}
+
+		std::vector<uint64_t> directOffsets(VectorLevel child) const {
+			std::vector<uint64_t> result{0};
+			switch (child) {
+				case VectorLevel::Block:
+					result.push_back(rawBlocks.size);
+					break;
+				case VectorLevel::Tx:
+					for (auto &block : rawBlocks) {
+						result.push_back(result.back() + block.txCount);
+					}
+					break;
+				case VectorLevel::Input:
+				case VectorLevel::Output: {
+					// The offsets of the following transaction are not part of the batch, the end is the total count
+					auto firsts = child == VectorLevel::Input ? blocks.txFirstInputNums() : blocks.txFirstOutputNums();
+					for (size_t i = 1; i < firsts.size; i++) {
+						result.push_back(firsts[i] - firsts[0]);
+					}
+					result.push_back(child == VectorLevel::Input ? inputCount : outputCount);
+					break;
+				}
+				default:
+					throw VectorFallback{};
+			}
+			return result;
+		}
+
+		std::vector<int64_t> loadField(VectorField field) {
+			using blocksci::RawBlock;
+			switch (field) {
+				case VectorField::BlockHeight:
+					return blockColumn([](const RawBlock &block) { return block.height; });
+				case VectorField::BlockTxCount:
+					return blockColumn([](const RawBlock &block) { return block.txCount; });
+				case VectorField::BlockInputCount:
+					return blockColumn([](const RawBlock &block) { return block.inputCount; });
+				case VectorField::BlockOutputCount:
+					return blockColumn([](const RawBlock &block) { return block.outputCount; });
+				case VectorField::BlockTimestamp:
+					return blockColumn([](const RawBlock &block) { return block.timestamp; });
+				case VectorField::BlockVersion:
+					return blockColumn([](const RawBlock &block) { return block.version; });
+				case VectorField::BlockBits:
+					return blockColumn([](const RawBlock &block) { return block.bits; });
+				case VectorField::BlockNonce:
+					return blockColumn([](const RawBlock &block) { return block.nonce; });
+				case VectorField::BlockBaseSize:
+					return blockColumn([](const RawBlock &block) { return block.baseSize; });
+				case VectorField::BlockTotalSize:
+					return blockColumn([](const RawBlock &block) { return block.realSize; });
+				case VectorField::TxIndex: {
+					std::vector<int64_t> values(txCount);
+					auto firstTx = rawBlocks.empty() ? 0 : rawBlocks[0].firstTxIndex;
+					for (size_t i = 0; i < values.size(); i++) {
+						values[i] = static_cast<int64_t>(firstTx + i);
+					}
+					return values;
+				}
+				case VectorField::TxInputCount:
+					return childCounts(VectorLevel::Input);
+				case VectorField::TxOutputCount:
+					return childCounts(VectorLevel::Output);
+				case VectorField::TxVersion:
+					return column(blocks.txVersions());
+				case VectorField::TxLocktime:
+					return txColumn([](const blocksci::Transaction &tx, std::vector<int64_t> &values) { values.push_back(tx.locktime()); });
+				case VectorField::TxBaseSize:
+					return txColumn([](const blocksci::Transaction &tx, std::vector<int64_t> &values) { values.push_back(tx.baseSize()); });
+				case VectorField::TxTotalSize:
+					return txColumn([](const blocksci::Transaction &tx, std::vector<int64_t> &values) { values.push_back(tx.totalSize()); });
+				case VectorField::InputValue:
+					if (inoutColumns) {
+						return column(blocks.inputValues());
+					}
+					return inputColumn([](const blocksci::Input &input) { return input.getValue(); });
+				case VectorField::InputAddressType:
+					if (inoutColumns) {
+						return column(blocks.inputTypes());
+					}
+					return inputColumn([](const blocksci::Input &input) { return static_cast<int64_t>(input.getType()); });
+				case VectorField::InputSequenceNum:
+					return column(blocks.inputSequenceNums());
+				case VectorField::InputSpentTxIndex:
+					if (inoutColumns) {
+						return column(blocks.inputSpentTxNums());
+					}
+					return inputColumn([](const blocksci::Input &input) { return input.spentTxIndex(); });
+				case VectorField::InputIndex:
+					return childPositions(VectorLevel::Input);
+				case VectorField::OutputValue:
+					if (inoutColumns) {
+						return column(blocks.outputValues());
+					}
+					return outputColumn([](const blocksci::Output &output) { return output.getValue(); });
+				case VectorField::OutputAddressType:
+					if (inoutColumns) {
+						return column(blocks.outputTypes());
+					}
+					return outputColumn([](const blocksci::Output &output) { return static_cast<int64_t>(output.getType()); });
+				case VectorField::OutputIsSpent:
+					// Spends by transactions past the loaded chain do not count, so the spending column is not used
+					return outputColumn([](const blocksci::Output &output) { return output.isSpent(); });
+				case VectorField::OutputIndex:
+					return childPositions(VectorLevel::Output);
+			}
+			throw VectorFallback{};
+		}
+
+	public:
+		explicit VectorBatch(const blocksci::BlockRange &blocks_) : blocks(blocks_), rawBlocks(blocks.rawBlocks()), inoutColumns(blocks.hasInoutColumns()) {
+			for (auto &block : rawBlocks) {
+				txCount += block.txCount;
+				inputCount += block.inputCount;
+				outputCount += block.outputCount;
+			}
+		}
+
+		uint64_t rowCount(VectorLevel level) const {
+			switch (level) {
+				case VectorLevel::Range:
+					return 1;
+				case VectorLevel::Block:
+					return rawBlocks.size;
+				case VectorLevel::Tx:
+					return txCount;
+				case VectorLevel::Input:
+					return inputCount;
+				case VectorLevel::Output:
+					return outputCount;
+				default:
+					throw VectorFallback{};
+			}
+		}
+
+		const std::vector<int64_t> &fieldValues(VectorField field) {
+			auto it = fields.find(field);
+			if (it == fields.end()) {
+				it = fields.emplace(field, loadField(field)).first;
+			}
+			return it->second;
+		}
+
+		// Position of the first row of child below each row of parent, followed by the number of rows of child
+		const std::vector<uint64_t> &offsetsOf(VectorLevel parent, VectorLevel child) {
+			auto key = std::make_pair(parent, child);
+			auto it = offsets.find(key);
+			if (it != offsets.end()) {
+				return it->second;
+			}
+			auto upper = parentLevel(child);
+			if (upper == VectorLevel::None) {
+				throw VectorFallback{};
+			}
+			std::vector<uint64_t> result;
+			if (upper == parent) {
+				result = directOffsets(child);
+			} else {
+				auto &outer = offsetsOf(parent, upper);
+				auto &inner = offsetsOf(upper, child);
+				result.reserve(outer.size());
+				for (auto offset : outer) {
+					result.push_back(inner[offset]);
+				}
+			}
+			return offsets.emplace(key, std::move(result)).first->second;
+		}
+
+		std::vector<int64_t> evaluate(const VectorNode &node, VectorLevel level) {
+			switch (node.kind) {
+				case VectorNode::Kind::Constant:
+					return std::vector<int64_t>(rowCount(level), node.constant);
+				case VectorNode::Kind::Field:
+					if (fieldLevel(node.field) != level) {
+						throw VectorFallback{};
+					}
+					return fieldValues(node.field);
+				case VectorNode::Kind::Unary: {
+					auto values = evaluate(*node.lhs, level);
+					for (auto &value : values) {
+						value = value == 0;
+					}
+					return values;
+				}
+				case VectorNode::Kind::Binary: {
+					auto values = evaluate(*node.lhs, level);
+					applyBinary(node.op, values, evaluate(*node.rhs, level));
+					return values;
+				}
+				case VectorNode::Kind::Broadcast: {
+					auto values = evaluate(*node.lhs, node.level);
+					auto &childOffsets = offsetsOf(node.level, level);
+					std::vector<int64_t> result;
+					result.reserve(rowCount(level));
+					for (size_t i = 0; i < values.size(); i++) {
+						result.insert(result.end(), childOffsets[i + 1] - childOffsets[i], values[i]);
+					}
+					return result;
+				}
+				case VectorNode::Kind::Reduce: {
+					std::vector<int64_t> values;
+					std::vector<int64_t> mask;
+					if (node.lhs) {
+						values = evaluate(*node.lhs, node.level);
+					}
+					if (node.rhs) {
+						mask = evaluate(*node.rhs, node.level);
+					}
+					auto &childOffsets = offsetsOf(level, node.level);
+					std::vector<int64_t> result;
+					result.reserve(rowCount(level));
+					for (size_t i = 0; i + 1 < childOffsets.size(); i++) {
+						result.push_back(finishPartial(node.op, reduceSegment(node.op, values, mask, childOffsets[i], childOffsets[i + 1])));
+					}
+					return result;
+				}
+				case VectorNode::Kind::Self:
+					break;
+			}
+			throw VectorFallback{};
+		}
+
+		// Reduction over all rows of the batch, which is combined with the other batches of the range
+		VectorPartial reduce(const VectorNode &node) {
+			std::vector<int64_t> values;
+			std::vector<int64_t> mask;
+			if (node.lhs) {
+				values = evaluate(*node.lhs, node.level);
+			}
+			if (node.rhs) {
+				mask = evaluate(*node.rhs, node.level);
+			}
+			return reduceSegment(node.op, values, mask, 0, rowCount(node.level));
+		}
+
+		void appendSequence(const VectorPlan &plan, std::vector<int64_t> &out) {
+			std::vector<int64_t> values;
+			if (plan.value) {
+				values = evaluate(*plan.value, plan.elementLevel);
+			} else if (plan.elementLevel == VectorLevel::Block) {
+				values = fieldValues(VectorField::BlockHeight);
+			} else if (plan.elementLevel == VectorLevel::Tx) {
+				values = fieldValues(VectorField::TxIndex);
+			} else {
+				throw VectorFallback{};
+			}
+			if (plan.mask) {
+				auto mask = evaluate(*plan.mask, plan.elementLevel);
+				for (size_t i = 0; i < values.size(); i++) {
+					if (mask[i] != 0) {
+						out.push_back(values[i]);
+					}
+				}
+			} else {
+				out.insert(out.end(), values.begin(), values.end());
+			}
+		}
+	};
+
+	template <typename F>
+	void forEachBatch(const blocksci::BlockRange &blocks, F f) {
+		auto rawBlocks = blocks.rawBlocks();
+		size_t end = 0;
+		while (end < rawBlocks.size) {
+			auto begin = end;
+			uint64_t rows = 0;
+			do {
+				rows += uint64_t{rawBlocks[end].txCount} + rawBlocks[end].inputCount + rawBlocks[end].outputCount;
+				end++;
+			} while (end < rawBlocks.size && rows < vectorBatchRows);
+			VectorBatch batch{blocks[{static_cast<blocksci::BlockHeight>(begin), static_cast<blocksci::BlockHeight>(end)}]};
+			f(batch);
+		}
+	}
+
+	void collectReductions(const VectorNode &node, std::vector<const VectorNode *> &reductions) {
+		switch (node.kind) {
+			case VectorNode::Kind::Unary:
+				collectReductions(*node.lhs, reductions);
+				break;
+			case VectorNode::Kind::Binary:
+				collectReductions(*node.lhs, reductions);
+				collectReductions(*node.rhs, reductions);
+				break;
+			case VectorNode::Kind::Reduce:
+				reductions.push_back(&node);
+				break;
+			default:
+				break;
+		}
+	}
+
+	// Evaluates the value of a plan at the Range level from the reductions accumulated over all batches
+	int64_t evaluateRange(const VectorNode &node, const std::vector<const VectorNode *> &reductions, const std::vector<VectorPartial> &totals) {
+		switch (node.kind) {
+			case VectorNode::Kind::Constant:
+				return node.constant;
+			case VectorNode::Kind::Unary:
+				return evaluateRange(*node.lhs, reductions, totals) == 0;
+			case VectorNode::Kind::Binary:
+				return applyBinary(node.op, evaluateRange(*node.lhs, reductions, totals), evaluateRange(*node.rhs, reductions, totals));
+			case VectorNode::Kind::Reduce: {
+				auto position = std::find(reductions.begin(), reductions.end(), &node) - reductions.begin();
+				return finishPartial(node.op, totals[static_cast<size_t>(position)]);
+			}
+			default:
+				throw VectorFallback{};
+		}
+	}
+}
+
+void setVectorizedExecution(bool enabled) {
+	vectorizedEnabled = enabled;
+}
+
+bool vectorizedExecution() {
+	return vectorizedEnabled;
+}
+
+uint64_t vectorizedExecutionCount() {
+	return vectorizedCount;
+}
+
+void countVectorizedExecution() {
+	vectorizedCount++;
+}
+
+VectorPlanPtr vectorIdentityPlan(VectorLevel level) {
+	switch (level) {
+		case VectorLevel::None:
+		case VectorLevel::Any:
+		case VectorLevel::Range:
+			return nullptr;
+		case VectorLevel::Value:
+			return simplePlan(level, selfNode());
+		default:
+			return simplePlan(level, nullptr);
+	}
+}
+
+VectorPlanPtr vectorRangePlan(VectorLevel level) {
+	if (level != VectorLevel::Block) {
+		return nullptr;
+	}
+	return sequencePlan(VectorLevel::Range, level, nullptr, nullptr);
+}
+
+VectorPlanPtr vectorConstantPlan(int64_t value) {
+	return simplePlan(VectorLevel::Any, constantNode(value));
+}
+
+VectorPlanPtr vectorPropertyPlan(VectorLevel level, const std::string &name) {
+	static const std::map<VectorLevel, PropertyPlans> plans = {
+		{VectorLevel::Block, blockPropertyPlans()},
+		{VectorLevel::Tx, txPropertyPlans()},
+		{VectorLevel::Input, inputPropertyPlans()},
+		{VectorLevel::Output, outputPropertyPlans()}
+	};
+	auto levelIt = plans.find(level);
+	if (levelIt == plans.end()) {
+		return nullptr;
+	}
+	auto it = levelIt->second.find(name);
+	return it != levelIt->second.end() ? it->second : nullptr;
+}
+
+VectorPlanPtr applyVectorProperty(const VectorPlanPtr &plan, const VectorPlanPtr &property) {
+	if (!plan || !property || plan->sequence || plan->value || plan->source != property->source) {
+		return nullptr;
+	}
+	return property;
+}
+
+VectorPlanPtr combineVectorPlans(VectorOp op, const VectorPlanPtr &plan1, const VectorPlanPtr &plan2) {
+	if (!plan1 || !plan2 || plan1->sequence || plan2->sequence || !plan1->value || !plan2->value) {
+		return nullptr;
+	}
+	auto source = plan1->source == VectorLevel::Any ? plan2->source : plan1->source;
+	if (plan2->source != VectorLevel::Any && plan2->source != source) {
+		return nullptr;
+	}
+	return simplePlan(source, binaryNode(op, plan1->value, plan2->value));
+}
+
+VectorPlanPtr invertVectorPlan(const VectorPlanPtr &plan) {
+	if (!plan || plan->sequence || !plan->value) {
+		return nullptr;
+	}
+	return simplePlan(plan->source, unaryNode(VectorOp::Not, plan->value));
+}
+
+VectorPlanPtr mapVectorPlan(const VectorPlanPtr &sequence, const VectorPlanPtr &func) {
+	if (!sequence || !func || !sequence->sequence || !fitsElements(*sequence, *func)) {
+		return nullptr;
+	}
+	if (!func->value) {
+		return sequence;
+	}
+	return sequencePlan(sequence->source, sequence->elementLevel, elementValue(*sequence, func->value), sequence->mask);
+}
+
+VectorPlanPtr mapSequenceVectorPlan(const VectorPlanPtr &sequence, const VectorPlanPtr &func) {
+	if (!sequence || !func || !sequence->sequence || sequence->value || !func->sequence || func->source != sequence->elementLevel) {
+		return nullptr;
+	}
+	auto mask = sequence->mask ? broadcastNode(sequence->elementLevel, sequence->mask) : nullptr;
+	return sequencePlan(sequence->source, func->elementLevel, func->value, andMasks(mask, func->mask));
+}
+
+VectorPlanPtr filterVectorPlan(const VectorPlanPtr &sequence, const VectorPlanPtr &predicate) {
+	if (!sequence || !predicate || !sequence->sequence || !predicate->value || !fitsElements(*sequence, *predicate)) {
+		return nullptr;
+	}
+	auto mask = andMasks(sequence->mask, elementValue(*sequence, predicate->value));
+	return sequencePlan(sequence->source, sequence->elementLevel, sequence->value, std::move(mask));
+}
+
+VectorPlanPtr reduceVectorPlan(VectorOp op, const VectorPlanPtr &sequence, const VectorPlanPtr &predicate) {
+	if (!sequence || !sequence->sequence) {
+		return nullptr;
+	}
+	VectorNodePtr values;
+	if (op == VectorOp::Any || op == VectorOp::All) {
+		if (!predicate || !predicate->value || !fitsElements(*sequence, *predicate)) {
+			return nullptr;
+		}
+		values = elementValue(*sequence, predicate->value);
+	} else if (op != VectorOp::Count) {
+		if (!sequence->value) {
+			return nullptr;
+		}
+		values = sequence->value;
+	}
+	return simplePlan(sequence->source, reduceNode(op, sequence->elementLevel, std::move(values), sequence->mask));
+}
+
+ranges::optional<VectorResult> executeVectorPlan(const VectorPlan &plan, std::any &val) {
+	if (plan.source != VectorLevel::Range) {
+		return ranges::nullopt;
+	}
+	if (plan.sequence && !plan.value && !plan.mask) {
+		// The proxy function produces the same items lazily without holding all of them in memory
+		return ranges::nullopt;
+	}
+	if (!plan.sequence && !plan.value) {
+		return ranges::nullopt;
+	}
+	auto blocks = contiguousBlockRange(val);
+	if (!blocks) {
+		return ranges::nullopt;
+	}
+	try {
+		VectorResult result;
+		result.sequence = plan.sequence;
+		result.access = &blocks->getAccess();
+		if (plan.sequence) {
+			forEachBatch(*blocks, [&](VectorBatch &batch) {
+				batch.appendSequence(plan, result.values);
+			});
+		} else {
+			std::vector<const VectorNode *> reductions;
+			collectReductions(*plan.value, reductions);
+			std::vector<VectorPartial> totals(reductions.size());
+			forEachBatch(*blocks, [&](VectorBatch &batch) {
+				for (size_t i = 0; i < reductions.size(); i++) {
+					auto partial = batch.reduce(*reductions[i]);
+					if (!partial.empty) {
+						accumulate(reductions[i]->op, totals[i], partial.value);
+					}
+				}
+			});
+			result.values.push_back(evaluateRange(*plan.value, reductions, totals));
+		}
+		return result;
+	} catch (const VectorFallback &) {
+		return ranges::nullopt;
+	}
+}
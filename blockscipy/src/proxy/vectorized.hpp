@@ -0,0 +1,277 @@
+//
+//  vectorized.hpp
+//  blocksci
+//
+
+#ifndef proxy_vectorized_hpp
+#define proxy_vectorized_hpp
+
+#include "python_fwd.hpp"
+#include "generic_proxy.hpp"
+
+#include <blocksci/chain/block.hpp>
+#include <blocksci/chain/transaction.hpp>
+#include <blocksci/core/address_types.hpp>
+
+#include <range/v3/utility/optional.hpp>
+#include <range/v3/view/iota.hpp>
+#include <range/v3/view/transform.hpp>
+
+#include <any>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/** Levels of the chain that vectorized plans operate on
+ *
+ * Range is the block range that a plan is applied to. Any is the level of constants, which fit every level, and Value
+ * is the level of the nested proxy of an int or bool sequence, which refers to the values of the sequence.
+ */
+enum class VectorLevel : uint8_t {
+	None, Any, Value, Range, Block, Tx, Input, Output
+};
+
+/** Columns that vectorized plans read, each one belongs to a single level */
+enum class VectorField : uint8_t {
+	BlockHeight, BlockTxCount, BlockInputCount, BlockOutputCount, BlockTimestamp, BlockVersion, BlockBits, BlockNonce,
+	BlockBaseSize, BlockTotalSize,
+	TxIndex, TxInputCount, TxOutputCount, TxVersion, TxLocktime, TxBaseSize, TxTotalSize,
+	InputValue, InputAddressType, InputSequenceNum, InputSpentTxIndex, InputIndex,
+	OutputValue, OutputAddressType, OutputIsSpent, OutputIndex
+};
+
+enum class VectorOp : uint8_t {
+	Add, Sub, Mul, Div, Mod, Eq, Ne, Lt, Le, Gt, Ge, And, Or, Not,
+	Sum, Min, Max, Count, Any, All
+};
+
+struct VectorNode;
+using VectorNodePtr = std::shared_ptr<const VectorNode>;
+
+/** Node of a vectorized expression, which produces one value for every row of the level it is evaluated at
+ *
+ * Bool values are stored as 0 and 1 and address types as their numeric value.
+ */
+struct VectorNode {
+	enum class Kind : uint8_t {
+		Self, Constant, Field, Unary, Binary, Broadcast, Reduce
+	};
+
+	Kind kind;
+	VectorOp op = VectorOp::Add;
+	VectorField field = VectorField::BlockHeight;
+	int64_t constant = 0;
+	// Broadcast: level of the argument, Reduce: level of the reduced elements
+	VectorLevel level = VectorLevel::None;
+	// Argument, left operand or reduced values (null when counting)
+	VectorNodePtr lhs;
+	// Right operand or mask of the reduced elements (null keeps all elements)
+	VectorNodePtr rhs;
+};
+
+/** Vectorized form of a proxy
+ *
+ * Proxies that are built only from supported properties and operators carry a plan next to their function. A simple
+ * plan computes value for every item of the source level, or is the item itself if value is null. A sequence plan
+ * produces the items of elementLevel below each source item that pass mask, mapped to value or the items themselves
+ * if value is null. Plans with the source level Range are executed column-at-a-time over contiguous block ranges
+ * instead of calling the function once per item.
+ */
+struct VectorPlan {
+	VectorLevel source = VectorLevel::None;
+	bool sequence = false;
+	VectorLevel elementLevel = VectorLevel::None;
+	VectorNodePtr value;
+	VectorNodePtr mask;
+};
+
+using VectorPlanPtr = std::shared_ptr<const VectorPlan>;
+
+/** Result of executing a plan, holding one value for scalar plans and the kept rows for sequence plans */
+struct VectorResult {
+	bool sequence = false;
+	std::vector<int64_t> values;
+	blocksci::DataAccess *access = nullptr;
+};
+
+template <typename T>
+struct VectorLevelOf {
+	static constexpr VectorLevel level = VectorLevel::None;
+};
+
+template <>
+struct VectorLevelOf<blocksci::Block> {
+	static constexpr VectorLevel level = VectorLevel::Block;
+};
+
+template <>
+struct VectorLevelOf<blocksci::Transaction> {
+	static constexpr VectorLevel level = VectorLevel::Tx;
+};
+
+template <>
+struct VectorLevelOf<blocksci::Input> {
+	static constexpr VectorLevel level = VectorLevel::Input;
+};
+
+template <>
+struct VectorLevelOf<blocksci::Output> {
+	static constexpr VectorLevel level = VectorLevel::Output;
+};
+
+template <>
+struct VectorLevelOf<int64_t> {
+	static constexpr VectorLevel level = VectorLevel::Value;
+};
+
+template <>
+struct VectorLevelOf<bool> {
+	static constexpr VectorLevel level = VectorLevel::Value;
+};
+
+template <>
+struct VectorLevelOf<blocksci::AddressType::Enum> {
+	static constexpr VectorLevel level = VectorLevel::Value;
+};
+
+void setVectorizedExecution(bool enabled);
+bool vectorizedExecution();
+/** Number of proxy calls that were answered by the column-at-a-time execution */
+uint64_t vectorizedExecutionCount();
+void countVectorizedExecution();
+
+/** Plan of the nested proxy of a sequence of items of the given level */
+VectorPlanPtr vectorIdentityPlan(VectorLevel level);
+/** Plan of the proxy of a block range, other ranges have no plan */
+VectorPlanPtr vectorRangePlan(VectorLevel level);
+VectorPlanPtr vectorConstantPlan(int64_t value);
+/** Plan of the property with the given name of an item of the given level, null if the property is not supported */
+VectorPlanPtr vectorPropertyPlan(VectorLevel level, const std::string &name);
+
+VectorPlanPtr applyVectorProperty(const VectorPlanPtr &plan, const VectorPlanPtr &property);
+VectorPlanPtr combineVectorPlans(VectorOp op, const VectorPlanPtr &plan1, const VectorPlanPtr &plan2);
+VectorPlanPtr invertVectorPlan(const VectorPlanPtr &plan);
+VectorPlanPtr mapVectorPlan(const VectorPlanPtr &sequence, const VectorPlanPtr &func);
+VectorPlanPtr mapSequenceVectorPlan(const VectorPlanPtr &sequence, const VectorPlanPtr &func);
+VectorPlanPtr filterVectorPlan(const VectorPlanPtr &sequence, const VectorPlanPtr &predicate);
+VectorPlanPtr reduceVectorPlan(VectorOp op, const VectorPlanPtr &sequence, const VectorPlanPtr &predicate = nullptr);
+
+/** Executes a plan with the source level Range over the blocks held by val
+ *
+ * Returns nullopt if val is not a contiguous range of blocks or the plan cannot be executed, for example because a
+ * minimum is taken over an empty sequence. The caller then falls back to the proxy function.
+ */
+ranges::optional<VectorResult> executeVectorPlan(const VectorPlan &plan, std::any &val);
+
+template <typename T>
+VectorPlanPtr vectorIdentityPlanOf() {
+	return vectorIdentityPlan(VectorLevelOf<T>::level);
+}
+
+template <typename T>
+VectorPlanPtr vectorConstantPlanOf(const T &value) {
+	if constexpr (VectorLevelOf<T>::level == VectorLevel::Value) {
+		return vectorConstantPlan(static_cast<int64_t>(value));
+	} else {
+		return nullptr;
+	}
+}
+
+template <typename P>
+P withVectorPlan(P proxy, VectorPlanPtr plan) {
+	proxy.vectorPlan = std::move(plan);
+	return proxy;
+}
+
+template <typename T>
+struct VectorElement {
+	static constexpr bool supported = VectorLevelOf<T>::level == VectorLevel::Value;
+
+	static T convert(int64_t value, blocksci::DataAccess *) {
+		return static_cast<T>(value);
+	}
+};
+
+template <>
+struct VectorElement<bool> {
+	static constexpr bool supported = true;
+
+	static bool convert(int64_t value, blocksci::DataAccess *) {
+		return value != 0;
+	}
+};
+
+template <>
+struct VectorElement<blocksci::Block> {
+	static constexpr bool supported = true;
+
+	static blocksci::Block convert(int64_t height, blocksci::DataAccess *access) {
+		return {static_cast<blocksci::BlockHeight>(height), *access};
+	}
+};
+
+template <>
+struct VectorElement<blocksci::Transaction> {
+	static constexpr bool supported = true;
+
+	static blocksci::Transaction convert(int64_t txNum, blocksci::DataAccess *access) {
+		return {static_cast<uint32_t>(txNum), *access};
+	}
+};
+
+template <typename T>
+struct VectorOutput {
+	static constexpr bool supported = VectorElement<T>::supported;
+	static constexpr bool sequence = false;
+
+	static T convert(VectorResult &&result) {
+		return VectorElement<T>::convert(result.values.front(), result.access);
+	}
+};
+
+template <typename T, typename Sequence>
+Sequence vectorSequenceOutput(VectorResult &&result) {
+	auto values = std::make_shared<std::vector<int64_t>>(std::move(result.values));
+	return ranges::views::transform(ranges::views::iota(size_t{0}, values->size()), [values, access = result.access](size_t i) -> T {
+		return VectorElement<T>::convert((*values)[i], access);
+	});
+}
+
+template <typename T>
+struct VectorOutput<RawRange<T>> {
+	static constexpr bool supported = VectorElement<T>::supported;
+	static constexpr bool sequence = true;
+
+	static RawRange<T> convert(VectorResult &&result) {
+		return vectorSequenceOutput<T, RawRange<T>>(std::move(result));
+	}
+};
+
+template <typename T>
+struct VectorOutput<RawIterator<T>> {
+	static constexpr bool supported = VectorElement<T>::supported;
+	static constexpr bool sequence = true;
+
+	static RawIterator<T> convert(VectorResult &&result) {
+		return vectorSequenceOutput<T, RawIterator<T>>(std::move(result));
+	}
+};
+
+/** Output of the proxy for val computed by its vectorized plan, nullopt if the proxy has to be called instead */
+template <typename T>
+ranges::optional<T> evaluateVectorized(const GenericProxy &p, std::any &val) {
+	if constexpr (VectorOutput<T>::supported) {
+		if (p.vectorPlan && vectorizedExecution()) {
+			auto result = executeVectorPlan(*p.vectorPlan, val);
+			if (result && result->sequence == VectorOutput<T>::sequence) {
+				countVectorizedExecution();
+				return VectorOutput<T>::convert(std::move(*result));
+			}
+		}
+	}
+	return ranges::nullopt;
+}
+
+#endif /* proxy_vectorized_hpp */
@@ -12,6 +12,8 @@
 #include "func_converter.hpp"
 #include "method_tags.hpp"
 #include "blocksci_type_converter.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 #include <pybind11/pybind11.h>
 
@@ -34,11 +36,15 @@ template <typename P, typename Out, typename R, typename... Args>
 struct ApplyMethodsToProxyFuncConverter {
     using Func = std::function<R(Out &, Args...)>;
     Func func;
+    // Vectorized form of properties, null for methods and properties without one
+    VectorPlanPtr propertyPlan;
 
-    ApplyMethodsToProxyFuncConverter(Func func_ ) : func(func_) {}
+    ApplyMethodsToProxyFuncConverter(Func func_, VectorPlanPtr propertyPlan_ = nullptr) : func(func_), propertyPlan(std::move(propertyPlan_)) {}
 
     auto operator()(P &p, const Args & ...args) const -> decltype(lift(p, proxy_apply_converter_t<P, Out, R>{std::bind(func, std::placeholders::_1, args...)})) {
-    	return lift(p, proxy_apply_converter_t<P, Out, R>{std::bind(func, std::placeholders::_1, args...)});
+    	auto result = lift(p, proxy_apply_converter_t<P, Out, R>{std::bind(func, std::placeholders::_1, args...)});
+    	result.vectorPlan = applyVectorProperty(p.vectorPlan, propertyPlan);
+    	return withThreadSafety(std::move(result), p.threadSafe && std::conjunction_v<ThreadSafeValue<std::decay_t<R>>, ThreadSafeValue<std::decay_t<Args>>...>);
     }
 };
 
@@ -47,10 +53,11 @@ struct ApplyGenericMethodsToProxyFuncConverter {
     using Func = std::function<R(Out &, Args...)>;
     Func func;
 
-    ApplyGenericMethodsToProxyFuncConverter(Func func_ ) : func(func_) {}
+    ApplyGenericMethodsToProxyFuncConverter(Func func_, VectorPlanPtr = nullptr) : func(func_) {}
 
     auto operator()(P &p, const Args & ...args) const -> decltype(liftGeneric(p, proxy_apply_converter_t<P, Out, R>{std::bind(func, std::placeholders::_1, args...)})) {
-        return liftGeneric(p, proxy_apply_converter_t<P, Out, R>{std::bind(func, std::placeholders::_1, args...)});
+        auto result = liftGeneric(p, proxy_apply_converter_t<P, Out, R>{std::bind(func, std::placeholders::_1, args...)});
+        return withThreadSafety(std::move(result), p.threadSafe && std::conjunction_v<ThreadSafeValue<std::decay_t<R>>, ThreadSafeValue<std::decay_t<Args>>...>);
     }
 };
 
@@ -68,7 +75,7 @@ struct ApplyMethodsToProxyImpl {
     template <typename result_type>
     void applyProperty(const std::string &propertyName, std::function<result_type(Out &)> func, const std::string &description) {
         using converted_t = Converter<P, Out, result_type>;
-        converted_t convertedFunc{func};
+        converted_t convertedFunc{func, vectorPropertyPlan(VectorLevelOf<Out>::level, propertyName)};
         applyPropertyImpl(propertyName, pybind11::cpp_function(std::move(convertedFunc), pybind11::return_value_policy::reference_internal), strdup(description.c_str()));
     }
 
@@ -15,7 +15,7 @@ using namespace blocksci;
 using namespace blocksci::script;
 
 Proxy<AnyScript> SimpleProxyCreator<AnyScript>::operator()() const {
-	return {std::function<AnyScript(std::any &)>{[](std::any &t) -> AnyScript {
+	Proxy<AnyScript> p{std::function<AnyScript(std::any &)>{[](std::any &t) -> AnyScript {
 		const std::type_info &o = t.type();
 		if (o == typeid(Pubkey)) {
 			return std::any_cast<Pubkey>(t);
@@ -45,4 +45,5 @@ Proxy<AnyScript> SimpleProxyCreator<AnyScript>::operator()() const {
 			throw std::runtime_error(ss.str());
 		}
 	}}, createProxyTypeInfo<AnyScript>()};
+	return withThreadSafety(std::move(p), true);
 }
\ No newline at end of file
@@ -9,15 +9,18 @@
 #define proxy_create_hpp
 
 #include "proxy.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 #include <blocksci/scripts/scripts_fwd.hpp>
 
 template <typename T>
 struct SimpleProxyCreator {
 	Proxy<T> operator()() const {
-		return {std::function<T(std::any &)>{[](std::any &t) -> T {
+		Proxy<T> p{std::function<T(std::any &)>{[](std::any &t) -> T {
 			return std::any_cast<T>(t);
 		}}, createProxyTypeInfo<T>()};
+		return withThreadSafety(withVectorPlan(std::move(p), vectorIdentityPlanOf<T>()), true);
 	}
 };
 
@@ -33,7 +36,7 @@ Proxy<T> makeSimpleProxy() {
 
 template<typename T>
 Proxy<ranges::optional<T>> makeOptionalProxy() {
-	return {std::function<ranges::optional<T>(std::any &)>{[](std::any &t) -> ranges::optional<T> {
+	Proxy<ranges::optional<T>> p{std::function<ranges::optional<T>(std::any &)>{[](std::any &t) -> ranges::optional<T> {
 		const std::type_info &o = t.type();
 		if (o == typeid(T)) {
 			return std::any_cast<T>(t);
@@ -43,28 +46,31 @@ Proxy<ranges::optional<T>> makeOptionalProxy() {
 			throw std::runtime_error("Proxy type error");
 		}
 	}}, createProxyTypeInfo<ranges::optional<T>>()};
+	return withThreadSafety(std::move(p), true);
 }
 
 template<typename T>
 Proxy<RawIterator<T>> makeIteratorProxy() {
-	return {std::function<RawIterator<T>(std::any &)>{[](std::any &t) -> RawIterator<T> {
+	Proxy<RawIterator<T>> p{std::function<RawIterator<T>(std::any &)>{[](std::any &t) -> RawIterator<T> {
 		RawIterator<BlocksciType> *rawIt = std::any_cast<RawIterator<BlocksciType>>(&t);
 		if (rawIt != nullptr) {
 			return ranges::views::transform(*rawIt, [](BlocksciType && r) -> T { return mpark::get<T>(r.var); });
 		}
 		return std::any_cast<RawIterator<T>>(t);
 	}}, createProxyTypeInfo<RawIterator<T>>()};
+	return withThreadSafety(withVectorPlan(std::move(p), vectorRangePlan(VectorLevelOf<T>::level)), true);
 }
 
 template<typename T>
 Proxy<RawRange<T>> makeRangeProxy() {
-	return {std::function<RawRange<T>(std::any &)>{[](std::any &t) -> RawRange<T> {
+	Proxy<RawRange<T>> p{std::function<RawRange<T>(std::any &)>{[](std::any &t) -> RawRange<T> {
 		RawRange<BlocksciType> *rawIt = std::any_cast<RawRange<BlocksciType>>(&t);
 		if (rawIt != nullptr) {
 			return ranges::views::transform(*rawIt, [](BlocksciType && r) -> T { return mpark::get<T>(r.var); });
 		}
 		return std::any_cast<RawRange<T>>(t);
 	}}, createProxyTypeInfo<RawRange<T>>()};
+	return withThreadSafety(withVectorPlan(std::move(p), vectorRangePlan(VectorLevelOf<T>::level)), true);
 }
 
 #endif /* proxy_create_hpp */
@@ -11,6 +11,8 @@
 #include "proxy.hpp"
 #include "proxy_type_check.hpp"
 #include "method_types.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 
 #include <range/v3/view/empty.hpp>
 #include <range/v3/view/single.hpp>
@@ -34,9 +36,10 @@ AllProxyClasses<T, SimpleBase> createProxyClasses(pybind11::module &m) {
     pybind11::class_<Proxy<RawRange<T>>, RangeProxy, SequenceProxy<T>> range(m, strdup(proxyName<Range<T>>().c_str()), pybind11::dynamic_attr());
 
     base.def(pybind11::init([](const T &val) -> Proxy<T> {
-        return {std::function<T(std::any &)>{[val](std::any &) -> T {
+        Proxy<T> p{std::function<T(std::any &)>{[val](std::any &) -> T {
             return val;
         }}, {nullptr, nullptr, ProxyType::Simple}};
+        return withThreadSafety(withVectorPlan(std::move(p), vectorConstantPlanOf(val)), true);
     }));
 
     iterator
@@ -46,9 +49,10 @@ AllProxyClasses<T, SimpleBase> createProxyClasses(pybind11::module &m) {
         }}, {nullptr, nullptr, ProxyType::Simple}};
     }))
     .def(pybind11::init([](const Proxy<RawRange<T>> &p) -> Proxy<RawIterator<T>> {
-        return {std::function<RawIterator<T>(std::any &)>{[p](std::any & v) -> RawIterator<T> {
+        Proxy<RawIterator<T>> converted{std::function<RawIterator<T>(std::any &)>{[p](std::any & v) -> RawIterator<T> {
             return p(v);
         }}, p.sourceType};
+        return withThreadSafety(withVectorPlan(std::move(converted), p.vectorPlan), p.threadSafe);
     }))
     ;
 
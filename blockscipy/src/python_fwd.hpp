@@ -69,6 +69,8 @@ struct GenericAddressRange;
 
 struct TypenameLookup;
 
+struct VectorPlan;
+
 
 template <typename T, typename SimpleBase = SimpleProxy>
 struct AllProxyClasses;
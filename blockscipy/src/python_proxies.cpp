@@ -10,6 +10,8 @@
 #include "proxy.hpp"
 #include "caster_py.hpp"
 #include "proxy/proxy_functions.hpp"
+#include "proxy/vectorized.hpp"
+#include "proxy/parallel.hpp"
 #include "generic_proxy/range.hpp"
 #include "generic_proxy/optional.hpp"
 #include "method_types.hpp"
@@ -43,6 +45,23 @@ void setupProxies(py::module &m) {
     })
     ;
 
+    proxyMod
+    .def("set_vectorized_execution", setVectorizedExecution, py::arg("enabled"),
+        "Enable or disable the column-at-a-time execution of proxies applied to contiguous block ranges. "
+        "Proxies built only from supported properties and operators are evaluated over batches of blocks "
+        "instead of once per item, others always call the proxy function. Enabled by default.")
+    .def("vectorized_execution", vectorizedExecution, "Returns whether the column-at-a-time execution of proxies is enabled")
+    .def("vectorized_execution_count", vectorizedExecutionCount,
+        "Returns how many proxy calls were evaluated column-at-a-time so far, which shows whether a query used the vectorized execution")
+    .def("set_parallel_execution", setParallelExecution, py::arg("enabled"),
+        "Enable or disable the parallel execution of proxies applied to contiguous block ranges. map, where and group_by "
+        "over such ranges split the blocks into segments that are evaluated on all cores without holding the GIL, as long "
+        "as the proxies do not touch Python objects. Results keep the order of the blocks. Enabled by default.")
+    .def("parallel_execution", parallelExecution, "Returns whether the parallel execution of proxies is enabled")
+    .def("parallel_execution_count", parallelExecutionCount,
+        "Returns how many proxy calls were evaluated on several threads so far, which shows whether a query used the parallel execution")
+    ;
+
     py::class_<GenericProxy> proxyCl(proxyMod, "Proxy");
 
     py::class_<IteratorProxy, GenericProxy> proxyIteratorCl(proxyMod, "IteratorProxy");
@@ -21,6 +21,7 @@
 #include <range/v3/utility/optional.hpp>
 
 #include <functional>
+#include <string>
 #include <unordered_set>
 #include <vector>
 
@@ -115,6 +116,27 @@ namespace blocksci {
     
     std::vector<Address> BLOCKSCI_EXPORT getAddressesWithPrefix(const std::string &prefix, DataAccess &access);
     
+    /** Address strings of many addresses, encoded on several threads
+     *
+     * Address types without an address string (eg. multisig or nulldata) result in an empty string.
+     * Throws std::out_of_range if an address number does not exist.
+     */
+    std::vector<std::string> BLOCKSCI_EXPORT getAddressStrings(const std::vector<RawAddress> &addresses, DataAccess &access);
+    
+    /** Addresses of many address strings, decoded and looked up on several threads
+     *
+     * Unlike getAddressFromString, invalid strings result in nullopt instead of an exception.
+     */
+    std::vector<ranges::optional<Address>> BLOCKSCI_EXPORT getAddressesFromStrings(const std::vector<std::string> &addressStrings, DataAccess &access);
+    
+    /** Balances of many addresses at many heights, calculated in one parallel pass over their outputs
+     *
+     * Returns a row-major matrix with a row for every address and a column for every height. The outputs of each
+     * thread's addresses are read in transaction order. A height of -1 stands for the current balance, as in
+     * Address::calculateBalance.
+     */
+    std::vector<int64_t> BLOCKSCI_EXPORT calculateBalances(const std::vector<RawAddress> &addresses, const std::vector<BlockHeight> &heights, DataAccess &access);
+    
     inline size_t hashAddress(uint32_t scriptNum, AddressType::Enum type) {
         return (static_cast<size_t>(scriptNum) << 32) + static_cast<size_t>(type);
     }
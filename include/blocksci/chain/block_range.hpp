@@ -11,6 +11,7 @@
 
 #include <blocksci/blocksci_export.h>
 #include <blocksci/chain/block.hpp>
+#include <blocksci/chain/column_view.hpp>
 
 #include <map>
 #include <type_traits>
@@ -197,6 +198,34 @@ namespace blocksci {
         // Returns a vector of [start, stop) intervals splitting the chain into segments with approximately the same number of segments
         std::vector<BlockRange> segment(unsigned int segmentCount) const;
         
+        /* Dense columns of the outputs and inputs of all transactions in the range, ordered by blockchain-wide
+         * output and input number. They are written by the parser's inout-columns-update command, the accessors
+         * throw if the columns do not cover the range. */
+        bool hasInoutColumns() const;
+        ColumnView<int64_t> outputValues() const;
+        ColumnView<uint8_t> outputTypes() const;
+        ColumnView<uint32_t> outputAddressNums() const;
+        // Tx number of the spending transaction of each output, 0 if the output is unspent
+        ColumnView<uint32_t> outputSpendingTxNums() const;
+        ColumnView<int64_t> inputValues() const;
+        ColumnView<uint8_t> inputTypes() const;
+        ColumnView<uint32_t> inputAddressNums() const;
+        // Tx number of the transaction containing the output spent by each input
+        ColumnView<uint32_t> inputSpentTxNums() const;
+        
+        /* Memory-mapped columns of the core chain files for the blocks, transactions and inputs in the range. Unlike
+         * the columns above they always exist. Hashes are in the internal byte order, which is the reverse of the
+         * order of their hex strings. */
+        ColumnView<RawBlock> rawBlocks() const;
+        ColumnView<uint256> txHashes() const;
+        ColumnView<int32_t> txVersions() const;
+        // Blockchain-wide number of the first input and output of each transaction
+        ColumnView<uint64_t> txFirstInputNums() const;
+        ColumnView<uint64_t> txFirstOutputNums() const;
+        ColumnView<uint32_t> inputSequenceNums() const;
+        // Output number within its transaction of the output spent by each input
+        ColumnView<uint16_t> inputSpentOutputNums() const;
+        
         Slice sl;
         
         DataAccess &getAccess() { return *access; }
@@ -12,6 +12,8 @@
 #include <blocksci/blocksci_export.h>
 #include <blocksci/address/address_fwd.hpp>
 #include <blocksci/chain/block_range.hpp>
+#include <blocksci/chain/mempool.hpp>
+#include <blocksci/chain/utxo_set.hpp>
 
 #include <map>
 #include <type_traits>
@@ -40,6 +42,22 @@ namespace blocksci {
         bool isParserRunning();
         
         uint32_t addressCount(AddressType::Enum type) const;
+        
+        /** Memory-mapped columns of the per transaction observations of the mempool recorder */
+        std::vector<MempoolColumn> mempoolObservations() const;
+        
+        /** Memory-mapped columns of the event log of the mempool recorder */
+        std::vector<MempoolColumn> mempoolEvents() const;
+        
+        /** Unspent outputs after the block at the given height (-1 for the last block)
+         *
+         * The set is derived from the closest UTXO snapshot written by the parser's utxo-snapshots-update command,
+         * or from the start of the chain if there are none.
+         */
+        UtxoSet utxoSet(BlockHeight height) const;
+        
+        /** Heights of the UTXO snapshots that describe blocks of the current chain */
+        std::vector<BlockHeight> utxoSnapshotHeights() const;
     };
     
     uint32_t BLOCKSCI_EXPORT txCount(Blockchain &chain);
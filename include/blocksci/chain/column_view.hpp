@@ -0,0 +1,42 @@
+//
+//  column_view.hpp
+//  blocksci
+//
+
+#ifndef blocksci_chain_column_view_hpp
+#define blocksci_chain_column_view_hpp
+
+#include <blocksci/blocksci_export.h>
+
+#include <cstddef>
+
+namespace blocksci {
+
+    /** Contiguous read-only view of a memory-mapped column
+     *
+     * The view stays valid until the Blockchain it was taken from is reloaded or destroyed.
+     */
+    template <typename T>
+    struct BLOCKSCI_EXPORT ColumnView {
+        const T *data = nullptr;
+        size_t size = 0;
+        
+        const T *begin() const {
+            return data;
+        }
+        
+        const T *end() const {
+            return data + size;
+        }
+        
+        const T &operator[](size_t i) const {
+            return data[i];
+        }
+        
+        bool empty() const {
+            return size == 0;
+        }
+    };
+} // namespace blocksci
+
+#endif /* blocksci_chain_column_view_hpp */
@@ -0,0 +1,58 @@
+//
+//  mempool.hpp
+//  blocksci
+//
+
+#ifndef blocksci_chain_mempool_hpp
+#define blocksci_chain_mempool_hpp
+
+#include <blocksci/blocksci_export.h>
+#include <blocksci/core/bitcoin_uint256.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace blocksci {
+
+    /** Number of transactions that share one entry of the segment table of the columnar mempool store */
+    constexpr uint32_t mempoolSegmentSize = 1u << 16;
+    
+    struct BLOCKSCI_EXPORT MempoolEventType {
+        enum Enum : uint32_t {
+            /** The transaction entered the mempool, feeRate is its fee rate */
+            Entered = 1,
+            /** The transaction was replaced by otherTxHash (RBF), feeRate is the fee rate of the replacement */
+            Replaced = 2,
+            /** The transaction left the mempool without being mined, eg. because it expired or was evicted */
+            Removed = 3
+        };
+    };
+    
+    /** Entry of the append-only event log of the mempool recorder */
+    struct BLOCKSCI_EXPORT MempoolEvent {
+        int64_t time;
+        uint256 txHash;
+        uint256 otherTxHash;
+        /** Fee rate in satoshi per 1000 virtual bytes, 0 if unknown */
+        uint64_t feeRate;
+        MempoolEventType::Enum type;
+        uint32_t padding;
+    };
+    
+    /** Strided memory-mapped column of the mempool observations
+     *
+     * Elements are stride bytes apart, an element consisting of width consecutive values of itemSize bytes.
+     */
+    struct BLOCKSCI_EXPORT MempoolColumn {
+        std::string name;
+        const void *data;
+        size_t itemSize;
+        size_t stride;
+        uint32_t width;
+        /** Value type as a Python struct format character */
+        std::string format;
+        uint64_t size;
+    };
+} // namespace blocksci
+
+#endif /* blocksci_chain_mempool_hpp */
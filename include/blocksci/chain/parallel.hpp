@@ -10,6 +10,7 @@
 
 #include <blocksci/chain/chain_fwd.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <future>
 #include <thread>
@@ -18,6 +19,27 @@
 
 namespace blocksci {
     
+    /** Minimum number of items that parallelForChunks hands to each thread by default */
+    constexpr size_t parallelChunkSize = 1024;
+    
+    /** Calls func(begin, end) for consecutive chunks of [0, count) on several threads
+     *
+     * Every thread gets at least minChunkSize items, so small counts are handled by a single call on a single thread.
+     */
+    template <typename Func>
+    void parallelForChunks(size_t count, Func func, size_t minChunkSize = parallelChunkSize) {
+        auto threadCount = std::min(static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)), std::max(count / minChunkSize, size_t{1}));
+        std::vector<std::future<void>> chunks;
+        for (size_t i = 0; i < threadCount; i++) {
+            auto begin = count * i / threadCount;
+            auto end = count * (i + 1) / threadCount;
+            chunks.push_back(std::async(std::launch::async, [&func, begin, end]() { func(begin, end); }));
+        }
+        for (auto &chunk : chunks) {
+            chunk.get();
+        }
+    }
+    
     template <typename It, typename MapType, typename ResultType>
     ResultType mapReduceTransactionsImp(It begin, It end, const std::function<MapType(const std::vector<Block> &)> &mapFunc, const std::function<ResultType&(ResultType &, MapType &)> &reduceFunc, ResultType identity) {
         auto segmentCount = std::distance(begin, end);
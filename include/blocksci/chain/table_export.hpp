@@ -0,0 +1,59 @@
+//
+//  table_export.hpp
+//  blocksci
+//
+
+#ifndef blocksci_chain_table_export_hpp
+#define blocksci_chain_table_export_hpp
+
+#include <blocksci/blocksci_export.h>
+#include <blocksci/chain/chain_fwd.hpp>
+#include <blocksci/cluster/cluster_fwd.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace blocksci {
+
+    /** Tables that can be exported column by column, with one row per transaction, input or output in chain order */
+    struct BLOCKSCI_EXPORT ExportTable {
+        enum Enum : uint8_t {
+            Txes, Inputs, Outputs
+        };
+    };
+
+    /** Column of an exported table holding the values of all rows back to back */
+    struct BLOCKSCI_EXPORT ExportColumn {
+        std::string name;
+        /** Value type as a Python struct format character, hashes are hex strings of format 64s */
+        std::string format;
+        size_t itemSize;
+        std::vector<char> data;
+
+        size_t size() const {
+            return data.size() / itemSize;
+        }
+
+        template <typename T>
+        void add(const T &value) {
+            auto offset = data.size();
+            data.resize(offset + sizeof(T));
+            memcpy(data.data() + offset, &value, sizeof(T));
+        }
+    };
+
+    /** Names of the columns of the table that exportTableColumns can produce */
+    std::vector<std::string> BLOCKSCI_EXPORT exportColumnNames(ExportTable::Enum table);
+
+    /** Computes the given columns for all rows of the table in the blocks
+     *
+     * The blocks are split into segments with about the same number of transactions that are processed in parallel,
+     * the rows keep the order of the chain. The cluster column requires a clustering. Throws std::invalid_argument for
+     * unknown columns.
+     */
+    std::vector<ExportColumn> BLOCKSCI_EXPORT exportTableColumns(const BlockRange &blocks, ExportTable::Enum table, const std::vector<std::string> &columns, const ClusterManager *clusters = nullptr);
+} // namespace blocksci
+
+#endif /* blocksci_chain_table_export_hpp */
@@ -22,6 +22,8 @@
 #include <range/v3/utility/optional.hpp>
 
 #include <chrono>
+#include <string>
+#include <vector>
 
 namespace blocksci {
     class uint256;
@@ -84,6 +86,12 @@ namespace blocksci {
         ranges::optional<std::chrono::system_clock::time_point> getTimeSeen() const;
         ranges::optional<uint32_t> getTimestampSeen() const;
         bool observedInMempool() const;
+        /** Fee rate in satoshi per 1000 virtual bytes at the time the transaction was first seen */
+        ranges::optional<uint64_t> getFeeRateSeen() const;
+        /** Last time the transaction left the mempool without being mined, eg. because it was evicted */
+        ranges::optional<uint32_t> getTimestampRemoved() const;
+        /** Number of mempool transactions that this transaction replaced (RBF) */
+        uint32_t getReplacedCount() const;
         
         std::string toString() const;
         
@@ -192,6 +200,16 @@ namespace blocksci {
     std::ostream BLOCKSCI_EXPORT &operator<<(std::ostream &os, const Transaction &tx);
     
     bool BLOCKSCI_EXPORT isSegwitMarker(const Transaction &tx);
+    
+    /** Tx numbers of the transactions with the given hashes, nullopt for hashes that are not in the chain
+     *
+     * The hash index is queried in batches on several threads, which is much faster than constructing a Transaction
+     * from each hash.
+     */
+    std::vector<ranges::optional<uint32_t>> BLOCKSCI_EXPORT getTxIndexes(const std::vector<uint256> &hashes, DataAccess &access);
+    
+    /** Tx numbers of the transactions with the given hex encoded hashes, nullopt for hashes that are not in the chain */
+    std::vector<ranges::optional<uint32_t>> BLOCKSCI_EXPORT getTxIndexes(const std::vector<std::string> &hashes, DataAccess &access);
 } // namespace blocksci
 
 
@@ -0,0 +1,58 @@
+//
+//  utxo_set.hpp
+//  blocksci
+//
+
+#ifndef blocksci_chain_utxo_set_hpp
+#define blocksci_chain_utxo_set_hpp
+
+#include <blocksci/blocksci_export.h>
+#include <blocksci/core/typedefs.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace blocksci {
+
+    /** Unspent outputs after a given block, stored column by column and sorted by (txNum, outputNum)
+     *
+     * An output is part of the set at height h if it was created in a block up to h and not spent in a block up to h,
+     * which matches the outputs counted by balance(h, ...).
+     */
+    struct BLOCKSCI_EXPORT UtxoSet {
+        BlockHeight height = 0;
+        std::vector<uint32_t> txNums;
+        std::vector<uint16_t> outputNums;
+        std::vector<int64_t> values;
+        /** AddressType::Enum of every output */
+        std::vector<uint8_t> addressTypes;
+        std::vector<uint32_t> addressNums;
+        
+        size_t size() const {
+            return txNums.size();
+        }
+        
+        void reserve(size_t count) {
+            txNums.reserve(count);
+            outputNums.reserve(count);
+            values.reserve(count);
+            addressTypes.reserve(count);
+            addressNums.reserve(count);
+        }
+        
+        void add(uint32_t txNum, uint16_t outputNum, int64_t value, uint8_t addressType, uint32_t addressNum) {
+            txNums.push_back(txNum);
+            outputNums.push_back(outputNum);
+            values.push_back(value);
+            addressTypes.push_back(addressType);
+            addressNums.push_back(addressNum);
+        }
+        
+        /** Appends the output at position i of another set */
+        void add(const UtxoSet &other, size_t i) {
+            add(other.txNums[i], other.outputNums[i], other.values[i], other.addressTypes[i], other.addressNums[i]);
+        }
+    };
+} // namespace blocksci
+
+#endif /* blocksci_chain_utxo_set_hpp */
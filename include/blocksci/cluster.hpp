@@ -9,6 +9,8 @@
 #define cluster_group_header_hpp
 
 #include <blocksci/cluster/cluster.hpp>
+#include <blocksci/cluster/cluster_comparison.hpp>
 #include <blocksci/cluster/cluster_manager.hpp>
+#include <blocksci/cluster/clustering_pipeline.hpp>
 
 #endif /* cluster_group_header_hpp */
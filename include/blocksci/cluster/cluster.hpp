@@ -24,6 +24,7 @@
 
 namespace blocksci {
     class ClusterAccess;
+    class ClusterManager;
     
     struct BLOCKSCI_EXPORT TaggedAddress {
         blocksci::Address address;
@@ -112,6 +113,24 @@ namespace blocksci {
         ranges::any_view<OutputPointer> getOutputPointers() const;
         
         int64_t calculateBalance(BlockHeight height) const;
+        
+        /** Whether the per-height activity log was created together with the clustering */
+        bool hasActivity() const;
+        
+        /** Height of the first block in which the cluster received or spent outputs, based on the activity log */
+        ranges::optional<BlockHeight> firstActivityHeight() const;
+        
+        /** Height of the last block in which the cluster received or spent outputs, based on the activity log */
+        ranges::optional<BlockHeight> lastActivityHeight() const;
+        
+        /** Total value received by the cluster in blocks [start, stop), based on the activity log. A stop of -1 includes all blocks */
+        int64_t receivedValue(BlockHeight start, BlockHeight stop) const;
+        
+        /** Total value spent by the cluster in blocks [start, stop), based on the activity log. A stop of -1 includes all blocks */
+        int64_t spentValue(BlockHeight start, BlockHeight stop) const;
+        
+        /** Number of transactions in blocks [start, stop) in which the cluster was involved, based on the activity log. A stop of -1 includes all blocks */
+        uint32_t activeTxCount(BlockHeight start, BlockHeight stop) const;
 
         ranges::any_view<Output> getOutputs() const;
         ranges::any_view<Input> getInputs() const;
@@ -138,6 +157,7 @@ namespace blocksci {
     private:
         
         friend Cluster;
+        friend ClusterManager;
         
         TaggedCluster(const Cluster &cluster_, TaggedRange &&taggedAddresses_) : cluster(cluster_), taggedAddresses(std::move(taggedAddresses_)) {}
     };
@@ -0,0 +1,64 @@
+//
+//  cluster_comparison.hpp
+//  blocksci
+//
+
+#ifndef cluster_comparison_hpp
+#define cluster_comparison_hpp
+
+#include <blocksci/blocksci_export.h>
+#include <blocksci/address/address.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace blocksci {
+
+    /** Number of addresses that are part of cluster first in the first clustering and of cluster second in the second clustering */
+    struct BLOCKSCI_EXPORT ClusterContingencyEntry {
+        uint32_t first;
+        uint32_t second;
+        uint32_t count;
+    };
+    
+    /** Cluster of one clustering whose addresses belong to several clusters of the other clustering */
+    struct BLOCKSCI_EXPORT ClusterChange {
+        /** Cluster number in the clustering the cluster belongs to */
+        uint32_t clusterNum;
+        /** Number of clusters of the other clustering that share addresses with the cluster */
+        uint32_t otherClusterCount;
+        /** Number of compared addresses in the cluster */
+        uint64_t size;
+    };
+    
+    /** Differences between two clusterings created from the same chain
+     *
+     * Addresses are compared as deduplicated addresses, i.e. type equivalent addresses are counted once.
+     * Only addresses that are part of both clusterings are compared, which matters for clusterings
+     * that were created at different chain heights.
+     */
+    struct BLOCKSCI_EXPORT ClusteringComparison {
+        uint32_t firstClusterCount = 0;
+        uint32_t secondClusterCount = 0;
+        /** Number of addresses that are part of both clusterings */
+        uint64_t comparedAddressCount = 0;
+        /** Number of addresses that are only part of one of the clusterings */
+        uint64_t unmatchedAddressCount = 0;
+        /** Number of clusters of the second clustering formed from several clusters of the first */
+        uint32_t mergedClusterCount = 0;
+        /** Number of clusters of the first clustering that were split over several clusters of the second */
+        uint32_t splitClusterCount = 0;
+        /** Non-zero entries of the contingency table, sorted by first and second cluster */
+        std::vector<ClusterContingencyEntry> contingency;
+        /** Largest merged clusters of the second clustering */
+        std::vector<ClusterChange> largestMerges;
+        /** Largest split clusters of the first clustering */
+        std::vector<ClusterChange> largestSplits;
+        /** Number of addresses that are not in the cluster which received most addresses of their previous cluster */
+        uint64_t movedAddressCount = 0;
+        /** The first of these addresses in address order, at most the limit passed to the comparison */
+        std::vector<Address> movedAddresses;
+    };
+} // namespace blocksci
+
+#endif /* cluster_comparison_hpp */
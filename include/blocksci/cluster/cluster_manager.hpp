@@ -11,6 +11,8 @@
 
 #include "cluster_fwd.hpp"
 #include "cluster.hpp"
+#include "cluster_comparison.hpp"
+#include "clustering_pipeline.hpp"
 
 #include <blocksci/blocksci_export.h>
 
@@ -20,6 +22,16 @@ namespace blocksci {
     }
     
     class ClusterAccess;
+    
+    /** Memory-mapped column of the per cluster statistics, indexed by cluster number */
+    struct BLOCKSCI_EXPORT ClusterStatsColumn {
+        std::string name;
+        const void *data;
+        size_t itemSize;
+        /** Element type as a Python struct format character */
+        std::string format;
+        uint64_t size;
+    };
 
     class BLOCKSCI_EXPORT ClusterManager {
         std::unique_ptr<ClusterAccess> access;
@@ -27,6 +39,8 @@ namespace blocksci {
         
         friend class blocksci::Cluster;
         
+        ranges::any_view<TaggedCluster> taggedClusters(std::vector<std::pair<uint32_t, std::unordered_map<Address, std::string>>> &&clusterTags) const;
+        
     public:
         ClusterManager(const std::string &baseDirectory, DataAccess &access);
         ClusterManager(ClusterManager && other);
@@ -36,11 +50,39 @@ namespace blocksci {
         static ClusterManager createClustering(BlockRange &chain, const heuristics::ChangeHeuristic &heuristic, const std::string &outputPath, bool overwrite = false, bool ignoreCoinJoin = true);
         static ClusterManager createClustering(BlockRange &chain, const std::function<ranges::any_view<Output>(const Transaction &tx)> &changeHeuristic, const std::string &outputPath, bool overwrite, bool ignoreCoinJoin);
         
+        /** Creates a clustering using the rules of the pipeline and stores the number of unions contributed by every rule */
+        static ClusterManager createClustering(BlockRange &chain, const ClusteringPipeline &pipeline, const std::string &outputPath, bool overwrite = false);
+        
+        /** Compares two clusterings of the same chain by streaming their cluster indexes side by side
+         *
+         * Reports the contingency table of cluster numbers, the topK largest merged and split clusters
+         * and the number of addresses that did not end up in the cluster which received most of their former
+         * cluster, together with the first movedAddressLimit of these addresses.
+         */
+        static ClusteringComparison compareClusterings(const ClusterManager &first, const ClusterManager &second, size_t topK = 10, size_t movedAddressLimit = 1000);
+        
         Cluster getCluster(const Address &address) const;
         
         ranges::any_view<Cluster, ranges::category::random_access | ranges::category::sized> getClusters() const;
         
+        /** Returns every cluster containing a tagged address
+         *
+         * Each tagged address is mapped to its cluster through the cluster index files,
+         * so the cost depends on the number of tags rather than the number of clustered addresses.
+         */
         ranges::any_view<TaggedCluster> taggedClusters(const std::unordered_map<Address, std::string> &tags) const;
+        
+        /** Returns every cluster containing an address of the tag set previously stored with saveTags */
+        ranges::any_view<TaggedCluster> taggedClusters(const std::string &tagSetName) const;
+        
+        /** Resolves the tags against this clustering and stores them as a sorted tag table inside the cluster directory */
+        void saveTags(const std::unordered_map<Address, std::string> &tags, const std::string &tagSetName, bool overwrite = false) const;
+        
+        /** Returns the columns of the statistics table that was created alongside the clustering */
+        std::vector<ClusterStatsColumn> getClusterStats() const;
+        
+        /** Returns the per rule link statistics recorded while creating the clustering, empty for older clusterings */
+        std::vector<ClusteringRuleStats> getRuleStats() const;
     };
     
     using cluster_range = decltype(std::declval<ClusterManager>().getClusters());
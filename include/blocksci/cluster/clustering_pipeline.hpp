@@ -0,0 +1,92 @@
+//
+//  clustering_pipeline.hpp
+//  blocksci
+//
+
+#ifndef clustering_pipeline_hpp
+#define clustering_pipeline_hpp
+
+#include <blocksci/blocksci_export.h>
+#include <blocksci/chain/chain_fwd.hpp>
+#include <blocksci/core/address_types.hpp>
+#include <blocksci/heuristics/change_address.hpp>
+
+#include <array>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace blocksci {
+
+    /** Number of transactions and unions contributed by a single clustering rule */
+    struct BLOCKSCI_EXPORT ClusteringRuleStats {
+        std::string name;
+        /** Transactions the rule applied to. For exclusion rules this is the number of excluded transactions */
+        uint64_t transactions = 0;
+        /** Unions that merged two previously separate clusters */
+        uint64_t unions = 0;
+        /** Unions between addresses that were already in the same cluster */
+        uint64_t redundant = 0;
+    };
+    
+    /** Describes the rules used to link addresses while creating a clustering
+     *
+     * Rules are evaluated per transaction in a fixed order: exclusion rules first, then the
+     * multi-input rule and then every change rule in the order it was added. A transaction
+     * matched by any exclusion rule contributes no links. Addresses of excluded address types
+     * are never linked by any rule.
+     */
+    class BLOCKSCI_EXPORT ClusteringPipeline {
+    public:
+        using TransactionFilter = std::function<bool(const Transaction &tx)>;
+    
+    private:
+        std::vector<std::pair<std::string, TransactionFilter>> exclusionRules;
+        bool multiInput = false;
+        std::string multiInputName;
+        std::vector<std::pair<std::string, heuristics::ChangeHeuristic>> changeRules;
+        std::array<bool, AddressType::size> excludedTypes{};
+    
+    public:
+        /** Link all inputs of a transaction */
+        ClusteringPipeline &addMultiInput(const std::string &name = "multi_input");
+        
+        /** Link the outputs selected by the change heuristic to the inputs of a transaction */
+        ClusteringPipeline &addChange(heuristics::ChangeHeuristic heuristic, const std::string &name);
+        
+        /** Skip transactions matched by the filter, e.g. one of the coinjoin detectors in tx_identification.hpp */
+        ClusteringPipeline &addExclusion(TransactionFilter filter, const std::string &name);
+        
+        /** Never link addresses of the given type */
+        ClusteringPipeline &excludeAddressType(AddressType::Enum type);
+        
+        /** The pipeline used by ClusterManager::createClustering when only a change heuristic is given */
+        static ClusteringPipeline standard(heuristics::ChangeHeuristic changeHeuristic, bool ignoreCoinJoin);
+        
+        const std::vector<std::pair<std::string, TransactionFilter>> &getExclusionRules() const {
+            return exclusionRules;
+        }
+        
+        bool hasMultiInput() const {
+            return multiInput;
+        }
+        
+        const std::string &getMultiInputName() const {
+            return multiInputName;
+        }
+        
+        const std::vector<std::pair<std::string, heuristics::ChangeHeuristic>> &getChangeRules() const {
+            return changeRules;
+        }
+        
+        bool linksAddressType(AddressType::Enum type) const {
+            return !excludedTypes[static_cast<size_t>(type)];
+        }
+        
+        /** Names of all rules in evaluation order, matching the order of the rule statistics */
+        std::vector<std::string> ruleNames() const;
+    };
+} // namespace blocksci
+
+#endif /* clustering_pipeline_hpp */
@@ -13,12 +13,16 @@
 #include <blocksci/chain/output.hpp>
 #include <blocksci/scripts/scripts_fwd.hpp>
 
+#include <mpark/variant.hpp>
+
+#include <range/v3/range_for.hpp>
 #include <range/v3/utility/optional.hpp>
 #include <range/v3/iterator/operations.hpp>
 #include <range/v3/view.hpp>
 #include <range/v3/view/set_algorithm.hpp>
 
 #include <unordered_set>
+#include <vector>
 
 #define CHANGE_ADDRESS_TYPE_LIST VAL(PeelingChain), VAL(PowerOfTen), VAL(OptimalChange), VAL(AddressType), VAL(Locktime), VAL(AddressReuse), VAL(ClientChangeAddressBehavior), VAL(Legacy), VAL(FixedFee), VAL(None), VAL(Spent)
 #define CHANGE_ADDRESS_TYPE_SET VAL(PeelingChain), VAL(PowerOfTen), VAL(OptimalChange), VAL(AddressType) VAL(Locktime), VAL(AddressReuse), VAL(ClientChangeAddressBehavior), VAL(Legacy), VAL(FixedFee), VAL(None), VAL(Spent)
@@ -39,16 +43,32 @@ namespace heuristics {
         static constexpr size_t size = all.size();
     };
     
+    /** Range over the outputs of a change heuristic that owns them */
+    ranges::any_view<Output> BLOCKSCI_EXPORT changeOutputsView(std::vector<Output> outputs);
+    
     template <ChangeType::Enum heuristic>
     struct BLOCKSCI_EXPORT ChangeHeuristicImpl {
-        ranges::any_view<Output> operator()(const Transaction &tx) const;
+        /** Appends the outputs of tx that may be change to change in output order */
+        void appendChange(const Transaction &tx, std::vector<Output> &change) const;
+        
+        ranges::any_view<Output> operator()(const Transaction &tx) const {
+            std::vector<Output> change;
+            appendChange(tx, change);
+            return changeOutputsView(std::move(change));
+        }
     };
     
     template<>
     struct BLOCKSCI_EXPORT ChangeHeuristicImpl<ChangeType::PowerOfTen> {
         int digits;
         ChangeHeuristicImpl(int digits_ = 6) : digits(digits_) {}
-        ranges::any_view<Output> operator()(const Transaction &tx) const;
+        void appendChange(const Transaction &tx, std::vector<Output> &change) const;
+        
+        ranges::any_view<Output> operator()(const Transaction &tx) const {
+            std::vector<Output> change;
+            appendChange(tx, change);
+            return changeOutputsView(std::move(change));
+        }
     };
     
     using PeelingChainChange = ChangeHeuristicImpl<ChangeType::PeelingChain>;
@@ -63,13 +83,21 @@ namespace heuristics {
     using NoChange = ChangeHeuristicImpl<ChangeType::None>;
     using Spent = ChangeHeuristicImpl<ChangeType::Spent>;
     
+    using BuiltinChangeHeuristic = mpark::variant<PeelingChainChange, PowerOfTenChange, OptimalChangeChange, AddressTypeChange, LocktimeChange, AddressReuseChange, ClientChangeAddressBehaviorChange, LegacyChange, FixedFee, NoChange, Spent>;
+    
     struct BLOCKSCI_EXPORT ChangeHeuristic {
         using HeuristicFunc = std::function<ranges::any_view<Output>(const Transaction &tx)>;
         
         HeuristicFunc impl;
         
+        /** The heuristic if it is one of the heuristics above, which appendChange calls directly */
+        ranges::optional<BuiltinChangeHeuristic> builtin;
+        
         ChangeHeuristic(HeuristicFunc func) : impl(std::move(func)) {}
         
+        template<ChangeType::Enum heuristic>
+        ChangeHeuristic(ChangeHeuristicImpl<heuristic> func) : impl(func), builtin(BuiltinChangeHeuristic{func}) {}
+        
         template<typename T>
         ChangeHeuristic(T func) : impl(std::move(func)) {}
         
@@ -77,6 +105,17 @@ namespace heuristics {
             return impl(tx);
         }
         
+        /** Appends the outputs of tx that may be change to change without allocating for built-in heuristics */
+        void appendChange(const Transaction &tx, std::vector<Output> &change) const {
+            if (builtin) {
+                mpark::visit([&](const auto &heuristic) { heuristic.appendChange(tx, change); }, *builtin);
+            } else {
+                RANGES_FOR(auto output, impl(tx)) {
+                    change.push_back(output);
+                }
+            }
+        }
+        
         static ChangeHeuristic uniqueChange(ChangeHeuristic ch) {
             return ChangeHeuristic{HeuristicFunc{[=](const Transaction &tx) {
                 auto c = ch(tx);
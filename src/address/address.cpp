@@ -11,6 +11,7 @@
 #include <blocksci/address/address.hpp>
 #include <blocksci/address/equiv_address.hpp>
 #include <blocksci/chain/algorithms.hpp>
+#include <blocksci/chain/parallel.hpp>
 #include <blocksci/chain/range_util.hpp>
 #include <blocksci/scripts/script_variant.hpp>
 
@@ -22,14 +23,22 @@
 #include <internal/chain_access.hpp>
 #include <internal/script_access.hpp>
 #include <internal/address_index.hpp>
+#include <internal/hash.hpp>
 #include <internal/hash_index.hpp>
 
 #include <range/v3/view/transform.hpp>
 #include <range/v3/view/unique.hpp>
 #include <range/v3/algorithm/min.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <tuple>
 #include <sstream>
+#include <thread>
 
 namespace blocksci {
     
@@ -272,27 +281,226 @@ namespace blocksci {
         }
     }
     
-    template<AddressType::Enum type>
-    std::vector<Address> getAddressesWithPrefixImp(const std::string &prefix, DataAccess &access) {
+    namespace {
+        /** Scans [lower, upper] of the index column of the given type from several threads, split by the first key byte */
+        std::vector<std::pair<uint32_t, std::string>> parallelScanAddressRange(AddressType::Enum indexType, const std::string &lower, const std::string &upper, DataAccess &access) {
+            auto firstByte = static_cast<unsigned int>(static_cast<unsigned char>(lower[0]));
+            auto lastByte = static_cast<unsigned int>(static_cast<unsigned char>(upper[0]));
+            auto threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), lastByte - firstByte + 1);
+            std::vector<std::future<std::vector<std::pair<uint32_t, std::string>>>> segments;
+            for (unsigned int i = 0; i < threadCount; i++) {
+                auto segmentFirst = firstByte + (lastByte - firstByte + 1) * i / threadCount;
+                auto segmentLast = firstByte + (lastByte - firstByte + 1) * (i + 1) / threadCount - 1;
+                auto segmentLower = segmentFirst == firstByte ? lower : std::string(1, static_cast<char>(segmentFirst));
+                auto segmentUpper = segmentLast == lastByte ? upper : std::string(1, static_cast<char>(segmentLast)) + std::string(upper.size() - 1, '\xff');
+                segments.push_back(std::async(std::launch::async, [&access, indexType, segmentLower, segmentUpper]() {
+                    std::vector<std::pair<uint32_t, std::string>> rows;
+                    access.getHashIndex().scanAddressRange(indexType, segmentLower, segmentUpper, [&](const MemoryView &key, uint32_t scriptNum) {
+                        rows.emplace_back(scriptNum, std::string(key.data, key.size));
+                    });
+                    return rows;
+                }));
+            }
+            std::vector<std::pair<uint32_t, std::string>> rows;
+            for (auto &segment : segments) {
+                auto segmentRows = segment.get();
+                rows.insert(rows.end(), std::make_move_iterator(segmentRows.begin()), std::make_move_iterator(segmentRows.end()));
+            }
+            return rows;
+        }
+        /** Adds P2PKH or P2SH addresses whose base58 encoding starts with prefix
+         *
+         * A base58 prefix corresponds to contiguous ranges of (version, hash) payloads, so only the matching part of the
+         * hash index is read. The ranges ignore the checksum, which is why the candidates are encoded and compared.
+         */
+        void addBase58PrefixMatches(std::vector<Address> &addresses, const std::string &prefix, AddressType::Enum type, const std::vector<unsigned char> &version, DataAccess &access) {
+            std::string versionBytes(version.begin(), version.end());
+            for (auto &range : Base58CheckPrefixRanges(prefix, version.size() + sizeof(uint160))) {
+                // Only payloads starting with the version bytes belong to this address type
+                auto lower = std::max(std::string(range.first.begin(), range.first.end()), versionBytes + std::string(sizeof(uint160), '\0'));
+                auto upper = std::min(std::string(range.second.begin(), range.second.end()), versionBytes + std::string(sizeof(uint160), '\xff'));
+                if (lower > upper) {
+                    continue;
+                }
+                access.getHashIndex().scanAddressRange(type, lower.substr(version.size()), upper.substr(version.size()), [&](const MemoryView &key, uint32_t scriptNum) {
+                    uint160 hash;
+                    memcpy(&hash, key.data, sizeof(hash));
+                    if (CBitcoinAddress(hash, version).ToString().compare(0, prefix.size(), prefix) == 0) {
+                        addresses.emplace_back(scriptNum, type, access);
+                    }
+                });
+            }
+        }
+        
+        /** Adds P2WPKH or P2WSH addresses whose bech32 encoding starts with prefix, which has to be lowercase
+         *
+         * The characters following the witness version fix the leading bits of the witness program, which bounds the
+         * part of the hash index that is scanned. The scan is split across threads since short prefixes cover most
+         * of the index.
+         */
+        void addBech32PrefixMatches(std::vector<Address> &addresses, const std::string &prefix, AddressType::Enum indexType, AddressType::Enum type, size_t programSize, DataAccess &access) {
+            static const std::string charset = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+            auto separatorPos = access.config.chainConfig.segwitPrefix.size();
+            std::string lower(programSize, '\0');
+            std::string upper(programSize, '\xff');
+            for (size_t pos = separatorPos + 2; pos < prefix.size(); pos++) {
+                auto charPos = charset.find(prefix[pos]);
+                if (charPos == std::string::npos) {
+                    return;
+                }
+                for (size_t bit = 0; bit < 5; bit++) {
+                    auto bitPos = (pos - separatorPos - 2) * 5 + bit;
+                    if (bitPos >= programSize * 8) {
+                        break;
+                    }
+                    auto mask = static_cast<char>(0x80 >> (bitPos % 8));
+                    if ((charPos >> (4 - bit)) & 1) {
+                        lower[bitPos / 8] |= mask;
+                    } else {
+                        upper[bitPos / 8] &= ~mask;
+                    }
+                }
+            }
+            for (auto &row : parallelScanAddressRange(indexType, lower, upper, access)) {
+                std::vector<uint8_t> witprog(row.second.begin(), row.second.end());
+                if (segwit_addr::encode(access.config.chainConfig, 0, witprog).compare(0, prefix.size(), prefix) == 0) {
+                    addresses.emplace_back(row.first, type, access);
+                }
+            }
+        }
+    }
+    
+    std::vector<Address> getAddressesWithPrefix(const std::string &prefix, DataAccess &access) {
         std::vector<Address> addresses;
-        auto count = access.getScripts().scriptCount(dedupType(type));
-        for (uint32_t scriptNum = 1; scriptNum <= count; scriptNum++) {
-            ScriptAddress<type> script(scriptNum, access);
-            if (script.addressString().compare(0, prefix.length(), prefix) == 0) {
-                addresses.emplace_back(scriptNum, type, access);
+        if (prefix.empty()) {
+            return addresses;
+        }
+        auto &chainConfig = access.config.chainConfig;
+        addBase58PrefixMatches(addresses, prefix, AddressType::PUBKEYHASH, chainConfig.pubkeyPrefix, access);
+        addBase58PrefixMatches(addresses, prefix, AddressType::SCRIPTHASH, chainConfig.scriptPrefix, access);
+        
+        // Bech32 addresses are <segwitPrefix>1<witness version><witness program and checksum>, only version 0 is indexed.
+        // They are case insensitive but must not mix cases, and are encoded in lowercase.
+        bool hasLower = std::any_of(prefix.begin(), prefix.end(), [](char c) { return std::islower(static_cast<unsigned char>(c)); });
+        bool hasUpper = std::any_of(prefix.begin(), prefix.end(), [](char c) { return std::isupper(static_cast<unsigned char>(c)); });
+        if (!chainConfig.segwitPrefix.empty() && !(hasLower && hasUpper)) {
+            std::string bech32Prefix = prefix;
+            std::transform(bech32Prefix.begin(), bech32Prefix.end(), bech32Prefix.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+            auto segwitStart = chainConfig.segwitPrefix + "1q";
+            auto comparedLength = std::min(bech32Prefix.size(), segwitStart.size());
+            if (bech32Prefix.compare(0, comparedLength, segwitStart, 0, comparedLength) == 0) {
+                addBech32PrefixMatches(addresses, bech32Prefix, AddressType::PUBKEYHASH, AddressType::WITNESS_PUBKEYHASH, sizeof(uint160), access);
+                addBech32PrefixMatches(addresses, bech32Prefix, AddressType::WITNESS_SCRIPTHASH, AddressType::WITNESS_SCRIPTHASH, sizeof(uint256), access);
             }
         }
+        std::sort(addresses.begin(), addresses.end());
+        addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
         return addresses;
     }
     
-    std::vector<Address> getAddressesWithPrefix(const std::string &prefix, DataAccess &access) {
-        if (prefix.compare(0, 1, "1") == 0) {
-            return getAddressesWithPrefixImp<AddressType::Enum::PUBKEYHASH>(prefix, access);
-        } else if (prefix.compare(0, 1, "3") == 0) {
-            return getAddressesWithPrefixImp<AddressType::Enum::SCRIPTHASH>(prefix, access);
-        } else {
-            return {};
+    namespace {
+        std::string base58AddressString(const std::vector<unsigned char> &version, const uint160 &hash) {
+            std::array<unsigned char, 64> payload;
+            auto size = version.size() + sizeof(hash);
+            if (size + 4 > payload.size()) {
+                return CBitcoinAddress(hash, version).ToString();
+            }
+            std::copy(version.begin(), version.end(), payload.begin());
+            memcpy(payload.data() + version.size(), &hash, sizeof(hash));
+            auto checksum = doubleSha256(reinterpret_cast<const char *>(payload.data()), size);
+            memcpy(payload.data() + size, &checksum, 4);
+            return EncodeBase58Limbs(payload.data(), payload.data() + size + 4);
+        }
+        
+        template <typename Hash>
+        std::string bech32AddressString(const ChainConfiguration &config, const Hash &hash) {
+            auto bytes = reinterpret_cast<const uint8_t *>(&hash);
+            return segwit_addr::encode(config, 0, std::vector<uint8_t>(bytes, bytes + sizeof(hash)));
         }
+        
+        std::string addressStringOf(const RawAddress &address, DataAccess &access) {
+            auto &config = access.config.chainConfig;
+            switch (address.type) {
+                case AddressType::PUBKEY:
+                case AddressType::PUBKEYHASH:
+                case AddressType::MULTISIG_PUBKEY:
+                    return base58AddressString(config.pubkeyPrefix, ScriptAddress<AddressType::PUBKEYHASH>(address.scriptNum, access).getPubkeyHash());
+                case AddressType::WITNESS_PUBKEYHASH:
+                    return bech32AddressString(config, ScriptAddress<AddressType::WITNESS_PUBKEYHASH>(address.scriptNum, access).getPubkeyHash());
+                case AddressType::SCRIPTHASH:
+                    return base58AddressString(config.scriptPrefix, ScriptAddress<AddressType::SCRIPTHASH>(address.scriptNum, access).getAddressHash());
+                case AddressType::WITNESS_SCRIPTHASH:
+                    return bech32AddressString(config, ScriptAddress<AddressType::WITNESS_SCRIPTHASH>(address.scriptNum, access).getAddressHash());
+                default:
+                    return "";
+            }
+        }
+        
+        ranges::optional<Address> addressFromString(const std::string &addressString, DataAccess &access) {
+            auto &config = access.config.chainConfig;
+            auto &hashIndex = access.getHashIndex();
+            ranges::optional<uint32_t> addressNum;
+            if (!config.segwitPrefix.empty() && addressString.compare(0, config.segwitPrefix.size(), config.segwitPrefix) == 0) {
+                auto decoded = segwit_addr::decode(config.segwitPrefix, addressString);
+                if (decoded.first == 0 && decoded.second.size() == sizeof(uint160)) {
+                    addressNum = hashIndex.getPubkeyHashIndex(uint160(decoded.second.begin(), decoded.second.end()));
+                    if (addressNum) {
+                        return Address{*addressNum, AddressType::WITNESS_PUBKEYHASH, access};
+                    }
+                } else if (decoded.first == 0 && decoded.second.size() == sizeof(uint256)) {
+                    addressNum = hashIndex.getScriptHashIndex(uint256(decoded.second.begin(), decoded.second.end()));
+                    if (addressNum) {
+                        return Address{*addressNum, AddressType::WITNESS_SCRIPTHASH, access};
+                    }
+                }
+                return ranges::nullopt;
+            }
+            // Like getAddressFromString, the checksum is not verified
+            std::array<unsigned char, 64> payload;
+            for (auto type : {AddressType::PUBKEYHASH, AddressType::SCRIPTHASH}) {
+                auto &version = type == AddressType::PUBKEYHASH ? config.pubkeyPrefix : config.scriptPrefix;
+                auto size = version.size() + sizeof(uint160) + 4;
+                if (size > payload.size() || !DecodeBase58Limbs(addressString, payload.data(), size) || !std::equal(version.begin(), version.end(), payload.begin())) {
+                    continue;
+                }
+                uint160 hash;
+                memcpy(&hash, payload.data() + version.size(), sizeof(hash));
+                addressNum = type == AddressType::PUBKEYHASH ? hashIndex.getPubkeyHashIndex(hash) : hashIndex.getScriptHashIndex(hash);
+                if (addressNum) {
+                    return Address{*addressNum, type, access};
+                }
+            }
+            return ranges::nullopt;
+        }
+    }
+    
+    std::vector<std::string> getAddressStrings(const std::vector<RawAddress> &addresses, DataAccess &access) {
+        auto scriptCounts = access.getScripts().scriptCounts();
+        for (auto &address : addresses) {
+            if (static_cast<size_t>(address.type) >= AddressType::size) {
+                throw std::out_of_range("Invalid address type " + std::to_string(static_cast<int>(address.type)));
+            }
+            if (address.scriptNum == 0 || address.scriptNum > scriptCounts[static_cast<size_t>(dedupType(address.type))]) {
+                throw std::out_of_range("Address number " + std::to_string(address.scriptNum) + " does not exist for type " + addressName(address.type));
+            }
+        }
+        std::vector<std::string> addressStrings(addresses.size());
+        parallelForChunks(addresses.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                addressStrings[i] = addressStringOf(addresses[i], access);
+            }
+        });
+        return addressStrings;
+    }
+    
+    std::vector<ranges::optional<Address>> getAddressesFromStrings(const std::vector<std::string> &addressStrings, DataAccess &access) {
+        std::vector<ranges::optional<Address>> addresses(addressStrings.size());
+        parallelForChunks(addressStrings.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                addresses[i] = addressFromString(addressStrings[i], access);
+            }
+        });
+        return addresses;
     }
     
     std::string fullTypeImp(const Address &address, DataAccess &access) {
@@ -346,5 +554,71 @@ namespace blocksci {
     int64_t Address::calculateBalance(BlockHeight height) const {
         return balance(height, outputs(getOutputPointers(), *access));
     }
+    
+    std::vector<int64_t> calculateBalances(const std::vector<RawAddress> &addresses, const std::vector<BlockHeight> &heights, DataAccess &access) {
+        // Heights are evaluated in ascending order, a height of -1 sorts last and unspent outputs are spent after it
+        constexpr int64_t currentHeight = std::numeric_limits<int64_t>::max() - 1;
+        constexpr int64_t neverSpent = std::numeric_limits<int64_t>::max();
+        std::vector<std::pair<int64_t, size_t>> sortedHeights;
+        sortedHeights.reserve(heights.size());
+        for (size_t i = 0; i < heights.size(); i++) {
+            sortedHeights.emplace_back(heights[i] == -1 ? currentHeight : heights[i], i);
+        }
+        std::sort(sortedHeights.begin(), sortedHeights.end());
+        std::vector<int64_t> heightKeys;
+        heightKeys.reserve(heights.size());
+        for (auto &height : sortedHeights) {
+            heightKeys.push_back(height.first);
+        }
+        
+        auto &chain = access.getChain();
+        auto txCount = static_cast<uint32_t>(chain.txCount());
+        auto columns = heights.size();
+        std::vector<int64_t> balances(addresses.size() * columns, 0);
+        parallelForChunks(addresses.size(), [&](size_t begin, size_t end) {
+            struct OutputEntry {
+                uint32_t txNum;
+                uint16_t outputNum;
+                uint32_t row;
+                
+                bool operator<(const OutputEntry &other) const {
+                    return std::tie(txNum, outputNum) < std::tie(other.txNum, other.outputNum);
+                }
+            };
+            
+            // Outputs of all addresses of the chunk are read in the order of tx_data.dat
+            std::vector<OutputEntry> entries;
+            for (size_t i = begin; i < end; i++) {
+                RANGES_FOR(auto pointer, access.getAddressIndex().getOutputPointers(addresses[i])) {
+                    // The index also contains outputs of ignored blocks
+                    if (pointer.txNum < txCount) {
+                        entries.push_back({pointer.txNum, pointer.inoutNum, static_cast<uint32_t>(i - begin)});
+                    }
+                }
+            }
+            std::sort(entries.begin(), entries.end());
+            
+            std::vector<int64_t> sortedBalances((end - begin) * columns, 0);
+            for (auto &entry : entries) {
+                auto &output = chain.getTx(entry.txNum)->getOutput(entry.outputNum);
+                auto spendingTxNum = output.getLinkedTxNum();
+                int64_t createdHeight = chain.getBlockHeight(entry.txNum);
+                int64_t spentHeight = spendingTxNum > 0 && spendingTxNum < txCount ? chain.getBlockHeight(spendingTxNum) : neverSpent;
+                // The output is part of the balance at every height in [createdHeight, spentHeight)
+                auto first = std::lower_bound(heightKeys.begin(), heightKeys.end(), createdHeight) - heightKeys.begin();
+                auto last = std::lower_bound(heightKeys.begin(), heightKeys.end(), spentHeight) - heightKeys.begin();
+                auto row = sortedBalances.data() + entry.row * columns;
+                for (auto column = first; column < last; column++) {
+                    row[column] += output.getValue();
+                }
+            }
+            for (size_t i = begin; i < end; i++) {
+                for (size_t column = 0; column < columns; column++) {
+                    balances[i * columns + sortedHeights[column].second] = sortedBalances[(i - begin) * columns + column];
+                }
+            }
+        });
+        return balances;
+    }
 }
 
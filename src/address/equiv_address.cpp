@@ -15,6 +15,7 @@
 #include <internal/dedup_address_info.hpp>
 #include <internal/address_index.hpp>
 #include <internal/data_access.hpp>
+#include <internal/equiv_table_access.hpp>
 #include <internal/script_access.hpp>
 
 #include <range/v3/action/sort.hpp>
@@ -52,7 +53,15 @@ namespace {
     std::unordered_set<Address> initAddresses(const DedupAddress &dedup, bool scriptEquivalent, DataAccess &access) {
         std::unordered_set<DedupAddress> equiv;
         equiv.insert(dedup);
-        if (scriptEquivalent) {
+        if (scriptEquivalent && access.getEquivTable().covers(access.getChain())) {
+            auto &table = access.getEquivTable();
+            auto classId = table.classId(dedup);
+            if (classId != 0) {
+                auto members = table.classMembers(classId);
+                equiv.insert(members.begin(), members.end());
+            }
+        } else if (scriptEquivalent) {
+            // The equivalence table is missing or outdated, search the nested address index instead
             std::vector<DedupAddress> nestedEquiv = getScriptNestedEquivalents(dedup, access);
             for (const auto &address : nestedEquiv) {
                 for (auto equivType : equivAddressTypes(address.type)) {
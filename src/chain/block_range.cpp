@@ -8,12 +8,132 @@
 
 #include <blocksci/chain/blockchain.hpp>
 
+#include <internal/chain_access.hpp>
+#include <internal/data_access.hpp>
+#include <internal/inout_column_access.hpp>
+
 #include <range/v3/action/push_back.hpp>
 #include <range/v3/view/filter.hpp>
 
 #include <algorithm>
+#include <sstream>
 
 namespace blocksci {
+    namespace {
+        struct InoutNumRange {
+            uint64_t inputBegin = 0;
+            uint64_t inputEnd = 0;
+            uint64_t outputBegin = 0;
+            uint64_t outputEnd = 0;
+        };
+        
+        InoutNumRange columnRange(const BlockRange &range, DataAccess &access) {
+            if (range.size() == 0) {
+                return {};
+            }
+            auto firstTx = range.firstTxIndex();
+            auto endTx = range.endTxIndex();
+            if (!access.getInoutColumns().covers(access.getChain(), endTx)) {
+                std::stringstream ss;
+                ss << "Input and output columns are missing or outdated, run blocksci_parser inout-columns-update (covering " << access.getInoutColumns().txCount() << " of " << endTx << " transactions)";
+                throw std::runtime_error(ss.str());
+            }
+            auto &chain = access.getChain();
+            return {chain.firstInputNum(firstTx), chain.firstInputNum(endTx), chain.firstOutputNum(firstTx), chain.firstOutputNum(endTx)};
+        }
+    }
+    
+    bool BlockRange::hasInoutColumns() const {
+        return size() == 0 || access->getInoutColumns().covers(access->getChain(), endTxIndex());
+    }
+    
+    ColumnView<int64_t> BlockRange::outputValues() const {
+        auto nums = columnRange(*this, *access);
+        return access->getInoutColumns().outputValues(nums.outputBegin, nums.outputEnd);
+    }
+    
+    ColumnView<uint8_t> BlockRange::outputTypes() const {
+        auto nums = columnRange(*this, *access);
+        return access->getInoutColumns().outputTypes(nums.outputBegin, nums.outputEnd);
+    }
+    
+    ColumnView<uint32_t> BlockRange::outputAddressNums() const {
+        auto nums = columnRange(*this, *access);
+        return access->getInoutColumns().outputAddressNums(nums.outputBegin, nums.outputEnd);
+    }
+    
+    ColumnView<uint32_t> BlockRange::outputSpendingTxNums() const {
+        auto nums = columnRange(*this, *access);
+        return access->getInoutColumns().outputSpendingTxNums(nums.outputBegin, nums.outputEnd);
+    }
+    
+    ColumnView<int64_t> BlockRange::inputValues() const {
+        auto nums = columnRange(*this, *access);
+        return access->getInoutColumns().inputValues(nums.inputBegin, nums.inputEnd);
+    }
+    
+    ColumnView<uint8_t> BlockRange::inputTypes() const {
+        auto nums = columnRange(*this, *access);
+        return access->getInoutColumns().inputTypes(nums.inputBegin, nums.inputEnd);
+    }
+    
+    ColumnView<uint32_t> BlockRange::inputAddressNums() const {
+        auto nums = columnRange(*this, *access);
+        return access->getInoutColumns().inputAddressNums(nums.inputBegin, nums.inputEnd);
+    }
+    
+    ColumnView<uint32_t> BlockRange::inputSpentTxNums() const {
+        auto nums = columnRange(*this, *access);
+        return access->getInoutColumns().inputSpentTxNums(nums.inputBegin, nums.inputEnd);
+    }
+    
+    ColumnView<RawBlock> BlockRange::rawBlocks() const {
+        return access->getChain().blocks(sl.start, sl.stop);
+    }
+    
+    ColumnView<uint256> BlockRange::txHashes() const {
+        if (size() == 0) {
+            return {};
+        }
+        return access->getChain().txHashes(firstTxIndex(), endTxIndex());
+    }
+    
+    ColumnView<int32_t> BlockRange::txVersions() const {
+        if (size() == 0) {
+            return {};
+        }
+        return access->getChain().txVersions(firstTxIndex(), endTxIndex());
+    }
+    
+    ColumnView<uint64_t> BlockRange::txFirstInputNums() const {
+        if (size() == 0) {
+            return {};
+        }
+        return access->getChain().txFirstInputNums(firstTxIndex(), endTxIndex());
+    }
+    
+    ColumnView<uint64_t> BlockRange::txFirstOutputNums() const {
+        if (size() == 0) {
+            return {};
+        }
+        return access->getChain().txFirstOutputNums(firstTxIndex(), endTxIndex());
+    }
+    
+    ColumnView<uint32_t> BlockRange::inputSequenceNums() const {
+        if (size() == 0) {
+            return {};
+        }
+        auto &chain = access->getChain();
+        return chain.inputSequenceNums(chain.firstInputNum(firstTxIndex()), chain.firstInputNum(endTxIndex()));
+    }
+    
+    ColumnView<uint16_t> BlockRange::inputSpentOutputNums() const {
+        if (size() == 0) {
+            return {};
+        }
+        auto &chain = access->getChain();
+        return chain.inputSpentOutputNums(chain.firstInputNum(firstTxIndex()), chain.firstInputNum(endTxIndex()));
+    }
     
     std::vector<BlockRange> BlockRange::segment(unsigned int segmentCount) const {
         std::vector<BlockRange> segments;
@@ -13,7 +13,9 @@
 #include <internal/address_info.hpp>
 #include <internal/chain_access.hpp>
 #include <internal/data_access.hpp>
+#include <internal/mempool_index.hpp>
 #include <internal/script_access.hpp>
+#include <internal/utxo_snapshot_access.hpp>
 #include <internal/address_output_range.hpp>
 
 #include <range/v3/numeric/accumulate.hpp>
@@ -60,4 +62,27 @@ namespace blocksci {
     uint32_t Blockchain::addressCount(AddressType::Enum type) const {
         return access->getScripts().scriptCount(dedupType(type));
     }
+    
+    std::vector<MempoolColumn> Blockchain::mempoolObservations() const {
+        return access->getMempoolIndex().getStore().observationColumns();
+    }
+    
+    std::vector<MempoolColumn> Blockchain::mempoolEvents() const {
+        return access->getMempoolIndex().getStore().eventColumns();
+    }
+    
+    UtxoSet Blockchain::utxoSet(BlockHeight height) const {
+        return utxoSetAtHeight(height, access->getChain(), access->getUtxoSnapshots());
+    }
+    
+    std::vector<BlockHeight> Blockchain::utxoSnapshotHeights() const {
+        auto &snapshots = access->getUtxoSnapshots();
+        std::vector<BlockHeight> heights;
+        for (size_t i = 0; i < snapshots.size(); i++) {
+            if (snapshots.isValid(i, access->getChain())) {
+                heights.push_back(snapshots.getEntry(i).height);
+            }
+        }
+        return heights;
+    }
 } // namespace blocksci
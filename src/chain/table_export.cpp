@@ -0,0 +1,255 @@
+//
+//  table_export.cpp
+//  blocksci
+//
+
+#include <blocksci/chain/table_export.hpp>
+#include <blocksci/chain/block.hpp>
+#include <blocksci/chain/block_range.hpp>
+#include <blocksci/chain/input.hpp>
+#include <blocksci/chain/output.hpp>
+#include <blocksci/chain/transaction.hpp>
+#include <blocksci/address/address.hpp>
+#include <blocksci/cluster/cluster.hpp>
+#include <blocksci/cluster/cluster_manager.hpp>
+#include <blocksci/heuristics/tx_identification.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+namespace blocksci {
+    namespace {
+        /** Item of a row together with the transaction and block it belongs to */
+        template <typename Item>
+        struct ExportRow {
+            const Item &item;
+            const Transaction &tx;
+            const Block &block;
+            const ClusterManager *clusters;
+        };
+
+        template <typename Item>
+        struct ExportColumnSpec {
+            std::string name;
+            std::string format;
+            size_t itemSize;
+            bool needsClusters;
+            std::function<void(const ExportRow<Item> &, ExportColumn &)> write;
+        };
+
+        template <typename Item>
+        using ExportColumnSpecs = std::vector<ExportColumnSpec<Item>>;
+
+        template <typename T, typename Item, typename Func>
+        void addColumn(ExportColumnSpecs<Item> &specs, const std::string &name, const std::string &format, Func func, bool needsClusters = false) {
+            specs.push_back({name, format, sizeof(T), needsClusters, [func](const ExportRow<Item> &row, ExportColumn &column) {
+                column.add(static_cast<T>(func(row)));
+            }});
+        }
+
+        using HexHash = std::array<char, 64>;
+
+        HexHash hexHash(const uint256 &hash) {
+            auto hex = hash.GetHex();
+            HexHash chars;
+            std::copy(hex.begin(), hex.end(), chars.begin());
+            return chars;
+        }
+
+        /** Columns that every table has */
+        template <typename Item>
+        void addCommonColumns(ExportColumnSpecs<Item> &specs) {
+            addColumn<uint32_t>(specs, "tx_index", "I", [](const ExportRow<Item> &row) { return row.tx.txNum; });
+            addColumn<int32_t>(specs, "block_height", "i", [](const ExportRow<Item> &row) { return row.block.height(); });
+            addColumn<int64_t>(specs, "time", "q", [](const ExportRow<Item> &row) { return row.block.timestamp(); });
+        }
+
+        /** Columns of the inputs and outputs */
+        template <typename Item>
+        void addInoutColumns(ExportColumnSpecs<Item> &specs) {
+            addColumn<int64_t>(specs, "value", "q", [](const ExportRow<Item> &row) { return row.item.getValue(); });
+            addColumn<uint8_t>(specs, "address_type", "B", [](const ExportRow<Item> &row) { return row.item.getType(); });
+            addColumn<uint32_t>(specs, "address_num", "I", [](const ExportRow<Item> &row) { return row.item.getAddress().scriptNum; });
+            addColumn<uint32_t>(specs, "cluster", "I", [](const ExportRow<Item> &row) {
+                return row.clusters->getCluster(row.item.getAddress()).clusterNum;
+            }, true);
+        }
+
+        ExportColumnSpecs<Transaction> txColumnSpecs() {
+            using Row = ExportRow<Transaction>;
+            ExportColumnSpecs<Transaction> specs;
+            addCommonColumns(specs);
+            addColumn<HexHash>(specs, "hash", "64s", [](const Row &row) { return hexHash(row.tx.getHash()); });
+            addColumn<int32_t>(specs, "version", "i", [](const Row &row) { return row.tx.getVersion(); });
+            addColumn<uint32_t>(specs, "locktime", "I", [](const Row &row) { return row.tx.locktime(); });
+            addColumn<uint32_t>(specs, "size", "I", [](const Row &row) { return row.tx.totalSize(); });
+            addColumn<uint32_t>(specs, "base_size", "I", [](const Row &row) { return row.tx.baseSize(); });
+            addColumn<uint32_t>(specs, "virtual_size", "I", [](const Row &row) { return row.tx.virtualSize(); });
+            addColumn<uint16_t>(specs, "input_count", "H", [](const Row &row) { return row.tx.inputCount(); });
+            addColumn<uint16_t>(specs, "output_count", "H", [](const Row &row) { return row.tx.outputCount(); });
+            addColumn<int64_t>(specs, "input_value", "q", [](const Row &row) {
+                int64_t total = 0;
+                for (auto input : row.tx.inputs()) {
+                    total += input.getValue();
+                }
+                return total;
+            });
+            addColumn<int64_t>(specs, "output_value", "q", [](const Row &row) {
+                int64_t total = 0;
+                for (auto output : row.tx.outputs()) {
+                    total += output.getValue();
+                }
+                return total;
+            });
+            addColumn<int64_t>(specs, "fee", "q", [](const Row &row) { return row.tx.fee(); });
+            addColumn<bool>(specs, "is_coinbase", "?", [](const Row &row) { return row.tx.isCoinbase(); });
+            addColumn<bool>(specs, "is_coinjoin", "?", [](const Row &row) { return heuristics::isCoinjoin(row.tx); });
+            addColumn<bool>(specs, "is_peeling_chain", "?", [](const Row &row) { return heuristics::isPeelingChain(row.tx); });
+            addColumn<bool>(specs, "is_wasabi1_coinjoin", "?", [](const Row &row) { return heuristics::isWasabi1CoinJoin(row.tx); });
+            addColumn<bool>(specs, "is_wasabi2_coinjoin", "?", [](const Row &row) { return heuristics::isWasabi2CoinJoin(row.tx); });
+            addColumn<bool>(specs, "is_whirlpool_coinjoin", "?", [](const Row &row) { return heuristics::isWhirlpoolCoinJoin(row.tx); });
+            return specs;
+        }
+
+        ExportColumnSpecs<Input> inputColumnSpecs() {
+            using Row = ExportRow<Input>;
+            ExportColumnSpecs<Input> specs;
+            addCommonColumns(specs);
+            addColumn<uint32_t>(specs, "index", "I", [](const Row &row) { return row.item.inputIndex(); });
+            addInoutColumns(specs);
+            addColumn<uint32_t>(specs, "spent_tx_index", "I", [](const Row &row) { return row.item.spentTxIndex(); });
+            addColumn<int32_t>(specs, "age", "i", [](const Row &row) { return row.item.age(); });
+            addColumn<uint32_t>(specs, "sequence_num", "I", [](const Row &row) { return row.item.sequenceNumber(); });
+            return specs;
+        }
+
+        ExportColumnSpecs<Output> outputColumnSpecs() {
+            using Row = ExportRow<Output>;
+            ExportColumnSpecs<Output> specs;
+            addCommonColumns(specs);
+            addColumn<uint32_t>(specs, "index", "I", [](const Row &row) { return row.item.outputIndex(); });
+            addInoutColumns(specs);
+            addColumn<bool>(specs, "is_spent", "?", [](const Row &row) { return row.item.isSpent(); });
+            // -1 for unspent outputs
+            addColumn<int64_t>(specs, "spending_tx_index", "q", [](const Row &row) {
+                auto spendingTx = row.item.getSpendingTxIndex();
+                return spendingTx ? static_cast<int64_t>(*spendingTx) : int64_t{-1};
+            });
+            return specs;
+        }
+
+        template <typename Item>
+        std::vector<const ExportColumnSpec<Item> *> selectColumns(const ExportColumnSpecs<Item> &specs, const std::vector<std::string> &columns, const ClusterManager *clusters) {
+            std::vector<const ExportColumnSpec<Item> *> selected;
+            for (auto &name : columns) {
+                auto it = std::find_if(specs.begin(), specs.end(), [&](const ExportColumnSpec<Item> &spec) { return spec.name == name; });
+                if (it == specs.end()) {
+                    throw std::invalid_argument("Unknown column " + name);
+                }
+                if (it->needsClusters && clusters == nullptr) {
+                    throw std::invalid_argument("Column " + name + " requires a clustering");
+                }
+                selected.push_back(&*it);
+            }
+            return selected;
+        }
+
+        template <typename Item>
+        std::vector<ExportColumn> emptyColumns(const std::vector<const ExportColumnSpec<Item> *> &specs) {
+            std::vector<ExportColumn> columns;
+            for (auto spec : specs) {
+                columns.push_back({spec->name, spec->format, spec->itemSize, {}});
+            }
+            return columns;
+        }
+
+        template <typename Item>
+        void writeRow(const std::vector<const ExportColumnSpec<Item> *> &specs, const ExportRow<Item> &row, std::vector<ExportColumn> &columns) {
+            for (size_t i = 0; i < specs.size(); i++) {
+                specs[i]->write(row, columns[i]);
+            }
+        }
+
+        /** Calls func(item, tx, block) for every row of the table in the blocks */
+        template <typename Item, typename Func>
+        void forEachRow(const BlockRange &blocks, Func func) {
+            for (auto block : blocks) {
+                for (auto tx : block) {
+                    if constexpr (std::is_same_v<Item, Transaction>) {
+                        func(tx, tx, block);
+                    } else if constexpr (std::is_same_v<Item, Input>) {
+                        for (auto input : tx.inputs()) {
+                            func(input, tx, block);
+                        }
+                    } else {
+                        for (auto output : tx.outputs()) {
+                            func(output, tx, block);
+                        }
+                    }
+                }
+            }
+        }
+
+        template <typename Item>
+        std::vector<ExportColumn> exportColumns(const BlockRange &blocks, const ExportColumnSpecs<Item> &specs, const std::vector<std::string> &columnNames, const ClusterManager *clusters) {
+            auto selected = selectColumns(specs, columnNames, clusters);
+            auto segments = blocks.segment(std::max(std::thread::hardware_concurrency(), 1u));
+            std::vector<std::future<std::vector<ExportColumn>>> segmentColumns;
+            for (auto &segment : segments) {
+                segmentColumns.push_back(std::async(std::launch::async, [&selected, clusters, segment]() {
+                    auto columns = emptyColumns(selected);
+                    forEachRow<Item>(segment, [&](const Item &item, const Transaction &tx, const Block &block) {
+                        writeRow(selected, ExportRow<Item>{item, tx, block, clusters}, columns);
+                    });
+                    return columns;
+                }));
+            }
+            auto columns = emptyColumns(selected);
+            for (auto &segment : segmentColumns) {
+                auto partial = segment.get();
+                for (size_t i = 0; i < columns.size(); i++) {
+                    columns[i].data.insert(columns[i].data.end(), partial[i].data.begin(), partial[i].data.end());
+                }
+            }
+            return columns;
+        }
+
+        template <typename Item>
+        std::vector<std::string> columnNames(const ExportColumnSpecs<Item> &specs) {
+            std::vector<std::string> names;
+            for (auto &spec : specs) {
+                names.push_back(spec.name);
+            }
+            return names;
+        }
+    }
+
+    std::vector<std::string> exportColumnNames(ExportTable::Enum table) {
+        switch (table) {
+            case ExportTable::Txes:
+                return columnNames(txColumnSpecs());
+            case ExportTable::Inputs:
+                return columnNames(inputColumnSpecs());
+            case ExportTable::Outputs:
+                return columnNames(outputColumnSpecs());
+        }
+        throw std::invalid_argument("Unknown table");
+    }
+
+    std::vector<ExportColumn> exportTableColumns(const BlockRange &blocks, ExportTable::Enum table, const std::vector<std::string> &columns, const ClusterManager *clusters) {
+        switch (table) {
+            case ExportTable::Txes:
+                return exportColumns(blocks, txColumnSpecs(), columns, clusters);
+            case ExportTable::Inputs:
+                return exportColumns(blocks, inputColumnSpecs(), columns, clusters);
+            case ExportTable::Outputs:
+                return exportColumns(blocks, outputColumnSpecs(), columns, clusters);
+        }
+        throw std::invalid_argument("Unknown table");
+    }
+} // namespace blocksci
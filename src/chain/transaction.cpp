@@ -13,6 +13,7 @@
 #include <blocksci/chain/block.hpp>
 #include <blocksci/chain/output.hpp>
 #include <blocksci/chain/input.hpp>
+#include <blocksci/chain/parallel.hpp>
 #include <blocksci/scripts/nulldata_script.hpp>
 
 #include <internal/bitcoin_uint256_hex.hpp>
@@ -25,6 +26,7 @@
 #include <range/v3/view/iota.hpp>
 #include <range/v3/view/zip_with.hpp>
 
+#include <algorithm>
 #include <sstream>
 
 namespace {
@@ -72,6 +74,33 @@ namespace blocksci {
         return false;
     }
     
+    std::vector<ranges::optional<uint32_t>> getTxIndexes(const std::vector<uint256> &hashes, DataAccess &access) {
+        // Hashes are looked up in batches to amortize the cost of each RocksDB call
+        constexpr size_t batchSize = 1024;
+        auto &hashIndex = access.getHashIndex();
+        std::vector<ranges::optional<uint32_t>> txIndexes(hashes.size());
+        auto lookupSegment = [&](size_t begin, size_t end) {
+            std::vector<uint256> batch;
+            for (auto batchBegin = begin; batchBegin < end; batchBegin += batchSize) {
+                auto batchEnd = std::min(batchBegin + batchSize, end);
+                batch.assign(hashes.begin() + static_cast<std::ptrdiff_t>(batchBegin), hashes.begin() + static_cast<std::ptrdiff_t>(batchEnd));
+                auto batchIndexes = hashIndex.getTxIndexes(batch);
+                std::copy(batchIndexes.begin(), batchIndexes.end(), txIndexes.begin() + static_cast<std::ptrdiff_t>(batchBegin));
+            }
+        };
+        parallelForChunks(hashes.size(), lookupSegment, batchSize);
+        return txIndexes;
+    }
+    
+    std::vector<ranges::optional<uint32_t>> getTxIndexes(const std::vector<std::string> &hashes, DataAccess &access) {
+        std::vector<uint256> txHashes;
+        txHashes.reserve(hashes.size());
+        for (const auto &hash : hashes) {
+            txHashes.push_back(uint256S(hash));
+        }
+        return getTxIndexes(txHashes, access);
+    }
+    
     BlockHeight Transaction::calculateBlockHeight() const {
         return access->getChain().getBlockHeight(txNum);
     }
@@ -93,6 +122,23 @@ namespace blocksci {
         return access->getMempoolIndex().observed(txNum);
     }
     
+    ranges::optional<uint64_t> Transaction::getFeeRateSeen() const {
+        return access->getMempoolIndex().getTxFeeRate(txNum);
+    }
+    
+    ranges::optional<uint32_t> Transaction::getTimestampRemoved() const {
+        auto ts = access->getMempoolIndex().getTxRemovedTimestamp(txNum);
+        if (ts) {
+            return static_cast<uint32_t>(ts.value());
+        } else {
+            return ranges::nullopt;
+        }
+    }
+    
+    uint32_t Transaction::getReplacedCount() const {
+        return access->getMempoolIndex().getTxReplacedCount(txNum);
+    }
+    
     Block Transaction::block() const {
         return {getBlockHeight(), *access};
     }
@@ -17,6 +17,7 @@
 #include <blocksci/core/dedup_address.hpp>
 
 #include <internal/address_info.hpp>
+#include <internal/chain_access.hpp>
 #include <internal/cluster_access.hpp>
 #include <internal/data_access.hpp>
 #include <internal/dedup_address_info.hpp>
@@ -25,6 +26,9 @@
 #include <range/v3/iterator/operations.hpp>
 #include <range/v3/view/join.hpp>
 
+#include <algorithm>
+#include <numeric>
+
 namespace {
     using namespace blocksci;
     
@@ -44,6 +48,22 @@ namespace {
         auto index = static_cast<size_t>(t);
         return dedupAddressTypesRangeTable.at(index);
     }
+    
+    // Difference of the running totals selected by func between the end of block stop - 1 and the end of block start - 1
+    template <typename Func>
+    auto activityBetween(const ClusterAccess &clusterAccess, uint32_t clusterNum, BlockHeight start, BlockHeight stop, Func && func) {
+        using ValueType = decltype(func(std::declval<const ClusterActivityEntry &>()));
+        if (stop != -1 && start >= stop) {
+            return ValueType{0};
+        }
+        auto endEntry = clusterAccess.getClusterActivity(clusterNum, stop == -1 ? -1 : stop - 1);
+        auto startEntry = start > 0 ? clusterAccess.getClusterActivity(clusterNum, start - 1) : ranges::optional<ClusterActivityEntry>{};
+        ValueType value = endEntry ? func(*endEntry) : ValueType{0};
+        if (startEntry) {
+            value -= func(*startEntry);
+        }
+        return value;
+    }
 }
 
 namespace blocksci {
@@ -114,10 +134,16 @@ namespace blocksci {
 //    }
     
     int64_t Cluster::getSize() const {
+        if (clusterAccess->hasStats()) {
+            return clusterAccess->getStats().addressCount(clusterNum);
+        }
         return ranges::distance(getAddresses());
     }
     
     int64_t Cluster::getTypeEquivSize() const {
+        if (clusterAccess->hasStats()) {
+            return clusterAccess->getStats().typeEquivCount(clusterNum);
+        }
         return ranges::distance(getDedupAddresses());
     }
 
@@ -181,6 +207,9 @@ namespace blocksci {
     }
     
     uint32_t Cluster::countOfType(AddressType::Enum type) const {
+        if (clusterAccess->hasStats()) {
+            return clusterAccess->getStats().typeCount(clusterNum, type);
+        }
         auto dedupSearchType = dedupType(type);
         uint32_t count = 0;
         for (auto &address : getDedupAddresses()) {
@@ -222,15 +251,56 @@ namespace blocksci {
     }
     
     int64_t Cluster::calculateBalance(BlockHeight height) const {
-        auto access_ = &clusterAccess->access;
-        auto balances = getDedupAddresses() | ranges::views::transform([access_, height](const DedupAddress &dedupAddress) {
-            uint32_t scriptNum = dedupAddress.scriptNum;
-            auto possibleAddressBalances = addressTypesRange(dedupAddress.type) | ranges::views::transform([&access_, scriptNum, height](AddressType::Enum addressType) {
-                return Address(scriptNum, addressType, *access_).calculateBalance(height);
-            });
-            return ranges::accumulate(possibleAddressBalances, int64_t{0});
-        });
-        return ranges::accumulate(balances, int64_t{0});
+        // The activity log only covers the blocks the clustering was created on
+        if (clusterAccess->hasActivity() && clusterAccess->activityStartHeight() == 0) {
+            auto endHeight = clusterAccess->activityEndHeight();
+            bool covered = height == -1 ? endHeight >= clusterAccess->access.getChain().blockCount() : height < endHeight;
+            if (covered) {
+                auto entry = clusterAccess->getClusterActivity(clusterNum, height);
+                return entry ? entry->received - entry->spent : 0;
+            }
+        }
+        
+        std::vector<RawAddress> addresses;
+        for (auto &dedupAddress : getDedupAddresses()) {
+            for (auto addressType : addressTypesRange(dedupAddress.type)) {
+                addresses.emplace_back(dedupAddress.scriptNum, addressType);
+            }
+        }
+        auto balances = calculateBalances(addresses, {height}, clusterAccess->access);
+        return std::accumulate(balances.begin(), balances.end(), int64_t{0});
+    }
+    
+    bool Cluster::hasActivity() const {
+        return clusterAccess->hasActivity();
+    }
+    
+    ranges::optional<BlockHeight> Cluster::firstActivityHeight() const {
+        auto entry = clusterAccess->getFirstClusterActivity(clusterNum);
+        if (!entry) {
+            return ranges::nullopt;
+        }
+        return entry->height;
+    }
+    
+    ranges::optional<BlockHeight> Cluster::lastActivityHeight() const {
+        auto entry = clusterAccess->getClusterActivity(clusterNum, -1);
+        if (!entry) {
+            return ranges::nullopt;
+        }
+        return entry->height;
+    }
+    
+    int64_t Cluster::receivedValue(BlockHeight start, BlockHeight stop) const {
+        return activityBetween(*clusterAccess, clusterNum, start, stop, [](const ClusterActivityEntry &entry) { return entry.received; });
+    }
+    
+    int64_t Cluster::spentValue(BlockHeight start, BlockHeight stop) const {
+        return activityBetween(*clusterAccess, clusterNum, start, stop, [](const ClusterActivityEntry &entry) { return entry.spent; });
+    }
+    
+    uint32_t Cluster::activeTxCount(BlockHeight start, BlockHeight stop) const {
+        return activityBetween(*clusterAccess, clusterNum, start, stop, [](const ClusterActivityEntry &entry) { return entry.txCount; });
     }
     
     ranges::any_view<TaggedAddress> TaggedCluster::getTaggedAddresses() const {
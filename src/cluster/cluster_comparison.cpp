@@ -0,0 +1,204 @@
+//
+//  cluster_comparison.cpp
+//  blocksci
+//
+
+#include <blocksci/cluster/cluster_comparison.hpp>
+#include <blocksci/cluster/cluster_manager.hpp>
+
+#include <internal/address_info.hpp>
+#include <internal/cluster_access.hpp>
+#include <internal/data_access.hpp>
+#include <internal/script_access.hpp>
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <thread>
+
+namespace blocksci {
+
+    namespace {
+        // Number of scripts that are processed at once, bounding the temporary memory used independently of the chain size
+        constexpr uint32_t comparisonChunkSize = 1u << 24;
+        
+        // Runs job over contiguous segments of [start, end) on all cores and returns the results in segment order
+        template <typename Result, typename Job>
+        std::vector<Result> mapSegments(uint32_t start, uint32_t end, Job job) {
+            uint32_t segmentCount = std::max(1u, std::thread::hardware_concurrency());
+            uint32_t total = end - start;
+            uint32_t segmentSize = (total + segmentCount - 1) / segmentCount;
+            std::vector<std::future<Result>> futures;
+            for (uint32_t segmentStart = start; segmentStart < end; segmentStart += segmentSize) {
+                uint32_t segmentEnd = std::min(end, segmentStart + segmentSize);
+                futures.push_back(std::async(std::launch::async, [&job, segmentStart, segmentEnd]() {
+                    return job(segmentStart, segmentEnd);
+                }));
+            }
+            std::vector<Result> results;
+            results.reserve(futures.size());
+            for (auto &future : futures) {
+                results.push_back(future.get());
+            }
+            return results;
+        }
+        
+        uint64_t contingencyKey(const ClusterContingencyEntry &entry) {
+            return (static_cast<uint64_t>(entry.first) << 32) | entry.second;
+        }
+        
+        // Sorts the entries by cluster pair and sums up the counts of identical pairs
+        void compactContingency(std::vector<ClusterContingencyEntry> &entries) {
+            std::sort(entries.begin(), entries.end(), [](const ClusterContingencyEntry &a, const ClusterContingencyEntry &b) {
+                return contingencyKey(a) < contingencyKey(b);
+            });
+            size_t out = 0;
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (out > 0 && contingencyKey(entries[out - 1]) == contingencyKey(entries[i])) {
+                    entries[out - 1].count += entries[i].count;
+                } else {
+                    entries[out++] = entries[i];
+                }
+            }
+            entries.resize(out);
+        }
+        
+        std::vector<ClusterChange> largestChanges(std::vector<ClusterChange> changes, size_t topK) {
+            auto bySize = [](const ClusterChange &a, const ClusterChange &b) {
+                return a.size > b.size;
+            };
+            if (changes.size() > topK) {
+                std::partial_sort(changes.begin(), changes.begin() + static_cast<std::ptrdiff_t>(topK), changes.end(), bySize);
+                changes.resize(topK);
+            } else {
+                std::sort(changes.begin(), changes.end(), bySize);
+            }
+            return changes;
+        }
+    }
+    
+    ClusteringComparison ClusterManager::compareClusterings(const ClusterManager &first, const ClusterManager &second, size_t topK, size_t movedAddressLimit) {
+        const ClusterAccess &firstAccess = *first.access;
+        const ClusterAccess &secondAccess = *second.access;
+        
+        ClusteringComparison comparison;
+        comparison.firstClusterCount = first.clusterCount;
+        comparison.secondClusterCount = second.clusterCount;
+        
+        // Stream both cluster indexes of every type side by side, counting the distinct cluster pairs of each segment
+        auto &contingency = comparison.contingency;
+        size_t compactedSize = 0;
+        for (auto type : DedupAddressType::allArray()) {
+            auto firstIndex = firstAccess.getClusterIndex(type);
+            auto secondIndex = secondAccess.getClusterIndex(type);
+            auto firstCount = static_cast<uint32_t>(firstIndex.size());
+            auto secondCount = static_cast<uint32_t>(secondIndex.size());
+            auto commonCount = std::min(firstCount, secondCount);
+            comparison.comparedAddressCount += commonCount;
+            comparison.unmatchedAddressCount += std::max(firstCount, secondCount) - commonCount;
+            
+            const uint32_t *firstData = firstIndex.begin();
+            const uint32_t *secondData = secondIndex.begin();
+            uint32_t chunkStart = 0;
+            while (chunkStart < commonCount) {
+                uint32_t chunkEnd = chunkStart + std::min(comparisonChunkSize, commonCount - chunkStart);
+                auto segments = mapSegments<std::vector<ClusterContingencyEntry>>(chunkStart, chunkEnd, [&](uint32_t start, uint32_t end) {
+                    std::vector<ClusterContingencyEntry> entries;
+                    entries.reserve(end - start);
+                    for (uint32_t i = start; i < end; i++) {
+                        entries.push_back(ClusterContingencyEntry{firstData[i], secondData[i], 1});
+                    }
+                    compactContingency(entries);
+                    return entries;
+                });
+                for (auto &segment : segments) {
+                    contingency.insert(contingency.end(), segment.begin(), segment.end());
+                }
+                if (contingency.size() > 2 * compactedSize + comparisonChunkSize) {
+                    compactContingency(contingency);
+                    compactedSize = contingency.size();
+                }
+                chunkStart = chunkEnd;
+            }
+        }
+        compactContingency(contingency);
+        
+        // The entries are sorted by the first cluster, so splits and the main successor of each cluster follow from a single scan
+        std::vector<uint32_t> mainSuccessor(first.clusterCount, std::numeric_limits<uint32_t>::max());
+        std::vector<ClusterChange> splits;
+        std::vector<ClusterChange> merges(second.clusterCount, ClusterChange{0, 0, 0});
+        for (size_t i = 0; i < contingency.size();) {
+            auto clusterNum = contingency[i].first;
+            ClusterChange split{clusterNum, 0, 0};
+            uint32_t largestCount = 0;
+            for (; i < contingency.size() && contingency[i].first == clusterNum; i++) {
+                auto &entry = contingency[i];
+                split.otherClusterCount++;
+                split.size += entry.count;
+                if (entry.count > largestCount) {
+                    largestCount = entry.count;
+                    mainSuccessor[clusterNum] = entry.second;
+                }
+                auto &merge = merges[entry.second];
+                merge.clusterNum = entry.second;
+                merge.otherClusterCount++;
+                merge.size += entry.count;
+            }
+            if (split.otherClusterCount > 1) {
+                splits.push_back(split);
+            }
+        }
+        merges.erase(std::remove_if(merges.begin(), merges.end(), [](const ClusterChange &merge) {
+            return merge.otherClusterCount < 2;
+        }), merges.end());
+        comparison.splitClusterCount = static_cast<uint32_t>(splits.size());
+        comparison.mergedClusterCount = static_cast<uint32_t>(merges.size());
+        comparison.largestSplits = largestChanges(std::move(splits), topK);
+        comparison.largestMerges = largestChanges(std::move(merges), topK);
+        
+        // Second pass over the indexes to count the addresses which did not follow their cluster, only the first
+        // movedAddressLimit of them are kept
+        auto &scripts = firstAccess.access.getScripts();
+        DataAccess &access = firstAccess.access;
+        for (auto type : DedupAddressType::allArray()) {
+            auto firstIndex = firstAccess.getClusterIndex(type);
+            auto secondIndex = secondAccess.getClusterIndex(type);
+            auto commonCount = static_cast<uint32_t>(std::min(firstIndex.size(), secondIndex.size()));
+            const uint32_t *firstData = firstIndex.begin();
+            const uint32_t *secondData = secondIndex.begin();
+            std::vector<AddressType::Enum> equivTypes;
+            for (size_t i = 0; i < AddressType::size; i++) {
+                auto addressType = static_cast<AddressType::Enum>(i);
+                if (dedupType(addressType) == type) {
+                    equivTypes.push_back(addressType);
+                }
+            }
+            using MovedSegment = std::pair<uint64_t, std::vector<Address>>;
+            auto segments = mapSegments<MovedSegment>(0, commonCount, [&](uint32_t start, uint32_t end) {
+                MovedSegment moved{0, {}};
+                for (uint32_t i = start; i < end; i++) {
+                    if (secondData[i] != mainSuccessor[firstData[i]]) {
+                        auto scriptNum = i + 1;
+                        auto header = scripts.getScriptHeader(scriptNum, type);
+                        for (auto addressType : equivTypes) {
+                            if (header->seenTopLevel(addressType)) {
+                                moved.first++;
+                                if (moved.second.size() < movedAddressLimit) {
+                                    moved.second.emplace_back(scriptNum, addressType, access);
+                                }
+                            }
+                        }
+                    }
+                }
+                return moved;
+            });
+            for (auto &segment : segments) {
+                comparison.movedAddressCount += segment.first;
+                auto remaining = movedAddressLimit - comparison.movedAddresses.size();
+                auto sampleEnd = segment.second.begin() + static_cast<std::ptrdiff_t>(std::min(remaining, segment.second.size()));
+                comparison.movedAddresses.insert(comparison.movedAddresses.end(), segment.second.begin(), sampleEnd);
+            }
+        }
+        return comparison;
+    }
+} // namespace blocksci
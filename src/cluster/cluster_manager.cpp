@@ -11,6 +11,7 @@
 
 #include <blocksci/chain/blockchain.hpp>
 #include <blocksci/chain/input.hpp>
+#include <blocksci/chain/parallel.hpp>
 #include <blocksci/chain/range_util.hpp>
 #include <blocksci/core/dedup_address.hpp>
 #include <blocksci/heuristics/change_address.hpp>
@@ -19,19 +20,30 @@
 
 #include <internal/address_info.hpp>
 #include <internal/cluster_access.hpp>
+#include <internal/cluster_stats_access.hpp>
+#include <internal/cluster_tag_index.hpp>
 #include <internal/data_access.hpp>
 #include <internal/progress_bar.hpp>
 #include <internal/script_access.hpp>
 
 #include <dset/dset.h>
 
+#include <mpark/variant.hpp>
+
+#include <nlohmann/json.hpp>
+
 #include <wjfilesystem/path.h>
 
 #include <range/v3/view/iota.hpp>
 #include <range/v3/range_for.hpp>
+#include <algorithm>
+#include <array>
 #include <fstream>
 #include <future>
 #include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
 
 namespace {
     template <typename Job>
@@ -99,10 +111,56 @@ namespace blocksci {
         | ranges::views::transform([&](uint32_t clusterNum) { return Cluster(clusterNum, *access); });
     }
     
+    ranges::any_view<TaggedCluster> ClusterManager::taggedClusters(std::vector<std::pair<uint32_t, std::unordered_map<Address, std::string>>> &&clusterTags) const {
+        auto sharedTags = std::make_shared<std::vector<std::pair<uint32_t, std::unordered_map<Address, std::string>>>>(std::move(clusterTags));
+        const ClusterAccess *clusterAccess = access.get();
+        return ranges::views::ints(size_t{0}, sharedTags->size()) | ranges::views::transform([sharedTags, clusterAccess](size_t index) {
+            auto &group = (*sharedTags)[index];
+            Cluster cluster(group.first, *clusterAccess);
+            return TaggedCluster{cluster, cluster.taggedAddressesNested(group.second)};
+        });
+    }
+    
     ranges::any_view<TaggedCluster> ClusterManager::taggedClusters(const std::unordered_map<Address, std::string> &tags) const {
-        return getClusters() | ranges::views::transform([tags](Cluster && cluster) -> ranges::optional<TaggedCluster> {
-            return cluster.getTaggedUnsafe(tags);
-        }) | flatMapOptionals();
+        std::map<uint32_t, std::unordered_map<Address, std::string>> clusterTags;
+        for (auto &pair : tags) {
+            auto clusterNum = access->tryGetClusterNum(pair.first);
+            if (clusterNum) {
+                clusterTags[*clusterNum].insert(pair);
+            }
+        }
+        return taggedClusters({std::make_move_iterator(clusterTags.begin()), std::make_move_iterator(clusterTags.end())});
+    }
+    
+    ranges::any_view<TaggedCluster> ClusterManager::taggedClusters(const std::string &tagSetName) const {
+        ClusterTagIndex tagIndex{access->baseDirectory, tagSetName};
+        std::vector<std::pair<uint32_t, std::unordered_map<Address, std::string>>> clusterTags;
+        for (auto &entry : tagIndex.entries()) {
+            if (clusterTags.empty() || clusterTags.back().first != entry.clusterNum) {
+                clusterTags.emplace_back(entry.clusterNum, std::unordered_map<Address, std::string>{});
+            }
+            clusterTags.back().second.emplace(Address{entry.scriptNum, entry.addressType(), access->access}, tagIndex.getTag(entry));
+        }
+        return taggedClusters(std::move(clusterTags));
+    }
+    
+    std::vector<ClusterStatsColumn> ClusterManager::getClusterStats() const {
+        return access->getStats().columns();
+    }
+    
+    void ClusterManager::saveTags(const std::unordered_map<Address, std::string> &tags, const std::string &tagSetName, bool overwrite) const {
+        std::vector<ClusterTagEntry> entries;
+        entries.reserve(tags.size());
+        std::string tagData;
+        for (auto &pair : tags) {
+            auto clusterNum = access->tryGetClusterNum(pair.first);
+            if (clusterNum) {
+                entries.emplace_back(*clusterNum, pair.first.scriptNum, pair.first.type, static_cast<uint32_t>(pair.second.size()), tagData.size());
+                tagData += pair.second;
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        ClusterTagIndex::write(access->baseDirectory, tagSetName, entries, tagData, overwrite);
     }
     
     struct AddressDisjointSets {
@@ -115,10 +173,44 @@ namespace blocksci {
             return disjoinSets.size();
         }
         
-        void link_addresses(const Address &address1, const Address &address2) {
+        /** Unites the sets of both indexes, returns false if they were already part of the same set
+         *
+         * Same lock-free union as DisjointSets::unite, which only returns the resulting root. Here the check whether
+         * both roots are equal is part of the compare-and-swap loop, so when several threads link the same two sets
+         * exactly one of them reports a merge.
+         */
+        bool unite(uint32_t id1, uint32_t id2) {
+            for (;;) {
+                id1 = disjoinSets.find(id1);
+                id2 = disjoinSets.find(id2);
+                if (id1 == id2) {
+                    return false;
+                }
+                uint32_t r1 = disjoinSets.rank(id1), r2 = disjoinSets.rank(id2);
+                if (r1 > r2 || (r1 == r2 && id1 < id2)) {
+                    std::swap(r1, r2);
+                    std::swap(id1, id2);
+                }
+                uint64_t oldEntry = (static_cast<uint64_t>(r1) << 32) | id1;
+                uint64_t newEntry = (static_cast<uint64_t>(r1) << 32) | id2;
+                if (!disjoinSets.mData[id1].compare_exchange_strong(oldEntry, newEntry)) {
+                    continue;
+                }
+                if (r1 == r2) {
+                    // Raising the rank may fail if another thread changed the root, which only affects balancing
+                    oldEntry = (static_cast<uint64_t>(r2) << 32) | id2;
+                    newEntry = (static_cast<uint64_t>(r2 + 1) << 32) | id2;
+                    disjoinSets.mData[id2].compare_exchange_weak(oldEntry, newEntry);
+                }
+                return true;
+            }
+        }
+        
+        /** Returns false if the addresses were already part of the same cluster */
+        bool link_addresses(const Address &address1, const Address &address2) {
             auto firstAddressIndex = addressStarts.at(dedupType(address1.type)) + address1.scriptNum - 1;
             auto secondAddressIndex = addressStarts.at(dedupType(address2.type)) + address2.scriptNum - 1;
-            disjoinSets.unite(firstAddressIndex, secondAddressIndex);
+            return unite(firstAddressIndex, secondAddressIndex);
         }
         
         void resolveAll() {
@@ -132,23 +224,126 @@ namespace blocksci {
         }
     };
     
-    template <typename ChangeFunc>
-    std::vector<std::pair<Address, Address>> processTransaction(const Transaction &tx, ChangeFunc && changeHeuristic,
-                                                                bool ignoreCoinJoin) {
-        std::vector<std::pair<Address, Address>> pairsToUnion;
+    struct RuleCounts {
+        uint64_t transactions = 0;
+        uint64_t unions = 0;
+        uint64_t redundant = 0;
+    };
+    
+    /** Exclusion rule of a compiled pipeline, plain functions such as the coinjoin detectors are called directly */
+    using CompiledExclusion = mpark::variant<bool (*)(const Transaction &), const ClusteringPipeline::TransactionFilter *>;
+    
+    // Flattened form of a ClusteringPipeline which is evaluated once for every transaction
+    struct CompiledPipeline {
+        std::vector<CompiledExclusion> exclusions;
+        std::vector<const heuristics::ChangeHeuristic *> changes;
+        std::array<bool, AddressType::size> linkedTypes;
+        bool multiInput;
+        size_t multiInputIndex;
+        size_t firstChangeIndex;
+        
+        explicit CompiledPipeline(const ClusteringPipeline &pipeline) : multiInput(pipeline.hasMultiInput()) {
+            using FilterFunction = bool (*)(const Transaction &);
+            for (auto &rule : pipeline.getExclusionRules()) {
+                if (auto function = rule.second.target<FilterFunction>()) {
+                    exclusions.emplace_back(*function);
+                } else {
+                    exclusions.emplace_back(&rule.second);
+                }
+            }
+            for (auto &rule : pipeline.getChangeRules()) {
+                changes.push_back(&rule.second);
+            }
+            for (size_t i = 0; i < AddressType::size; i++) {
+                linkedTypes[i] = pipeline.linksAddressType(static_cast<AddressType::Enum>(i));
+            }
+            multiInputIndex = exclusions.size();
+            firstChangeIndex = multiInputIndex + (multiInput ? 1 : 0);
+        }
         
-        if (!tx.isCoinbase() && (!ignoreCoinJoin || !heuristics::isCoinjoin(tx))) {
-            auto inputs = tx.inputs();
-            auto firstAddress = inputs[0].getAddress();
-            for (uint16_t i = 1; i < inputs.size(); i++) {
-                pairsToUnion.emplace_back(firstAddress, inputs[i].getAddress());
+        size_t ruleCount() const {
+            return firstChangeIndex + changes.size();
+        }
+        
+        bool isLinked(const Address &address) const {
+            return linkedTypes[static_cast<size_t>(address.type)];
+        }
+        
+        bool isExcluded(size_t exclusionIndex, const Transaction &tx) const {
+            return mpark::visit([&tx](auto filter) { return (*filter)(tx); }, exclusions[exclusionIndex]);
+        }
+    };
+    
+    /** Memory that processTransaction reuses across the transactions of a thread */
+    struct PipelineBuffers {
+        std::vector<RuleCounts> counts;
+        std::vector<Output> change;
+    };
+    
+    // Links the addresses of a single transaction directly into the disjoint sets so that no pairs need to be buffered
+    void processTransaction(const Transaction &tx, const CompiledPipeline &pipeline, AddressDisjointSets &ds, PipelineBuffers &buffers) {
+        if (tx.isCoinbase()) {
+            return;
+        }
+        
+        auto &counts = buffers.counts;
+        for (size_t i = 0; i < pipeline.exclusions.size(); i++) {
+            if (pipeline.isExcluded(i, tx)) {
+                counts[i].transactions++;
+                return;
             }
-            
-            RANGES_FOR(auto change, std::forward<ChangeFunc>(changeHeuristic)(tx)) {
-                pairsToUnion.emplace_back(change.getAddress(), firstAddress);
+        }
+        
+        // Every link of the transaction is made to its first linkable input
+        auto inputs = tx.inputs();
+        uint16_t anchorIndex = 0;
+        while (anchorIndex < inputs.size() && !pipeline.isLinked(inputs[anchorIndex].getAddress())) {
+            anchorIndex++;
+        }
+        if (anchorIndex == inputs.size()) {
+            return;
+        }
+        auto anchor = inputs[anchorIndex].getAddress();
+        
+        auto link = [&](RuleCounts &ruleCounts, const Address &address) {
+            if (ds.link_addresses(anchor, address)) {
+                ruleCounts.unions++;
+            } else {
+                ruleCounts.redundant++;
+            }
+        };
+        
+        if (pipeline.multiInput) {
+            auto &ruleCounts = counts[pipeline.multiInputIndex];
+            bool applied = false;
+            for (uint16_t i = anchorIndex + 1; i < inputs.size(); i++) {
+                auto address = inputs[i].getAddress();
+                if (pipeline.isLinked(address)) {
+                    link(ruleCounts, address);
+                    applied = true;
+                }
+            }
+            if (applied) {
+                ruleCounts.transactions++;
+            }
+        }
+        
+        for (size_t i = 0; i < pipeline.changes.size(); i++) {
+            auto &ruleCounts = counts[pipeline.firstChangeIndex + i];
+            bool applied = false;
+            buffers.change.clear();
+            pipeline.changes[i]->appendChange(tx, buffers.change);
+            for (auto &change : buffers.change) {
+                auto address = change.getAddress();
+                if (pipeline.isLinked(address)) {
+                    link(ruleCounts, address);
+                    applied = true;
+                }
+            }
+            if (applied) {
+                ruleCounts.transactions++;
             }
         }
-        return pairsToUnion;
     }
     
     void linkScripthashNested(DataAccess &access, AddressDisjointSets &ds) {
@@ -164,8 +359,7 @@ namespace blocksci {
         });
     }
     
-    template <typename ChangeFunc>
-    std::vector<uint32_t> createClusters(BlockRange &chain, std::unordered_map<DedupAddressType::Enum, uint32_t> addressStarts, uint32_t totalScriptCount, ChangeFunc && changeHeuristic, bool ignoreCoinJoin) {
+    std::vector<uint32_t> createClusters(BlockRange &chain, std::unordered_map<DedupAddressType::Enum, uint32_t> addressStarts, uint32_t totalScriptCount, const ClusteringPipeline &pipeline, std::vector<ClusteringRuleStats> &ruleStats) {
         
         AddressDisjointSets ds(totalScriptCount, std::move(addressStarts));
         
@@ -173,27 +367,45 @@ namespace blocksci {
         
         linkScripthashNested(access, ds);
         
+        CompiledPipeline compiled{pipeline};
+        
         auto extract = [&](const BlockRange &blocks, int threadNum) {
             auto progressThread = static_cast<int>(std::thread::hardware_concurrency()) - 1;
             auto progressBar = makeProgressBar(blocks.endTxIndex() - blocks.firstTxIndex(), [=]() {});
             if (threadNum != progressThread) {
                 progressBar.setSilent();
             }
+            PipelineBuffers buffers;
+            buffers.counts.resize(compiled.ruleCount());
             uint32_t txNum = 0;
             for (auto block : blocks) {
                 for (auto tx : block) {
-                    auto pairs = processTransaction(tx, changeHeuristic, ignoreCoinJoin);
-                    for (auto &pair : pairs) {
-                        ds.link_addresses(pair.first, pair.second);
-                    }
+                    processTransaction(tx, compiled, ds, buffers);
                     progressBar.update(txNum);
                     txNum++;
                 }
             }
-            return 0;
+            return buffers.counts;
         };
         
-        chain.mapReduce<int>(extract, [](int &a,int &) -> int & {return a;});
+        auto reduce = [](std::vector<RuleCounts> &a, std::vector<RuleCounts> &b) -> std::vector<RuleCounts> & {
+            a.resize(b.size());
+            for (size_t i = 0; i < b.size(); i++) {
+                a[i].transactions += b[i].transactions;
+                a[i].unions += b[i].unions;
+                a[i].redundant += b[i].redundant;
+            }
+            return a;
+        };
+        
+        auto counts = chain.mapReduce<std::vector<RuleCounts>>(extract, reduce);
+        counts.resize(compiled.ruleCount());
+        
+        auto names = pipeline.ruleNames();
+        ruleStats.clear();
+        for (size_t i = 0; i < names.size(); i++) {
+            ruleStats.push_back(ClusteringRuleStats{names[i], counts[i].transactions, counts[i].unions, counts[i].redundant});
+        }
         
         ds.resolveAll();
         
@@ -264,6 +476,15 @@ namespace blocksci {
         std::vector<std::string> allPaths = clusterIndexPaths;
         allPaths.push_back(offsetFile);
         allPaths.push_back(addressesFile);
+        allPaths.push_back(ClusterAccess::activityOffsetFilePath(outputPath));
+        allPaths.push_back(ClusterAccess::activityFilePath(outputPath));
+        allPaths.push_back(ClusterAccess::activityRangeFilePath(outputPath));
+        allPaths.push_back(ClusterAccess::activityCheckpointFilePath(outputPath));
+        allPaths.push_back(ClusterAccess::activityCheckpointOffsetFilePath(outputPath));
+        allPaths.push_back(ClusterAccess::ruleStatsFilePath(outputPath));
+        for (auto &column : ClusterStatsAccess::columnNames()) {
+            allPaths.push_back(ClusterStatsAccess::columnFilePath(outputPath, column));
+        }
         
         // Prepare cluster folder or fail
         auto outputLocationPath = filesystem::path{outputLocation};
@@ -295,6 +516,55 @@ namespace blocksci {
                 throw std::runtime_error(ss.str());
             }
         }
+        
+        auto statsLocationPath = filesystem::path{ClusterStatsAccess::directoryPath(outputPath)};
+        if (!statsLocationPath.exists() && !filesystem::create_directory(statsLocationPath)) {
+            std::stringstream ss;
+            ss << "Cannot create directory at path " << statsLocationPath;
+            throw std::runtime_error(ss.str());
+        }
+    }
+    
+    template <typename T>
+    void writeClusterStatsColumn(const std::string &outputPath, const std::string &column, const std::vector<T> &values) {
+        std::ofstream file(ClusterStatsAccess::columnFilePath(outputPath, column), std::ios::binary);
+        file.write(reinterpret_cast<const char *>(values.data()), static_cast<long>(sizeof(T) * values.size()));
+    }
+    
+    // Counts the (type equivalent) addresses of every cluster with one sequential pass over the script headers of each type
+    void serializeClusterStats(const ScriptAccess &scripts, const std::string &outputPath, const std::vector<uint32_t> &parent, const std::unordered_map<DedupAddressType::Enum, uint32_t> &scriptStarts, uint32_t clusterCount) {
+        std::vector<uint32_t> addressCounts(clusterCount, 0);
+        std::vector<uint32_t> typeEquivCounts(clusterCount, 0);
+        for (auto dedupAddressType : DedupAddressType::allArray()) {
+            std::vector<AddressType::Enum> equivTypes;
+            for (size_t i = 0; i < AddressType::size; i++) {
+                auto type = static_cast<AddressType::Enum>(i);
+                if (dedupType(type) == dedupAddressType) {
+                    equivTypes.push_back(type);
+                }
+            }
+            std::vector<std::vector<uint32_t>> typeCounts(equivTypes.size(), std::vector<uint32_t>(clusterCount, 0));
+            
+            auto startIndex = scriptStarts.at(dedupAddressType);
+            auto scriptCount = scripts.scriptCount(dedupAddressType);
+            for (uint32_t scriptNum = 1; scriptNum <= scriptCount; scriptNum++) {
+                auto clusterNum = parent[startIndex + scriptNum - 1];
+                typeEquivCounts[clusterNum]++;
+                auto header = scripts.getScriptHeader(scriptNum, dedupAddressType);
+                for (size_t i = 0; i < equivTypes.size(); i++) {
+                    if (header->seenTopLevel(equivTypes[i])) {
+                        typeCounts[i][clusterNum]++;
+                        addressCounts[clusterNum]++;
+                    }
+                }
+            }
+            
+            for (size_t i = 0; i < equivTypes.size(); i++) {
+                writeClusterStatsColumn(outputPath, ClusterStatsAccess::typeCountColumn(equivTypes[i]), typeCounts[i]);
+            }
+        }
+        writeClusterStatsColumn(outputPath, "address_count", addressCounts);
+        writeClusterStatsColumn(outputPath, "type_equiv_count", typeEquivCounts);
     }
     
     void serializeClusterData(const ScriptAccess &scripts, const std::string &outputPath, const std::vector<uint32_t> &parent, const std::unordered_map<DedupAddressType::Enum, uint32_t> &scriptStarts, uint32_t clusterCount) {
@@ -334,8 +604,208 @@ namespace blocksci {
         clusterOffsetFile.write(reinterpret_cast<char *>(clusterPositions.data()), static_cast<long>(sizeof(uint32_t) * clusterPositions.size()));
     }
     
-    template <typename ChangeFunc>
-    ClusterManager createClusteringImpl(BlockRange &chain, ChangeFunc && changeHeuristic, const std::string &outputPath, bool overwrite, bool ignoreCoinJoin) {
+    struct ClusterActivityDelta {
+        uint32_t clusterNum;
+        BlockHeight height;
+        uint32_t txCount;
+        int64_t received;
+        int64_t spent;
+    };
+    
+    /** Number of chain segments per thread whose activity is collected, fewer and larger segments need more memory */
+    constexpr unsigned int activitySegmentsPerThread = 8;
+    
+    std::string activitySpillFilePath(const std::string &outputPath, size_t segmentNum) {
+        std::stringstream ss;
+        ss << "clusterActivitySegment" << segmentNum << ".tmp";
+        return (filesystem::path{outputPath}/ss.str()).str();
+    }
+    
+    // Collects one delta per cluster and block height at which the cluster received or spent outputs. The chain is split
+    // into many more segments than threads, and every segment writes its deltas sorted by cluster, keeping the height
+    // order within a cluster, to its own spill file, so only the segments being processed are held in memory.
+    size_t collectClusterActivity(BlockRange &chain, const std::string &outputPath, const std::vector<uint32_t> &parent, const std::unordered_map<DedupAddressType::Enum, uint32_t> &scriptStarts) {
+        std::array<uint32_t, DedupAddressType::size> starts;
+        for (auto &pair : scriptStarts) {
+            starts[static_cast<size_t>(pair.first)] = pair.second;
+        }
+        auto clusterOf = [&](const Address &address) {
+            return parent[starts[static_cast<size_t>(dedupType(address.type))] + address.scriptNum - 1];
+        };
+        
+        auto extract = [&](const BlockRange &blocks, size_t segmentNum) {
+            std::vector<ClusterActivityDelta> deltas;
+            std::unordered_map<uint32_t, size_t> blockDeltaPositions;
+            std::vector<uint32_t> txClusters;
+            for (auto block : blocks) {
+                auto height = block.height();
+                blockDeltaPositions.clear();
+                auto deltaFor = [&](uint32_t clusterNum) -> ClusterActivityDelta & {
+                    auto it = blockDeltaPositions.find(clusterNum);
+                    if (it == blockDeltaPositions.end()) {
+                        it = blockDeltaPositions.emplace(clusterNum, deltas.size()).first;
+                        deltas.push_back(ClusterActivityDelta{clusterNum, height, 0, 0, 0});
+                    }
+                    return deltas[it->second];
+                };
+                for (auto tx : block) {
+                    txClusters.clear();
+                    RANGES_FOR(auto input, tx.inputs()) {
+                        auto clusterNum = clusterOf(input.getAddress());
+                        deltaFor(clusterNum).spent += input.getValue();
+                        txClusters.push_back(clusterNum);
+                    }
+                    RANGES_FOR(auto output, tx.outputs()) {
+                        auto clusterNum = clusterOf(output.getAddress());
+                        deltaFor(clusterNum).received += output.getValue();
+                        txClusters.push_back(clusterNum);
+                    }
+                    std::sort(txClusters.begin(), txClusters.end());
+                    txClusters.erase(std::unique(txClusters.begin(), txClusters.end()), txClusters.end());
+                    for (auto clusterNum : txClusters) {
+                        deltaFor(clusterNum).txCount++;
+                    }
+                }
+            }
+            std::stable_sort(deltas.begin(), deltas.end(), [](const ClusterActivityDelta &a, const ClusterActivityDelta &b) {
+                return a.clusterNum < b.clusterNum;
+            });
+            std::ofstream spillFile(activitySpillFilePath(outputPath, segmentNum), std::ios::binary | std::ios::trunc);
+            spillFile.write(reinterpret_cast<const char *>(deltas.data()), static_cast<long>(sizeof(ClusterActivityDelta) * deltas.size()));
+            spillFile.close();
+            if (!spillFile) {
+                throw std::runtime_error("Failed to write the cluster activity of a chain segment");
+            }
+        };
+        
+        auto segments = chain.segment(std::max(std::thread::hardware_concurrency(), 1u) * activitySegmentsPerThread);
+        parallelForChunks(segments.size(), [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; i++) {
+                extract(segments[i], i);
+            }
+        }, 1);
+        return segments.size();
+    }
+    
+    /** Reads the deltas of a segment back from its spill file in order */
+    class ActivitySpillReader {
+        std::ifstream file;
+        ClusterActivityDelta current;
+        bool valid;
+        
+    public:
+        explicit ActivitySpillReader(const std::string &path) : file(path, std::ios::binary) {
+            next();
+        }
+        
+        bool hasDeltaOf(uint32_t clusterNum) const {
+            return valid && current.clusterNum == clusterNum;
+        }
+        
+        const ClusterActivityDelta &delta() const {
+            return current;
+        }
+        
+        void next() {
+            valid = static_cast<bool>(file.read(reinterpret_cast<char *>(&current), sizeof(current)));
+        }
+    };
+    
+    void writeActivityVarInt(std::string &out, uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+    
+    void serializeClusterActivity(BlockRange &chain, const std::string &outputPath, const std::vector<uint32_t> &parent, const std::unordered_map<DedupAddressType::Enum, uint32_t> &scriptStarts, uint32_t clusterCount) {
+        auto segmentCount = collectClusterActivity(chain, outputPath, parent, scriptStarts);
+        std::vector<std::unique_ptr<ActivitySpillReader>> readers;
+        for (size_t i = 0; i < segmentCount; i++) {
+            readers.push_back(std::make_unique<ActivitySpillReader>(activitySpillFilePath(outputPath, i)));
+        }
+        
+        std::vector<uint64_t> activityOffsets(clusterCount + 1, 0);
+        std::vector<uint64_t> checkpointOffsets(clusterCount + 1, 0);
+        std::vector<int64_t> totalReceived(clusterCount, 0);
+        std::vector<BlockHeight> firstHeights(clusterCount, -1);
+        std::vector<BlockHeight> lastHeights(clusterCount, -1);
+        std::vector<uint32_t> txCounts(clusterCount, 0);
+        
+        // The segments are in height order, so visiting them in order for every cluster merges the per segment lists
+        // into the height ordered activity of each cluster, which is encoded and written out directly
+        std::ofstream activityFile(ClusterAccess::activityFilePath(outputPath), std::ios::binary);
+        std::ofstream checkpointFile(ClusterAccess::activityCheckpointFilePath(outputPath), std::ios::binary);
+        std::string encoded;
+        std::vector<ClusterActivityCheckpoint> checkpoints;
+        uint64_t offset = 0;
+        uint64_t checkpointCount = 0;
+        for (uint32_t clusterNum = 0; clusterNum < clusterCount; clusterNum++) {
+            encoded.clear();
+            checkpoints.clear();
+            BlockHeight previousHeight = 0;
+            int64_t spent = 0;
+            uint32_t entryCount = 0;
+            for (auto &reader : readers) {
+                for (; reader->hasDeltaOf(clusterNum); reader->next()) {
+                    auto &delta = reader->delta();
+                    writeActivityVarInt(encoded, static_cast<uint64_t>(delta.height - previousHeight));
+                    writeActivityVarInt(encoded, delta.txCount);
+                    writeActivityVarInt(encoded, static_cast<uint64_t>(delta.received));
+                    writeActivityVarInt(encoded, static_cast<uint64_t>(delta.spent));
+                    if (firstHeights[clusterNum] == -1) {
+                        firstHeights[clusterNum] = delta.height;
+                    }
+                    lastHeights[clusterNum] = delta.height;
+                    totalReceived[clusterNum] += delta.received;
+                    txCounts[clusterNum] += delta.txCount;
+                    spent += delta.spent;
+                    previousHeight = delta.height;
+                    if (++entryCount % ClusterAccess::activityCheckpointInterval == 0) {
+                        checkpoints.push_back(ClusterActivityCheckpoint{offset + encoded.size(), totalReceived[clusterNum], spent, delta.height, txCounts[clusterNum]});
+                    }
+                }
+            }
+            activityFile.write(encoded.data(), static_cast<long>(encoded.size()));
+            checkpointFile.write(reinterpret_cast<const char *>(checkpoints.data()), static_cast<long>(sizeof(ClusterActivityCheckpoint) * checkpoints.size()));
+            offset += encoded.size();
+            checkpointCount += checkpoints.size();
+            activityOffsets[clusterNum + 1] = offset;
+            checkpointOffsets[clusterNum + 1] = checkpointCount;
+        }
+        readers.clear();
+        for (size_t i = 0; i < segmentCount; i++) {
+            filesystem::path{activitySpillFilePath(outputPath, i)}.remove_file();
+        }
+        
+        // The totals of every cluster form the activity columns of the statistics table
+        writeClusterStatsColumn(outputPath, "total_received", totalReceived);
+        writeClusterStatsColumn(outputPath, "first_height", firstHeights);
+        writeClusterStatsColumn(outputPath, "last_height", lastHeights);
+        writeClusterStatsColumn(outputPath, "tx_count", txCounts);
+        
+        std::ofstream activityOffsetFile(ClusterAccess::activityOffsetFilePath(outputPath), std::ios::binary);
+        activityOffsetFile.write(reinterpret_cast<const char *>(activityOffsets.data()), static_cast<long>(sizeof(uint64_t) * activityOffsets.size()));
+        
+        std::ofstream checkpointOffsetFile(ClusterAccess::activityCheckpointOffsetFilePath(outputPath), std::ios::binary);
+        checkpointOffsetFile.write(reinterpret_cast<const char *>(checkpointOffsets.data()), static_cast<long>(sizeof(uint64_t) * checkpointOffsets.size()));
+        
+        std::array<BlockHeight, 2> activityRange{{chain.sl.start, chain.sl.stop}};
+        std::ofstream activityRangeFile(ClusterAccess::activityRangeFilePath(outputPath), std::ios::binary);
+        activityRangeFile.write(reinterpret_cast<const char *>(activityRange.data()), static_cast<long>(sizeof(BlockHeight) * activityRange.size()));
+    }
+    
+    void serializeRuleStats(const std::string &outputPath, const std::vector<ClusteringRuleStats> &ruleStats) {
+        auto rules = nlohmann::json::array();
+        for (auto &stats : ruleStats) {
+            rules.push_back({{"name", stats.name}, {"transactions", stats.transactions}, {"unions", stats.unions}, {"redundant", stats.redundant}});
+        }
+        std::ofstream file(ClusterAccess::ruleStatsFilePath(outputPath));
+        file << rules.dump(4);
+    }
+    
+    ClusterManager ClusterManager::createClustering(BlockRange &chain, const ClusteringPipeline &pipeline, const std::string &outputPath, bool overwrite) {
         prepareClusterDataLocation(outputPath, overwrite);
         
         // Perform clustering
@@ -354,23 +824,36 @@ namespace blocksci {
             }
         }
         
-        auto parent = createClusters(chain, scriptStarts, static_cast<uint32_t>(totalScriptCount), std::forward<ChangeFunc>(changeHeuristic), ignoreCoinJoin);
+        std::vector<ClusteringRuleStats> ruleStats;
+        auto parent = createClusters(chain, scriptStarts, static_cast<uint32_t>(totalScriptCount), pipeline, ruleStats);
         uint32_t clusterCount = remapClusterIds(parent);
         serializeClusterData(scripts, outputPath, parent, scriptStarts, clusterCount);
+        serializeClusterActivity(chain, outputPath, parent, scriptStarts, clusterCount);
+        serializeClusterStats(scripts, outputPath, parent, scriptStarts, clusterCount);
+        serializeRuleStats(outputPath, ruleStats);
         return {filesystem::path{outputPath}.str(), chain.getAccess()};
     }
     
     ClusterManager ClusterManager::createClustering(BlockRange &chain, const heuristics::ChangeHeuristic &changeHeuristic, const std::string &outputPath, bool overwrite, bool ignoreCoinJoin) {
-        
-        auto changeHeuristicL = [&changeHeuristic](const Transaction &tx) -> ranges::any_view<Output> {
-            return changeHeuristic(tx);
-        };
-        
-        return createClusteringImpl(chain, changeHeuristicL, outputPath, overwrite, ignoreCoinJoin);
+        return createClustering(chain, ClusteringPipeline::standard(changeHeuristic, ignoreCoinJoin), outputPath, overwrite);
     }
     
     ClusterManager ClusterManager::createClustering(BlockRange &chain, const std::function<ranges::any_view<Output>(const Transaction &tx)> &changeHeuristic, const std::string &outputPath, bool overwrite, bool ignoreCoinJoin) {
-        return createClusteringImpl(chain, changeHeuristic, outputPath, overwrite, ignoreCoinJoin);
+        return createClustering(chain, ClusteringPipeline::standard(heuristics::ChangeHeuristic{changeHeuristic}, ignoreCoinJoin), outputPath, overwrite);
+    }
+    
+    std::vector<ClusteringRuleStats> ClusterManager::getRuleStats() const {
+        std::vector<ClusteringRuleStats> ruleStats;
+        std::ifstream file(ClusterAccess::ruleStatsFilePath(access->baseDirectory));
+        if (!file) {
+            return ruleStats;
+        }
+        nlohmann::json rules;
+        file >> rules;
+        for (auto &rule : rules) {
+            ruleStats.push_back(ClusteringRuleStats{rule.at("name").get<std::string>(), rule.at("transactions").get<uint64_t>(), rule.at("unions").get<uint64_t>(), rule.at("redundant").get<uint64_t>()});
+        }
+        return ruleStats;
     }
 } // namespace blocksci
 
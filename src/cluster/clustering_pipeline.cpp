@@ -0,0 +1,56 @@
+//
+//  clustering_pipeline.cpp
+//  blocksci
+//
+
+#include <blocksci/cluster/clustering_pipeline.hpp>
+
+#include <blocksci/heuristics/tx_identification.hpp>
+
+namespace blocksci {
+
+    ClusteringPipeline &ClusteringPipeline::addMultiInput(const std::string &name) {
+        multiInput = true;
+        multiInputName = name;
+        return *this;
+    }
+    
+    ClusteringPipeline &ClusteringPipeline::addChange(heuristics::ChangeHeuristic heuristic, const std::string &name) {
+        changeRules.emplace_back(name, std::move(heuristic));
+        return *this;
+    }
+    
+    ClusteringPipeline &ClusteringPipeline::addExclusion(TransactionFilter filter, const std::string &name) {
+        exclusionRules.emplace_back(name, std::move(filter));
+        return *this;
+    }
+    
+    ClusteringPipeline &ClusteringPipeline::excludeAddressType(AddressType::Enum type) {
+        excludedTypes[static_cast<size_t>(type)] = true;
+        return *this;
+    }
+    
+    ClusteringPipeline ClusteringPipeline::standard(heuristics::ChangeHeuristic changeHeuristic, bool ignoreCoinJoin) {
+        ClusteringPipeline pipeline;
+        if (ignoreCoinJoin) {
+            pipeline.addExclusion(heuristics::isCoinjoin, "coinjoin");
+        }
+        pipeline.addMultiInput();
+        pipeline.addChange(std::move(changeHeuristic), "change");
+        return pipeline;
+    }
+    
+    std::vector<std::string> ClusteringPipeline::ruleNames() const {
+        std::vector<std::string> names;
+        for (auto &rule : exclusionRules) {
+            names.push_back(rule.first);
+        }
+        if (multiInput) {
+            names.push_back(multiInputName);
+        }
+        for (auto &rule : changeRules) {
+            names.push_back(rule.first);
+        }
+        return names;
+    }
+} // namespace blocksci
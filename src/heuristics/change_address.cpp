@@ -13,9 +13,12 @@
 #include <blocksci/chain/input.hpp>
 #include <blocksci/scripts/script_variant.hpp>
 
+#include <range/v3/algorithm/any_of.hpp>
 #include <range/v3/range_for.hpp>
-#include <range/v3/view/filter.hpp>
+#include <range/v3/view/iota.hpp>
+#include <range/v3/view/transform.hpp>
 
+#include <memory>
 #include <unordered_set>
 #include <cmath>
 
@@ -31,20 +34,39 @@ namespace blocksci { namespace heuristics {
         return o.getAddress().isSpendable();
     }
     
+    ranges::any_view<Output> changeOutputsView(std::vector<Output> outputs) {
+        auto shared = std::make_shared<std::vector<Output>>(std::move(outputs));
+        return ranges::views::transform(ranges::views::iota(size_t{0}, shared->size()), [shared](size_t i) {
+            return (*shared)[i];
+        });
+    }
+    
+    namespace {
+        /** Appends the outputs of tx matched by pred, leaving out OP_RETURN outputs */
+        template <typename Pred>
+        void appendSpendableOutputs(const Transaction &tx, std::vector<Output> &change, Pred pred) {
+            RANGES_FOR(auto output, tx.outputs()) {
+                if (pred(output) && filterOpReturn(output)) {
+                    change.push_back(output);
+                }
+            }
+        }
+    }
+    
     /** In a peeling chain, the change output is the output that continues the chain
      *
      * Note: This heuristic depends on the outputs being spent to detect change.
      * If an output has not been spent, it is considered a potential change output.
      */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::PeelingChain>::operator()(const Transaction &tx) const {
+    void ChangeHeuristicImpl<ChangeType::PeelingChain>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
         // If current tx is not a peeling chain, return an empty set
         if (!isPeelingChain(tx)) {
-            return ranges::views::empty<Output>;
+            return;
         }
         
         // Check which output(s) continue the peeling chain
-        return tx.outputs() | ranges::views::filter([](Output o){return !o.isSpent() || isPeelingChain(*o.getSpendingTx());}) | ranges::views::filter(filterOpReturn);
+        appendSpendableOutputs(tx, change, [](const Output &o){return !o.isSpent() || isPeelingChain(*o.getSpendingTx());});
     }
 
     /** Returns 10^{digits} */
@@ -66,9 +88,9 @@ namespace blocksci { namespace heuristics {
      * On the other hand, it is extremely unlikely that you receive power of ten change due to a wallet's coin selection.
      * Default for digits is 6 (i.e. it selects outputs with a value that is a multiple of 0.01 BTC)
      */
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::PowerOfTen>::operator()(const Transaction &tx) const {
+    void ChangeHeuristicImpl<ChangeType::PowerOfTen>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
         int64_t value = int_pow_ten(digits);
-        return tx.outputs() | ranges::views::filter([value](Output o){return o.getValue() % value != 0;}) | ranges::views::filter(filterOpReturn);
+        appendSpendableOutputs(tx, change, [value](const Output &o){return o.getValue() % value != 0;});
     }
     
     
@@ -78,32 +100,26 @@ namespace blocksci { namespace heuristics {
      * wouldn't need to add the input in the first place.
      */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::OptimalChange>::operator()(const Transaction &tx) const {
+    void ChangeHeuristicImpl<ChangeType::OptimalChange>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
         auto smallestInputValue = tx.inputs()[0].getValue();
         RANGES_FOR(auto input, tx.inputs()) {
             smallestInputValue = std::min(smallestInputValue, input.getValue());
         }
-        return tx.outputs() | ranges::views::filter([smallestInputValue](Output o){return o.getValue() < smallestInputValue;}) | ranges::views::filter(filterOpReturn);
+        appendSpendableOutputs(tx, change, [smallestInputValue](const Output &o){return o.getValue() < smallestInputValue;});
     }
     
     /** If all inputs are of one address type (e.g., P2PKH or P2SH), it is likely that the change output has the same type. */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::AddressType>::operator()(const Transaction &tx) const {
+    void ChangeHeuristicImpl<ChangeType::AddressType>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
         // check whether all inputs have the same type (e.g., P2SH)
-        bool allInputsSameType = true;
         AddressType::Enum inputType = tx.inputs()[0].getType();
         RANGES_FOR(auto input, tx.inputs()) {
             if (input.getType() != inputType) {
-                allInputsSameType = false;
-                break;
+                return;
             }
         }
         
-        if (allInputsSameType) {
-            return tx.outputs() | ranges::views::filter([inputType](Output o){return o.getType() == inputType;}) | ranges::views::filter(filterOpReturn);
-        } else {
-            return ranges::views::empty<Output>;
-        }
+        appendSpendableOutputs(tx, change, [inputType](const Output &o){return o.getType() == inputType;});
     }
     
     /** Detects change based on a transaction's locktime
@@ -115,20 +131,29 @@ namespace blocksci { namespace heuristics {
      * If an output has not been spent, it is considered a potential change output.
      */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::Locktime>::operator()(const Transaction &tx) const {
+    void ChangeHeuristicImpl<ChangeType::Locktime>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
         bool locktimeGreaterZero = tx.locktime() > 0;
-        return tx.outputs() | ranges::views::filter([locktimeGreaterZero](Output o){return !o.isSpent() || (o.getSpendingTx().value().locktime() > 0) == locktimeGreaterZero;}) | ranges::views::filter(filterOpReturn);
+        appendSpendableOutputs(tx, change, [locktimeGreaterZero](const Output &o){return !o.isSpent() || (o.getSpendingTx().value().locktime() > 0) == locktimeGreaterZero;});
     }
 
     /** If input addresses appear as an output address, the client might have reused addresses for change. */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::AddressReuse>::operator()(const Transaction &tx) const {
+    void ChangeHeuristicImpl<ChangeType::AddressReuse>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
+        // Comparing every pair is cheaper than building a set for the inputs and outputs of most transactions
+        constexpr size_t maxPairCount = 1024;
+        if (static_cast<size_t>(tx.inputCount()) * tx.outputCount() <= maxPairCount) {
+            appendSpendableOutputs(tx, change, [&tx](const Output &o){
+                auto address = o.getAddress();
+                return ranges::any_of(tx.inputs(), [&address](const Input &input) { return input.getAddress() == address; });
+            });
+            return;
+        }
+        
         std::unordered_set<Address> inputAddresses;
         RANGES_FOR(auto input, tx.inputs()) {
             inputAddresses.insert(input.getAddress());
         }
-        
-        return tx.outputs() | ranges::views::filter([inputAddresses](Output o){return inputAddresses.find(o.getAddress()) != inputAddresses.end();}) | ranges::views::filter(filterOpReturn);
+        appendSpendableOutputs(tx, change, [&inputAddresses](const Output &o){return inputAddresses.find(o.getAddress()) != inputAddresses.end();});
     }
 
     /** Most clients will generate a fresh address for the change.
@@ -136,8 +161,8 @@ namespace blocksci { namespace heuristics {
      * If an output is the first to send value to an address, it is potentially the change.
      */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::ClientChangeAddressBehavior>::operator()(const Transaction &tx) const {
-        return tx.outputs() | ranges::views::filter([tx](Output o){return o.getAddress().isSpendable() && o.getAddress().getBaseScript().getFirstTxIndex() == tx.txNum;}) | ranges::views::filter(filterOpReturn);
+    void ChangeHeuristicImpl<ChangeType::ClientChangeAddressBehavior>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
+        appendSpendableOutputs(tx, change, [&tx](const Output &o){return o.getAddress().isSpendable() && o.getAddress().getBaseScript().getFirstTxIndex() == tx.txNum;});
     }
     
     /** Legacy heuristic used in previous versions of BlockSci */
@@ -174,34 +199,35 @@ namespace blocksci { namespace heuristics {
     // This function mostly exists to ensure a consistent API.
     // The set it returns will never contain more than one output.
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::Legacy>::operator()(const Transaction &tx) const {
+    void ChangeHeuristicImpl<ChangeType::Legacy>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
         auto c = uniqueChangeByLegacyHeuristic(tx);
         if (c.has_value()) {
-            return ranges::views::single(c.value());
+            change.push_back(c.value());
         }
-        return ranges::views::empty<Output>;
     }
 
     /** Clients may choose a fixed fee per kb instead of using one based on the current fee market. */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::FixedFee>::operator()(const Transaction &tx) const {
+    void ChangeHeuristicImpl<ChangeType::FixedFee>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
         auto fee = tx.fee() * 1000 / tx.virtualSize();
-        return tx.outputs() | ranges::views::filter([fee](Output o) {return !o.isSpent() || (o.getSpendingTx()->fee() * 1000 / o.getSpendingTx()->virtualSize()) == fee;}) | ranges::views::filter(filterOpReturn);
+        appendSpendableOutputs(tx, change, [fee](const Output &o) {return !o.isSpent() || (o.getSpendingTx()->fee() * 1000 / o.getSpendingTx()->virtualSize()) == fee;});
     }
     
     /** Disables change address clustering by returning an empty set. */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::None>::operator()(const Transaction &) const {
-        return ranges::views::empty<Output>;
-    }
+    void ChangeHeuristicImpl<ChangeType::None>::appendChange(const Transaction &, std::vector<Output> &) const {}
     
     /** Returns all outputs that have been spent.
      *
      * This is useful in combination with change address heuristics that return unspent outputs as candidates.
      */
     template<>
-    ranges::any_view<Output> ChangeHeuristicImpl<ChangeType::Spent>::operator()(const Transaction &tx) const {
-        return tx.outputs() | ranges::views::filter([](Output o){return o.isSpent();});
+    void ChangeHeuristicImpl<ChangeType::Spent>::appendChange(const Transaction &tx, std::vector<Output> &change) const {
+        RANGES_FOR(auto output, tx.outputs()) {
+            if (output.isSpent()) {
+                change.push_back(output);
+            }
+        }
     }
 }  // namespace heuristics
 }  // namespace blocksci
@@ -12,6 +12,7 @@
 #include "file_mapper.hpp"
 #include "exception.hpp"
 
+#include <blocksci/chain/column_view.hpp>
 #include <blocksci/core/bitcoin_uint256.hpp>
 #include <blocksci/core/core_fwd.hpp>
 #include <blocksci/core/raw_block.hpp>
@@ -25,6 +26,15 @@
 
 namespace blocksci {
 
+    /** View of the elements [begin, end) of a memory-mapped file */
+    template <typename T>
+    ColumnView<T> fileColumnView(const FixedSizeFileMapper<T> &file, uint64_t begin, uint64_t end) {
+        if (begin >= end) {
+            return {};
+        }
+        return {file[static_cast<OffsetType>(begin)], end - begin};
+    }
+
     /** Provides data access for blocks, transactions, inputs, and outputs.
      *
      * The files here represent the core data about blocks and transactions.
@@ -273,6 +283,54 @@ namespace blocksci {
             return _maxLoadedTx;
         }
 
+        /** Blockchain-wide number of the first input of the given tx, or the number of inputs for txNum == txCount() */
+        uint64_t firstInputNum(uint32_t txNum) const {
+            return txNum < _maxLoadedTx ? *txFirstInputFile[txNum] : inputCount();
+        }
+
+        /** Blockchain-wide number of the first output of the given tx, or the number of outputs for txNum == txCount() */
+        uint64_t firstOutputNum(uint32_t txNum) const {
+            return txNum < _maxLoadedTx ? *txFirstOutputFile[txNum] : outputCount();
+        }
+
+        /** Memory-mapped columns of the blocks [beginHeight, endHeight) */
+        ColumnView<RawBlock> blocks(BlockHeight beginHeight, BlockHeight endHeight) const {
+            reorgCheck();
+            return fileColumnView(blockFile, static_cast<uint64_t>(beginHeight), static_cast<uint64_t>(endHeight));
+        }
+
+        /** Memory-mapped columns of the transactions [beginTx, endTx) */
+        ColumnView<uint256> txHashes(uint32_t beginTx, uint32_t endTx) const {
+            reorgCheck();
+            return fileColumnView(txHashesFile, beginTx, endTx);
+        }
+
+        ColumnView<int32_t> txVersions(uint32_t beginTx, uint32_t endTx) const {
+            reorgCheck();
+            return fileColumnView(txVersionFile, beginTx, endTx);
+        }
+
+        ColumnView<uint64_t> txFirstInputNums(uint32_t beginTx, uint32_t endTx) const {
+            reorgCheck();
+            return fileColumnView(txFirstInputFile, beginTx, endTx);
+        }
+
+        ColumnView<uint64_t> txFirstOutputNums(uint32_t beginTx, uint32_t endTx) const {
+            reorgCheck();
+            return fileColumnView(txFirstOutputFile, beginTx, endTx);
+        }
+
+        /** Memory-mapped columns of the inputs with the blockchain-wide numbers [beginInput, endInput) */
+        ColumnView<uint32_t> inputSequenceNums(uint64_t beginInput, uint64_t endInput) const {
+            reorgCheck();
+            return fileColumnView(sequenceFile, beginInput, endInput);
+        }
+
+        ColumnView<uint16_t> inputSpentOutputNums(uint64_t beginInput, uint64_t endInput) const {
+            reorgCheck();
+            return fileColumnView(inputSpentOutputFile, beginInput, endInput);
+        }
+
         uint64_t inputCount() const {
             if (_maxLoadedTx > 0) {
                 auto lastTx = getTx(_maxLoadedTx - 1);
@@ -37,7 +37,7 @@ namespace blocksci {
     }
     
     void to_json(json& j, const ChainRPCConfiguration& p) {
-        j = json{{"username", p.username}, {"password", p.password}, {"address", p.address}, {"port", p.port}};
+        j = json{{"username", p.username}, {"password", p.password}, {"address", p.address}, {"port", p.port}, {"rawBlocks", p.rawBlocks}};
     }
     
     void from_json(const json& j, ChainRPCConfiguration& p) {
@@ -45,6 +45,7 @@ namespace blocksci {
         j.at("password").get_to(p.password);
         j.at("address").get_to(p.address);
         j.at("port").get_to(p.port);
+        p.rawBlocks = j.value("rawBlocks", false);
     }
     
     ChainConfiguration ChainConfiguration::dash(const std::string &chainDir) {
@@ -217,7 +218,8 @@ namespace blocksci {
             username,
             password,
             "127.0.0.1",
-            8332
+            8332,
+            true
         };
     }
     
@@ -226,7 +228,8 @@ namespace blocksci {
             username,
             password,
             "127.0.0.1",
-            18332
+            18332,
+            true
         };
     }
     
@@ -235,7 +238,8 @@ namespace blocksci {
             username,
             password,
             "127.0.0.1",
-            8332
+            8332,
+            true
         };
     }
     
@@ -244,7 +248,8 @@ namespace blocksci {
             username,
             password,
             "127.0.0.1",
-            18332
+            18332,
+            true
         };
     }
     
@@ -253,7 +258,8 @@ namespace blocksci {
             username,
             password,
             "127.0.0.1",
-            9332
+            9332,
+            true
         };
     }
     
@@ -262,7 +268,8 @@ namespace blocksci {
             username,
             password,
             "127.0.0.1",
-            19332
+            19332,
+            true
         };
     }
     
@@ -66,6 +66,8 @@ namespace blocksci {
         std::string password;
         std::string address;
         int port = 0;
+        /** Whether the node serializes blocks like Bitcoin, so that raw blocks can be parsed like blk files */
+        bool rawBlocks = false;
         
         static ChainRPCConfiguration bitcoin(const std::string &username, const std::string &password);
         static ChainRPCConfiguration bitcoinTestnet(const std::string &username, const std::string &password);
@@ -9,17 +9,53 @@
 #define cluster_access_h
 
 #include "address_info.hpp"
+#include "cluster_stats_access.hpp"
 #include "dedup_address_info.hpp"
 #include "file_mapper.hpp"
 
 #include <blocksci/core/raw_address.hpp>
 #include <blocksci/core/dedup_address.hpp>
+#include <blocksci/core/typedefs.hpp>
 
+#include <range/v3/utility/optional.hpp>
 #include <range/v3/view/subrange.hpp>
 
 #include <wjfilesystem/path.h>
 
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
 namespace blocksci {
+    /** Running totals of the activity of a cluster up to and including a block height
+     *
+     * Only heights at which the cluster received or spent outputs are recorded, so the
+     * values at any other height are those of the closest preceding entry. The entries are
+     * decoded from the per height deltas stored in the activity log.
+     */
+    struct ClusterActivityEntry {
+        BlockHeight height;
+        uint32_t txCount;
+        int64_t received;
+        int64_t spent;
+    };
+    
+    /** Running totals of a cluster stored at fixed intervals of its activity log
+     *
+     * A query starts decoding at the last checkpoint at or before the requested height, so it reads at most
+     * activityCheckpointInterval entries of the log instead of the whole history of the cluster.
+     */
+    struct ClusterActivityCheckpoint {
+        /** Offset in the activity log of the entry following the checkpoint */
+        uint64_t offset;
+        int64_t received;
+        int64_t spent;
+        BlockHeight height;
+        uint32_t txCount;
+    };
+    
+    static_assert(sizeof(ClusterActivityCheckpoint) == 32, "ClusterActivityCheckpoint must not contain padding");
+    
     template<DedupAddressType::Enum type>
     struct ScriptClusterIndexFile : public FixedSizeFileMapper<uint32_t> {
         using FixedSizeFileMapper<uint32_t>::FixedSizeFileMapper;
@@ -33,10 +69,39 @@ namespace blocksci {
         static uint32_t f(const ClusterAccess *access, uint32_t scriptNum);
     };
     
+    template<blocksci::DedupAddressType::Enum type>
+    struct ClusterIndexSizeFunctor {
+        static uint32_t f(const ClusterAccess *access);
+    };
+    
+    template<blocksci::DedupAddressType::Enum type>
+    struct ClusterIndexDataFunctor {
+        static const uint32_t *f(const ClusterAccess *access);
+    };
+    
     class ClusterAccess {
         FixedSizeFileMapper<uint32_t> clusterOffsetFile;
         FixedSizeFileMapper<DedupAddress> clusterScriptsFile;
         
+        /** Per cluster activity log, created alongside the clustering
+         *
+         * Files: - clusterActivityOffsets.dat: byte offset of the activity of every cluster in clusterActivity.dat (clusterCount + 1 entries)
+         *        - clusterActivity.dat: activity grouped by cluster and sorted by height. Every block height at which the
+         *          cluster was active is stored as four varints: the height difference to the previous entry of the
+         *          cluster (to 0 for the first one), and the transaction count, received value and spent value in that block
+         *        - clusterActivityRange.dat: [start, stop) block heights covered by the activity log
+         *        - clusterActivityCheckpoints.dat: ClusterActivityCheckpoint after every activityCheckpointInterval
+         *          entries of a cluster, grouped by cluster
+         *        - clusterActivityCheckpointOffsets.dat: index of the first checkpoint of every cluster (clusterCount + 1 entries)
+         */
+        FixedSizeFileMapper<uint64_t> clusterActivityOffsetFile;
+        SimpleFileMapper<> clusterActivityFile;
+        FixedSizeFileMapper<BlockHeight> clusterActivityRangeFile;
+        FixedSizeFileMapper<ClusterActivityCheckpoint> clusterActivityCheckpointFile;
+        FixedSizeFileMapper<uint64_t> clusterActivityCheckpointOffsetFile;
+        
+        ClusterStatsAccess clusterStats;
+        
         using ScriptClusterIndexTuple = to_dedup_address_tuple_t<ScriptClusterIndexFile>;
         
         ScriptClusterIndexTuple scriptClusterIndexFiles;
@@ -47,24 +112,110 @@ namespace blocksci {
         template<DedupAddressType::Enum type>
         friend struct ClusterNumFunctor;
         
+        template<DedupAddressType::Enum type>
+        friend struct ClusterIndexSizeFunctor;
+        
+        template<DedupAddressType::Enum type>
+        friend struct ClusterIndexDataFunctor;
+        
         template<DedupAddressType::Enum type>
         uint32_t getClusterNumImpl(uint32_t scriptNum) const {
             auto &file = std::get<ScriptClusterIndexFile<type>>(scriptClusterIndexFiles);
             return *file[scriptNum - 1];
         }
         
+        template<DedupAddressType::Enum type>
+        uint32_t getClusterIndexSizeImpl() const {
+            auto &file = std::get<ScriptClusterIndexFile<type>>(scriptClusterIndexFiles);
+            return static_cast<uint32_t>(file.size());
+        }
+        
+        template<DedupAddressType::Enum type>
+        const uint32_t *getClusterIndexDataImpl() const {
+            auto &file = std::get<ScriptClusterIndexFile<type>>(scriptClusterIndexFiles);
+            return file.size() > 0 ? file[0] : nullptr;
+        }
+        
+        /** Reads the entries of the activity log of a cluster */
+        class ActivityDecoder {
+            const unsigned char *pos;
+            const unsigned char *last;
+            
+            uint64_t readVarInt() {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    if (pos == last) {
+                        break;
+                    }
+                    auto byte = *pos++;
+                    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                throw std::runtime_error("Cluster activity data is corrupted, recreate the clustering to regenerate it");
+            }
+            
+        public:
+            ActivityDecoder(const char *begin, const char *end) : pos(reinterpret_cast<const unsigned char *>(begin)), last(reinterpret_cast<const unsigned char *>(end)) {}
+            
+            bool done() const {
+                return pos == last;
+            }
+            
+            BlockHeight readHeight(BlockHeight previousHeight) {
+                return previousHeight + static_cast<BlockHeight>(readVarInt());
+            }
+            
+            /** Adds the deltas following the height of the entry to the running totals */
+            void readTotals(ClusterActivityEntry &entry) {
+                entry.txCount += static_cast<uint32_t>(readVarInt());
+                entry.received += static_cast<int64_t>(readVarInt());
+                entry.spent += static_cast<int64_t>(readVarInt());
+            }
+        };
+        
+        void checkActivity() const {
+            if (!hasActivity()) {
+                throw std::runtime_error("Cluster activity data not found, recreate the clustering to generate it");
+            }
+        }
+        
+        /** Decoder of the activity log of the cluster from the given offset to the end of the cluster */
+        ActivityDecoder activityDecoder(uint32_t clusterNum, OffsetType start) const {
+            auto end = static_cast<OffsetType>(*clusterActivityOffsetFile[clusterNum + 1]);
+            if (start == end) {
+                return {nullptr, nullptr};
+            }
+            auto data = clusterActivityFile.getDataAtOffset(start);
+            return {data, data + (end - start)};
+        }
+        
     public:
+        /** Number of entries of the activity log of a cluster between two checkpoints */
+        static constexpr uint32_t activityCheckpointInterval = 64;
+        
         DataAccess &access;
         
-        ClusterAccess(const std::string &baseDirectory, DataAccess &access_) :
-        clusterOffsetFile((filesystem::path{baseDirectory}/"clusterOffsets").str()),
-        clusterScriptsFile((filesystem::path{baseDirectory}/"clusterAddresses").str()),
+        /** Directory the cluster data was loaded from */
+        std::string baseDirectory;
+        
+        ClusterAccess(const std::string &baseDirectory_, DataAccess &access_) :
+        clusterOffsetFile((filesystem::path{baseDirectory_}/"clusterOffsets").str()),
+        clusterScriptsFile((filesystem::path{baseDirectory_}/"clusterAddresses").str()),
+        clusterActivityOffsetFile((filesystem::path{baseDirectory_}/"clusterActivityOffsets").str()),
+        clusterActivityFile((filesystem::path{baseDirectory_}/"clusterActivity").str()),
+        clusterActivityRangeFile((filesystem::path{baseDirectory_}/"clusterActivityRange").str()),
+        clusterActivityCheckpointFile((filesystem::path{baseDirectory_}/"clusterActivityCheckpoints").str()),
+        clusterActivityCheckpointOffsetFile((filesystem::path{baseDirectory_}/"clusterActivityCheckpointOffsets").str()),
+        clusterStats(baseDirectory_),
         scriptClusterIndexFiles(blocksci::apply(DedupAddressType::all(), [&] (auto tag) {
             std::stringstream ss;
             ss << dedupAddressName(tag) << "_cluster_index";
-            return (filesystem::path{baseDirectory}/ss.str()).str();
+            return (filesystem::path{baseDirectory_}/ss.str()).str();
         })),
-        access(access_)  {
+        access(access_),
+        baseDirectory(baseDirectory_) {
             if (!(filesystem::path{baseDirectory}/"clusterAddresses.dat").exists()) {
                 throw std::runtime_error("Cluster data not found");
             }
@@ -78,6 +229,30 @@ namespace blocksci {
             return (filesystem::path{baseDirectory}/"clusterAddresses.dat").str();
         }
         
+        static std::string activityOffsetFilePath(const std::string &baseDirectory) {
+            return (filesystem::path{baseDirectory}/"clusterActivityOffsets.dat").str();
+        }
+        
+        static std::string activityFilePath(const std::string &baseDirectory) {
+            return (filesystem::path{baseDirectory}/"clusterActivity.dat").str();
+        }
+        
+        static std::string ruleStatsFilePath(const std::string &baseDirectory) {
+            return (filesystem::path{baseDirectory}/"clusteringRules.json").str();
+        }
+        
+        static std::string activityRangeFilePath(const std::string &baseDirectory) {
+            return (filesystem::path{baseDirectory}/"clusterActivityRange.dat").str();
+        }
+        
+        static std::string activityCheckpointFilePath(const std::string &baseDirectory) {
+            return (filesystem::path{baseDirectory}/"clusterActivityCheckpoints.dat").str();
+        }
+        
+        static std::string activityCheckpointOffsetFilePath(const std::string &baseDirectory) {
+            return (filesystem::path{baseDirectory}/"clusterActivityCheckpointOffsets.dat").str();
+        }
+        
         static std::string typeIndexFilePath(const std::string &baseDirectory, DedupAddressType::Enum type) {
             filesystem::path base{baseDirectory};
             std::stringstream ss;
@@ -91,6 +266,27 @@ namespace blocksci {
             return table.at(index)(this, address.scriptNum);
         }
         
+        /** Number of scripts of the given type that were assigned a cluster when the clustering was created */
+        uint32_t clusteredScriptCount(DedupAddressType::Enum type) const {
+            static auto table = blocksci::make_dynamic_table<DedupAddressType, ClusterIndexSizeFunctor>();
+            return table.at(static_cast<size_t>(type))(this);
+        }
+        
+        /** Cluster numbers of all clustered scripts of the type, indexed by scriptNum - 1 */
+        ranges::subrange<const uint32_t *> getClusterIndex(DedupAddressType::Enum type) const {
+            static auto table = blocksci::make_dynamic_table<DedupAddressType, ClusterIndexDataFunctor>();
+            auto data = table.at(static_cast<size_t>(type))(this);
+            return ranges::make_subrange(data, data + (data ? clusteredScriptCount(type) : 0));
+        }
+        
+        /** Returns the cluster number of the address, or nullopt if it is not part of the clustering */
+        ranges::optional<uint32_t> tryGetClusterNum(const RawAddress &address) const {
+            if (address.scriptNum == 0 || address.scriptNum > clusteredScriptCount(dedupType(address.type))) {
+                return ranges::nullopt;
+            }
+            return getClusterNum(address);
+        }
+        
         uint32_t getClusterSize(uint32_t clusterNum) const {
             auto clusterOffset = *clusterOffsetFile[clusterNum];
             auto clusterSize = clusterOffset;
@@ -117,6 +313,86 @@ namespace blocksci {
             return ranges::make_subrange(firstAddressOffset, firstAddressOffset + clusterSize);
         }
         
+        /** Clusterings created before the activity log was introduced have no activity data */
+        bool hasActivity() const {
+            auto offsetCount = static_cast<OffsetType>(clusterCount()) + 1;
+            return clusterActivityRangeFile.size() == 2 && clusterActivityOffsetFile.size() == offsetCount && clusterActivityCheckpointOffsetFile.size() == offsetCount;
+        }
+        
+        BlockHeight activityStartHeight() const {
+            return *clusterActivityRangeFile[0];
+        }
+        
+        BlockHeight activityEndHeight() const {
+            return *clusterActivityRangeFile[1];
+        }
+        
+        /** Running totals of the first block in which the cluster was active, or nullopt if it never was */
+        ranges::optional<ClusterActivityEntry> getFirstClusterActivity(uint32_t clusterNum) const {
+            checkActivity();
+            auto decoder = activityDecoder(clusterNum, static_cast<OffsetType>(*clusterActivityOffsetFile[clusterNum]));
+            if (decoder.done()) {
+                return ranges::nullopt;
+            }
+            ClusterActivityEntry entry{decoder.readHeight(0), 0, 0, 0};
+            decoder.readTotals(entry);
+            return entry;
+        }
+        
+        /** Running totals of the cluster up to and including the height (-1 for the whole log), or nullopt if the cluster
+         * had no activity yet
+         *
+         * Binary searches the checkpoints of the cluster and decodes at most activityCheckpointInterval entries after it.
+         */
+        ranges::optional<ClusterActivityEntry> getClusterActivity(uint32_t clusterNum, BlockHeight height) const {
+            checkActivity();
+            auto checkpointBegin = static_cast<OffsetType>(*clusterActivityCheckpointOffsetFile[clusterNum]);
+            auto checkpointEnd = static_cast<OffsetType>(*clusterActivityCheckpointOffsetFile[clusterNum + 1]);
+            const ClusterActivityCheckpoint *checkpoint = nullptr;
+            if (checkpointBegin != checkpointEnd) {
+                auto first = clusterActivityCheckpointFile[checkpointBegin];
+                auto last = first + (checkpointEnd - checkpointBegin);
+                auto it = height == -1 ? last : std::upper_bound(first, last, height, [](BlockHeight searchHeight, const ClusterActivityCheckpoint &checkpoint) {
+                    return searchHeight < checkpoint.height;
+                });
+                if (it != first) {
+                    checkpoint = std::prev(it);
+                }
+            }
+            
+            ranges::optional<ClusterActivityEntry> result;
+            ClusterActivityEntry entry{0, 0, 0, 0};
+            auto start = static_cast<OffsetType>(*clusterActivityOffsetFile[clusterNum]);
+            if (checkpoint != nullptr) {
+                entry = ClusterActivityEntry{checkpoint->height, checkpoint->txCount, checkpoint->received, checkpoint->spent};
+                result = entry;
+                start = static_cast<OffsetType>(checkpoint->offset);
+            }
+            auto decoder = activityDecoder(clusterNum, start);
+            while (!decoder.done()) {
+                auto nextHeight = decoder.readHeight(entry.height);
+                if (height != -1 && nextHeight > height) {
+                    break;
+                }
+                entry.height = nextHeight;
+                decoder.readTotals(entry);
+                result = entry;
+            }
+            return result;
+        }
+        
+        /** Clusterings created before the statistics table was introduced have no statistics */
+        bool hasStats() const {
+            return clusterStats.exists(clusterCount());
+        }
+        
+        const ClusterStatsAccess &getStats() const {
+            if (!hasStats()) {
+                throw std::runtime_error("Cluster statistics not found, recreate the clustering to generate them");
+            }
+            return clusterStats;
+        }
+        
         std::vector<uint32_t> getClusterSizes() const {
             auto tot = clusterCount();
             std::vector<uint32_t> clusterSizes;
@@ -136,6 +412,16 @@ namespace blocksci {
         return access->getClusterNumImpl<type>(scriptNum);
     }
     
+    template<blocksci::DedupAddressType::Enum type>
+    uint32_t ClusterIndexSizeFunctor<type>::f(const ClusterAccess *access) {
+        return access->getClusterIndexSizeImpl<type>();
+    }
+    
+    template<blocksci::DedupAddressType::Enum type>
+    const uint32_t *ClusterIndexDataFunctor<type>::f(const ClusterAccess *access) {
+        return access->getClusterIndexDataImpl<type>();
+    }
+    
 } // namespace blocksci
 
 #endif /* cluster_access_h */
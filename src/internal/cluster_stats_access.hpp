@@ -0,0 +1,123 @@
+//
+//  cluster_stats_access.hpp
+//  blocksci
+//
+
+#ifndef cluster_stats_access_hpp
+#define cluster_stats_access_hpp
+
+#include "address_info.hpp"
+#include "file_mapper.hpp"
+
+#include <blocksci/core/address_types.hpp>
+#include <blocksci/core/typedefs.hpp>
+#include <blocksci/cluster/cluster_manager.hpp>
+
+#include <wjfilesystem/path.h>
+
+#include <string>
+#include <vector>
+
+namespace blocksci {
+
+    /** Provides access to the columnar per cluster statistics that are created alongside the clustering
+     *
+     * Every column is stored in its own file and indexed by cluster number.
+     *
+     * Directory: clusterStats/ inside of the cluster directory
+     * Files: - address_count.dat: [<uint32_t>, ...] number of addresses, as returned by Cluster::getSize
+     *        - type_equiv_count.dat: [<uint32_t>, ...] number of deduplicated addresses, as returned by Cluster::getTypeEquivSize
+     *        - <address type>_count.dat: [<uint32_t>, ...] number of addresses of the type, as returned by Cluster::countOfType
+     *        - total_received.dat: [<int64_t>, ...] total value received by the cluster
+     *        - first_height.dat, last_height.dat: [<BlockHeight>, ...] first and last block with activity, -1 if there was none
+     *        - tx_count.dat: [<uint32_t>, ...] number of transactions in which the cluster received or spent outputs
+     */
+    class ClusterStatsAccess {
+        FixedSizeFileMapper<uint32_t> addressCountFile;
+        FixedSizeFileMapper<uint32_t> typeEquivCountFile;
+        std::vector<FixedSizeFileMapper<uint32_t>> typeCountFiles;
+        FixedSizeFileMapper<int64_t> totalReceivedFile;
+        FixedSizeFileMapper<BlockHeight> firstHeightFile;
+        FixedSizeFileMapper<BlockHeight> lastHeightFile;
+        FixedSizeFileMapper<uint32_t> txCountFile;
+        
+        static filesystem::path columnPrefix(const std::string &baseDirectory, const std::string &column) {
+            return filesystem::path{directoryPath(baseDirectory)}/column;
+        }
+        
+        template <typename T>
+        static ClusterStatsColumn makeColumn(const std::string &name, const FixedSizeFileMapper<T> &file, const char *format) {
+            const void *data = file.size() > 0 ? file[0] : nullptr;
+            return ClusterStatsColumn{name, data, sizeof(T), format, static_cast<uint64_t>(file.size())};
+        }
+    
+    public:
+        explicit ClusterStatsAccess(const std::string &baseDirectory) :
+        addressCountFile(columnPrefix(baseDirectory, "address_count")),
+        typeEquivCountFile(columnPrefix(baseDirectory, "type_equiv_count")),
+        totalReceivedFile(columnPrefix(baseDirectory, "total_received")),
+        firstHeightFile(columnPrefix(baseDirectory, "first_height")),
+        lastHeightFile(columnPrefix(baseDirectory, "last_height")),
+        txCountFile(columnPrefix(baseDirectory, "tx_count")) {
+            typeCountFiles.reserve(AddressType::size);
+            for (size_t i = 0; i < AddressType::size; i++) {
+                typeCountFiles.emplace_back(columnPrefix(baseDirectory, typeCountColumn(static_cast<AddressType::Enum>(i))));
+            }
+        }
+        
+        static std::string directoryPath(const std::string &baseDirectory) {
+            return (filesystem::path{baseDirectory}/"clusterStats").str();
+        }
+        
+        static std::string columnFilePath(const std::string &baseDirectory, const std::string &column) {
+            return columnPrefix(baseDirectory, column).str() + ".dat";
+        }
+        
+        static std::string typeCountColumn(AddressType::Enum type) {
+            return addressName(type) + "_count";
+        }
+        
+        static std::vector<std::string> columnNames() {
+            std::vector<std::string> names{"address_count", "type_equiv_count"};
+            for (size_t i = 0; i < AddressType::size; i++) {
+                names.push_back(typeCountColumn(static_cast<AddressType::Enum>(i)));
+            }
+            names.insert(names.end(), {"total_received", "first_height", "last_height", "tx_count"});
+            return names;
+        }
+        
+        /** Clusterings created before the statistics were introduced have no statistics files */
+        bool exists(uint32_t clusterCount) const {
+            auto count = static_cast<OffsetType>(clusterCount);
+            return addressCountFile.size() == count && typeEquivCountFile.size() == count && txCountFile.size() == count;
+        }
+        
+        uint32_t addressCount(uint32_t clusterNum) const {
+            return *addressCountFile[clusterNum];
+        }
+        
+        uint32_t typeEquivCount(uint32_t clusterNum) const {
+            return *typeEquivCountFile[clusterNum];
+        }
+        
+        uint32_t typeCount(uint32_t clusterNum, AddressType::Enum type) const {
+            return *typeCountFiles[static_cast<size_t>(type)][clusterNum];
+        }
+        
+        std::vector<ClusterStatsColumn> columns() const {
+            std::vector<ClusterStatsColumn> cols;
+            cols.push_back(makeColumn("address_count", addressCountFile, "I"));
+            cols.push_back(makeColumn("type_equiv_count", typeEquivCountFile, "I"));
+            for (size_t i = 0; i < AddressType::size; i++) {
+                cols.push_back(makeColumn(typeCountColumn(static_cast<AddressType::Enum>(i)), typeCountFiles[i], "I"));
+            }
+            cols.push_back(makeColumn("total_received", totalReceivedFile, "q"));
+            cols.push_back(makeColumn("first_height", firstHeightFile, "i"));
+            cols.push_back(makeColumn("last_height", lastHeightFile, "i"));
+            cols.push_back(makeColumn("tx_count", txCountFile, "I"));
+            return cols;
+        }
+    };
+} // namespace blocksci
+
+#endif /* cluster_stats_access_hpp */
@@ -0,0 +1,139 @@
+//
+//  cluster_tag_index.hpp
+//  blocksci
+//
+
+#ifndef cluster_tag_index_hpp
+#define cluster_tag_index_hpp
+
+#include "file_mapper.hpp"
+
+#include <blocksci/core/address_types.hpp>
+
+#include <range/v3/view/subrange.hpp>
+
+#include <wjfilesystem/path.h>
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace blocksci {
+
+    /** Entry of a persisted tag set, sorted by (clusterNum, type, scriptNum)
+     *
+     * The entries are written to disk as they are in memory, so all fields have a fixed width and the layout contains
+     * no implicit padding.
+     */
+    struct ClusterTagEntry {
+        uint64_t tagOffset;
+        uint32_t clusterNum;
+        uint32_t scriptNum;
+        uint32_t tagLength;
+        uint8_t type;
+        uint8_t reserved[3];
+        
+        ClusterTagEntry() = default;
+        ClusterTagEntry(uint32_t clusterNum_, uint32_t scriptNum_, AddressType::Enum type_, uint32_t tagLength_, uint64_t tagOffset_) :
+        tagOffset(tagOffset_), clusterNum(clusterNum_), scriptNum(scriptNum_), tagLength(tagLength_), type(static_cast<uint8_t>(type_)), reserved{0, 0, 0} {}
+        
+        AddressType::Enum addressType() const {
+            return static_cast<AddressType::Enum>(type);
+        }
+        
+        bool operator<(const ClusterTagEntry &other) const {
+            return std::tie(clusterNum, type, scriptNum) < std::tie(other.clusterNum, other.type, other.scriptNum);
+        }
+    };
+    
+    static_assert(sizeof(ClusterTagEntry) == 24, "ClusterTagEntry must not contain padding");
+    
+    /** Memory-mapped tag set that was resolved against a clustering
+     *
+     * File(s): tags/<name>_tag_entries.dat and tags/<name>_tag_strings.dat inside of the cluster directory
+     *     - tag entries: ClusterTagEntry records sorted by cluster number
+     *     - tag strings: concatenated tag strings, referenced by tagOffset and tagLength
+     */
+    class ClusterTagIndex {
+        FixedSizeFileMapper<ClusterTagEntry> entryFile;
+        SimpleFileMapper<> tagFile;
+        
+        static filesystem::path tagDirectory(const std::string &baseDirectory) {
+            return filesystem::path{baseDirectory}/"tags";
+        }
+        
+        static std::string filePrefix(const std::string &baseDirectory, const std::string &tagSetName, const std::string &suffix) {
+            return (tagDirectory(baseDirectory)/(tagSetName + suffix)).str();
+        }
+    
+    public:
+        ClusterTagIndex(const std::string &baseDirectory, const std::string &tagSetName) :
+        entryFile(filePrefix(baseDirectory, tagSetName, "_tag_entries")),
+        tagFile(filePrefix(baseDirectory, tagSetName, "_tag_strings")) {
+            if (!filesystem::path{entriesFilePath(baseDirectory, tagSetName)}.exists()) {
+                std::stringstream ss;
+                ss << "Tag set " << tagSetName << " not found in cluster directory " << baseDirectory;
+                throw std::runtime_error(ss.str());
+            }
+        }
+        
+        static std::string entriesFilePath(const std::string &baseDirectory, const std::string &tagSetName) {
+            return filePrefix(baseDirectory, tagSetName, "_tag_entries.dat");
+        }
+        
+        static std::string stringsFilePath(const std::string &baseDirectory, const std::string &tagSetName) {
+            return filePrefix(baseDirectory, tagSetName, "_tag_strings.dat");
+        }
+        
+        /** Writes a tag set, entries must already be sorted and reference offsets into tagData */
+        static void write(const std::string &baseDirectory, const std::string &tagSetName, const std::vector<ClusterTagEntry> &entries, const std::string &tagData, bool overwrite) {
+            assert(std::is_sorted(entries.begin(), entries.end()));
+            auto directory = tagDirectory(baseDirectory);
+            if (!directory.exists()) {
+                if (!filesystem::create_directory(directory)) {
+                    std::stringstream ss;
+                    ss << "Cannot create directory at path " << directory;
+                    throw std::runtime_error(ss.str());
+                }
+            }
+            
+            for (auto &path : {entriesFilePath(baseDirectory, tagSetName), stringsFilePath(baseDirectory, tagSetName)}) {
+                auto filePath = filesystem::path{path};
+                if (filePath.exists()) {
+                    if (!overwrite) {
+                        std::stringstream ss;
+                        ss << "Overwrite is off, but " << filePath << " exists already";
+                        throw std::runtime_error{ss.str()};
+                    }
+                    filePath.remove_file();
+                }
+            }
+            
+            std::ofstream entriesFile(entriesFilePath(baseDirectory, tagSetName), std::ios::binary);
+            entriesFile.write(reinterpret_cast<const char *>(entries.data()), static_cast<long>(sizeof(ClusterTagEntry) * entries.size()));
+            // Always write at least one byte so that the strings file can be mapped
+            std::ofstream stringsFile(stringsFilePath(baseDirectory, tagSetName), std::ios::binary);
+            stringsFile.write(tagData.data(), static_cast<long>(tagData.size()));
+            stringsFile.put('\0');
+        }
+        
+        ranges::subrange<const ClusterTagEntry *> entries() const {
+            auto count = entryFile.size();
+            if (count == 0) {
+                return {nullptr, nullptr};
+            }
+            auto first = entryFile[0];
+            return ranges::make_subrange(first, first + count);
+        }
+        
+        std::string getTag(const ClusterTagEntry &entry) const {
+            return std::string(tagFile.getDataAtOffset(static_cast<OffsetType>(entry.tagOffset)), entry.tagLength);
+        }
+    };
+} // namespace blocksci
+
+#endif /* cluster_tag_index_hpp */
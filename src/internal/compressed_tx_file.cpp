@@ -0,0 +1,284 @@
+//
+//  compressed_tx_file.cpp
+//  blocksci
+//
+
+#include "compressed_tx_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+namespace blocksci {
+    namespace {
+        void writeVarInt(std::string &out, uint64_t value) {
+            while (value >= 0x80) {
+                out += static_cast<char>((value & 0x7f) | 0x80);
+                value >>= 7;
+            }
+            out += static_cast<char>(value);
+        }
+        
+        uint64_t zigzag(int64_t value) {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+        
+        int64_t unzigzag(uint64_t value) {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+        
+        class FrameReader {
+            const unsigned char *pos;
+            const unsigned char *end;
+        
+        public:
+            FrameReader(const char *data, size_t size) : pos(reinterpret_cast<const unsigned char *>(data)), end(pos + size) {}
+            
+            uint64_t readVarInt() {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    if (pos == end) {
+                        throw std::runtime_error("Compressed transaction frame is truncated");
+                    }
+                    auto byte = *pos++;
+                    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                throw std::runtime_error("Compressed transaction frame contains an invalid varint");
+            }
+            
+            const unsigned char *readBytes(size_t count) {
+                if (static_cast<size_t>(end - pos) < count) {
+                    throw std::runtime_error("Compressed transaction frame is truncated");
+                }
+                auto data = pos;
+                pos += count;
+                return data;
+            }
+        };
+        
+        uint8_t bitWidth(uint64_t value) {
+            uint8_t width = 0;
+            while (value > 0) {
+                width++;
+                value >>= 1;
+            }
+            return width;
+        }
+    }
+    
+    void encodeTxFrame(std::string &out, uint32_t firstTxNum, const std::vector<const RawTransaction *> &txes) {
+        uint64_t inoutCount = 0;
+        for (auto tx : txes) {
+            inoutCount += tx->inputCount + tx->outputCount;
+        }
+        writeVarInt(out, txes.size());
+        writeVarInt(out, inoutCount);
+        
+        for (auto tx : txes) {
+            writeVarInt(out, tx->realSize);
+            writeVarInt(out, tx->realSize - tx->baseSize);
+            writeVarInt(out, tx->locktime);
+            writeVarInt(out, tx->inputCount);
+            writeVarInt(out, tx->outputCount);
+        }
+        
+        // Linked transactions are mostly close to the transaction itself, 0 marks unspent outputs
+        auto txNum = firstTxNum;
+        for (auto tx : txes) {
+            for (auto inout = tx->beginInputs(); inout != tx->endOutputs(); ++inout) {
+                auto linked = inout->getLinkedTxNum();
+                writeVarInt(out, linked == 0 ? 0 : zigzag(static_cast<int64_t>(linked) - static_cast<int64_t>(txNum)) + 1);
+            }
+            txNum++;
+        }
+        
+        std::array<uint32_t, 16> lastAddressNums{};
+        for (auto tx : txes) {
+            for (auto inout = tx->beginInputs(); inout != tx->endOutputs(); ++inout) {
+                auto &last = lastAddressNums[static_cast<size_t>(inout->getType())];
+                writeVarInt(out, zigzag(static_cast<int64_t>(inout->getAddressNum()) - static_cast<int64_t>(last)));
+                last = inout->getAddressNum();
+            }
+        }
+        
+        std::string types((inoutCount + 1) / 2, '\0');
+        uint64_t minValue = std::numeric_limits<uint64_t>::max();
+        uint64_t maxValue = 0;
+        uint64_t i = 0;
+        for (auto tx : txes) {
+            for (auto inout = tx->beginInputs(); inout != tx->endOutputs(); ++inout, ++i) {
+                types[i / 2] = static_cast<char>(types[i / 2] | (static_cast<uint8_t>(inout->getType()) << (4 * (i % 2))));
+                auto value = static_cast<uint64_t>(inout->getValue());
+                minValue = std::min(minValue, value);
+                maxValue = std::max(maxValue, value);
+            }
+        }
+        out += types;
+        
+        if (inoutCount == 0) {
+            return;
+        }
+        auto width = bitWidth(maxValue - minValue);
+        writeVarInt(out, minValue);
+        out += static_cast<char>(width);
+        std::string packed((inoutCount * width + 7) / 8, '\0');
+        uint64_t bitPos = 0;
+        for (auto tx : txes) {
+            for (auto inout = tx->beginInputs(); inout != tx->endOutputs(); ++inout) {
+                auto delta = static_cast<uint64_t>(inout->getValue()) - minValue;
+                for (uint8_t bit = 0; bit < width; bit += 8 - (bitPos + bit) % 8) {
+                    auto bytePos = (bitPos + bit) / 8;
+                    auto shift = (bitPos + bit) % 8;
+                    packed[bytePos] = static_cast<char>(static_cast<uint8_t>(packed[bytePos]) | static_cast<uint8_t>((delta >> bit) << shift));
+                }
+                bitPos += width;
+            }
+        }
+        out += packed;
+    }
+    
+    TxFrame decodeTxFrame(const char *data, size_t size, uint32_t firstTxNum) {
+        FrameReader reader(data, size);
+        auto txCount = reader.readVarInt();
+        auto inoutCount = reader.readVarInt();
+        if (txCount > compressedTxFrameSize || inoutCount > size * 8) {
+            throw std::runtime_error("Compressed transaction frame has an invalid header");
+        }
+        
+        TxFrame frame(firstTxNum);
+        frame.storage.resize((txCount * sizeof(RawTransaction) + inoutCount * sizeof(Inout)) / sizeof(uint64_t));
+        frame.offsets.reserve(txCount);
+        auto bytes = reinterpret_cast<char *>(frame.storage.data());
+        
+        uint64_t offset = 0;
+        uint64_t decodedInouts = 0;
+        for (uint64_t i = 0; i < txCount; i++) {
+            auto realSize = static_cast<uint32_t>(reader.readVarInt());
+            auto baseSize = realSize - static_cast<uint32_t>(reader.readVarInt());
+            auto locktime = static_cast<uint32_t>(reader.readVarInt());
+            auto inputCount = static_cast<uint16_t>(reader.readVarInt());
+            auto outputCount = static_cast<uint16_t>(reader.readVarInt());
+            decodedInouts += inputCount + outputCount;
+            if (decodedInouts > inoutCount) {
+                throw std::runtime_error("Compressed transaction frame has inconsistent input and output counts");
+            }
+            new (bytes + offset) RawTransaction(realSize, baseSize, locktime, inputCount, outputCount);
+            frame.offsets.push_back(static_cast<uint32_t>(offset));
+            offset += sizeof(RawTransaction) + sizeof(Inout) * (inputCount + outputCount);
+        }
+        if (decodedInouts != inoutCount) {
+            throw std::runtime_error("Compressed transaction frame has inconsistent input and output counts");
+        }
+        
+        std::vector<uint32_t> linkedTxNums;
+        linkedTxNums.reserve(inoutCount);
+        for (uint64_t i = 0; i < txCount; i++) {
+            auto tx = reinterpret_cast<const RawTransaction *>(bytes + frame.offsets[i]);
+            auto txNum = static_cast<int64_t>(firstTxNum + i);
+            for (uint32_t j = 0; j < static_cast<uint32_t>(tx->inputCount + tx->outputCount); j++) {
+                auto code = reader.readVarInt();
+                linkedTxNums.push_back(code == 0 ? 0 : static_cast<uint32_t>(txNum + unzigzag(code - 1)));
+            }
+        }
+        std::vector<uint64_t> addressCodes;
+        addressCodes.reserve(inoutCount);
+        for (uint64_t i = 0; i < inoutCount; i++) {
+            addressCodes.push_back(reader.readVarInt());
+        }
+        auto types = reader.readBytes((inoutCount + 1) / 2);
+        uint64_t minValue = 0;
+        uint8_t width = 0;
+        const unsigned char *packed = nullptr;
+        if (inoutCount > 0) {
+            minValue = reader.readVarInt();
+            width = *reader.readBytes(1);
+            if (width > 64) {
+                throw std::runtime_error("Compressed transaction frame has an invalid value width");
+            }
+            packed = reader.readBytes((inoutCount * width + 7) / 8);
+        }
+        
+        std::array<uint32_t, 16> lastAddressNums{};
+        uint64_t i = 0;
+        uint64_t bitPos = 0;
+        for (uint64_t txIndex = 0; txIndex < txCount; txIndex++) {
+            auto tx = reinterpret_cast<RawTransaction *>(bytes + frame.offsets[txIndex]);
+            auto inouts = reinterpret_cast<Inout *>(tx + 1);
+            for (uint32_t j = 0; j < static_cast<uint32_t>(tx->inputCount + tx->outputCount); j++, i++) {
+                auto type = static_cast<AddressType::Enum>((types[i / 2] >> (4 * (i % 2))) & 0xf);
+                auto &last = lastAddressNums[static_cast<size_t>(type)];
+                last = static_cast<uint32_t>(static_cast<int64_t>(last) + unzigzag(addressCodes[i]));
+                uint64_t delta = 0;
+                for (uint8_t bit = 0; bit < width; bit += 8 - (bitPos + bit) % 8) {
+                    auto bytePos = (bitPos + bit) / 8;
+                    auto shift = (bitPos + bit) % 8;
+                    delta |= static_cast<uint64_t>(packed[bytePos] >> shift) << bit;
+                }
+                if (width < 64) {
+                    delta &= (uint64_t(1) << width) - 1;
+                }
+                bitPos += width;
+                new (&inouts[j]) Inout(linkedTxNums[i], last, type, static_cast<int64_t>(minValue + delta));
+            }
+        }
+        return frame;
+    }
+    
+    CompressedTxFile::CompressedTxFile(const filesystem::path &baseDirectory, uint32_t chainTxCount, size_t cacheFrames) :
+    indexFile(indexFilePath(baseDirectory)),
+    dataFile(dataFilePath(baseDirectory)),
+    cacheCapacity(std::max(cacheFrames, size_t{1})) {
+        if (txCount() != chainTxCount) {
+            std::stringstream ss;
+            ss << "Compressed transaction data was built for " << txCount() << " transactions, but the chain has " << chainTxCount << ". Run compress-tx-data again.";
+            throw std::runtime_error(ss.str());
+        }
+    }
+    
+    uint32_t CompressedTxFile::recordedTxCount(const filesystem::path &baseDirectory) {
+        std::ifstream file(indexFilePath(baseDirectory).str() + ".dat", std::ios::binary);
+        uint64_t txCount = 0;
+        if (!file.read(reinterpret_cast<char *>(&txCount), sizeof(txCount))) {
+            return 0;
+        }
+        return static_cast<uint32_t>(txCount);
+    }
+    
+    std::shared_ptr<const TxFrame> CompressedTxFile::getFrame(uint32_t frameNum) const {
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            auto it = cachePositions.find(frameNum);
+            if (it != cachePositions.end()) {
+                cacheHits++;
+                cache.splice(cache.begin(), cache, it->second);
+                return it->second->second;
+            }
+            cacheMisses++;
+        }
+        
+        if (frameNum >= frameCount()) {
+            throw std::out_of_range("Compressed transaction frame out of range");
+        }
+        auto begin = *indexFile[frameNum + 1];
+        auto end = *indexFile[frameNum + 2];
+        auto frame = std::make_shared<const TxFrame>(decodeTxFrame(dataFile.getDataAtOffset(begin), end - begin, frameNum * compressedTxFrameSize));
+        
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (cachePositions.find(frameNum) == cachePositions.end()) {
+            cache.emplace_front(frameNum, frame);
+            cachePositions[frameNum] = cache.begin();
+            if (cache.size() > cacheCapacity) {
+                cachePositions.erase(cache.back().first);
+                cache.pop_back();
+            }
+        }
+        return frame;
+    }
+} // namespace blocksci
@@ -0,0 +1,133 @@
+//
+//  compressed_tx_file.hpp
+//  blocksci
+//
+
+#ifndef compressed_tx_file_hpp
+#define compressed_tx_file_hpp
+
+#include "file_mapper.hpp"
+
+#include <blocksci/core/raw_transaction.hpp>
+
+#include <wjfilesystem/path.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blocksci {
+
+    /** Number of consecutive transactions that are compressed together into one frame */
+    constexpr uint32_t compressedTxFrameSize = 4096;
+    
+    /** Transactions of one frame, decoded into the layout of chain/tx_data.dat */
+    class TxFrame {
+        // uint64_t elements keep the RawTransaction and Inout objects aligned
+        std::vector<uint64_t> storage;
+        std::vector<uint32_t> offsets;
+        uint32_t firstTxNum;
+        
+        friend TxFrame decodeTxFrame(const char *data, size_t size, uint32_t firstTxNum);
+    
+    public:
+        explicit TxFrame(uint32_t firstTxNum_) : firstTxNum(firstTxNum_) {}
+        
+        uint32_t firstTx() const {
+            return firstTxNum;
+        }
+        
+        uint32_t size() const {
+            return static_cast<uint32_t>(offsets.size());
+        }
+        
+        /** Transaction with the given blockchain-wide number, which has to be part of the frame */
+        const RawTransaction *getTx(uint32_t txNum) const {
+            auto bytes = reinterpret_cast<const char *>(storage.data());
+            return reinterpret_cast<const RawTransaction *>(bytes + offsets[txNum - firstTxNum]);
+        }
+    };
+    
+    /** Appends the compressed encoding of consecutive transactions starting at firstTxNum to out
+     *
+     * Transaction fields and input/output counts are varint coded. Linked tx numbers are stored as the difference to
+     * the transaction number and address numbers as the difference to the previous address of the same type, both
+     * zigzag and varint coded. Types are packed into 4 bits and values are frame-of-reference bit-packed.
+     */
+    void encodeTxFrame(std::string &out, uint32_t firstTxNum, const std::vector<const RawTransaction *> &txes);
+    
+    TxFrame decodeTxFrame(const char *data, size_t size, uint32_t firstTxNum);
+    
+    /** Provides random access to a compressed copy of chain/tx_data.dat
+     *
+     * Transactions are decoded a frame at a time and the decoded frames are kept in a small LRU cache. Frames are
+     * handed out as shared pointers, so an evicted frame stays valid for as long as a caller still uses it. The copy
+     * is only opened if it was built for the current number of transactions of the chain.
+     *
+     * Files: - chain/tx_compressed_data.dat: [<frame>, <frame>, ...]
+     *        - chain/tx_compressed_index.dat: [<uint64_t>, <uint64_t>, ...] number of compressed transactions, then the
+     *          offset of every frame followed by the end of the data
+     */
+    class CompressedTxFile {
+        FixedSizeFileMapper<uint64_t> indexFile;
+        SimpleFileMapper<> dataFile;
+        size_t cacheCapacity;
+        
+        mutable std::mutex cacheMutex;
+        mutable std::list<std::pair<uint32_t, std::shared_ptr<const TxFrame>>> cache;
+        mutable std::unordered_map<uint32_t, decltype(cache)::iterator> cachePositions;
+        mutable uint64_t cacheHits = 0;
+        mutable uint64_t cacheMisses = 0;
+    
+    public:
+        /** Throws std::runtime_error if the copy does not hold exactly chainTxCount transactions */
+        CompressedTxFile(const filesystem::path &baseDirectory, uint32_t chainTxCount, size_t cacheFrames = 64);
+        
+        static filesystem::path dataFilePath(const filesystem::path &baseDirectory) {
+            return baseDirectory/"tx_compressed_data";
+        }
+        
+        static filesystem::path indexFilePath(const filesystem::path &baseDirectory) {
+            return baseDirectory/"tx_compressed_index";
+        }
+        
+        static bool exists(const filesystem::path &baseDirectory) {
+            return filesystem::path{indexFilePath(baseDirectory).str() + ".dat"}.exists();
+        }
+        
+        /** Number of transactions the copy was built for, 0 if there is no copy */
+        static uint32_t recordedTxCount(const filesystem::path &baseDirectory);
+        
+        uint32_t frameCount() const {
+            return indexFile.size() > 1 ? static_cast<uint32_t>(indexFile.size() - 2) : 0;
+        }
+        
+        uint32_t txCount() const {
+            return indexFile.size() > 0 ? static_cast<uint32_t>(*indexFile[0]) : 0;
+        }
+        
+        uint64_t compressedSize() const {
+            return dataFile.size();
+        }
+        
+        std::shared_ptr<const TxFrame> getFrame(uint32_t frameNum) const;
+        
+        std::shared_ptr<const TxFrame> getFrameOfTx(uint32_t txNum) const {
+            return getFrame(txNum / compressedTxFrameSize);
+        }
+        
+        uint64_t getCacheHits() const {
+            return cacheHits;
+        }
+        
+        uint64_t getCacheMisses() const {
+            return cacheMisses;
+        }
+    };
+} // namespace blocksci
+
+#endif /* compressed_tx_file_hpp */
@@ -12,6 +12,9 @@
 #include "address_index.hpp"
 #include "hash_index.hpp"
 #include "mempool_index.hpp"
+#include "inout_column_access.hpp"
+#include "equiv_table_access.hpp"
+#include "utxo_snapshot_access.hpp"
 
 namespace blocksci {
     
@@ -23,7 +26,10 @@ namespace blocksci {
     scripts{std::make_unique<ScriptAccess>(config.scriptsDirectory())},
     addressIndex{std::make_unique<AddressIndex>(config.addressDBFilePath(), true)},
     hashIndex{std::make_unique<HashIndex>(config.hashIndexFilePath(), true)},
-    mempoolIndex{std::make_unique<MempoolIndex>(config.mempoolDirectory())} {}
+    mempoolIndex{std::make_unique<MempoolIndex>(config.mempoolDirectory())},
+    inoutColumns{std::make_unique<InoutColumnAccess>(config.chainDirectory())},
+    equivTable{std::make_unique<EquivTableAccess>(config.scriptsDirectory())},
+    utxoSnapshots{std::make_unique<UtxoSnapshotAccess>(config.chainDirectory())} {}
     
     DataAccess::DataAccess(DataAccess &&) = default;
     DataAccess &DataAccess::operator=(DataAccess &&) = default;
@@ -33,5 +39,8 @@ namespace blocksci {
         chain->reload();
         scripts->reload();
         mempoolIndex->reload();
+        inoutColumns->reload();
+        equivTable->reload();
+        utxoSnapshots->reload();
     }
 }
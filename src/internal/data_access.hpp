@@ -19,6 +19,9 @@ namespace blocksci {
     class AddressIndex;
     class HashIndex;
     class MempoolIndex;
+    class InoutColumnAccess;
+    class EquivTableAccess;
+    class UtxoSnapshotAccess;
 
     /** This class wraps and manages all data and index access classes
      *     - ChainAccess: Provides data access for blocks, transactions, inputs, and outputs
@@ -26,6 +29,9 @@ namespace blocksci {
      *     - AddressIndex: Provides data access to address indexes (RocksDB database)
      *     - HashIndex: Provides data access to hash indexes (RocksDB database)
      *     - MempoolIndex: Provides data access to the mempool index (when a transaction has been first seen)
+     *     - InoutColumnAccess: Provides dense per-field columns of all inputs and outputs
+     *     - EquivTableAccess: Provides the script-equivalence classes of nested addresses
+     *     - UtxoSnapshotAccess: Provides the UTXO sets materialized every few blocks
      *
      *     - DataConfiguration: Loads and holds blockchain configuration files, needed to load blockchains
      */
@@ -78,6 +84,26 @@ namespace blocksci {
          * Directory: mempool/
          */
         std::unique_ptr<MempoolIndex> mempoolIndex;
+
+        /** Provides dense per-field columns of all inputs and outputs. The columns are empty until
+         * the parser's inout-columns-update command has been run.
+         *
+         * Directory: chain/columns/
+         */
+        std::unique_ptr<InoutColumnAccess> inoutColumns;
+
+        /** Provides the script-equivalence classes of addresses that are nested in script hash addresses,
+         * which the parser writes so that EquivAddress does not have to query the address index.
+         *
+         * Directory: scripts/equiv/
+         */
+        std::unique_ptr<EquivTableAccess> equivTable;
+
+        /** Provides the UTXO sets that the parser's utxo-snapshots-update command materializes every few blocks.
+         *
+         * Directory: chain/utxo_snapshots/
+         */
+        std::unique_ptr<UtxoSnapshotAccess> utxoSnapshots;
         
         DataAccess();
         explicit DataAccess(DataConfiguration config_);
@@ -97,6 +123,18 @@ namespace blocksci {
             return *mempoolIndex;
         }
 
+        const InoutColumnAccess &getInoutColumns() const {
+            return *inoutColumns;
+        }
+
+        const EquivTableAccess &getEquivTable() const {
+            return *equivTable;
+        }
+
+        const UtxoSnapshotAccess &getUtxoSnapshots() const {
+            return *utxoSnapshots;
+        }
+
         AddressIndex &getAddressIndex() {
             return *addressIndex;
         }
@@ -0,0 +1,131 @@
+//
+//  equiv_table_access.hpp
+//  blocksci
+//
+
+#ifndef equiv_table_access_hpp
+#define equiv_table_access_hpp
+
+#include "chain_access.hpp"
+#include "file_mapper.hpp"
+
+#include <blocksci/chain/column_view.hpp>
+#include <blocksci/core/bitcoin_uint256.hpp>
+#include <blocksci/core/dedup_address.hpp>
+
+#include <wjfilesystem/path.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+
+namespace blocksci {
+
+    /** Extent of the equivalence table */
+    struct EquivTableState {
+        uint32_t txCount;
+        uint32_t classCount;
+        /** Number of script hash addresses when the table was written, later ones are added by the next update */
+        uint32_t scriptHashCount;
+        uint32_t padding;
+        /** Hash of the last covered transaction, used to detect reorgs and outdated tables */
+        uint256 lastTxHash;
+    };
+    
+    /** Class of an address that has equivalents, entries are sorted by address */
+    struct EquivTableEntry {
+        DedupAddress address;
+        uint32_t classId;
+        
+        bool operator<(const EquivTableEntry &other) const {
+            return std::make_tuple(address.type, address.scriptNum) < std::make_tuple(other.address.type, other.address.scriptNum);
+        }
+    };
+    
+    /** Provides the script-equivalence classes of all addresses that are nested in a script hash
+     *
+     * A class contains the innermost address of a chain of script hash addresses together with every script hash
+     * address that wraps it, directly or through other script hash addresses. These are the addresses that
+     * EquivAddress otherwise collects by following wrapped addresses and the nested address index. Only addresses
+     * with equivalents are listed, all other addresses have the class id 0 and form a class on their own. The table is
+     * written by the parser once equiv-table-update has been run and describes the chain as it was at that time.
+     *
+     * Directory: scripts/equiv/
+     * Files: - class_entry.dat: [<EquivTableEntry>, ...] class of every address with equivalents, sorted by address
+     *        - class_offset.dat: [<uint64_t>, ...] position of the first member of each class followed by the end
+     *        - class_member.dat: [<DedupAddress>, ...] members of all classes, sorted within each class
+     *        - state.dat: [<EquivTableState>]
+     */
+    class EquivTableAccess {
+        FixedSizeFileMapper<EquivTableEntry> classEntryFile;
+        FixedSizeFileMapper<uint64_t> classOffsetFile;
+        FixedSizeFileMapper<DedupAddress> classMemberFile;
+        FixedSizeFileMapper<EquivTableState> stateFile;
+    
+    public:
+        explicit EquivTableAccess(const filesystem::path &baseDirectory) :
+        classEntryFile(tableDirectory(baseDirectory)/"class_entry"),
+        classOffsetFile(tableDirectory(baseDirectory)/"class_offset"),
+        classMemberFile(tableDirectory(baseDirectory)/"class_member"),
+        stateFile(stateFilePath(baseDirectory)) {}
+        
+        static filesystem::path tableDirectory(const filesystem::path &baseDirectory) {
+            return baseDirectory/"equiv";
+        }
+        
+        static filesystem::path stateFilePath(const filesystem::path &baseDirectory) {
+            return tableDirectory(baseDirectory)/"state";
+        }
+        
+        /** Number of transactions the table was written for, 0 if it was never written */
+        uint32_t txCount() const {
+            return stateFile.size() > 0 ? stateFile[0]->txCount : 0;
+        }
+        
+        /** Returns whether the table describes the current state of the chain
+         *
+         * Script hash addresses reveal their wrapped address when they are spent, so a table written for fewer
+         * transactions can miss equivalences and is not used.
+         */
+        bool covers(const ChainAccess &chain) const {
+            auto count = txCount();
+            if (count == 0 || count < chain.txCount()) {
+                return false;
+            }
+            if (count > chain.txCount()) {
+                // Blocks at the end of the chain are ignored, the address index also includes them
+                return true;
+            }
+            return *chain.getTxHash(count - 1) == stateFile[0]->lastTxHash;
+        }
+        
+        /** Id of the equivalence class of the address, 0 if the address is only equivalent to itself */
+        uint32_t classId(const DedupAddress &address) const {
+            auto count = classEntryFile.size();
+            if (count == 0) {
+                return 0;
+            }
+            auto first = classEntryFile[0];
+            auto last = first + count;
+            EquivTableEntry searched{address, 0};
+            auto it = std::lower_bound(first, last, searched);
+            return it != last && it->address == address ? it->classId : 0;
+        }
+        
+        /** Members of the class with the given id, which must not be 0 */
+        ColumnView<DedupAddress> classMembers(uint32_t classId) const {
+            auto begin = *classOffsetFile[classId - 1];
+            auto end = *classOffsetFile[classId];
+            return {classMemberFile[static_cast<OffsetType>(begin)], end - begin};
+        }
+        
+        void reload() {
+            classEntryFile.reload();
+            classOffsetFile.reload();
+            classMemberFile.reload();
+            stateFile.reload();
+        }
+    };
+} // namespace blocksci
+
+#endif /* equiv_table_access_hpp */
@@ -131,6 +131,26 @@ namespace blocksci {
         return getMatch(getTxColumn().get(), txHash);
     }
     
+    std::vector<ranges::optional<uint32_t>> HashIndex::getTxIndexes(const std::vector<uint256> &txHashes) {
+        std::vector<rocksdb::Slice> keys;
+        keys.reserve(txHashes.size());
+        for (const auto &txHash : txHashes) {
+            keys.emplace_back(reinterpret_cast<const char *>(&txHash), sizeof(txHash));
+        }
+        std::vector<rocksdb::ColumnFamilyHandle *> handles(keys.size(), getTxColumn().get());
+        std::vector<std::string> values;
+        auto statuses = db->MultiGet(rocksdb::ReadOptions{}, handles, keys, &values);
+        std::vector<ranges::optional<uint32_t>> txIndexes(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (statuses[i].ok() && values[i].size() >= sizeof(uint32_t)) {
+                uint32_t value;
+                memcpy(&value, values[i].data(), sizeof(value));
+                txIndexes[i] = value;
+            }
+        }
+        return txIndexes;
+    }
+    
     ranges::optional<uint32_t> HashIndex::lookupAddressImpl(blocksci::AddressType::Enum type, const char *data, size_t size) {
         return getAddressMatch(type, data, size);
     }
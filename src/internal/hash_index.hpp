@@ -22,6 +22,7 @@
 #include <vector>
 #include <cstdint>
 #include <cstring>
+#include <string>
 
 namespace blocksci {
 
@@ -159,6 +160,9 @@ namespace blocksci {
         /** Get the tx number for the given transaction hash */
         ranges::optional<uint32_t> getTxIndex(const uint256 &txHash);
         
+        /** Get the tx numbers for the given transaction hashes with a single batched lookup, nullopt for unknown hashes */
+        std::vector<ranges::optional<uint32_t>> getTxIndexes(const std::vector<uint256> &txHashes);
+        
         uint32_t countColumn(AddressType::Enum type);
         uint32_t countTxes();
         
@@ -178,6 +182,24 @@ namespace blocksci {
         
         ranges::any_view<std::pair<MemoryView, MemoryView>> getRawAddressRange(AddressType::Enum type);
         
+        /** Calls func(key, scriptNum) for every entry of the column of the given type whose key lies in [lower, upper]
+         *
+         * Keys are compared bytewise, which orders hashes by their bytes in memory order. Iterators over the index are
+         * independent, so different ranges can be scanned from several threads at once.
+         */
+        template <typename Func>
+        void scanAddressRange(AddressType::Enum type, const std::string &lower, const std::string &upper, Func func) {
+            auto it = getIterator(type);
+            rocksdb::Slice upperSlice{upper};
+            for (it->Seek(rocksdb::Slice{lower}); it->Valid() && it->key().compare(upperSlice) <= 0; it->Next()) {
+                auto key = it->key();
+                auto value = it->value();
+                uint32_t scriptNum;
+                memcpy(&scriptNum, value.data(), sizeof(scriptNum));
+                func(MemoryView{key.data(), key.size()}, scriptNum);
+            }
+        }
+        
         template<AddressType::Enum type>
         ranges::any_view<std::pair<uint32_t, typename blocksci::AddressInfo<type>::IDType>> getAddressRange();
 
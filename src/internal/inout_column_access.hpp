@@ -0,0 +1,146 @@
+//
+//  inout_column_access.hpp
+//  blocksci
+//
+
+#ifndef inout_column_access_hpp
+#define inout_column_access_hpp
+
+#include "chain_access.hpp"
+#include "file_mapper.hpp"
+
+#include <blocksci/chain/column_view.hpp>
+#include <blocksci/core/bitcoin_uint256.hpp>
+
+#include <wjfilesystem/path.h>
+
+#include <cstdint>
+
+namespace blocksci {
+
+    /** Extent of the transactions that the inout columns were written for */
+    struct InoutColumnState {
+        uint32_t txCount;
+        uint32_t padding;
+        uint64_t inputCount;
+        uint64_t outputCount;
+        /** Hash of the last covered transaction, used to detect reorgs */
+        uint256 lastTxHash;
+    };
+    
+    /** Provides dense per-field columns of all inputs and outputs
+     *
+     * The columns hold the same values as the Inout entries of chain/tx_data.dat, but store every field
+     * contiguously so that scans over a single field only read that field. They are indexed by the
+     * blockchain-wide input and output numbers of chain/firstInput.dat and chain/firstOutput.dat and are
+     * written by the inout-columns-update command of the parser.
+     *
+     * Directory: chain/columns/
+     * Files: - output_value.dat, input_value.dat: [<int64_t>, ...]
+     *        - output_type.dat, input_type.dat: [<uint8_t AddressType::Enum>, ...]
+     *        - output_address.dat, input_address.dat: [<uint32_t addressNum>, ...]
+     *        - output_spent_tx.dat: [<uint32_t>, ...] tx number of the spending transaction, 0 if unspent
+     *        - input_spent_tx.dat: [<uint32_t>, ...] tx number of the transaction containing the spent output
+     *        - state.dat: [<InoutColumnState>]
+     */
+    class InoutColumnAccess {
+        FixedSizeFileMapper<int64_t> outputValueFile;
+        FixedSizeFileMapper<uint8_t> outputTypeFile;
+        FixedSizeFileMapper<uint32_t> outputAddressFile;
+        FixedSizeFileMapper<uint32_t> outputSpentTxFile;
+        FixedSizeFileMapper<int64_t> inputValueFile;
+        FixedSizeFileMapper<uint8_t> inputTypeFile;
+        FixedSizeFileMapper<uint32_t> inputAddressFile;
+        FixedSizeFileMapper<uint32_t> inputSpentTxFile;
+        FixedSizeFileMapper<InoutColumnState> stateFile;
+    
+    public:
+        explicit InoutColumnAccess(const filesystem::path &baseDirectory) :
+        outputValueFile(columnFilePath(baseDirectory, "output_value")),
+        outputTypeFile(columnFilePath(baseDirectory, "output_type")),
+        outputAddressFile(columnFilePath(baseDirectory, "output_address")),
+        outputSpentTxFile(columnFilePath(baseDirectory, "output_spent_tx")),
+        inputValueFile(columnFilePath(baseDirectory, "input_value")),
+        inputTypeFile(columnFilePath(baseDirectory, "input_type")),
+        inputAddressFile(columnFilePath(baseDirectory, "input_address")),
+        inputSpentTxFile(columnFilePath(baseDirectory, "input_spent_tx")),
+        stateFile(stateFilePath(baseDirectory)) {}
+        
+        static filesystem::path columnDirectory(const filesystem::path &baseDirectory) {
+            return baseDirectory/"columns";
+        }
+        
+        static filesystem::path columnFilePath(const filesystem::path &baseDirectory, const std::string &name) {
+            return columnDirectory(baseDirectory)/name;
+        }
+        
+        static filesystem::path stateFilePath(const filesystem::path &baseDirectory) {
+            return columnDirectory(baseDirectory)/"state";
+        }
+        
+        /** Number of transactions covered by the columns, 0 if they were never written */
+        uint32_t txCount() const {
+            return stateFile.size() > 0 ? stateFile[0]->txCount : 0;
+        }
+        
+        /** Returns whether the columns contain the inputs and outputs of all transactions before endTxNum */
+        bool covers(const ChainAccess &chain, uint32_t endTxNum) const {
+            auto count = txCount();
+            if (count < endTxNum || count == 0) {
+                return endTxNum == 0;
+            }
+            if (count > chain.txCount()) {
+                // Blocks at the end of the chain are ignored, the update of the columns checks them for reorgs
+                return true;
+            }
+            // After a reorg the columns describe transactions that are no longer part of the chain
+            return *chain.getTxHash(count - 1) == stateFile[0]->lastTxHash;
+        }
+        
+        ColumnView<int64_t> outputValues(uint64_t begin, uint64_t end) const {
+            return fileColumnView(outputValueFile, begin, end);
+        }
+        
+        ColumnView<uint8_t> outputTypes(uint64_t begin, uint64_t end) const {
+            return fileColumnView(outputTypeFile, begin, end);
+        }
+        
+        ColumnView<uint32_t> outputAddressNums(uint64_t begin, uint64_t end) const {
+            return fileColumnView(outputAddressFile, begin, end);
+        }
+        
+        ColumnView<uint32_t> outputSpendingTxNums(uint64_t begin, uint64_t end) const {
+            return fileColumnView(outputSpentTxFile, begin, end);
+        }
+        
+        ColumnView<int64_t> inputValues(uint64_t begin, uint64_t end) const {
+            return fileColumnView(inputValueFile, begin, end);
+        }
+        
+        ColumnView<uint8_t> inputTypes(uint64_t begin, uint64_t end) const {
+            return fileColumnView(inputTypeFile, begin, end);
+        }
+        
+        ColumnView<uint32_t> inputAddressNums(uint64_t begin, uint64_t end) const {
+            return fileColumnView(inputAddressFile, begin, end);
+        }
+        
+        ColumnView<uint32_t> inputSpentTxNums(uint64_t begin, uint64_t end) const {
+            return fileColumnView(inputSpentTxFile, begin, end);
+        }
+        
+        void reload() {
+            outputValueFile.reload();
+            outputTypeFile.reload();
+            outputAddressFile.reload();
+            outputSpentTxFile.reload();
+            inputValueFile.reload();
+            inputTypeFile.reload();
+            inputAddressFile.reload();
+            inputSpentTxFile.reload();
+            stateFile.reload();
+        }
+    };
+} // namespace blocksci
+
+#endif /* inout_column_access_hpp */
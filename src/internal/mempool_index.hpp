@@ -10,12 +10,17 @@
 
 #include "file_mapper.hpp"
 
+#include <blocksci/chain/mempool.hpp>
+
 #include <range/v3/algorithm/upper_bound.hpp>
 #include <range/v3/view/transform.hpp>
 
 #include <wjfilesystem/path.h>
 
 #include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
 
 namespace blocksci {
     
@@ -103,13 +108,143 @@ namespace blocksci {
         }
     };
 
+    /** Columnar store of the mempool observations of the recorder
+     *
+     * Every column is indexed by slot * mempoolSegmentSize + txNum % mempoolSegmentSize, where the slot of a
+     * transaction is looked up in the segment table with txNum / mempoolSegmentSize. Slots are assigned in the order
+     * in which the recorder reaches the segments, so recording gaps do not take up space.
+     *
+     * Directory: mempool/columns/
+     * Files: - segments.dat: [<uint32_t>, ...] slot + 1 of every segment, 0 if no transaction of it was recorded
+     *        - tx_index.dat: [<uint32_t>, ...] txNum of the row
+     *        - first_seen.dat: [<int64_t>, ...] 0 if not observed, 1 if present when the recorder started, else the time first seen
+     *        - fee_rate.dat: [<uint64_t>, ...] fee rate in satoshi per 1000 vbytes when first seen, 0 if unknown
+     *        - removed.dat: [<int64_t>, ...] last time the transaction left the mempool without being mined, 0 if never
+     *        - replaced_count.dat: [<uint32_t>, ...] number of mempool transactions that the transaction replaced
+     *        - events.dat: [<MempoolEvent>, ...] append-only log of mempool events
+     */
+    class MempoolStore {
+        FixedSizeFileMapper<uint32_t> segmentFile;
+        FixedSizeFileMapper<uint32_t> txIndexFile;
+        FixedSizeFileMapper<int64_t> firstSeenFile;
+        FixedSizeFileMapper<uint64_t> feeRateFile;
+        FixedSizeFileMapper<int64_t> removedFile;
+        FixedSizeFileMapper<uint32_t> replacedCountFile;
+        FixedSizeFileMapper<MempoolEvent> eventFile;
+        
+        template <typename T>
+        static MempoolColumn makeColumn(const std::string &name, const FixedSizeFileMapper<T> &file, const char *format) {
+            const void *data = file.size() > 0 ? file[0] : nullptr;
+            return MempoolColumn{name, data, sizeof(T), sizeof(T), 1, format, static_cast<uint64_t>(file.size())};
+        }
+        
+        template <typename T>
+        MempoolColumn makeEventColumn(const std::string &name, size_t offset, uint32_t width, const char *format) const {
+            const char *data = eventFile.size() > 0 ? reinterpret_cast<const char *>(eventFile[0]) + offset : nullptr;
+            return MempoolColumn{name, data, sizeof(T), sizeof(MempoolEvent), width, format, static_cast<uint64_t>(eventFile.size())};
+        }
+        
+    public:
+        explicit MempoolStore(const filesystem::path &baseDirectory) :
+        segmentFile(columnPath(baseDirectory, "segments")),
+        txIndexFile(columnPath(baseDirectory, "tx_index")),
+        firstSeenFile(columnPath(baseDirectory, "first_seen")),
+        feeRateFile(columnPath(baseDirectory, "fee_rate")),
+        removedFile(columnPath(baseDirectory, "removed")),
+        replacedCountFile(columnPath(baseDirectory, "replaced_count")),
+        eventFile(columnPath(baseDirectory, "events")) {}
+        
+        static filesystem::path directoryPath(const filesystem::path &baseDirectory) {
+            return baseDirectory/"columns";
+        }
+        
+        static filesystem::path columnPath(const filesystem::path &baseDirectory, const std::string &column) {
+            return directoryPath(baseDirectory)/column;
+        }
+        
+        /** Row of the transaction in the columns, if its segment has been recorded */
+        ranges::optional<uint64_t> row(uint32_t txNum) const {
+            auto segment = txNum / mempoolSegmentSize;
+            if (segment >= segmentFile.size()) {
+                return ranges::nullopt;
+            }
+            auto slot = *segmentFile[segment];
+            if (slot == 0) {
+                return ranges::nullopt;
+            }
+            auto index = static_cast<uint64_t>(slot - 1) * mempoolSegmentSize + txNum % mempoolSegmentSize;
+            if (index >= firstSeenFile.size() || *firstSeenFile[index] == 0) {
+                return ranges::nullopt;
+            }
+            return index;
+        }
+        
+        int64_t firstSeen(uint64_t row) const {
+            return *firstSeenFile[row];
+        }
+        
+        ranges::optional<uint64_t> feeRate(uint64_t row) const {
+            if (row < feeRateFile.size() && *feeRateFile[row] > 0) {
+                return *feeRateFile[row];
+            }
+            return ranges::nullopt;
+        }
+        
+        ranges::optional<int64_t> removed(uint64_t row) const {
+            if (row < removedFile.size() && *removedFile[row] > 0) {
+                return *removedFile[row];
+            }
+            return ranges::nullopt;
+        }
+        
+        uint32_t replacedCount(uint64_t row) const {
+            return row < replacedCountFile.size() ? *replacedCountFile[row] : 0;
+        }
+        
+        /** Columns of the per transaction observations, rows that were not observed have a first_seen of 0 */
+        std::vector<MempoolColumn> observationColumns() const {
+            return {
+                makeColumn("tx_index", txIndexFile, "I"),
+                makeColumn("first_seen", firstSeenFile, "q"),
+                makeColumn("fee_rate", feeRateFile, "Q"),
+                makeColumn("removed", removedFile, "q"),
+                makeColumn("replaced_count", replacedCountFile, "I")
+            };
+        }
+        
+        /** Columns of the event log, hashes are in internal byte order which is the reverse of their hex form */
+        std::vector<MempoolColumn> eventColumns() const {
+            return {
+                makeEventColumn<int64_t>("time", offsetof(MempoolEvent, time), 1, "q"),
+                makeEventColumn<uint8_t>("tx_hash", offsetof(MempoolEvent, txHash), 32, "B"),
+                makeEventColumn<uint8_t>("other_tx_hash", offsetof(MempoolEvent, otherTxHash), 32, "B"),
+                makeEventColumn<uint64_t>("fee_rate", offsetof(MempoolEvent, feeRate), 1, "Q"),
+                makeEventColumn<uint32_t>("type", offsetof(MempoolEvent, type), 1, "I")
+            };
+        }
+        
+        void reload() {
+            segmentFile.reload();
+            txIndexFile.reload();
+            firstSeenFile.reload();
+            feeRateFile.reload();
+            removedFile.reload();
+            replacedCountFile.reload();
+            eventFile.reload();
+        }
+    };
+
     /** Provides access to the mempool index, which stores the timestamp of when a transaction has been
      * first seen. Only relevant when BlockSci's mempool_recorder is enabled (= running).
      *
+     * Transactions are looked up in the columnar MempoolStore first, the per recording N_tx files only cover data
+     * of recorders that predate it.
+     *
      * Directory: mempool/
      */
     class MempoolIndex {
         filesystem::path baseDirectory;
+        MempoolStore store;
         std::vector<TimestampIndex> timestampFiles;
         std::vector<BlocktimeIndex> blockTimeFiles;
         
@@ -143,7 +278,7 @@ namespace blocksci {
         }
         
     public:
-        explicit MempoolIndex(filesystem::path baseDirectory_) :  baseDirectory(std::move(baseDirectory_)) {
+        explicit MempoolIndex(filesystem::path baseDirectory_) :  baseDirectory(std::move(baseDirectory_)), store(baseDirectory) {
             setup();
         }
         
@@ -173,16 +308,28 @@ namespace blocksci {
             return ranges::nullopt;
         }
 
+        const MempoolStore &getStore() const {
+            return store;
+        }
+
         ranges::optional<std::chrono::system_clock::time_point> getTxTime(uint32_t index) const {
-            auto possibleFile = selectPossibleTxRecording(index);
-            if (possibleFile) {
-                return (*possibleFile).get().getTime(index);
+            auto timestamp = getTxTimestamp(index);
+            if (timestamp) {
+                return std::chrono::system_clock::from_time_t(timestamp.value());
             } else {
                 return ranges::nullopt;
             }
         }
 
         ranges::optional<time_t> getTxTimestamp(uint32_t index) const {
+            auto row = store.row(index);
+            if (row) {
+                auto time = store.firstSeen(*row);
+                if (time > 1) {
+                    return static_cast<time_t>(time);
+                }
+                return ranges::nullopt;
+            }
             auto possibleFile = selectPossibleTxRecording(index);
             if (possibleFile) {
                 return (*possibleFile).get().getTimestamp(index);
@@ -192,6 +339,9 @@ namespace blocksci {
         }
         
         bool observed(uint32_t index) const {
+            if (store.row(index)) {
+                return true;
+            }
             auto possibleFile = selectPossibleTxRecording(index);
             if (possibleFile) {
                 return (*possibleFile).get().observed(index);
@@ -200,6 +350,27 @@ namespace blocksci {
             }
         }
         
+        ranges::optional<uint64_t> getTxFeeRate(uint32_t index) const {
+            auto row = store.row(index);
+            return row ? store.feeRate(*row) : ranges::nullopt;
+        }
+        
+        ranges::optional<time_t> getTxRemovedTimestamp(uint32_t index) const {
+            auto row = store.row(index);
+            if (row) {
+                auto time = store.removed(*row);
+                if (time) {
+                    return static_cast<time_t>(*time);
+                }
+            }
+            return ranges::nullopt;
+        }
+        
+        uint32_t getTxReplacedCount(uint32_t index) const {
+            auto row = store.row(index);
+            return row ? store.replacedCount(*row) : 0;
+        }
+        
         ranges::optional<std::chrono::system_clock::time_point> getBlockTime(int height) const {
             auto possibleFile = selectPossibleBlockRecording(height);
             if (possibleFile) {
@@ -222,6 +393,7 @@ namespace blocksci {
             for (auto &file : timestampFiles) {
                 file.reload();
             }
+            store.reload();
             setup();
         }
     };
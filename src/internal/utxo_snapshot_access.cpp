@@ -0,0 +1,240 @@
+//
+//  utxo_snapshot_access.cpp
+//  blocksci
+//
+
+#include "utxo_snapshot_access.hpp"
+
+#include <blocksci/core/raw_block.hpp>
+#include <blocksci/core/raw_transaction.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace blocksci {
+    namespace {
+        void writeVarInt(std::string &out, uint64_t value) {
+            while (value >= 0x80) {
+                out += static_cast<char>((value & 0x7f) | 0x80);
+                value >>= 7;
+            }
+            out += static_cast<char>(value);
+        }
+        
+        uint64_t zigzag(int64_t value) {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+        
+        int64_t unzigzag(uint64_t value) {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+        
+        class SnapshotReader {
+            const unsigned char *pos;
+            const unsigned char *end;
+        
+        public:
+            SnapshotReader(const char *data, size_t size) : pos(reinterpret_cast<const unsigned char *>(data)), end(pos + size) {}
+            
+            uint64_t readVarInt() {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    if (pos == end) {
+                        throw std::runtime_error("UTXO snapshot is truncated");
+                    }
+                    auto byte = *pos++;
+                    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                throw std::runtime_error("UTXO snapshot contains an invalid varint");
+            }
+            
+            uint8_t readByte() {
+                if (pos == end) {
+                    throw std::runtime_error("UTXO snapshot is truncated");
+                }
+                return *pos++;
+            }
+        };
+        
+        /** Number of transactions in the blocks up to height, 0 for a height of -1 */
+        uint32_t endTxOfHeight(BlockHeight height, const ChainAccess &chain) {
+            if (height < 0) {
+                return 0;
+            }
+            auto block = chain.getBlock(height);
+            return block->firstTxIndex + block->txCount;
+        }
+        
+        /** Merges the first count outputs of a with all outputs of b, both sorted by (txNum, outputNum) */
+        UtxoSet mergeSets(const UtxoSet &a, size_t count, const UtxoSet &b, BlockHeight height) {
+            UtxoSet merged;
+            merged.height = height;
+            merged.reserve(count + b.size());
+            size_t i = 0;
+            size_t j = 0;
+            while (i < count || j < b.size()) {
+                if (j == b.size() || (i < count && std::make_pair(a.txNums[i], a.outputNums[i]) < std::make_pair(b.txNums[j], b.outputNums[j]))) {
+                    merged.add(a, i++);
+                } else {
+                    merged.add(b, j++);
+                }
+            }
+            return merged;
+        }
+        
+        /** UTXO set after the block at height, built by undoing the blocks after height up to base.height */
+        UtxoSet applyBlocksBackward(const UtxoSet &base, BlockHeight height, const ChainAccess &chain) {
+            auto cutTx = endTxOfHeight(height, chain);
+            auto endTx = endTxOfHeight(base.height, chain);
+            
+            // Outputs created after height are dropped, outputs created before and spent after height are restored
+            auto kept = static_cast<size_t>(std::lower_bound(base.txNums.begin(), base.txNums.end(), cutTx) - base.txNums.begin());
+            std::vector<std::pair<uint32_t, uint16_t>> restoredPointers;
+            for (uint32_t txNum = cutTx; txNum < endTx; txNum++) {
+                auto tx = chain.getTx(txNum);
+                if (tx->inputCount == 0) {
+                    continue;
+                }
+                auto spentOutputNums = chain.getSpentOutputNumbers(txNum);
+                uint16_t inputNum = 0;
+                for (auto input = tx->beginInputs(); input != tx->endInputs(); ++input, ++inputNum) {
+                    if (input->getLinkedTxNum() < cutTx) {
+                        restoredPointers.emplace_back(input->getLinkedTxNum(), spentOutputNums[inputNum]);
+                    }
+                }
+            }
+            std::sort(restoredPointers.begin(), restoredPointers.end());
+            
+            UtxoSet restored;
+            restored.reserve(restoredPointers.size());
+            for (auto &pointer : restoredPointers) {
+                auto &output = chain.getTx(pointer.first)->getOutput(pointer.second);
+                restored.add(pointer.first, pointer.second, output.getValue(), static_cast<uint8_t>(output.getType()), output.getAddressNum());
+            }
+            return mergeSets(base, kept, restored, height);
+        }
+    }
+    
+    void encodeUtxoSet(std::string &out, const UtxoSet &set) {
+        uint32_t lastTxNum = 0;
+        std::array<uint32_t, 256> lastAddressNums{};
+        for (size_t i = 0; i < set.size(); i++) {
+            writeVarInt(out, set.txNums[i] - lastTxNum);
+            lastTxNum = set.txNums[i];
+            writeVarInt(out, set.outputNums[i]);
+            writeVarInt(out, static_cast<uint64_t>(set.values[i]));
+            out += static_cast<char>(set.addressTypes[i]);
+            auto &last = lastAddressNums[set.addressTypes[i]];
+            writeVarInt(out, zigzag(static_cast<int64_t>(set.addressNums[i]) - static_cast<int64_t>(last)));
+            last = set.addressNums[i];
+        }
+    }
+    
+    UtxoSet decodeUtxoSet(const char *data, size_t size, uint64_t utxoCount, BlockHeight height) {
+        SnapshotReader reader(data, size);
+        UtxoSet set;
+        set.height = height;
+        set.reserve(utxoCount);
+        uint32_t txNum = 0;
+        std::array<uint32_t, 256> lastAddressNums{};
+        for (uint64_t i = 0; i < utxoCount; i++) {
+            txNum += static_cast<uint32_t>(reader.readVarInt());
+            auto outputNum = static_cast<uint16_t>(reader.readVarInt());
+            auto value = static_cast<int64_t>(reader.readVarInt());
+            auto type = reader.readByte();
+            auto &last = lastAddressNums[type];
+            last = static_cast<uint32_t>(static_cast<int64_t>(last) + unzigzag(reader.readVarInt()));
+            set.add(txNum, outputNum, value, type, last);
+        }
+        return set;
+    }
+    
+    UtxoSet applyBlocksForward(const UtxoSet &base, BlockHeight height, const ChainAccess &chain) {
+        auto firstTx = endTxOfHeight(base.height, chain);
+        auto endTx = endTxOfHeight(height, chain);
+        
+        // Outputs of the base set spent up to height are removed, new outputs are added unless spent up to height
+        std::vector<std::pair<uint32_t, uint16_t>> spentPointers;
+        UtxoSet added;
+        for (uint32_t txNum = firstTx; txNum < endTx; txNum++) {
+            auto tx = chain.getTx(txNum);
+            if (tx->inputCount > 0) {
+                auto spentOutputNums = chain.getSpentOutputNumbers(txNum);
+                uint16_t inputNum = 0;
+                for (auto input = tx->beginInputs(); input != tx->endInputs(); ++input, ++inputNum) {
+                    if (input->getLinkedTxNum() < firstTx) {
+                        spentPointers.emplace_back(input->getLinkedTxNum(), spentOutputNums[inputNum]);
+                    }
+                }
+            }
+            uint16_t outputNum = 0;
+            for (auto output = tx->beginOutputs(); output != tx->endOutputs(); ++output, ++outputNum) {
+                auto spendingTxNum = output->getLinkedTxNum();
+                if (spendingTxNum == 0 || spendingTxNum >= endTx) {
+                    added.add(txNum, outputNum, output->getValue(), static_cast<uint8_t>(output->getType()), output->getAddressNum());
+                }
+            }
+        }
+        std::sort(spentPointers.begin(), spentPointers.end());
+        
+        UtxoSet remaining;
+        remaining.reserve(base.size() - std::min(base.size(), spentPointers.size()));
+        auto spent = spentPointers.begin();
+        for (size_t i = 0; i < base.size(); i++) {
+            auto pointer = std::make_pair(base.txNums[i], base.outputNums[i]);
+            while (spent != spentPointers.end() && *spent < pointer) {
+                ++spent;
+            }
+            if (spent == spentPointers.end() || *spent != pointer) {
+                remaining.add(base, i);
+            }
+        }
+        // All added outputs belong to later transactions than the outputs of the base set
+        return mergeSets(remaining, remaining.size(), added, height);
+    }
+    
+    UtxoSet utxoSetAtHeight(BlockHeight height, const ChainAccess &chain, const UtxoSnapshotAccess &snapshots) {
+        if (height == -1) {
+            height = chain.blockCount() - 1;
+        }
+        if (height < 0 || height >= chain.blockCount()) {
+            throw std::out_of_range("Block height " + std::to_string(height) + " is out of range");
+        }
+        
+        // Pick the starting point that requires applying the fewest transactions
+        auto targetTx = endTxOfHeight(height, chain);
+        uint32_t bestCost = targetTx;
+        size_t bestSnapshot = snapshots.size();
+        for (size_t i = 0; i < snapshots.size(); i++) {
+            if (!snapshots.isValid(i, chain)) {
+                continue;
+            }
+            auto snapshotTx = endTxOfHeight(snapshots.getEntry(i).height, chain);
+            auto cost = snapshotTx > targetTx ? snapshotTx - targetTx : targetTx - snapshotTx;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestSnapshot = i;
+            }
+        }
+        
+        if (bestSnapshot == snapshots.size()) {
+            UtxoSet empty;
+            empty.height = -1;
+            return applyBlocksForward(empty, height, chain);
+        }
+        auto snapshot = snapshots.getSnapshot(bestSnapshot);
+        if (snapshot.height == height) {
+            return snapshot;
+        } else if (snapshot.height < height) {
+            return applyBlocksForward(snapshot, height, chain);
+        } else {
+            return applyBlocksBackward(snapshot, height, chain);
+        }
+    }
+} // namespace blocksci
@@ -0,0 +1,118 @@
+//
+//  utxo_snapshot_access.hpp
+//  blocksci
+//
+
+#ifndef utxo_snapshot_access_hpp
+#define utxo_snapshot_access_hpp
+
+#include "chain_access.hpp"
+#include "file_mapper.hpp"
+
+#include <blocksci/chain/utxo_set.hpp>
+#include <blocksci/core/bitcoin_uint256.hpp>
+
+#include <wjfilesystem/path.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace blocksci {
+
+    /** Default number of blocks between two UTXO snapshots */
+    constexpr BlockHeight defaultUtxoSnapshotInterval = 10000;
+    
+    /** Index entry of a UTXO snapshot */
+    struct UtxoSnapshotEntry {
+        BlockHeight height;
+        /** Number of blocks to the next snapshot, used when new snapshots are added */
+        uint32_t interval;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t utxoCount;
+        /** Hash of the block at height, used to detect reorgs */
+        uint256 blockHash;
+    };
+    
+    /** Appends the compressed encoding of the set to out
+     *
+     * Outputs are stored in order. The tx number is stored as the varint coded difference to the previous output,
+     * which is never negative. The address number is stored as the difference to the previous address of the same
+     * type, zigzag and varint coded.
+     */
+    void encodeUtxoSet(std::string &out, const UtxoSet &set);
+    
+    UtxoSet decodeUtxoSet(const char *data, size_t size, uint64_t utxoCount, BlockHeight height);
+    
+    /** Provides the UTXO sets that the parser materialized every few blocks
+     *
+     * Files are written by the utxo-snapshots-update command of the parser.
+     *
+     * Directory: chain/utxo_snapshots/
+     * Files: - index.dat: [<UtxoSnapshotEntry>, ...] in ascending order of the height
+     *        - data.dat: [<encoded set>, ...]
+     */
+    class UtxoSnapshotAccess {
+        FixedSizeFileMapper<UtxoSnapshotEntry> indexFile;
+        SimpleFileMapper<> dataFile;
+    
+    public:
+        explicit UtxoSnapshotAccess(const filesystem::path &baseDirectory) :
+        indexFile(indexFilePath(baseDirectory)),
+        dataFile(dataFilePath(baseDirectory)) {}
+        
+        static filesystem::path snapshotDirectory(const filesystem::path &baseDirectory) {
+            return baseDirectory/"utxo_snapshots";
+        }
+        
+        static filesystem::path indexFilePath(const filesystem::path &baseDirectory) {
+            return snapshotDirectory(baseDirectory)/"index";
+        }
+        
+        static filesystem::path dataFilePath(const filesystem::path &baseDirectory) {
+            return snapshotDirectory(baseDirectory)/"data";
+        }
+        
+        size_t size() const {
+            return static_cast<size_t>(indexFile.size());
+        }
+        
+        const UtxoSnapshotEntry &getEntry(size_t i) const {
+            return *indexFile[static_cast<OffsetType>(i)];
+        }
+        
+        /** Returns whether snapshot i describes a block that is still part of the chain */
+        bool isValid(size_t i, const ChainAccess &chain) const {
+            auto &entry = getEntry(i);
+            return entry.height < chain.blockCount() && chain.getBlock(entry.height)->hash == entry.blockHash;
+        }
+        
+        UtxoSet getSnapshot(size_t i) const {
+            auto &entry = getEntry(i);
+            auto data = entry.size > 0 ? dataFile.getDataAtOffset(static_cast<OffsetType>(entry.offset)) : nullptr;
+            return decodeUtxoSet(data, entry.size, entry.utxoCount, entry.height);
+        }
+        
+        void reload() {
+            indexFile.reload();
+            dataFile.reload();
+        }
+    };
+    
+    /** UTXO set after the block at the given height
+     *
+     * Starts from the closest valid snapshot and applies the transactions between the snapshot and the height, going
+     * forward from an earlier snapshot or backward from a later one. Without snapshots the set is built from the start
+     * of the chain.
+     */
+    UtxoSet utxoSetAtHeight(BlockHeight height, const ChainAccess &chain, const UtxoSnapshotAccess &snapshots);
+    
+    /** UTXO set after the block at height, built by applying the blocks after base.height to base
+     *
+     * A base height of -1 stands for the empty set before the first block.
+     */
+    UtxoSet applyBlocksForward(const UtxoSet &base, BlockHeight height, const ChainAccess &chain);
+} // namespace blocksci
+
+#endif /* utxo_snapshot_access_hpp */
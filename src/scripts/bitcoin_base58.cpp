@@ -9,7 +9,10 @@
 #include <internal/hash.hpp>
 #include <internal/data_configuration.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -115,6 +118,130 @@ namespace blocksci {
         return EncodeBase58(vch.data(), vch.data() + vch.size());
     }
 
+    namespace {
+        /** 58^5, the largest power of 58 that fits into a 32 bit limb */
+        constexpr uint32_t base58LimbBase = 656356768;
+        constexpr size_t maxBase58Limbs = 16;
+
+        struct Base58DigitTable {
+            std::array<int8_t, 256> values;
+
+            Base58DigitTable() {
+                values.fill(-1);
+                for (int8_t i = 0; i < 58; i++) {
+                    values[static_cast<unsigned char>(pszBase58[i])] = i;
+                }
+            }
+        };
+
+        const Base58DigitTable base58Digits;
+    }
+
+    std::string EncodeBase58Limbs(const unsigned char* pbegin, const unsigned char* pend)
+    {
+        size_t zeroes = 0;
+        while (pbegin != pend && *pbegin == 0) {
+            pbegin++;
+            zeroes++;
+        }
+        auto size = static_cast<size_t>(pend - pbegin);
+        auto limbCount = (size + 3) / 4;
+        if (limbCount > maxBase58Limbs) {
+            return EncodeBase58(pbegin - zeroes, pend);
+        }
+        // Load the bytes as big-endian 32 bit limbs
+        std::array<uint32_t, maxBase58Limbs> limbs{};
+        for (size_t i = 0; i < size; i++) {
+            limbs[limbCount - 1 - i / 4] |= static_cast<uint32_t>(pend[-1 - static_cast<std::ptrdiff_t>(i)]) << (8 * (i % 4));
+        }
+        // Every long division by 58^5 yields five digits, least significant first
+        std::array<char, maxBase58Limbs * 4 * 138 / 100 + 6> digits;
+        size_t digitCount = 0;
+        size_t firstLimb = 0;
+        while (firstLimb < limbCount) {
+            uint64_t remainder = 0;
+            for (size_t i = firstLimb; i < limbCount; i++) {
+                uint64_t current = (remainder << 32) | limbs[i];
+                limbs[i] = static_cast<uint32_t>(current / base58LimbBase);
+                remainder = current % base58LimbBase;
+            }
+            while (firstLimb < limbCount && limbs[firstLimb] == 0) {
+                firstLimb++;
+            }
+            for (int i = 0; i < 5; i++) {
+                digits[digitCount++] = static_cast<char>(remainder % 58);
+                remainder /= 58;
+            }
+        }
+        while (digitCount > 0 && digits[digitCount - 1] == 0) {
+            digitCount--;
+        }
+        std::string str(zeroes + digitCount, '1');
+        for (size_t i = 0; i < digitCount; i++) {
+            str[zeroes + i] = pszBase58[static_cast<size_t>(digits[digitCount - 1 - i])];
+        }
+        return str;
+    }
+
+    bool DecodeBase58Limbs(const std::string& str, unsigned char* out, size_t size)
+    {
+        size_t zeroes = 0;
+        while (zeroes < str.size() && str[zeroes] == '1') {
+            zeroes++;
+        }
+        if (zeroes > size) {
+            return false;
+        }
+        auto valueSize = size - zeroes;
+        // One limb more than needed, so that values which are too large are detected
+        auto limbCount = (valueSize + 3) / 4 + 1;
+        if (limbCount > maxBase58Limbs) {
+            std::vector<unsigned char> decoded;
+            if (!DecodeBase58(str, decoded) || decoded.size() != size) {
+                return false;
+            }
+            std::copy(decoded.begin(), decoded.end(), out);
+            return true;
+        }
+        std::array<uint32_t, maxBase58Limbs> limbs{};
+        // Apply "value = value * 58^n + digits" for groups of up to five digits
+        for (size_t pos = zeroes; pos < str.size();) {
+            uint32_t group = 0;
+            uint32_t multiplier = 1;
+            for (int i = 0; i < 5 && pos < str.size(); i++, pos++) {
+                auto digit = base58Digits.values[static_cast<unsigned char>(str[pos])];
+                if (digit < 0) {
+                    return false;
+                }
+                group = group * 58 + static_cast<uint32_t>(digit);
+                multiplier *= 58;
+            }
+            uint64_t carry = group;
+            for (size_t i = limbCount; i-- > 0;) {
+                carry += static_cast<uint64_t>(limbs[i]) * multiplier;
+                limbs[i] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+            if (carry != 0) {
+                return false;
+            }
+        }
+        // The value has to take up exactly valueSize bytes, leading zero bytes are encoded as '1'
+        for (size_t i = 0; i < limbCount * 4; i++) {
+            auto byte = static_cast<unsigned char>(limbs[limbCount - 1 - i / 4] >> (8 * (i % 4)));
+            if (i < valueSize) {
+                out[size - 1 - i] = byte;
+            } else if (byte != 0) {
+                return false;
+            }
+        }
+        if (valueSize > 0 && out[zeroes] == 0) {
+            return false;
+        }
+        std::fill(out, out + zeroes, 0);
+        return true;
+    }
+
     bool DecodeBase58(const std::string& str, std::vector<unsigned char>& vchRet)
     {
         return DecodeBase58(str.c_str(), vchRet);
@@ -126,7 +253,7 @@ namespace blocksci {
         std::vector<unsigned char> vch(vchIn);
         uint256 hash = doubleSha256(reinterpret_cast<const char*>(vch.data()), vch.size());
         vch.insert(vch.end(), reinterpret_cast<unsigned char*>(&hash), reinterpret_cast<unsigned char*>(&hash) + 4);
-        return EncodeBase58(vch);
+        return EncodeBase58Limbs(vch.data(), vch.data() + vch.size());
     }
 
     bool DecodeBase58Check(const char* psz, std::vector<unsigned char>& vchRet)
@@ -146,6 +273,63 @@ namespace blocksci {
         return DecodeBase58Check(str.c_str(), vchRet);
     }
 
+    namespace {
+        /** Big-endian number with one byte more than the numbers it is compared against, saturated on overflow */
+        using Base58Number = std::vector<unsigned char>;
+
+        Base58Number base58Value(const std::string &digits, size_t width) {
+            Base58Number value(width, 0);
+            for (auto c : digits) {
+                auto carry = static_cast<unsigned int>(strchr(pszBase58, c) - pszBase58);
+                for (auto it = value.rbegin(); it != value.rend(); ++it) {
+                    carry += 58u * *it;
+                    *it = static_cast<unsigned char>(carry % 256);
+                    carry /= 256;
+                }
+                if (carry != 0) {
+                    return Base58Number(width, 0xff);
+                }
+            }
+            return value;
+        }
+    }
+
+    std::vector<Base58PayloadRange> Base58CheckPrefixRanges(const std::string &prefix, size_t payloadSize) {
+        std::vector<Base58PayloadRange> ranges;
+        if (prefix.find_first_not_of(pszBase58) != std::string::npos) {
+            return ranges;
+        }
+        auto encodedSize = payloadSize + 4;
+        auto width = encodedSize + 1;
+        auto leadingOnes = std::min(prefix.find_first_not_of('1'), prefix.size());
+        auto rest = prefix.substr(leadingOnes);
+        // Every leading '1' encodes a zero byte, the remaining characters encode the value of the other bytes
+        auto maxZeroBytes = rest.empty() ? encodedSize - 1 : leadingOnes;
+        for (auto zeroBytes = leadingOnes; zeroBytes <= maxZeroBytes && zeroBytes < encodedSize; zeroBytes++) {
+            auto valueBytes = encodedSize - zeroBytes;
+            // The value has exactly valueBytes bytes
+            Base58Number minValue(width, 0);
+            minValue[width - valueBytes] = 1;
+            Base58Number maxValue(width, 0);
+            std::fill(maxValue.end() - static_cast<std::ptrdiff_t>(valueBytes), maxValue.end(), 0xff);
+            auto maxDigits = valueBytes * 1366 / 1000 + 1; // log(256) / log(58), rounded up
+            for (auto digits = std::max(rest.size(), size_t{1}); digits <= maxDigits; digits++) {
+                std::string lowDigits = rest.empty() ? "2" : rest;
+                std::string highDigits = rest;
+                lowDigits.resize(digits, '1');
+                highDigits.resize(digits, 'z');
+                auto low = std::max(base58Value(lowDigits, width), minValue);
+                auto high = std::min(base58Value(highDigits, width), maxValue);
+                if (low > high) {
+                    continue;
+                }
+                // Dropping the checksum maps the range of encoded values to a range of payloads
+                ranges.emplace_back(std::vector<unsigned char>(low.begin() + 1, low.end() - 4), std::vector<unsigned char>(high.begin() + 1, high.end() - 4));
+            }
+        }
+        return ranges;
+    }
+
     CBase58Data::CBase58Data()
     {
         vchVersion.clear();
@@ -18,6 +18,7 @@
 #include <blocksci/core/address_types.hpp>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace blocksci {
@@ -36,6 +37,18 @@ namespace blocksci {
      */
     std::string EncodeBase58(const std::vector<unsigned char>& vch);
     
+    /**
+     * Encode a byte sequence as a base58-encoded string like EncodeBase58, but convert five digits per long
+     * division of 32 bit limbs instead of one digit per pass over the bytes.
+     */
+    std::string EncodeBase58Limbs(const unsigned char* pbegin, const unsigned char* pend);
+    
+    /**
+     * Decode a base58-encoded string (str) into exactly size bytes (out) using 32 bit limbs.
+     * return false if str is not valid base58 or does not decode to size bytes.
+     */
+    bool DecodeBase58Limbs(const std::string& str, unsigned char* out, size_t size);
+    
     /**
      * Decode a base58-encoded string (psz) into a byte vector (vchRet).
      * return true if decoding is successful.
@@ -66,6 +79,16 @@ namespace blocksci {
      */
     inline bool DecodeBase58Check(const std::string& str, std::vector<unsigned char>& vchRet);
     
+    /** Inclusive range of byte strings of equal length in big-endian (memcmp) order */
+    using Base58PayloadRange = std::pair<std::vector<unsigned char>, std::vector<unsigned char>>;
+    
+    /**
+     * Return the ranges of payloads of payloadSize bytes whose base58check encoding (payload followed by a
+     * 4 byte checksum) can start with prefix. Since the checksum is ignored, the ranges may also contain payloads
+     * whose encoding does not start with prefix. They may overlap and are empty if prefix is not valid base58.
+     */
+    std::vector<Base58PayloadRange> Base58CheckPrefixRanges(const std::string &prefix, size_t payloadSize);
+    
     /**
      * Base class for all base58-encoded data
      */
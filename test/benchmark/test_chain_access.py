@@ -83,3 +83,32 @@ def size_txes_outputs(chain):
 
 def test_chain_size_blocks_outputs(chain, benchmark):
     benchmark(size_txes_outputs, chain)
+
+
+def recent_tx_hashes(chain):
+    offset = min(len(chain), 100)
+    return chain.tx_columns(len(chain) - offset, len(chain))["hash"]
+
+
+def txes_with_hashes_fee(chain, hashes):
+    assert chain.txes_with_hashes(hashes).apply(lambda tx: tx.fee).sum() >= 0
+
+
+def test_chain_txes_with_hashes_fee(chain, benchmark):
+    benchmark(txes_with_hashes_fee, chain, recent_tx_hashes(chain))
+
+
+def tx_with_hash_fee(chain, hashes):
+    assert sum(chain.tx_with_hash(h[::-1].hex()).fee for h in hashes) >= 0
+
+
+def test_chain_tx_with_hash_fee(chain, benchmark):
+    benchmark(tx_with_hash_fee, chain, recent_tx_hashes(chain))
+
+
+def export_tx_columns(chain):
+    assert len(chain.export_columns("txes", ["hash", "fee", "size", "is_coinjoin"])["fee"]) > 0
+
+
+def test_chain_export_tx_columns(chain, benchmark):
+    benchmark(export_tx_columns, chain)
@@ -1,3 +1,6 @@
+import blocksci
+
+
 def map_block_tx_count(chain):
     offset = min(len(chain), 10000)
     assert chain[-offset:].map(lambda b: b.tx_count).size
@@ -102,3 +105,53 @@ def group_by_utxo_type_value(chain):
 
 def test_proxy_group_by_utxo_type_value(chain, benchmark):
     benchmark(group_by_utxo_type_value, chain)
+
+
+def map_block_output_value(chain, vectorized):
+    offset = min(len(chain), 1000)
+    blocksci.proxy.set_vectorized_execution(vectorized)
+    try:
+        assert len(chain[-offset:].map(lambda b: b.txes.outputs.value.sum)) == offset
+    finally:
+        blocksci.proxy.set_vectorized_execution(True)
+
+
+def test_proxy_map_block_output_value(chain, benchmark):
+    benchmark(map_block_output_value, chain, True)
+
+
+def test_proxy_map_block_output_value_unvectorized(chain, benchmark):
+    benchmark(map_block_output_value, chain, False)
+
+
+def where_block_fee(chain, vectorized):
+    offset = min(len(chain), 1000)
+    blocksci.proxy.set_vectorized_execution(vectorized)
+    try:
+        chain[-offset:].where(lambda b: b.txes.where(lambda tx: tx.fee > 10000).size > 1).to_list()
+    finally:
+        blocksci.proxy.set_vectorized_execution(True)
+
+
+def test_proxy_where_block_fee(chain, benchmark):
+    benchmark(where_block_fee, chain, True)
+
+
+def test_proxy_where_block_fee_unvectorized(chain, benchmark):
+    benchmark(where_block_fee, chain, False)
+
+
+def most_valuable_addresses(chain, parallel):
+    blocksci.proxy.set_parallel_execution(parallel)
+    try:
+        chain.most_valuable_addresses(100)
+    finally:
+        blocksci.proxy.set_parallel_execution(True)
+
+
+def test_proxy_most_valuable_addresses(chain, benchmark):
+    benchmark(most_valuable_addresses, chain, True)
+
+
+def test_proxy_most_valuable_addresses_serial(chain, benchmark):
+    benchmark(most_valuable_addresses, chain, False)
@@ -32,10 +32,8 @@ def pytest_runtest_call(item):
             )
 
 
-@pytest.fixture(scope="session")
-def chain(tmpdir_factory, chain_name):
-    temp_dir = tmpdir_factory.mktemp(chain_name)
-    chain_dir = str(temp_dir)
+def parse_regtest_chain(chain_dir, chain_name, max_block=None):
+    """Parses the regtest chain into chain_dir, or updates the chain that was parsed there before"""
     self_dir = os.path.dirname(os.path.realpath(__file__))
 
     if chain_name == "btc":
@@ -55,24 +53,45 @@ def chain(tmpdir_factory, chain_name):
         chain_dir,
         "--disk",
         "{}/../files/{}/regtest/".format(self_dir, chain_name),
-        "--max-block",
-        "100",
     ]
-    parse_cmd = ["blocksci_parser", chain_dir + "/config.json", "update"]
+    if max_block is not None:
+        create_config_cmd += ["--max-block", str(max_block)]
+    subprocess.run(create_config_cmd, check=True)
+    subprocess.run(["blocksci_parser", chain_dir + "/config.json", "update"], check=True)
+    return chain_dir + "/config.json"
+
+
+@pytest.fixture(scope="session")
+def chain(tmpdir_factory, chain_name):
+    temp_dir = tmpdir_factory.mktemp(chain_name)
+    chain_dir = str(temp_dir)
 
     # Parse the chain up to block 100 only
-    subprocess.run(create_config_cmd, check=True)
-    subprocess.run(parse_cmd, check=True)
+    parse_regtest_chain(chain_dir, chain_name, 100)
 
     # Now parse the remainder of the chain
-    subprocess.run(create_config_cmd[:-2], check=True)
-    subprocess.run(parse_cmd, check=True)
+    parse_regtest_chain(chain_dir, chain_name)
 
     import blocksci
     chain = blocksci.Blockchain(chain_dir + "/config.json")
     return chain
 
 
+@pytest.fixture
+def parse_chain(tmpdir_factory, chain_name):
+    """Parses a private copy of the chain for tests that write into the data directory
+
+    Returns a function that parses the copy up to max_block (the whole chain by default) and returns the path of its
+    config. Calling it again updates the same copy.
+    """
+    chain_dir = str(tmpdir_factory.mktemp(chain_name + "_copy"))
+
+    def parse(max_block=None):
+        return parse_regtest_chain(chain_dir, chain_name, max_block)
+
+    return parse
+
+
 @pytest.fixture
 def json_data(chain_name):
     import json
@@ -79,6 +79,54 @@ def test_p2wsh_address(chain, json_data):
     address_received_test(addr, blocksci.address_type.witness_scripthash, 0, 4)
 
 
+def test_addresses_with_prefix(chain, json_data, chain_name):
+    for addr_type in address_types(chain_name):
+        address_string = json_data["address-{}-spend-0".format(addr_type)]
+        for length in [2, 6, len(address_string)]:
+            prefix = address_string[:length]
+            matches = [match.address_string for match in chain.addresses_with_prefix(prefix)]
+            assert all(match.startswith(prefix) for match in matches)
+            assert address_string in matches
+            assert len(set(matches)) == len(matches)
+            if addr_type.startswith("p2w"):
+                # Bech32 addresses are case insensitive
+                assert [match.address_string for match in chain.addresses_with_prefix(prefix.upper())] == matches
+
+
+def test_address_strings_round_trip(chain, json_data, chain_name):
+    address_strings = [
+        json_data["address-{}-spend-{}".format(addr_type, i)]
+        for addr_type in address_types(chain_name)
+        for i in range(3)
+    ]
+    nums, types = chain.addresses_from_strings(address_strings + ["invalid"])
+    assert nums[-1] == 0
+    for address_string, num, raw_type in zip(address_strings, nums, types):
+        addr = chain.address_from_string(address_string)
+        assert num == addr.address_num
+        assert raw_type == int(addr.raw_type)
+    assert list(chain.address_strings(nums[:-1], types[:-1])) == address_strings
+
+
+def test_address_balances(chain, json_data, chain_name):
+    addrs = [
+        chain.address_from_string(json_data["address-{}-spend-{}".format(addr_type, i)])
+        for addr_type in address_types(chain_name)
+        for i in range(3)
+    ]
+    nums = [addr.address_num for addr in addrs]
+    types = [int(addr.raw_type) for addr in addrs]
+    heights = [-1, 0, len(chain) // 2, len(chain) - 1]
+    balances = chain.address_balances(nums, types, heights)
+    assert balances.shape == (len(addrs), len(heights))
+    for row, addr in zip(balances, addrs):
+        assert list(row) == [addr.balance(height) for height in heights]
+
+    chunks = list(chain.address_balances_chunked(nums, types, heights, chunk_size=4))
+    assert [start for start, _ in chunks] == list(range(0, len(addrs), 4))
+    assert [list(row) for _, chunk in chunks for row in chunk] == [list(row) for row in balances]
+
+
 def test_address_regression(chain, json_data, regtest, chain_name):
     for addr, addr_type in addresses(chain, json_data, chain_name):
         if "multisig" not in addr_type:
@@ -1,4 +1,7 @@
 import os
+import subprocess
+import numpy as np
+import pandas as pd
 import pytest
 import blocksci
 from util import correct_timestamp
@@ -104,3 +107,228 @@ def test_filter_txes_legacy(chain):
     txs1 = [tx for block in chain for tx in block if tx.block.height % 3 == 0]
     txs2 = chain.filter_txes_legacy(lambda tx: tx.block.height % 3 == 0)
     assert txs1 == txs2
+
+
+def compressed_tx_count(chain_dir):
+    with open(os.path.join(chain_dir, "tx_compressed_index.dat"), "rb") as f:
+        return int.from_bytes(f.read(8), "little")
+
+
+def test_compressed_tx_data(parse_chain):
+    """Tests that the compressed copy of the transaction data decodes to the original, is smaller and is rebuilt by
+    update"""
+    config = parse_chain(100)
+    subprocess.run(["blocksci_parser", config, "compress-tx-data", "--verify"], check=True)
+    partial_chain = blocksci.Blockchain(config)
+    chain_dir = os.path.join(partial_chain.data_location, "chain")
+    compressed_size = os.path.getsize(os.path.join(chain_dir, "tx_compressed_data.dat"))
+    assert 0 < compressed_size < os.path.getsize(os.path.join(chain_dir, "tx_data.dat"))
+    assert compressed_tx_count(chain_dir) == sum(block.tx_count for block in partial_chain)
+
+    # The copy built at block 100 is outdated after the update and has to be rebuilt for the new transactions
+    parse_chain()
+    full_chain = blocksci.Blockchain(config)
+    assert compressed_tx_count(chain_dir) == sum(block.tx_count for block in full_chain)
+    subprocess.run(["blocksci_parser", config, "compress-tx-data", "--verify"], check=True)
+
+
+def test_inout_columns(parse_chain, json_data):
+    """Tests that the dense input and output columns match the values of the individual inputs and outputs"""
+    config = parse_chain()
+    subprocess.run(["blocksci_parser", config, "inout-columns-update"], check=True)
+    columns_chain = blocksci.Blockchain(config)
+    columns = columns_chain.inout_columns()
+    assert len(columns["output_value"]) == sum(block.output_count for block in columns_chain)
+    assert len(columns["input_value"]) == sum(block.input_count for block in columns_chain)
+    assert columns["output_value"].sum() == sum(block.output_value for block in columns_chain)
+    assert columns["input_value"].sum() == sum(block.input_value for block in columns_chain)
+
+    height = json_data["address-p2pkh-spend-1-height"]
+    columns = columns_chain.inout_columns(height, height + 1)
+    outputs = [out for tx in columns_chain[height].txes for out in tx.outputs]
+    inputs = [inpt for tx in columns_chain[height].txes for inpt in tx.inputs]
+    assert list(columns["output_value"]) == [out.value for out in outputs]
+    assert list(columns["output_spent_tx"]) == [out.spending_tx_index or 0 for out in outputs]
+    assert list(columns["input_value"]) == [inpt.value for inpt in inputs]
+    assert list(columns["input_spent_tx"]) == [inpt.spent_tx_index for inpt in inputs]
+
+
+def assert_inout_columns_match(columns_chain):
+    columns = columns_chain.inout_columns()
+    outputs = [out for block in columns_chain for tx in block.txes for out in tx.outputs]
+    inputs = [inpt for block in columns_chain for tx in block.txes for inpt in tx.inputs]
+    assert list(columns["output_value"]) == [out.value for out in outputs]
+    assert list(columns["output_spent_tx"]) == [out.spending_tx_index or 0 for out in outputs]
+    assert list(columns["input_value"]) == [inpt.value for inpt in inputs]
+    assert list(columns["input_spent_tx"]) == [inpt.spent_tx_index for inpt in inputs]
+
+
+def test_inout_columns_incremental(parse_chain):
+    """Tests that update extends the input and output columns and that incomplete columns are rebuilt"""
+    config = parse_chain(100)
+    subprocess.run(["blocksci_parser", config, "inout-columns-update"], check=True)
+
+    # The update appends the new transactions and patches the earlier outputs they spend
+    parse_chain()
+    columns_chain = blocksci.Blockchain(config)
+    assert_inout_columns_match(columns_chain)
+
+    # An interrupted update leaves columns that are longer than recorded in the state file
+    columns_dir = os.path.join(columns_chain.data_location, "chain", "columns")
+    output_value_path = os.path.join(columns_dir, "output_value.dat")
+    with open(output_value_path, "ab") as f:
+        f.write(bytes(8))
+    subprocess.run(["blocksci_parser", config, "inout-columns-update"], check=True)
+    columns_chain = blocksci.Blockchain(config)
+    assert os.path.getsize(output_value_path) == 8 * sum(block.output_count for block in columns_chain)
+    assert_inout_columns_match(columns_chain)
+
+
+def test_chain_columns(chain, json_data):
+    """Tests that the block and transaction columns match the values of the individual blocks, transactions and inputs"""
+    blocks = chain.block_columns()
+    assert list(blocks["height"]) == [block.height for block in chain]
+    assert list(blocks["timestamp"]) == [block.timestamp for block in chain]
+    assert list(blocks["tx_count"]) == [block.tx_count for block in chain]
+    assert [bytes(h[::-1]).hex() for h in blocks["hash"]] == [str(block.hash) for block in chain]
+
+    height = json_data["address-p2pkh-spend-1-height"]
+    columns = chain.tx_columns(height, height + 1)
+    txes = list(chain[height].txes)
+    inputs = [inpt for tx in txes for inpt in tx.inputs]
+    assert [bytes(h[::-1]).hex() for h in columns["hash"]] == [str(tx.hash) for tx in txes]
+    assert list(columns["version"]) == [tx.version for tx in txes]
+    assert list(columns["input_sequence"]) == [inpt.sequence_num for inpt in inputs]
+    assert list(columns["input_spent_output"]) == [inpt.spent_output.index for inpt in inputs]
+    assert len(columns["first_output"]) == len(txes)
+
+
+def test_hash_columns_keep_zero_bytes(chain):
+    """Tests that hashes ending in zero bytes, which have leading zeros in hex, keep all 32 bytes in the hash columns"""
+    txes = [tx for block in chain for tx in block.txes]
+    hashes = chain.tx_columns()["hash"]
+    assert hashes.shape == (len(txes), 32)
+    assert [bytes(h[::-1]).hex() for h in hashes] == [str(tx.hash) for tx in txes]
+    block_hashes = chain.block_columns()["hash"]
+    assert [bytes(h[::-1]).hex() for h in block_hashes] == [str(block.hash) for block in chain]
+
+    # Hash rows ending in zero bytes are looked up with all 32 bytes, also when passed as void elements
+    zero_ending = [i for i, tx in enumerate(txes) if str(tx.hash).startswith("00")]
+    missing = np.zeros((1, 32), dtype=np.uint8)
+    missing[0, 0] = 1
+    rows = np.concatenate([hashes[zero_ending], missing])
+    expected = [txes[i].index for i in zero_ending] + [-1]
+    assert list(chain.tx_indexes_from_hashes(rows)) == expected
+    assert list(chain.tx_indexes_from_hashes(rows.view("V32").ravel())) == expected
+
+
+def utxo_pointers(chain, height):
+    return sorted(
+        (out.tx_index, out.index)
+        for block in chain[: height + 1]
+        for tx in block.txes
+        for out in tx.outputs
+        if not out.is_spent or out.spending_tx.block_height > height
+    )
+
+
+def test_utxo_snapshots(chain, parse_chain):
+    """Tests that UTXO sets derived from snapshots match the outputs unspent at the height"""
+    config = parse_chain()
+    interval = max(len(chain) // 4, 1)
+    subprocess.run(["blocksci_parser", config, "utxo-snapshots-update", "--interval", str(interval)], check=True)
+    snapshot_chain = blocksci.Blockchain(config)
+    assert snapshot_chain.utxo_snapshot_heights == list(range(interval, len(chain), interval))
+
+    for height in [0, interval, interval + 1, 2 * interval - 1, len(chain) - 1]:
+        utxos = snapshot_chain.utxo_set(height)
+        assert list(zip(utxos["tx_index"], utxos["output_index"])) == utxo_pointers(chain, height)
+        outputs = [
+            snapshot_chain.tx_with_index(int(tx)).outputs[int(out)]
+            for tx, out in zip(utxos["tx_index"], utxos["output_index"])
+        ]
+        assert list(utxos["value"]) == [out.value for out in outputs]
+        assert list(utxos["address_type"]) == [int(out.address_type) for out in outputs]
+        assert list(utxos["address_num"]) == [out.address.address_num for out in outputs]
+    assert list(snapshot_chain.utxo_set()["value"]) == list(snapshot_chain.utxo_set(len(chain) - 1)["value"])
+
+
+
+def test_txes_with_hashes(chain):
+    """Tests that batched hash lookups resolve the same transactions as tx_with_hash"""
+    txes = [tx for block in chain[100:110] for tx in block.txes]
+    hashes = [str(tx.hash) for tx in txes]
+    missing = "00" * 32
+    indexes = chain.tx_indexes_from_hashes(hashes + [missing])
+    assert list(indexes) == [tx.index for tx in txes] + [-1]
+
+    raw_hashes = chain.tx_columns(100, 110)["hash"]
+    assert list(chain.tx_indexes_from_hashes(raw_hashes)) == [tx.index for tx in txes]
+
+    resolved = chain.txes_with_hashes([missing] + hashes)
+    assert [tx.index for tx in resolved] == [tx.index for tx in txes]
+    assert list(resolved.apply(lambda tx: tx.fee)) == [tx.fee for tx in txes]
+    assert list(resolved.apply(blocksci.Tx._self_proxy.output_count)) == [tx.output_count for tx in txes]
+
+    # Enough hashes to split the range of transactions over several threads
+    repeats = 4096 // len(txes) + 1
+    resolved = chain.txes_with_hashes(hashes * repeats)
+    count = blocksci.proxy.parallel_execution_count()
+    assert list(resolved.apply(lambda tx: tx.fee)) == [tx.fee for tx in txes] * repeats
+    assert blocksci.proxy.parallel_execution_count() > count
+
+    # Transactions after the last block of a truncated chain are not part of it
+    truncated = blocksci.Blockchain(chain.config_location, 105)
+    in_chain = [tx.index if tx.block_height < len(truncated) else -1 for tx in txes]
+    assert list(truncated.tx_indexes_from_hashes(hashes)) == in_chain
+    assert [tx.index for tx in truncated.txes_with_hashes(hashes)] == [index for index in in_chain if index != -1]
+
+
+def test_export_columns(chain):
+    """Tests that exported columns match the values of the individual transactions and outputs"""
+    txes = [tx for block in chain[100:110] for tx in block.txes]
+    columns = chain.export_columns("txes", ["tx_index", "hash", "fee", "size", "input_value"], 100, 110)
+    assert list(columns["tx_index"]) == [tx.index for tx in txes]
+    assert [h.decode() for h in columns["hash"]] == [str(tx.hash) for tx in txes]
+    assert list(columns["fee"]) == [tx.fee for tx in txes]
+    assert list(columns["size"]) == [tx.total_size for tx in txes]
+    assert list(columns["input_value"]) == [tx.input_value for tx in txes]
+
+    outputs = [out for tx in txes for out in tx.outputs]
+    columns = chain.export_columns("outputs", ["tx_index", "value", "address_type", "spending_tx_index"], 100, 110)
+    assert list(columns["tx_index"]) == [out.tx_index for out in outputs]
+    assert list(columns["value"]) == [out.value for out in outputs]
+    assert list(columns["spending_tx_index"]) == [out.spending_tx.index if out.is_spent else -1 for out in outputs]
+
+    with pytest.raises(ValueError):
+        chain.export_columns("outputs", ["cluster"], 100, 110)
+
+
+def test_export_table(chain, tmpdir):
+    """Tests that exported tables hold all rows of the selected blocks across batches"""
+    pq = pytest.importorskip("pyarrow.parquet")
+    path = str(tmpdir / "inputs.parquet")
+    chain.export_table("inputs", path, columns=["tx_index", "value"], start=50, end=120, batch_rows=10)
+    table = pq.read_table(path).to_pydict()
+    inputs = [inpt for block in chain[50:120] for tx in block.txes for inpt in tx.inputs]
+    assert table["tx_index"] == [inpt.tx_index for inpt in inputs]
+    assert table["value"] == [inpt.value for inpt in inputs]
+
+
+def test_export_table_dates(chain, tmpdir):
+    """Tests that an end date includes the blocks of the whole day while an end time is exact"""
+    pq = pytest.importorskip("pyarrow.parquet")
+    timestamps = [block.timestamp for block in chain]
+    day = pd.Timestamp(timestamps[60], unit="s").strftime("%Y-%m-%d")
+    day_start = pd.Timestamp(day).timestamp()
+    first = next(i for i, ts in enumerate(timestamps) if ts >= day_start)
+    stop = max(i for i, ts in enumerate(timestamps) if ts < day_start + 86400) + 1
+    path = str(tmpdir / "txes_day.parquet")
+    chain.export_table("txes", path, columns=["tx_index"], start=day, end=day)
+    assert pq.read_table(path).to_pydict()["tx_index"] == [tx.index for block in chain[first:stop] for tx in block.txes]
+
+    end_time = pd.Timestamp(timestamps[60], unit="s")
+    stop = max(i for i, ts in enumerate(timestamps) if ts <= timestamps[60]) + 1
+    path = str(tmpdir / "txes_time.parquet")
+    chain.export_table("txes", path, columns=["tx_index"], start=day, end=end_time.strftime("%Y-%m-%d %H:%M:%S"))
+    assert pq.read_table(path).to_pydict()["tx_index"] == [tx.index for block in chain[first:stop] for tx in block.txes]
@@ -280,3 +280,277 @@ def test_tagged_address(chain, tmpdir_factory):
     assert cluster.tagged_addresses(tags).size == 1
     assert cluster.tagged_addresses(tags).to_list()[0].address == address
     assert cluster.tagged_addresses(tags).to_list()[0].tag == "test-tag"
+
+
+def test_tagged_clusters(chain, tmpdir_factory):
+    cm = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("tagged-clusters-test")),
+        chain,
+        heuristic=blocksci.heuristics.change.none
+    )
+    address = chain[-1].txes[0].outputs[0].address
+    cluster = cm.cluster_with_address(address)
+    tags = {address: "test-tag"}
+
+    tagged = cm.tagged_clusters(tags).to_list()
+    assert len(tagged) == 1
+    assert tagged[0].cluster.index == cluster.index
+    assert tagged[0].tagged_addresses.to_list()[0].tag == "test-tag"
+
+    cm.save_tags(tags, "test-tags")
+    stored = cm.tagged_clusters("test-tags").to_list()
+    assert len(stored) == 1
+    assert stored[0].cluster.index == cluster.index
+    assert stored[0].tagged_addresses.to_list()[0].address == address
+    assert stored[0].tagged_addresses.to_list()[0].tag == "test-tag"
+
+
+def test_cluster_activity(chain, json_data, tmpdir_factory):
+    cm = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("cluster-activity-test")),
+        chain,
+        heuristic=blocksci.heuristics.change.none
+    )
+    cluster = cm.cluster_with_address(
+        chain.address_from_string(json_data["merge-addr-1"])
+    )
+    addresses = cluster.addresses.to_list()
+
+    for height in [-1, 100, len(chain) // 2]:
+        assert cluster.balance(height) == sum(a.balance(height) for a in addresses)
+    assert cluster.balance() == cluster.received_value() - cluster.spent_value()
+
+    first = cluster.first_activity_height
+    last = cluster.last_activity_height
+    assert first <= last
+    assert cluster.received_value(0, first) == 0
+    assert cluster.active_tx_count() == len(cluster.txes())
+    assert cluster.active_tx_count(first, last + 1) == cluster.active_tx_count()
+
+
+def test_cluster_activity_checkpoints(chain, tmpdir_factory):
+    """Tests the activity queries of a cluster that was active in more blocks than fit between two checkpoints"""
+    cm = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("cluster-activity-checkpoints-test")),
+        chain,
+        heuristic=blocksci.heuristics.change.none
+    )
+    tx_counts = cm.cluster_stats()["tx_count"]
+    cluster = cm.clusters()[int(tx_counts.argmax())]
+    outputs = cluster.outputs().to_list()
+    inputs = cluster.inputs().to_list()
+    assert len({out.tx.block_height for out in outputs} | {inp.tx.block_height for inp in inputs}) > 64
+
+    for height in range(len(chain)):
+        received = sum(out.value for out in outputs if out.tx.block_height <= height)
+        spent = sum(inp.value for inp in inputs if inp.tx.block_height <= height)
+        assert cluster.received_value(0, height + 1) == received
+        assert cluster.spent_value(0, height + 1) == spent
+        assert cluster.balance(height) == received - spent
+    assert cluster.first_activity_height == min(out.tx.block_height for out in outputs)
+    assert cluster.last_activity_height == max(tx.block_height for tx in cluster.txes())
+
+
+def test_cluster_stats(chain, json_data, tmpdir_factory):
+    cm = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("cluster-stats-test")),
+        chain,
+        heuristic=blocksci.heuristics.change.none
+    )
+    stats = cm.cluster_stats()
+    cluster_count = len(cm.clusters())
+    for column in stats.values():
+        assert len(column) == cluster_count
+        assert not column.flags.writeable
+
+    # Type equivalent addresses share their address number within these groups of types
+    equiv_groups = {
+        blocksci.address_type.pubkey: "pubkey",
+        blocksci.address_type.pubkeyhash: "pubkey",
+        blocksci.address_type.multisig_pubkey: "pubkey",
+        blocksci.address_type.witness_pubkeyhash: "pubkey",
+        blocksci.address_type.scripthash: "scripthash",
+        blocksci.address_type.witness_scripthash: "scripthash",
+    }
+    for cluster in cm.clusters():
+        addresses = cluster.addresses.to_list()
+        index = cluster.index
+        assert stats["address_count"][index] == len(addresses)
+        # Scripts that were never seen at the top level are singleton clusters without addresses
+        assert stats["type_equiv_count"][index] == max(
+            len({(equiv_groups.get(a.type, a.type), a.address_num) for a in addresses}), 1
+        )
+        assert stats["pubkeyhash_count"][index] == sum(
+            1 for a in addresses if a.type == blocksci.address_type.pubkeyhash
+        )
+
+    cluster = cm.cluster_with_address(
+        chain.address_from_string(json_data["merge-addr-1"])
+    )
+    index = cluster.index
+    addresses = cluster.addresses.to_list()
+    outputs = [o for a in addresses for o in a.outputs.to_list()]
+    inputs = [i for a in addresses for i in a.inputs.to_list()]
+    heights = [o.tx.block_height for o in outputs] + [i.tx.block_height for i in inputs]
+    assert stats["total_received"][index] == sum(o.value for o in outputs)
+    assert stats["total_received"][index] - sum(i.value for i in inputs) == sum(
+        a.balance() for a in addresses
+    )
+    assert stats["first_height"][index] == min(heights)
+    assert stats["last_height"][index] == max(heights)
+    assert stats["tx_count"][index] == len(
+        {o.tx_index for o in outputs} | {i.tx_index for i in inputs}
+    )
+
+
+def _link_inputs(chain, base, excluded_types=(), exclude_coinjoin=False):
+    """Applies the multi-input rule to the clusters of base in Python
+
+    Returns the expected (excluded, transactions, unions, redundant) counts and the sorted type equivalent sizes of
+    the resulting clusters.
+    """
+    clusters = base.clusters().to_list()
+    parent = list(range(len(clusters)))
+
+    def find(index):
+        while parent[index] != index:
+            parent[index] = parent[parent[index]]
+            index = parent[index]
+        return index
+
+    excluded = transactions = unions = redundant = 0
+    for block in chain:
+        for tx in block:
+            if tx.is_coinbase:
+                continue
+            if exclude_coinjoin and blocksci.heuristics.is_coinjoin(tx):
+                excluded += 1
+                continue
+            linked = [
+                base.cluster_with_address(inp.address).index
+                for inp in tx.inputs
+                if inp.address.type not in excluded_types
+            ]
+            if len(linked) < 2:
+                continue
+            transactions += 1
+            for index in linked[1:]:
+                first, second = find(linked[0]), find(index)
+                if first == second:
+                    redundant += 1
+                else:
+                    parent[first] = second
+                    unions += 1
+
+    sizes = {}
+    for cluster in clusters:
+        root = find(cluster.index)
+        sizes[root] = sizes.get(root, 0) + cluster.type_equiv_size
+    return (excluded, transactions, unions, redundant), sorted(sizes.values())
+
+
+def _cluster_sizes(cm):
+    return sorted(cluster.type_equiv_size for cluster in cm.clusters())
+
+
+def test_clustering_pipeline(chain, json_data, tmpdir_factory):
+    default = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("pipeline-default-test")),
+        chain,
+        heuristic=blocksci.heuristics.change.none
+    )
+    stats = default.rule_stats()
+    assert [s.name for s in stats] == ["coinjoin", "multi_input", "change"]
+    assert stats[2].unions == 0
+
+    pipeline = blocksci.cluster.ClusteringPipeline.standard(
+        blocksci.heuristics.change.none, True
+    )
+    cm = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("pipeline-standard-test")),
+        chain,
+        pipeline=pipeline
+    )
+    assert len(cm.clusters()) == len(default.clusters())
+    assert [s.unions + s.redundant for s in cm.rule_stats()] == [
+        s.unions + s.redundant for s in stats
+    ]
+
+    # Without any rule only nested scripthash addresses are linked
+    empty = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("pipeline-empty-test")),
+        chain,
+        pipeline=blocksci.cluster.ClusteringPipeline()
+    )
+    assert empty.rule_stats() == []
+    # Nested scripthash addresses are linked before any rule runs, so every union of a rule removes one cluster
+    merged = sum(s.unions for s in stats)
+    assert merged > 0
+    assert len(empty.clusters()) == len(default.clusters()) + merged
+
+    address = chain.address_from_string(json_data["merge-addr-1"])
+    pipeline = blocksci.cluster.ClusteringPipeline()
+    pipeline.add_multi_input().exclude_address_type(address.type)
+    filtered = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("pipeline-filtered-test")),
+        chain,
+        pipeline=pipeline
+    )
+    assert filtered.cluster_with_address(address).address_count() < 3
+
+    # The clusters and link counts match the rules applied to the clusters of nested scripthash addresses
+    (excluded, transactions, unions, redundant), sizes = _link_inputs(chain, empty, exclude_coinjoin=True)
+    assert [(s.transactions, s.unions, s.redundant) for s in stats] == [
+        (excluded, 0, 0), (transactions, unions, redundant), (0, 0, 0)
+    ]
+    assert _cluster_sizes(default) == sizes
+
+    (_, transactions, unions, redundant), sizes = _link_inputs(chain, empty, excluded_types=(address.type,))
+    assert [(s.transactions, s.unions, s.redundant) for s in filtered.rule_stats()] == [
+        (transactions, unions, redundant)
+    ]
+    assert _cluster_sizes(filtered) == sizes
+
+
+def test_compare_clusterings(chain, json_data, tmpdir_factory):
+    cm = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("compare-default-test")),
+        chain,
+        heuristic=blocksci.heuristics.change.none
+    )
+    same = blocksci.cluster.ClusterManager.compare_clusterings(cm, cm)
+    assert same.merged_cluster_count == 0
+    assert same.split_cluster_count == 0
+    assert same.moved_address_count == 0
+    assert same.moved_addresses == []
+    assert same.unmatched_address_count == 0
+    first, second, count = same.contingency
+    assert (first == second).all()
+    assert count.sum() == same.compared_address_count
+
+    # Without the multi-input rule, the clusters of the default run are merges of the finer clusters
+    fine = blocksci.cluster.ClusterManager.create_clustering(
+        str(tmpdir_factory.mktemp("compare-fine-test")),
+        chain,
+        pipeline=blocksci.cluster.ClusteringPipeline()
+    )
+    diff = blocksci.cluster.ClusterManager.compare_clusterings(fine, cm, top_k=3)
+    assert diff.split_cluster_count == 0
+    assert diff.merged_cluster_count > 0
+    assert len(diff.largest_merges) <= 3
+    assert diff.moved_address_count == 0
+    assert diff.moved_addresses == []
+
+    cluster = cm.cluster_with_address(
+        chain.address_from_string(json_data["merge-addr-1"])
+    )
+    assert diff.largest_merges[0].size >= cluster.type_equiv_size
+
+    reverse = blocksci.cluster.ClusterManager.compare_clusterings(cm, fine)
+    assert reverse.split_cluster_count == diff.merged_cluster_count
+    assert reverse.merged_cluster_count == 0
+    assert 0 < len(reverse.moved_addresses) <= reverse.moved_address_count
+
+    limited = blocksci.cluster.ClusterManager.compare_clusterings(cm, fine, moved_address_limit=1)
+    assert limited.moved_address_count == reverse.moved_address_count
+    assert limited.moved_addresses == reverse.moved_addresses[:1]
@@ -1,3 +1,9 @@
+import os
+import subprocess
+
+import blocksci
+
+
 def address_types(chain_name):
     if chain_name == "btc":
         return ["p2sh", "p2wsh"]
@@ -24,3 +30,33 @@ def test_script_equivalence(chain, json_data, regtest, chain_name):
         script_equiv = sort_addresses(addr.equiv(True).addresses.to_list())
         for equiv_address in script_equiv:
             assert script_equiv == sort_addresses(equiv_address.equiv(True).addresses.to_list())
+
+
+def script_equivalents(chain):
+    address_types = [
+        blocksci.address_type.pubkey,
+        blocksci.address_type.pubkeyhash,
+        blocksci.address_type.witness_pubkeyhash,
+        blocksci.address_type.multisig,
+        blocksci.address_type.scripthash,
+        blocksci.address_type.witness_scripthash,
+    ]
+    return {
+        (addr.type, addr.address_num): sorted((a.type, a.address_num) for a in addr.equiv(True).addresses.to_list())
+        for address_type in address_types
+        for addr in chain.addresses(address_type).to_list()
+    }
+
+
+def test_equiv_table(parse_chain):
+    """Tests that the equivalence table, built at block 100 and extended by update, matches the address index search"""
+    config = parse_chain(100)
+    subprocess.run(["blocksci_parser", config, "equiv-table-update"], check=True)
+    parse_chain()
+    table_chain = blocksci.Blockchain(config)
+    from_table = script_equivalents(table_chain)
+    assert any(len(equiv) > 1 for equiv in from_table.values())
+
+    # Without the state file the table is ignored and EquivAddress searches the nested address index
+    os.remove(os.path.join(table_chain.data_location, "scripts", "equiv", "state.dat"))
+    assert from_table == script_equivalents(blocksci.Blockchain(config))
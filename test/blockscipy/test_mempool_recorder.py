@@ -0,0 +1,227 @@
+import json
+import os
+import signal
+import socket
+import struct
+import subprocess
+import threading
+import time
+from http.server import ThreadingHTTPServer
+
+import blocksci
+import pytest
+
+from test_rpc_parser import COIN_TYPES, RPC_PASSWORD, RPC_USER, FakeNode
+
+
+class MempoolNode(FakeNode):
+    """Fake node that additionally answers the calls of the mempool recorder"""
+
+    def __init__(self, blocks_dir):
+        super(MempoolNode, self).__init__(blocks_dir)
+        self.mempool = []
+        # Fee in BTC, virtual size and serialization of transactions the recorder may ask about
+        self.entries = {}
+
+    def call(self, method, params):
+        if method == "getrawmempool":
+            return list(self.mempool)
+        if method == "getmempoolentry":
+            fee, vsize, _ = self.entries[params[0]]
+            return {"fees": {"base": fee}, "vsize": vsize}
+        if method == "getrawtransaction" and params[0] in self.entries:
+            return self.entries[params[0]][2]
+        if method == "getchaintips":
+            tip = {"height": len(self.chain) - 1, "hash": self.chain[-1]}
+            return [dict(tip, branchlen=0, status="active")]
+        if method == "getblock" and len(params) == 1:
+            return self.header(params[0])
+        return super(MempoolNode, self).call(method, params)
+
+
+def zmtp_frame(flags, body):
+    if len(body) > 255:
+        return bytes([flags | 2]) + struct.pack(">Q", len(body)) + body
+    return bytes([flags, len(body)]) + body
+
+
+def spending_tx(prev_hash, prev_index):
+    """Serialization of a transaction with a single input spending the given outpoint"""
+    tx = struct.pack("<i", 2) + b"\x01" + bytes.fromhex(prev_hash)[::-1]
+    tx += struct.pack("<I", prev_index) + b"\x00" + b"\xff" * 4 + b"\x00" + bytes(4)
+    return tx.hex()
+
+
+class NotificationPublisher(object):
+    """Stand-in for the ZeroMQ publisher of a node, speaking ZMTP 3.0 to a single subscriber"""
+
+    def __init__(self):
+        self.server = socket.socket()
+        self.server.bind(("127.0.0.1", 0))
+        self.server.listen(1)
+        self.port = self.server.getsockname()[1]
+        self.subscribed = threading.Event()
+        self.connection = None
+        self.sequences = {}
+        threading.Thread(target=self.accept, daemon=True).start()
+
+    def read_exact(self, size):
+        data = b""
+        while len(data) < size:
+            chunk = self.connection.recv(size - len(data))
+            if not chunk:
+                raise ConnectionError("Subscriber disconnected")
+            data += chunk
+        return data
+
+    def read_frame(self):
+        flags = self.read_exact(1)[0]
+        if flags & 2:
+            size = struct.unpack(">Q", self.read_exact(8))[0]
+        else:
+            size = self.read_exact(1)[0]
+        return flags, self.read_exact(size)
+
+    def accept(self):
+        self.connection, _ = self.server.accept()
+        mechanism = b"NULL".ljust(20, b"\0")
+        signature = b"\xff" + bytes(8) + b"\x7f"
+        self.connection.sendall(signature + bytes([3, 0]) + mechanism + bytes(32))
+        greeting = self.read_exact(64)
+        assert greeting[0] == 0xFF and greeting[12:16] == b"NULL"
+        flags, ready = self.read_frame()
+        assert flags & 4 and ready.startswith(b"\x05READY")
+        properties = bytes([11]) + b"Socket-Type" + struct.pack(">I", 3) + b"PUB"
+        self.connection.sendall(zmtp_frame(4, b"\x05READY" + properties))
+        topics = set()
+        while topics != {b"hashtx", b"hashblock", b"sequence"}:
+            _, subscription = self.read_frame()
+            assert subscription[:1] == b"\x01"
+            topics.add(subscription[1:])
+        self.subscribed.set()
+
+    def publish(self, topic, body):
+        sequence = self.sequences.get(topic, 0)
+        self.sequences[topic] = sequence + 1
+        self.connection.sendall(
+            zmtp_frame(1, topic)
+            + zmtp_frame(1, body)
+            + zmtp_frame(0, struct.pack("<I", sequence))
+        )
+
+    def close(self):
+        if self.connection is not None:
+            self.connection.close()
+        self.server.close()
+
+
+def read_recorder_state(data_dir):
+    """Returns the first-seen times of all transactions in the state file of the recorder"""
+    with open(os.path.join(data_dir, "mempool", "recorder_state.dat"), "rb") as f:
+        data = f.read()
+    version, tx_count = struct.unpack_from("<IQ", data)
+    assert version == 2
+    times = {}
+    pos = 12
+    for _ in range(tx_count):
+        tx_hash, seen = struct.unpack_from("<32sq", data, pos)
+        times[tx_hash[::-1].hex()] = seen
+        pos += 60
+    return times
+
+
+def run_recorder(config_file, extra_args, until):
+    recorder = subprocess.Popen(["mempool_recorder", config_file] + extra_args)
+    try:
+        until()
+    finally:
+        recorder.send_signal(signal.SIGTERM)
+        recorder.wait(timeout=60)
+    assert recorder.returncode == 0
+
+
+@pytest.mark.btc
+def test_mempool_recorder_notifications(chain_name, tmpdir_factory):
+    """Tests that transactions announced by notifications are recorded and that first-seen times survive a restart"""
+    self_dir = os.path.dirname(os.path.realpath(__file__))
+    node = MempoolNode("{}/../files/{}/regtest/blocks".format(self_dir, chain_name))
+    server = ThreadingHTTPServer(("127.0.0.1", 0), node.handler())
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    publisher = NotificationPublisher()
+
+    data_dir = str(tmpdir_factory.mktemp(chain_name + "_mempool"))
+    config_file = data_dir + "/config.json"
+    create_config_cmd = [
+        "blocksci_parser",
+        config_file,
+        "generate-config",
+        COIN_TYPES[chain_name],
+        data_dir,
+        "--disk",
+        "{}/../files/{}/regtest/".format(self_dir, chain_name),
+    ]
+    subprocess.run(create_config_cmd, check=True)
+    subprocess.run(["blocksci_parser", config_file, "update"], check=True)
+    with open(config_file) as f:
+        config = json.load(f)
+    config["parser"]["rpc"] = {
+        "username": RPC_USER,
+        "password": RPC_PASSWORD,
+        "address": "127.0.0.1",
+        "port": server.server_address[1],
+    }
+    with open(config_file, "w") as f:
+        json.dump(config, f)
+
+    polled_tx = "11" * 32
+    notified_tx = "22" * 32
+    replacement_tx = "33" * 32
+    node.mempool = [polled_tx]
+    node.entries[notified_tx] = (0.00001, 250, spending_tx("aa" * 32, 0))
+    node.entries[replacement_tx] = (0.00005, 250, spending_tx("aa" * 32, 0))
+
+    # The node also publishes hashtx for the transactions of a new block, which never were in its mempool
+    block = next(block for block in blocksci.Blockchain(config_file) if len(block.txes) > 1)
+    coinbase_tx = str(block.txes[0].hash)
+    mined_tx = str(block.txes[1].hash)
+
+    def publish_tx():
+        assert publisher.subscribed.wait(timeout=60)
+        publisher.publish(b"hashtx", bytes.fromhex(notified_tx))
+        publisher.publish(b"hashtx", bytes.fromhex(coinbase_tx))
+        publisher.publish(b"hashtx", bytes.fromhex(mined_tx))
+        time.sleep(0.5)
+        publisher.publish(b"sequence", bytes.fromhex(notified_tx) + b"R" + bytes(8))
+        publisher.publish(b"sequence", bytes.fromhex(replacement_tx) + b"A" + bytes(8))
+        time.sleep(1)
+
+    try:
+        endpoint = "tcp://127.0.0.1:{}".format(publisher.port)
+        run_recorder(config_file, ["--zmq", endpoint], publish_tx)
+        times = read_recorder_state(data_dir)
+        assert polled_tx in times
+        assert notified_tx in times
+        assert replacement_tx in times
+        assert coinbase_tx not in times
+        assert mined_tx not in times
+
+        # The replacement spends the same outpoint as the removed transaction
+        events = blocksci.Blockchain(config_file).mempool_events()
+        hashes = [bytes(h[::-1]).hex() for h in events["tx_hash"]]
+        entered = [(hashes[i], events["fee_rate"][i]) for i in range(len(hashes)) if events["type"][i] == 1]
+        assert entered == [(notified_tx, 4000), (replacement_tx, 20000)]
+        replaced = [i for i in range(len(hashes)) if events["type"][i] == 2]
+        assert [hashes[i] for i in replaced] == [notified_tx]
+        assert bytes(events["other_tx_hash"][replaced[0]][::-1]).hex() == replacement_tx
+        # The replaced transaction is only reported as replaced, not also as removed
+        assert [hashes[i] for i in range(len(hashes)) if events["type"][i] == 3] == []
+
+        # After a restart, transactions that are still in the mempool keep the time at which they were first seen
+        node.mempool = [polled_tx, notified_tx, replacement_tx]
+        run_recorder(config_file, [], lambda: time.sleep(2))
+        restarted_times = read_recorder_state(data_dir)
+        assert restarted_times[polled_tx] == times[polled_tx]
+        assert restarted_times[notified_tx] == times[notified_tx]
+    finally:
+        publisher.close()
+        server.shutdown()
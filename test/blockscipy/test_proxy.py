@@ -1,3 +1,6 @@
+import blocksci
+
+
 def test_map_txes(chain):
     tx0 = set()
     for block in chain:
@@ -166,3 +169,85 @@ def test_nested_select(chain):
         .any(lambda o: o.spending_tx.select(lambda t: t.fee_per_byte()).or_value(0) > o.tx.fee_per_byte())).to_list()
     assert txes1
     assert txes1 == txes2
+
+
+def _collect(result):
+    if hasattr(result, "to_list"):
+        return result.to_list()
+    if hasattr(result, "tolist"):
+        return result.tolist()
+    return result
+
+
+def test_vectorized_execution(chain):
+    queries = [
+        lambda: chain.blocks.fee,
+        lambda: chain.blocks.weight,
+        lambda: chain.blocks.map(lambda b: b.txes.outputs.value.sum),
+        lambda: chain.blocks.map(lambda b: b.txes.fee),
+        lambda: chain.blocks.map(lambda b: b.txes.where(lambda tx: tx.input_count > 1).size),
+        lambda: chain.blocks.map(lambda b: b.outputs.where(lambda o: o.is_spent).value.sum),
+        lambda: chain.blocks.map(lambda b: b.inputs.where(lambda i: i.sequence_num != 0).index),
+        lambda: chain.blocks.where(lambda b: b.txes.any(lambda tx: tx.locktime > 0)),
+        lambda: chain.blocks.where(lambda b: b.txes.all(lambda tx: tx.is_coinbase)),
+        lambda: chain[100:130].map(lambda b: b.txes.map(lambda tx: tx.output_value - tx.fee // 2)),
+        lambda: chain.blocks._self_proxy.txes.outputs.value.sum(chain.blocks),
+        lambda: chain.blocks._self_proxy.txes.where(lambda tx: tx.fee > 0).size(chain.blocks),
+    ]
+
+    assert blocksci.proxy.vectorized_execution()
+    try:
+        for query in queries:
+            blocksci.proxy.set_vectorized_execution(True)
+            count = blocksci.proxy.vectorized_execution_count()
+            vectorized = _collect(query())
+            assert blocksci.proxy.vectorized_execution_count() > count
+            blocksci.proxy.set_vectorized_execution(False)
+            count = blocksci.proxy.vectorized_execution_count()
+            assert vectorized == _collect(query())
+            assert blocksci.proxy.vectorized_execution_count() == count
+    finally:
+        blocksci.proxy.set_vectorized_execution(True)
+
+
+def test_parallel_execution(chain):
+    queries = [
+        lambda: chain.blocks.map(lambda b: b.txes.outputs.value.sum),
+        lambda: chain.blocks.map(lambda b: b.hash),
+        lambda: chain.blocks.map(lambda b: b.outputs.where(lambda o: o.is_spent).size),
+        lambda: chain.blocks.where(lambda b: b.txes.any(lambda tx: tx.fee > 0)),
+        lambda: chain[100:130].where(lambda b: b.tx_count > 1),
+        lambda: chain.blocks._self_proxy.txes.fee(chain.blocks),
+        lambda: chain.blocks._self_proxy.outputs.where(lambda o: ~o.is_spent).value(chain.blocks),
+        lambda: chain.blocks.group_by(lambda b: b.tx_count, lambda blocks: blocks.size),
+        lambda: chain.blocks._self_proxy.outputs.group_by(lambda o: o.address, lambda o: o.value.sum)(chain.blocks),
+    ]
+    # Python objects are only created while holding the GIL, so these queries stay on a single thread
+    python_queries = [
+        lambda: chain.blocks.map(lambda b: b.coinbase_param),
+    ]
+
+    assert blocksci.proxy.parallel_execution()
+    blocksci.proxy.set_vectorized_execution(False)
+    try:
+        for query in queries + python_queries:
+            blocksci.proxy.set_parallel_execution(True)
+            count = blocksci.proxy.parallel_execution_count()
+            parallel = _collect(query())
+            if query in python_queries:
+                assert blocksci.proxy.parallel_execution_count() == count
+            else:
+                assert blocksci.proxy.parallel_execution_count() > count
+            blocksci.proxy.set_parallel_execution(False)
+            count = blocksci.proxy.parallel_execution_count()
+            assert parallel == _collect(query())
+            assert blocksci.proxy.parallel_execution_count() == count
+    finally:
+        blocksci.proxy.set_parallel_execution(True)
+        blocksci.proxy.set_vectorized_execution(True)
+
+
+def test_most_valuable_addresses(chain):
+    values = chain.blocks.outputs.where(lambda o: ~o.is_spent).group_by(lambda o: o.address, lambda o: o.value.sum)
+    top = chain.most_valuable_addresses(10)
+    assert [value for _, value in top] == sorted(values.values(), reverse=True)[:10]
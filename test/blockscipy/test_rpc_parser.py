@@ -0,0 +1,281 @@
+import base64
+import hashlib
+import json
+import os
+import struct
+import subprocess
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+import blocksci
+import pytest
+
+RPC_USER = "blocksci"
+RPC_PASSWORD = "regtest"
+
+COIN_TYPES = {
+    "btc": "bitcoin_regtest",
+    "bch": "bitcoin_cash_regtest",
+    "ltc": "litecoin_regtest",
+}
+
+
+def read_varint(data, pos):
+    """Returns the value of the variable length integer at pos and the position after it"""
+    first = data[pos]
+    if first < 0xFD:
+        return first, pos + 1
+    fmt, size = {0xFD: ("<H", 2), 0xFE: ("<I", 4), 0xFF: ("<Q", 8)}[first]
+    return struct.unpack_from(fmt, data, pos + 1)[0], pos + 1 + size
+
+
+def read_bytes(data, pos):
+    length, pos = read_varint(data, pos)
+    return data[pos : pos + length], pos + length
+
+
+def double_sha256(data):
+    return hashlib.sha256(hashlib.sha256(data).digest()).digest()
+
+
+def decode_tx(data, pos):
+    """Decodes the transaction at pos like bitcoind does for getblock with verbosity 2"""
+    start = pos
+    version = struct.unpack_from("<i", data, pos)[0]
+    pos += 4
+    segwit = data[pos] == 0
+    if segwit:
+        pos += 2
+    inputs_start = pos
+    vin = []
+    input_count, pos = read_varint(data, pos)
+    for _ in range(input_count):
+        prev_hash, prev_index = data[pos : pos + 32], struct.unpack_from("<I", data, pos + 32)[0]
+        script, pos = read_bytes(data, pos + 36)
+        sequence = struct.unpack_from("<I", data, pos)[0]
+        pos += 4
+        if prev_hash == bytes(32):
+            vin.append({"coinbase": script.hex(), "sequence": sequence})
+        else:
+            vin.append(
+                {
+                    "txid": prev_hash[::-1].hex(),
+                    "vout": prev_index,
+                    "scriptSig": {"hex": script.hex()},
+                    "sequence": sequence,
+                }
+            )
+    vout = []
+    output_count, pos = read_varint(data, pos)
+    for n in range(output_count):
+        value = struct.unpack_from("<q", data, pos)[0]
+        script, pos = read_bytes(data, pos + 8)
+        vout.append({"value": value / 1e8, "n": n, "scriptPubKey": {"hex": script.hex()}})
+    inputs_end = pos
+    if segwit:
+        for item in vin:
+            stack_size, pos = read_varint(data, pos)
+            stack = []
+            for _ in range(stack_size):
+                witness_item, pos = read_bytes(data, pos)
+                stack.append(witness_item.hex())
+            if stack:
+                item["txinwitness"] = stack
+    locktime = struct.unpack_from("<I", data, pos)[0]
+    pos += 4
+    stripped = data[start : start + 4] + data[inputs_start:inputs_end] + data[pos - 4 : pos]
+    tx = {
+        "txid": double_sha256(stripped)[::-1].hex(),
+        "version": version,
+        "locktime": locktime,
+        "vin": vin,
+        "vout": vout,
+        "hex": data[start:pos].hex(),
+    }
+    return tx, pos
+
+
+class FakeNode(object):
+    """Answers the JSON-RPC calls of the parser from the blocks stored in blk files"""
+
+    def __init__(self, blocks_dir):
+        self.blocks = {}
+        for name in sorted(os.listdir(blocks_dir)):
+            if not (name.startswith("blk") and name.endswith(".dat")):
+                continue
+            with open(os.path.join(blocks_dir, name), "rb") as f:
+                data = f.read()
+            pos = 0
+            while pos + 8 <= len(data):
+                magic, length = struct.unpack_from("<II", data, pos)
+                if magic == 0:
+                    break
+                raw = data[pos + 8 : pos + 8 + length]
+                pos += 8 + length
+                self.blocks[self.block_hash(raw)] = raw
+
+        # The main chain ends in the block with the largest height, like in the disk parser
+        children = {}
+        for block_hash, raw in self.blocks.items():
+            children.setdefault(raw[4:36][::-1].hex(), []).append(block_hash)
+        heights = {}
+        queue = [("00" * 32, -1)]
+        while queue:
+            parent, height = queue.pop()
+            for child in children.get(parent, []):
+                heights[child] = height + 1
+                queue.append((child, height + 1))
+        tip = max(heights, key=heights.get)
+        self.chain = [tip]
+        while heights[self.chain[-1]] > 0:
+            self.chain.append(self.blocks[self.chain[-1]][4:36][::-1].hex())
+        self.chain.reverse()
+        self.heights = heights
+
+        self.requests = 0
+        self.calls = 0
+        self.lock = threading.Lock()
+
+    @staticmethod
+    def block_hash(raw):
+        return double_sha256(raw[:80])[::-1].hex()
+
+    def header(self, block_hash):
+        raw = self.blocks[block_hash]
+        version, prev, merkle, time, bits, nonce = struct.unpack_from(
+            "<i32s32sIII", raw
+        )
+        header = {
+            "hash": block_hash,
+            "height": self.heights[block_hash],
+            "version": version,
+            "merkleroot": merkle[::-1].hex(),
+            "time": time,
+            "bits": "{:08x}".format(bits),
+            "nonce": nonce,
+            "nTx": read_varint(raw, 80)[0],
+        }
+        if self.heights[block_hash] > 0:
+            header["previousblockhash"] = prev[::-1].hex()
+        return header
+
+    def call(self, method, params):
+        if method == "getblockcount":
+            return len(self.chain) - 1
+        if method == "getblockhash":
+            return self.chain[params[0]]
+        if method == "getblockheader":
+            return self.header(params[0])
+        if method == "getblock" and params[1] == 0:
+            return self.blocks[params[0]].hex()
+        if method == "getblock" and params[1] == 2:
+            raw = self.blocks[params[0]]
+            block = self.header(params[0])
+            tx_count, pos = read_varint(raw, 80)
+            block["tx"] = []
+            for _ in range(tx_count):
+                tx, pos = decode_tx(raw, pos)
+                block["tx"].append(tx)
+            return block
+        raise ValueError("Unsupported call {} {}".format(method, params))
+
+    def respond(self, request):
+        try:
+            return {
+                "result": self.call(request["method"], request.get("params", [])),
+                "error": None,
+                "id": request["id"],
+            }
+        except (KeyError, IndexError, ValueError) as e:
+            return {
+                "result": None,
+                "error": {"code": -1, "message": str(e)},
+                "id": request["id"],
+            }
+
+    def handler(self):
+        node = self
+        credentials = base64.b64encode(
+            "{}:{}".format(RPC_USER, RPC_PASSWORD).encode()
+        ).decode()
+
+        class Handler(BaseHTTPRequestHandler):
+            protocol_version = "HTTP/1.1"
+
+            def do_POST(self):
+                body = self.rfile.read(int(self.headers["Content-Length"]))
+                if self.headers.get("Authorization") != "Basic " + credentials:
+                    self.send_response(401)
+                    self.send_header("Content-Length", "0")
+                    self.end_headers()
+                    return
+                request = json.loads(body)
+                batch = request if isinstance(request, list) else [request]
+                with node.lock:
+                    node.requests += 1
+                    node.calls += len(batch)
+                responses = [node.respond(item) for item in batch]
+                response = responses if isinstance(request, list) else responses[0]
+                data = json.dumps(response).encode()
+                self.send_response(200)
+                self.send_header("Content-Type", "application/json")
+                self.send_header("Content-Length", str(len(data)))
+                self.end_headers()
+                self.wfile.write(data)
+
+            def log_message(self, format, *args):
+                pass
+
+        return Handler
+
+
+@pytest.mark.parametrize("raw_blocks", [True, False])
+def test_rpc_parser_matches_disk_parser(chain, chain_name, raw_blocks, tmpdir_factory):
+    """Tests that parsing the chain from a node over JSON-RPC gives the same result as parsing the blk files,
+    both from serialized blocks and from blocks with transactions decoded by the node"""
+    self_dir = os.path.dirname(os.path.realpath(__file__))
+    node = FakeNode(
+        "{}/../files/{}/regtest/blocks".format(self_dir, chain_name)
+    )
+    server = ThreadingHTTPServer(("127.0.0.1", 0), node.handler())
+    server_thread = threading.Thread(target=server.serve_forever, daemon=True)
+    server_thread.start()
+
+    chain_dir = str(tmpdir_factory.mktemp(chain_name + "_rpc"))
+    config_file = chain_dir + "/config.json"
+    create_config_cmd = [
+        "blocksci_parser",
+        config_file,
+        "generate-config",
+        COIN_TYPES[chain_name],
+        chain_dir,
+        "--rpc",
+        RPC_USER,
+        RPC_PASSWORD,
+        "--address",
+        "127.0.0.1",
+        "--port",
+        str(server.server_address[1]),
+    ]
+    parse_cmd = ["blocksci_parser", config_file, "update"]
+    try:
+        subprocess.run(create_config_cmd, check=True)
+        with open(config_file) as f:
+            config = json.load(f)
+        assert config["parser"]["rpc"]["rawBlocks"]
+        config["parser"]["rpc"]["rawBlocks"] = raw_blocks
+        with open(config_file, "w") as f:
+            json.dump(config, f)
+        subprocess.run(parse_cmd, check=True)
+    finally:
+        server.shutdown()
+
+    rpc_chain = blocksci.Blockchain(config_file)
+    assert len(rpc_chain) == len(chain)
+    assert rpc_chain.tx_count == chain.tx_count
+    for rpc_block, block in zip(rpc_chain, chain):
+        assert rpc_block.hash == block.hash
+        assert [tx.hash for tx in rpc_block] == [tx.hash for tx in block]
+
+    # Headers and blocks are requested in batches
+    assert node.requests < node.calls
@@ -0,0 +1,396 @@
+//
+//  chunked_checksum.cpp
+//  blocksci_check_integrity
+//
+
+#include "chunked_checksum.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // Directories of the data directory that are covered by the manifest, the RocksDB indexes are checked separately
+    const std::vector<std::string> checkedDirectories = {"chain", "scripts"};
+    
+    // Chain files which are only ever appended to. Transaction data is not included since spending transactions are
+    // linked into the outputs they spend, and script data is updated when an address is first spent.
+    const std::set<std::string> appendOnlyFiles = {
+        "chain/block.dat", "chain/coinbases.dat", "chain/tx_index.dat", "chain/tx_hashes.dat", "chain/tx_version.dat",
+        "chain/firstInput.dat", "chain/firstOutput.dat", "chain/sequence.dat", "chain/input_out_num.dat"
+    };
+    
+    constexpr size_t readBufferSize = 1 << 20;
+    
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        throw std::runtime_error("Invalid hex digit in checksum manifest");
+    }
+    
+    ChunkDigest parseDigest(const std::string &hex) {
+        if (hex.size() != 64) {
+            throw std::runtime_error("Invalid digest in checksum manifest");
+        }
+        ChunkDigest digest;
+        for (size_t i = 0; i < digest.size(); i++) {
+            digest[i] = static_cast<unsigned char>((hexValue(hex[2 * i]) << 4) | hexValue(hex[2 * i + 1]));
+        }
+        return digest;
+    }
+    
+    ChunkDigest finalDigest(SHA256_CTX &sha256) {
+        ChunkDigest digest;
+        SHA256_Final(digest.data(), &sha256);
+        return digest;
+    }
+    
+    std::string joinPath(const std::string &directory, const std::string &name) {
+        return directory.empty() || directory.back() == '/' ? directory + name : directory + "/" + name;
+    }
+    
+    struct ScannedFile {
+        std::string name;
+        std::string path;
+        FileChecksum checksum;
+        int fd = -1;
+    };
+    
+    struct ChunkTask {
+        size_t fileIndex;
+        uint64_t chunk;
+        
+        // Length of the chunk that is checked against the digest of the previous manifest, 0 if it is not checked
+        uint64_t previousLength;
+        ChunkDigest previousDigest;
+    };
+    
+    std::vector<ScannedFile> scanFiles(const std::string &dataDirectory) {
+        std::vector<ScannedFile> files;
+        for (auto &directory : checkedDirectories) {
+            auto directoryPath = joinPath(dataDirectory, directory);
+            DIR *dir = opendir(directoryPath.c_str());
+            if (dir == nullptr) {
+                continue;
+            }
+            while (auto entry = readdir(dir)) {
+                ScannedFile file;
+                file.name = directory + "/" + entry->d_name;
+                file.path = joinPath(directoryPath, entry->d_name);
+                struct stat fileStat;
+                if (stat(file.path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+                    continue;
+                }
+                file.checksum.size = static_cast<uint64_t>(fileStat.st_size);
+                file.checksum.modificationTime = static_cast<int64_t>(fileStat.st_mtime);
+                file.checksum.appendOnly = appendOnlyFiles.count(file.name) > 0;
+                files.push_back(std::move(file));
+            }
+            closedir(dir);
+        }
+        std::sort(files.begin(), files.end(), [](const ScannedFile &a, const ScannedFile &b) {
+            return a.name < b.name;
+        });
+        return files;
+    }
+    
+    // Reads [offset, offset + length) of the file into the hash
+    void hashRange(SHA256_CTX &sha256, const ScannedFile &file, uint64_t offset, uint64_t length, std::vector<char> &buffer) {
+        while (length > 0) {
+            auto toRead = static_cast<size_t>(std::min<uint64_t>(length, buffer.size()));
+            auto bytesRead = pread(file.fd, buffer.data(), toRead, static_cast<off_t>(offset));
+            if (bytesRead <= 0) {
+                throw std::runtime_error("Could not read " + file.path);
+            }
+            SHA256_Update(&sha256, buffer.data(), static_cast<size_t>(bytesRead));
+            offset += static_cast<uint64_t>(bytesRead);
+            length -= static_cast<uint64_t>(bytesRead);
+        }
+    }
+}
+
+std::string digestHex(const ChunkDigest &digest) {
+    static const char *digits = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(2 * digest.size());
+    for (auto byte : digest) {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 0xf];
+    }
+    return hex;
+}
+
+ChunkDigest FileChecksum::root() const {
+    SHA256_CTX sha256;
+    SHA256_Init(&sha256);
+    for (auto &chunk : chunks) {
+        SHA256_Update(&sha256, chunk.data(), chunk.size());
+    }
+    return finalDigest(sha256);
+}
+
+ChunkDigest ChecksumManifest::root() const {
+    SHA256_CTX sha256;
+    SHA256_Init(&sha256);
+    for (auto &file : files) {
+        auto fileRoot = file.second.root();
+        SHA256_Update(&sha256, fileRoot.data(), fileRoot.size());
+    }
+    return finalDigest(sha256);
+}
+
+std::string ChecksumManifest::manifestPath(const std::string &dataDirectory) {
+    return joinPath(dataDirectory, "integrity_manifest.json");
+}
+
+bool ChecksumManifest::exists(const std::string &dataDirectory) {
+    struct stat fileStat;
+    return stat(manifestPath(dataDirectory).c_str(), &fileStat) == 0;
+}
+
+ChecksumManifest ChecksumManifest::load(const std::string &dataDirectory) {
+    std::ifstream rawFile(manifestPath(dataDirectory));
+    if (!rawFile) {
+        throw std::runtime_error("No checksum manifest found at " + manifestPath(dataDirectory));
+    }
+    nlohmann::json json;
+    rawFile >> json;
+    ChecksumManifest manifest;
+    manifest.chunkSize = json.at("chunkSize").get<uint64_t>();
+    for (auto &file : json.at("files").items()) {
+        auto &value = file.value();
+        FileChecksum checksum;
+        checksum.size = value.at("size").get<uint64_t>();
+        checksum.modificationTime = value.at("modificationTime").get<int64_t>();
+        checksum.appendOnly = value.at("appendOnly").get<bool>();
+        for (auto &chunk : value.at("chunks")) {
+            checksum.chunks.push_back(parseDigest(chunk.get<std::string>()));
+        }
+        manifest.files[file.key()] = std::move(checksum);
+    }
+    return manifest;
+}
+
+void ChecksumManifest::save(const std::string &dataDirectory) const {
+    nlohmann::json json;
+    json["chunkSize"] = chunkSize;
+    json["root"] = digestHex(root());
+    auto &filesJson = json["files"] = nlohmann::json::object();
+    for (auto &file : files) {
+        nlohmann::json chunksJson = nlohmann::json::array();
+        for (auto &chunk : file.second.chunks) {
+            chunksJson.push_back(digestHex(chunk));
+        }
+        filesJson[file.first] = {
+            {"size", file.second.size},
+            {"modificationTime", file.second.modificationTime},
+            {"appendOnly", file.second.appendOnly},
+            {"root", digestHex(file.second.root())},
+            {"chunks", std::move(chunksJson)}
+        };
+    }
+    
+    // Write to a temporary file first so that an interrupted run does not destroy the previous manifest
+    auto path = manifestPath(dataDirectory);
+    auto tempPath = path + ".tmp";
+    {
+        std::ofstream rawFile(tempPath);
+        rawFile << json.dump(1) << "\n";
+        if (!rawFile) {
+            throw std::runtime_error("Could not write checksum manifest to " + tempPath);
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Could not write checksum manifest to " + path);
+    }
+}
+
+ChecksumRun computeChecksums(const std::string &dataDirectory, const ChecksumManifest *previous, bool reuseUnchanged) {
+    auto startTime = std::chrono::steady_clock::now();
+    ChecksumRun run;
+    run.manifest.chunkSize = checksumChunkSize;
+    auto chunkSize = run.manifest.chunkSize;
+    if (previous != nullptr && previous->chunkSize != chunkSize) {
+        run.problems.push_back("Previous manifest uses a different chunk size, hashing all data");
+        previous = nullptr;
+    }
+    
+    auto files = scanFiles(dataDirectory);
+    std::vector<ChunkTask> tasks;
+    for (size_t fileIndex = 0; fileIndex < files.size(); fileIndex++) {
+        auto &file = files[fileIndex];
+        auto &checksum = file.checksum;
+        auto chunkCount = (checksum.size + chunkSize - 1) / chunkSize;
+        checksum.chunks.resize(chunkCount);
+        
+        uint64_t firstChunk = 0;
+        const FileChecksum *old = nullptr;
+        if (previous != nullptr) {
+            auto it = previous->files.find(file.name);
+            if (it != previous->files.end()) {
+                old = &it->second;
+            }
+        }
+        if (old != nullptr && reuseUnchanged) {
+            if (old->size == checksum.size && old->modificationTime == checksum.modificationTime) {
+                checksum.chunks = old->chunks;
+                run.chunksReused += chunkCount;
+                continue;
+            }
+            if (checksum.appendOnly && checksum.size >= old->size) {
+                // A reorg rewrites the end of the append-only files, so the last complete chunk of the previous
+                // manifest is hashed again and checked instead of being taken over
+                firstChunk = old->size / chunkSize;
+                if (firstChunk > 0) {
+                    firstChunk--;
+                }
+                std::copy(old->chunks.begin(), old->chunks.begin() + static_cast<std::ptrdiff_t>(firstChunk), checksum.chunks.begin());
+                run.chunksReused += firstChunk;
+            }
+        }
+        
+        for (uint64_t chunk = firstChunk; chunk < chunkCount; chunk++) {
+            ChunkTask task{fileIndex, chunk, 0, {}};
+            if (old != nullptr && checksum.appendOnly && checksum.size >= old->size && chunk < old->chunks.size()) {
+                if (chunk < old->size / chunkSize) {
+                    // Complete chunk of the previous manifest, it must be unchanged
+                    task.previousLength = chunkSize;
+                    task.previousDigest = old->chunks[chunk];
+                } else if (checksum.size > old->size) {
+                    // The previous manifest ended inside this chunk, check that the part it covered is unchanged
+                    task.previousLength = old->size % chunkSize;
+                    task.previousDigest = old->chunks[chunk];
+                }
+            }
+            tasks.push_back(task);
+        }
+    }
+    
+    for (auto &file : files) {
+        if (file.checksum.size > 0) {
+            file.fd = open(file.path.c_str(), O_RDONLY);
+            if (file.fd < 0) {
+                throw std::runtime_error("Could not open " + file.path);
+            }
+        }
+    }
+    
+    // Chunks are handed out in file order so that consecutive reads of a worker stay close to each other
+    std::atomic<size_t> nextTask{0};
+    std::mutex problemMutex;
+    auto worker = [&]() {
+        std::vector<char> buffer(readBufferSize);
+        uint64_t bytesHashed = 0;
+        for (size_t taskIndex = nextTask++; taskIndex < tasks.size(); taskIndex = nextTask++) {
+            auto &task = tasks[taskIndex];
+            auto &file = files[task.fileIndex];
+            auto offset = task.chunk * chunkSize;
+            auto length = std::min(chunkSize, file.checksum.size - offset);
+            SHA256_CTX sha256;
+            SHA256_Init(&sha256);
+            if (task.previousLength > 0) {
+                hashRange(sha256, file, offset, task.previousLength, buffer);
+                SHA256_CTX previousPart = sha256;
+                if (finalDigest(previousPart) != task.previousDigest) {
+                    std::lock_guard<std::mutex> lock(problemMutex);
+                    run.problems.push_back(file.name + ": data before offset " + std::to_string(offset + task.previousLength) + " changed since the previous manifest (chunk " + std::to_string(task.chunk) + ")");
+                }
+                hashRange(sha256, file, offset + task.previousLength, length - task.previousLength, buffer);
+            } else {
+                hashRange(sha256, file, offset, length, buffer);
+            }
+            file.checksum.chunks[task.chunk] = finalDigest(sha256);
+            bytesHashed += length;
+        }
+        return bytesHashed;
+    };
+    
+    auto workerCount = std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned int>(tasks.size())));
+    std::vector<std::future<uint64_t>> workers;
+    for (unsigned int i = 0; i < workerCount; i++) {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    std::exception_ptr error;
+    for (auto &future : workers) {
+        try {
+            run.bytesHashed += future.get();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+    for (auto &file : files) {
+        if (file.fd >= 0) {
+            close(file.fd);
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    
+    run.chunksHashed = tasks.size();
+    for (auto &file : files) {
+        run.manifest.files[file.name] = std::move(file.checksum);
+    }
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return run;
+}
+
+std::vector<std::string> compareChecksums(const ChecksumManifest &expected, const ChecksumManifest &actual) {
+    std::vector<std::string> differences;
+    auto chunkSize = expected.chunkSize;
+    for (auto &file : expected.files) {
+        auto &name = file.first;
+        auto &expectedFile = file.second;
+        auto it = actual.files.find(name);
+        if (it == actual.files.end()) {
+            differences.push_back(name + " is missing");
+            continue;
+        }
+        auto &actualFile = it->second;
+        if (actualFile.size < expectedFile.size) {
+            differences.push_back(name + " shrank from " + std::to_string(expectedFile.size) + " to " + std::to_string(actualFile.size) + " bytes");
+        }
+        
+        // An incomplete last chunk can only be compared if the file did not grow, otherwise it was checked while hashing
+        auto comparedChunks = actualFile.size == expectedFile.size ? expectedFile.chunks.size() : expectedFile.size / chunkSize;
+        comparedChunks = std::min(comparedChunks, actualFile.chunks.size());
+        for (size_t chunk = 0; chunk < comparedChunks; chunk++) {
+            if (expectedFile.chunks[chunk] != actualFile.chunks[chunk]) {
+                std::stringstream ss;
+                ss << name << ": chunk " << chunk << " at offset " << chunk * chunkSize << " differs";
+                if (!expectedFile.appendOnly && actualFile.modificationTime != expectedFile.modificationTime) {
+                    ss << " (file was modified after the manifest was written)";
+                }
+                differences.push_back(ss.str());
+            }
+        }
+    }
+    for (auto &file : actual.files) {
+        if (expected.files.find(file.first) == expected.files.end()) {
+            differences.push_back(file.first + " is not part of the manifest");
+        }
+    }
+    return differences;
+}
@@ -0,0 +1,86 @@
+//
+//  chunked_checksum.hpp
+//  blocksci_check_integrity
+//
+
+#ifndef chunked_checksum_hpp
+#define chunked_checksum_hpp
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/** Size of the pieces that data files are split into, each piece is hashed independently */
+constexpr uint64_t checksumChunkSize = 64ull * 1024 * 1024;
+
+using ChunkDigest = std::array<unsigned char, 32>;
+
+std::string digestHex(const ChunkDigest &digest);
+
+/** Checksums of a single file in the data directory */
+struct FileChecksum {
+    uint64_t size = 0;
+    int64_t modificationTime = 0;
+    
+    /** Whether the parser only ever appends to the file, so that its complete chunks never change */
+    bool appendOnly = false;
+    
+    /** SHA256 of every chunk of the file, the last one covers the remainder of the file */
+    std::vector<ChunkDigest> chunks;
+    
+    /** SHA256 over the concatenated chunk digests */
+    ChunkDigest root() const;
+};
+
+/** Merkle-style checksum of the chain and script data of a data directory
+ *
+ * Stored as integrity_manifest.json in the data directory.
+ */
+struct ChecksumManifest {
+    uint64_t chunkSize = checksumChunkSize;
+    
+    /** Checksums of all files, keyed by their path relative to the data directory */
+    std::map<std::string, FileChecksum> files;
+    
+    /** SHA256 over the roots of all files in path order */
+    ChunkDigest root() const;
+    
+    static std::string manifestPath(const std::string &dataDirectory);
+    static bool exists(const std::string &dataDirectory);
+    static ChecksumManifest load(const std::string &dataDirectory);
+    void save(const std::string &dataDirectory) const;
+};
+
+/** Result of hashing a data directory */
+struct ChecksumRun {
+    ChecksumManifest manifest;
+    
+    /** Problems found while reusing checksums of a previous manifest */
+    std::vector<std::string> problems;
+    
+    uint64_t bytesHashed = 0;
+    uint64_t chunksHashed = 0;
+    uint64_t chunksReused = 0;
+    double seconds = 0;
+    
+    double gigabytesPerSecond() const {
+        return seconds > 0 ? static_cast<double>(bytesHashed) / seconds / 1e9 : 0;
+    }
+};
+
+/** Hashes the chunks of all files in the chain and scripts directories on all cores
+ *
+ * If a previous manifest is given, the part of the last chunk of an append-only file that it covered is checked
+ * against it. With reuseUnchanged, only data that changed since the previous manifest is hashed: files with
+ * unchanged size and modification time are taken over completely, and append-only files only hash the chunks
+ * that were appended. Since a reorg rewrites the end of these files, their last complete chunk of the previous
+ * manifest is hashed again and checked as well.
+ */
+ChecksumRun computeChecksums(const std::string &dataDirectory, const ChecksumManifest *previous, bool reuseUnchanged);
+
+/** Compares freshly computed checksums against a stored manifest and returns a description of every difference */
+std::vector<std::string> compareChecksums(const ChecksumManifest &expected, const ChecksumManifest &actual);
+
+#endif /* chunked_checksum_hpp */
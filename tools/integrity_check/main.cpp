@@ -5,6 +5,8 @@
 //  Created by Malte Möser on 3/6/20.
 //
 
+#include "chunked_checksum.hpp"
+
 #include <blocksci/address.hpp>
 #include <blocksci/core/dedup_address.hpp>
 #include <blocksci/chain/blockchain.hpp>
@@ -26,7 +28,9 @@
 #include <clipp.h>
 
 #include <iostream>
+#include <iomanip>
 #include <fstream>
+#include <future>
 
 using namespace blocksci;
 
@@ -73,6 +77,16 @@ uint256 compute_txdata_hash(const ChainAccess &access) {
     return hash;
 }
 
+/**
+ Hash the first count elements of a column. Elements are stored without padding, so they are hashed in a single call.
+ */
+template<typename T>
+void hash_column(SHA256_CTX &sha256, const FixedSizeFileMapper<T> &file, uint64_t count) {
+    if(count > 0) {
+        SHA256_Update(&sha256, file[0], count * sizeof(T));
+    }
+}
+
 /**
  Compute a checksum over additional data (kept in separate files that are memory-mapped on-demand).
  - Input sequence numbers
@@ -90,34 +104,22 @@ uint256 compute_additional_data_hash(const DataAccess &access) {
     auto chainDirectory = access.config.chainDirectory();
 
     FixedSizeFileMapper<uint32_t> sequenceFile(chainAccess.sequenceFilePath(chainDirectory));
-    for(uint64_t i = 0; i < chainAccess.inputCount(); ++i) {
-        SHA256_Update(&sha256, sequenceFile[i], 4);
-    }
+    hash_column(sha256, sequenceFile, chainAccess.inputCount());
 
     FixedSizeFileMapper<uint16_t> spentOutNumFile(chainAccess.inputSpentOutNumFilePath(chainDirectory));
-    for(uint64_t i = 0; i < chainAccess.inputCount(); ++i) {
-        SHA256_Update(&sha256, spentOutNumFile[i], 2);
-    }
+    hash_column(sha256, spentOutNumFile, chainAccess.inputCount());
 
     FixedSizeFileMapper<int32_t> txVersionFile(chainAccess.txVersionFilePath(chainDirectory));
-    for(uint32_t i = 0; i < chainAccess.txCount(); ++i) {
-        SHA256_Update(&sha256, txVersionFile[i], 4);
-    }
+    hash_column(sha256, txVersionFile, chainAccess.txCount());
 
     FixedSizeFileMapper<uint256> txHashesFile(chainAccess.txHashesFilePath(chainDirectory));
-    for(uint32_t i = 0; i < chainAccess.txCount(); ++i) {
-        SHA256_Update(&sha256, txHashesFile[i], 32);
-    }
+    hash_column(sha256, txHashesFile, chainAccess.txCount());
 
     FixedSizeFileMapper<uint64_t> txFirstInputFile(chainAccess.firstInputFilePath(chainDirectory));
-    for(uint32_t i = 0; i < chainAccess.txCount(); ++i) {
-        SHA256_Update(&sha256, txFirstInputFile[i], 8);
-    }
+    hash_column(sha256, txFirstInputFile, chainAccess.txCount());
 
     FixedSizeFileMapper<uint64_t> txFirstOutputFile(chainAccess.firstOutputFilePath(chainDirectory));
-    for(uint32_t i = 0; i < chainAccess.txCount(); ++i) {
-        SHA256_Update(&sha256, txFirstOutputFile[i], 8);
-    }
+    hash_column(sha256, txFirstOutputFile, chainAccess.txCount());
 
     SHA256_Final(reinterpret_cast<unsigned char *>(&hash), &sha256);
     return hash;
@@ -374,12 +376,60 @@ bool check_nesting_scripthash_index(const DataAccess &access) {
     return allNestingsCorrect;
 }
 
+/**
+ Hash the data files in fixed-size chunks on all cores and write or verify the checksum manifest of the data directory.
+ Returns the exit code of the tool.
+ */
+int run_chunked_checksums(const std::string &dataDirectory, bool writeManifest, bool incremental) {
+    bool hasManifest = ChecksumManifest::exists(dataDirectory);
+    if(!writeManifest && !hasManifest) {
+        std::cout << "No checksum manifest found at " << ChecksumManifest::manifestPath(dataDirectory) << ", create one with --write-manifest." << std::endl;
+        return 1;
+    }
+    ranges::optional<ChecksumManifest> stored;
+    if(hasManifest) {
+        stored = ChecksumManifest::load(dataDirectory);
+    }
+
+    auto run = computeChecksums(dataDirectory, stored ? &*stored : nullptr, incremental);
+    auto problems = run.problems;
+    if(!writeManifest) {
+        auto differences = compareChecksums(*stored, run.manifest);
+        problems.insert(problems.end(), differences.begin(), differences.end());
+    }
+    for(auto &problem : problems) {
+        std::cout << problem << std::endl;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Hashed " << static_cast<double>(run.bytesHashed) / 1e9 << " GB in " << run.chunksHashed << " chunks (" << run.chunksReused << " reused from the manifest) in " << run.seconds << "s, " << run.gigabytesPerSecond() << " GB/s." << std::endl;
+    std::cout << digestHex(run.manifest.root()) << " (DATA DIRECTORY)" << std::endl;
+
+    if(!writeManifest) {
+        if(!problems.empty()) {
+            std::cout << "Data directory does not match the checksum manifest." << std::endl;
+            return 1;
+        }
+        std::cout << "Data directory matches the checksum manifest." << std::endl;
+    }
+
+    // An incremental verification moves the manifest forward so that the next run only hashes data appended after this one
+    if(writeManifest || incremental) {
+        run.manifest.save(dataDirectory);
+        std::cout << "Wrote checksum manifest to " << ChecksumManifest::manifestPath(dataDirectory) << std::endl;
+    }
+    return 0;
+}
+
 int main(int argc, char * argv[]) {
     std::string configLocation;
     std::string outputFile;
     std::ofstream out;
     bool runTxIndexCheck = false;
     bool runNestingIndexCheck = false;
+    bool writeManifest = false;
+    bool verifyManifest = false;
+    bool incremental = false;
     std::streambuf *coutbuf = nullptr;
     int endBlock = 0;
 
@@ -387,7 +437,10 @@ int main(int argc, char * argv[]) {
         clipp::value("config file location", configLocation) % "Path to config file",
         (clipp::option("--file", "-f") & clipp::value("output file", outputFile)) % "Write to file instead of std::cout",
         clipp::option("--txindex", "-t").set(runTxIndexCheck).doc("Run tx index check"),
-        clipp::option("--nestingindex", "-n").set(runNestingIndexCheck).doc("Run nesting address index check")
+        clipp::option("--nestingindex", "-n").set(runNestingIndexCheck).doc("Run nesting address index check"),
+        clipp::option("--write-manifest", "-m").set(writeManifest).doc("Hash the data files in chunks and store the checksums in the data directory"),
+        clipp::option("--verify", "-v").set(verifyManifest).doc("Check the data files against the stored checksum manifest"),
+        clipp::option("--incremental", "-i").set(incremental).doc("Only hash data that changed since the stored checksum manifest was written")
     );
 
     auto res = parse(argc, argv, cli);
@@ -410,41 +463,46 @@ int main(int argc, char * argv[]) {
 
     std::cout << "Chain contains " << chain.size() << " blocks, " << chain.getAccess().getChain().txCount() << " txes, " << chain.getAccess().getChain().inputCount() << " inputs, " << chain.getAccess().getChain().outputCount() << " outputs." << std::endl;
 
+    if(writeManifest || verifyManifest) {
+        auto result = run_chunked_checksums(dataAccess.config.chainConfig.dataDirectory.str(), writeManifest, incremental);
+        if((!outputFile.empty()) && (coutbuf != nullptr)) {
+            std::cout.rdbuf(coutbuf);
+            out.close();
+        }
+        return result;
+    }
+
+    // The checksums are independent of each other, compute them concurrently and print them in a fixed order
+    auto block_hash = std::async(std::launch::async, [&]() { return compute_block_hash(chainAccess); });
+    auto txdata_hash = std::async(std::launch::async, [&]() { return compute_txdata_hash(chainAccess); });
+    auto additional_data_hash = std::async(std::launch::async, [&]() { return compute_additional_data_hash(dataAccess); });
+    auto scripthash_hash = std::async(std::launch::async, [&]() { return compute_scriptdata_hash<DedupAddressType::SCRIPTHASH>(dataAccess); });
+    auto pubkey_hash = std::async(std::launch::async, [&]() { return compute_scriptdata_hash<DedupAddressType::PUBKEY>(dataAccess); });
+    auto multisig_hash = std::async(std::launch::async, [&]() { return compute_scriptdata_hash<DedupAddressType::MULTISIG>(dataAccess); });
+    auto nulldata_hash = std::async(std::launch::async, [&]() { return compute_scriptdata_hash<DedupAddressType::NULL_DATA>(dataAccess); });
+    auto witnessunknown_hash = std::async(std::launch::async, [&]() { return compute_scriptdata_hash<DedupAddressType::WITNESS_UNKNOWN>(dataAccess); });
+    auto nonstandard_hash = std::async(std::launch::async, [&]() { return compute_scriptdata_hash<DedupAddressType::NONSTANDARD>(dataAccess); });
+    auto hashindex_addressrange_hash = std::async(std::launch::async, [&]() { return compute_hashindex_addressrange_hash(dataAccess); });
+
     std::cout << std::endl << "Blocks:" << std::endl;
-    auto block_hash = compute_block_hash(chainAccess);
-    std::cout << block_hash.GetHex() << " (BLOCKS)" <<  std::endl;
+    std::cout << block_hash.get().GetHex() << " (BLOCKS)" <<  std::endl;
 
     std::cout << std::endl << "Transactions:" << std::endl;
-    auto txdata_hash = compute_txdata_hash(chainAccess);
-    std::cout << txdata_hash.GetHex() << " (TXES)" << std::endl;
+    std::cout << txdata_hash.get().GetHex() << " (TXES)" << std::endl;
 
     std::cout << std::endl << "Additional data:" << std::endl;
-    auto additional_data_hash = compute_additional_data_hash(dataAccess);
-    std::cout << additional_data_hash.GetHex() << " (ADDITIONAL)" <<  std::endl;
+    std::cout << additional_data_hash.get().GetHex() << " (ADDITIONAL)" <<  std::endl;
 
     std::cout << std::endl << "Scripts:" << std::endl;
-
-    auto scripthash_hash = compute_scriptdata_hash<DedupAddressType::SCRIPTHASH>(dataAccess);
-    std::cout << scripthash_hash.GetHex() <<  " (SCRIPTHASH)" << std::endl;
-
-    auto pubkey_hash = compute_scriptdata_hash<DedupAddressType::PUBKEY>(dataAccess);
-    std::cout << pubkey_hash.GetHex() <<  " (PUBKEY)" << std::endl;
-
-    auto multisig_hash = compute_scriptdata_hash<DedupAddressType::MULTISIG>(dataAccess);
-    std::cout << multisig_hash.GetHex() <<  " (MULTISIG)" << std::endl;
-
-    auto nulldata_hash = compute_scriptdata_hash<DedupAddressType::NULL_DATA>(dataAccess);
-    std::cout << nulldata_hash.GetHex() <<  " (NULL_DATA)" << std::endl;
-
-    auto witnessunknown_hash = compute_scriptdata_hash<DedupAddressType::WITNESS_UNKNOWN>(dataAccess);
-    std::cout << witnessunknown_hash.GetHex() <<  " (WITNESS_UNKNOWN)" << std::endl;
-
-    auto nonstandard_hash = compute_scriptdata_hash<DedupAddressType::NONSTANDARD>(dataAccess);
-    std::cout << nonstandard_hash.GetHex() <<  " (NONSTANDARD)" << std::endl;
+    std::cout << scripthash_hash.get().GetHex() <<  " (SCRIPTHASH)" << std::endl;
+    std::cout << pubkey_hash.get().GetHex() <<  " (PUBKEY)" << std::endl;
+    std::cout << multisig_hash.get().GetHex() <<  " (MULTISIG)" << std::endl;
+    std::cout << nulldata_hash.get().GetHex() <<  " (NULL_DATA)" << std::endl;
+    std::cout << witnessunknown_hash.get().GetHex() <<  " (WITNESS_UNKNOWN)" << std::endl;
+    std::cout << nonstandard_hash.get().GetHex() <<  " (NONSTANDARD)" << std::endl;
 
     std::cout << std::endl << "Hash index:" << std::endl;
-    auto hashindex_addressrange_hash = compute_hashindex_addressrange_hash(dataAccess);
-    std::cout << hashindex_addressrange_hash.GetHex() << " (ADDRESSINDEX)" <<  std::endl;
+    std::cout << hashindex_addressrange_hash.get().GetHex() << " (ADDRESSINDEX)" <<  std::endl;
 
     if(runTxIndexCheck) {
         std::cout << std::endl << "Index: transaction hash->transaction index:" << std::endl;
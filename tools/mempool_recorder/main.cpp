@@ -9,11 +9,15 @@
 #define BLOCKSCI_WITHOUT_SINGLETON
 
 #include "file_writer.hpp"
+#include "mempool_store_writer.hpp"
+#include "notification_subscriber.hpp"
+#include "rpc_client.hpp"
 
 #include <blocksci/chain/blockchain.hpp>
 #include <blocksci/chain/block.hpp>
 
 #include <internal/bitcoin_uint256_hex.hpp>
+#include <internal/chain_configuration.hpp>
 #include <internal/data_access.hpp>
 #include <internal/mempool_index.hpp>
 
@@ -25,13 +29,19 @@
 
 #include <range/v3/range_for.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <ctime>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <future>
+#include <memory>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <csignal>
 
@@ -46,6 +56,69 @@ void term(int)
     done = 1;
 }
 
+// Version of the file in which the recorder keeps the transactions and blocks it observed across restarts
+static constexpr uint32_t recorderStateVersion = 2;
+
+template <typename T>
+void writeValue(std::ostream &file, const T &value) {
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+T readValue(std::istream &file) {
+    T value{};
+    file.read(reinterpret_cast<char *>(&value), sizeof(value));
+    return value;
+}
+
+// Outpoints spent by a serialized transaction, each as the 32 byte hash followed by the 4 byte output index
+std::vector<std::string> spentOutpoints(const std::string &rawTxHex) {
+    std::string raw;
+    raw.reserve(rawTxHex.size() / 2);
+    for (size_t i = 0; i + 1 < rawTxHex.size(); i += 2) {
+        raw += static_cast<char>(std::stoi(rawTxHex.substr(i, 2), nullptr, 16));
+    }
+    size_t pos = 4;
+    auto readVarInt = [&]() -> uint64_t {
+        if (pos >= raw.size()) {
+            throw std::runtime_error("Truncated transaction");
+        }
+        auto first = static_cast<uint8_t>(raw[pos++]);
+        size_t length = first < 0xfd ? 0 : (first == 0xfd ? 2 : (first == 0xfe ? 4 : 8));
+        if (length == 0) {
+            return first;
+        }
+        if (pos + length > raw.size()) {
+            throw std::runtime_error("Truncated transaction");
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < length; i++) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(raw[pos + i])) << (8 * i);
+        }
+        pos += length;
+        return value;
+    };
+    // Segwit transactions have a zero marker and a non-zero flag in place of the input count
+    if (raw.size() > 5 && raw[4] == 0 && raw[5] != 0) {
+        pos = 6;
+    }
+    std::vector<std::string> outpoints;
+    try {
+        auto inputCount = readVarInt();
+        for (uint64_t i = 0; i < inputCount; i++) {
+            if (pos + 36 > raw.size()) {
+                throw std::runtime_error("Truncated transaction");
+            }
+            outpoints.push_back(raw.substr(pos, 36));
+            pos += 36;
+            pos += readVarInt() + 4;
+        }
+    } catch (const std::runtime_error &) {
+        outpoints.clear();
+    }
+    return outpoints;
+}
+
 int initializeRecordingFile(Blockchain &chain) {
     auto mempoolDir = chain.getAccess().config.mempoolDirectory();
     if (!mempoolDir.exists()){
@@ -71,16 +144,45 @@ struct MempoolFiles {
     {}
 };
 
+// Fee rate and serialization of a transaction in the mempool of the node
+struct MempoolTxData {
+    bool found = false;
+    uint64_t feeRate = 0;
+    std::string rawTxHex;
+};
+
 class SaferBitcoinApi {
     std::string username;
     std::string password;
     std::string address;
     int port;
     BitcoinAPI bitcoinAPI;
+    BatchRPCClient batchClient;
+    
+    static blocksci::ChainRPCConfiguration rpcConfiguration(const std::string &username, const std::string &password, const std::string &address, int port) {
+        blocksci::ChainRPCConfiguration config;
+        config.username = username;
+        config.password = password;
+        config.address = address;
+        config.port = port;
+        return config;
+    }
+    
+    // Fee rate of a mempool entry in satoshi per 1000 virtual bytes
+    static uint64_t feeRate(const nlohmann::json &entry) {
+        auto fee = entry.contains("fees") ? entry["fees"]["base"].get<double>() : entry["fee"].get<double>();
+        auto size = entry.contains("vsize") ? entry["vsize"].get<uint64_t>() : entry["size"].get<uint64_t>();
+        if (size == 0) {
+            return 0;
+        }
+        auto satoshis = static_cast<uint64_t>(std::llround(fee * 1e8));
+        return satoshis * 1000 / size;
+    }
     
 public:
     SaferBitcoinApi(std::string username_, std::string password_, std::string address_, int port_) :
-    username(std::move(username_)), password(std::move(password_)), address(std::move(address_)), port(port_), bitcoinAPI(username, password, address, port) {}
+    username(std::move(username_)), password(std::move(password_)), address(std::move(address_)), port(port_), bitcoinAPI(username, password, address, port),
+    batchClient(rpcConfiguration(username, password, address, port)) {}
     
     std::vector<chaintip_t> getchaintips() {
         return bitcoinAPI.getchaintips();
@@ -97,25 +199,203 @@ public:
     std::vector<std::string> getrawmempool() {
         return bitcoinAPI.getrawmempool();
     }
+    
+    // Fetches the mempool entries and serializations of the transactions with one batch request each. Transactions
+    // that already left the mempool again are not found.
+    std::vector<MempoolTxData> getmempooltxes(const std::vector<std::string> &txids) {
+        std::vector<nlohmann::json> entryParams;
+        std::vector<nlohmann::json> rawTxParams;
+        entryParams.reserve(txids.size());
+        rawTxParams.reserve(txids.size());
+        for (auto &txid : txids) {
+            entryParams.push_back(nlohmann::json::array({txid}));
+            rawTxParams.push_back(nlohmann::json::array({txid, 0}));
+        }
+        auto entries = batchClient.batchAllowingErrors("getmempoolentry", entryParams);
+        auto rawTxes = batchClient.batchAllowingErrors("getrawtransaction", rawTxParams);
+        std::vector<MempoolTxData> txes(txids.size());
+        for (size_t i = 0; i < txids.size(); i++) {
+            if (entries[i].is_object() && rawTxes[i].is_string()) {
+                txes[i].found = true;
+                txes[i].feeRate = feeRate(entries[i]);
+                txes[i].rawTxHex = rawTxes[i].get<std::string>();
+            }
+        }
+        return txes;
+    }
+};
+
+// What the recorder knows about a transaction until the block containing it has been recorded
+struct MempoolEntry {
+    time_t time;
+    uint64_t feeRate = 0;
+    int64_t removed = 0;
+    uint32_t replacedCount = 0;
+    bool inMempool = true;
+    
+    explicit MempoolEntry(time_t time_) : time(time_) {}
+};
+
+// Transaction that entered the mempool and whose fee rate and inputs still have to be fetched from the node
+struct PendingTx {
+    blocksci::uint256 txHash;
+    time_t time;
+    bool firstSeen;
+    // Announced by a hashtx notification, which the node also publishes for every transaction of a new block, so it
+    // only counts as an arrival if the node still has the transaction in its mempool
+    bool hint;
 };
 
 class MempoolRecorder {
     blocksci::Blockchain chain;
     blocksci::BlockHeight lastHeight;
-    std::unordered_map<blocksci::uint256, MempoolRecord, std::hash<blocksci::uint256>> mempool;
+    std::unordered_map<blocksci::uint256, MempoolEntry, std::hash<blocksci::uint256>> mempool;
     SaferBitcoinApi &bitcoinAPI;
     
     MempoolFiles files;
-    std::unordered_map<std::string, std::pair<BlockRecord, int>> blocksSeen;
+    MempoolStoreWriter store;
+    
+    // Transaction spending each outpoint in the mempool, used to detect replacements
+    std::unordered_map<std::string, blocksci::uint256> outpointSpenders;
+    
+    // Transactions that disappeared from a poll, with the time and node height at which they disappeared. Unless
+    // they were mined in a block up to that height, they were removed from the mempool. Removals announced by a
+    // notification have a height of -1.
+    std::unordered_map<blocksci::uint256, std::pair<time_t, int>, std::hash<blocksci::uint256>> pendingRemovals;
+    std::unordered_map<blocksci::uint256, std::pair<BlockRecord, int>, std::hash<blocksci::uint256>> blocksSeen;
+    
+    // Transactions whose arrival is recorded once their details were fetched in a batch
+    std::vector<PendingTx> pendingTxes;
+    
+    // Transaction hashes returned by the previous poll, only hashes that are not contained in it need to be parsed
+    std::unordered_set<std::string> lastRawMempool;
+    
+    // Sequence number of the last notification of every topic, used to detect notifications that were dropped
+    std::unordered_map<std::string, uint32_t> lastSequences;
     
     static constexpr int heightCutoff = 1000;
+    
+    filesystem::path statePath() {
+        return chain.getAccess().config.mempoolDirectory()/"recorder_state.dat";
+    }
+    
+    void writeEvent(MempoolEventType::Enum type, time_t time, const blocksci::uint256 &txHash, const blocksci::uint256 &otherTxHash, uint64_t feeRate) {
+        store.writeEvent(MempoolEvent{static_cast<int64_t>(time), txHash, otherTxHash, feeRate, type, 0});
+    }
+    
+    void addTx(const blocksci::uint256 &txHash, time_t time) {
+        // Keeps the time at which the transaction was seen first
+        auto inserted = mempool.emplace(txHash, MempoolEntry{time});
+        auto &entry = inserted.first->second;
+        if (!inserted.second && entry.inMempool) {
+            return;
+        }
+        entry.inMempool = true;
+        pendingRemovals.erase(txHash);
+        // Transactions that were already in the mempool when the recorder started are not queried to keep startup fast
+        if (time <= 1) {
+            return;
+        }
+        pendingTxes.push_back(PendingTx{txHash, time, inserted.second, false});
+    }
+    
+    // Queues a transaction from a hashtx notification, which is only added to the mempool once the node confirms it
+    void addTxHint(const blocksci::uint256 &txHash, time_t time) {
+        auto it = mempool.find(txHash);
+        if (it != mempool.end() && it->second.inMempool) {
+            return;
+        }
+        pendingTxes.push_back(PendingTx{txHash, time, false, true});
+    }
+    
+    // Fetches the fee rates and inputs of the pending transactions in one batch and records their arrival, together
+    // with the transactions they replaced
+    void recordPendingTxes() {
+        if (pendingTxes.empty()) {
+            return;
+        }
+        std::vector<std::string> txids;
+        txids.reserve(pendingTxes.size());
+        for (auto &pending : pendingTxes) {
+            txids.push_back(pending.txHash.GetHex());
+        }
+        std::vector<MempoolTxData> txes;
+        try {
+            txes = bitcoinAPI.getmempooltxes(txids);
+        } catch (std::exception &e) {
+            // The pending transactions are fetched again with the next batch
+            std::cerr << "Failed to fetch mempool transactions with error: " << e.what() << std::endl;
+            return;
+        }
+        
+        for (size_t i = 0; i < pendingTxes.size(); i++) {
+            auto &txHash = pendingTxes[i].txHash;
+            auto time = pendingTxes[i].time;
+            // Transactions that already left the mempool again have no fee rate to record. Hints are dropped, this
+            // also filters out the coinbase and the other transactions of a new block.
+            if (!txes[i].found) {
+                continue;
+            }
+            auto firstSeen = pendingTxes[i].firstSeen;
+            if (pendingTxes[i].hint) {
+                auto inserted = mempool.emplace(txHash, MempoolEntry{time});
+                if (!inserted.second && inserted.first->second.inMempool) {
+                    continue;
+                }
+                inserted.first->second.inMempool = true;
+                pendingRemovals.erase(txHash);
+                firstSeen = inserted.second;
+            }
+            auto feeRate = txes[i].feeRate;
+            auto outpoints = spentOutpoints(txes[i].rawTxHex);
+            auto entry = mempool.find(txHash);
+            if (entry != mempool.end() && firstSeen) {
+                entry->second.feeRate = feeRate;
+            }
+            writeEvent(MempoolEventType::Entered, time, txHash, blocksci::uint256{}, feeRate);
+            
+            std::unordered_set<blocksci::uint256, std::hash<blocksci::uint256>> replaced;
+            for (auto &outpoint : outpoints) {
+                auto spender = outpointSpenders.find(outpoint);
+                if (spender != outpointSpenders.end()) {
+                    if (spender->second != txHash && replaced.insert(spender->second).second) {
+                        auto replacedEntry = mempool.find(spender->second);
+                        if (replacedEntry != mempool.end() && replacedEntry->second.inMempool) {
+                            replacedEntry->second.inMempool = false;
+                            replacedEntry->second.removed = time;
+                        }
+                        writeEvent(MempoolEventType::Replaced, time, spender->second, txHash, feeRate);
+                    }
+                    spender->second = txHash;
+                } else {
+                    outpointSpenders.emplace(outpoint, txHash);
+                }
+            }
+            if (entry != mempool.end()) {
+                entry->second.replacedCount += static_cast<uint32_t>(replaced.size());
+            }
+        }
+        pendingTxes.clear();
+    }
+    
+    // Records that a transaction left the mempool without being mined
+    void removeTx(const blocksci::uint256 &txHash, time_t time) {
+        auto it = mempool.find(txHash);
+        if (it != mempool.end() && it->second.inMempool) {
+            it->second.inMempool = false;
+            it->second.removed = time;
+            writeEvent(MempoolEventType::Removed, time, txHash, blocksci::uint256{}, 0);
+        }
+    }
 
 public:
     MempoolRecorder(const std::string &configLocation, SaferBitcoinApi &bitcoinAPI_) :
     chain(configLocation),
     lastHeight(static_cast<int>(chain.size())),
     bitcoinAPI(bitcoinAPI_),
-    files(chain.getAccess().config.mempoolDirectory(), initializeRecordingFile(chain)) {
+    files(chain.getAccess().config.mempoolDirectory(), initializeRecordingFile(chain)),
+    store(chain.getAccess().config.mempoolDirectory()) {
+        loadState();
         updateBlockTimes(0);
         updateTxTimes(1);
     }
@@ -124,25 +404,38 @@ public:
         auto tips = bitcoinAPI.getchaintips();
         auto currentHeight = bitcoinAPI.getblockcount();
         for(auto &tip : tips) {
-            std::string searchBlock = std::move(tip.hash);
+            auto searchBlock = uint256S(tip.hash);
             int height = tip.height;
             while (height >= std::max(currentHeight - heightCutoff, 0) &&
-                   blocksSeen.insert(std::pair<std::string, std::pair<BlockRecord, int>>(searchBlock, {BlockRecord{time}, height})).second) {
-                searchBlock = bitcoinAPI.getpreviousblockhash(searchBlock);
+                   blocksSeen.insert(std::make_pair(searchBlock, std::make_pair(BlockRecord{time}, height))).second) {
+                searchBlock = uint256S(bitcoinAPI.getpreviousblockhash(searchBlock.GetHex()));
                 height--;
             }
         }
     }
     
+    // Polls the mempool of the node and records the transactions that appeared or disappeared since the previous poll
     void updateTxTimes(time_t time) {
         auto rawMempool = bitcoinAPI.getrawmempool();
+        std::unordered_set<std::string> currentMempool;
+        currentMempool.reserve(rawMempool.size());
         for (auto &txHashString : rawMempool) {
-            auto txHash = uint256S(txHashString);
-            auto it = mempool.find(txHash);
-            if (it == mempool.end()) {
-                mempool[txHash] = {time};
+            if (lastRawMempool.find(txHashString) == lastRawMempool.end()) {
+                addTx(uint256S(txHashString), time);
+            }
+            currentMempool.insert(std::move(txHashString));
+        }
+        recordPendingTxes();
+        int height = -1;
+        for (auto &txHashString : lastRawMempool) {
+            if (currentMempool.find(txHashString) == currentMempool.end()) {
+                if (height == -1) {
+                    height = bitcoinAPI.getblockcount();
+                }
+                pendingRemovals.emplace(uint256S(txHashString), std::make_pair(time, height));
             }
         }
+        lastRawMempool = std::move(currentMempool);
     }
 
     // Update our view of the mempool
@@ -155,6 +448,122 @@ public:
         }
     }
 
+    void resetNotificationSequences() {
+        lastSequences.clear();
+    }
+    
+    // Records transactions and blocks announced by the node. Returns false if notifications were dropped, in which
+    // case the mempool has to be polled to catch up.
+    bool processNotifications(const std::vector<Notification> &notifications) {
+        auto time = system_clock::to_time_t(system_clock::now());
+        bool complete = true;
+        bool newBlock = false;
+        for (auto &notification : notifications) {
+            if (notification.hasSequence) {
+                auto it = lastSequences.find(notification.topic);
+                if (it != lastSequences.end() && notification.sequence != it->second + 1) {
+                    complete = false;
+                }
+                lastSequences[notification.topic] = notification.sequence;
+            }
+            if (notification.topic == "hashtx" && notification.body.size() == 32) {
+                // Hashes are published in the byte order in which they are displayed
+                blocksci::uint256 txHash;
+                std::reverse_copy(notification.body.begin(), notification.body.end(), txHash.begin());
+                addTxHint(txHash, time);
+            } else if (notification.topic == "sequence" && notification.body.size() >= 33) {
+                // Hash followed by a label, A and R for transactions that were added to or removed from the mempool
+                blocksci::uint256 txHash;
+                std::reverse_copy(notification.body.begin(), notification.body.begin() + 32, txHash.begin());
+                auto label = notification.body[32];
+                if (label == 'A') {
+                    addTx(txHash, time);
+                } else if (label == 'R') {
+                    // The node announces the removal of a replaced transaction before the replacement, so the removal
+                    // is only recorded with the next recording if no replacement turned up until then
+                    pendingRemovals.emplace(txHash, std::make_pair(time, -1));
+                }
+            } else if (notification.topic == "hashblock") {
+                newBlock = true;
+            }
+        }
+        recordPendingTxes();
+        if (newBlock) {
+            try {
+                updateBlockTimes(time);
+            } catch (BitcoinException& e){
+                std::cerr << "Failed to update blocks with error: " << e.what() << std::endl;
+            }
+        }
+        return complete;
+    }
+    
+    // Persist the observed transactions and blocks, so that their first-seen times survive a restart of the recorder
+    void saveState() {
+        auto path = statePath().str();
+        auto tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            writeValue(file, recorderStateVersion);
+            writeValue(file, static_cast<uint64_t>(mempool.size()));
+            for (auto &entry : mempool) {
+                file.write(reinterpret_cast<const char *>(entry.first.begin()), 32);
+                writeValue(file, static_cast<int64_t>(entry.second.time));
+                writeValue(file, entry.second.feeRate);
+                writeValue(file, entry.second.removed);
+                writeValue(file, entry.second.replacedCount);
+            }
+            writeValue(file, static_cast<uint64_t>(blocksSeen.size()));
+            for (auto &entry : blocksSeen) {
+                file.write(reinterpret_cast<const char *>(entry.first.begin()), 32);
+                writeValue(file, static_cast<int64_t>(entry.second.first.observationTime));
+                writeValue(file, static_cast<int32_t>(entry.second.second));
+            }
+            if (!file) {
+                print_msg("Failed to write recorder state to " + tempPath);
+                return;
+            }
+        }
+        std::rename(tempPath.c_str(), path.c_str());
+    }
+    
+    void loadState() {
+        std::ifstream file(statePath().str(), std::ios::binary);
+        if (!file) {
+            return;
+        }
+        auto version = readValue<uint32_t>(file);
+        if (version != 1 && version != recorderStateVersion) {
+            print_msg("Ignoring recorder state of an unknown version");
+            return;
+        }
+        auto txCount = readValue<uint64_t>(file);
+        for (uint64_t i = 0; i < txCount && file; i++) {
+            blocksci::uint256 txHash;
+            file.read(reinterpret_cast<char *>(txHash.begin()), 32);
+            MempoolEntry entry{static_cast<time_t>(readValue<int64_t>(file))};
+            if (version >= 2) {
+                entry.feeRate = readValue<uint64_t>(file);
+                entry.removed = readValue<int64_t>(file);
+                entry.replacedCount = readValue<uint32_t>(file);
+            }
+            // Whether the transaction is still in the mempool is found out by the first poll
+            entry.inMempool = false;
+            mempool.emplace(txHash, entry);
+        }
+        auto blockCount = readValue<uint64_t>(file);
+        for (uint64_t i = 0; i < blockCount && file; i++) {
+            blocksci::uint256 blockHash;
+            file.read(reinterpret_cast<char *>(blockHash.begin()), 32);
+            auto time = static_cast<time_t>(readValue<int64_t>(file));
+            auto height = readValue<int32_t>(file);
+            blocksSeen.insert(std::make_pair(blockHash, std::make_pair(BlockRecord{time}, height)));
+        }
+        std::stringstream ss;
+        ss << "Restored " << mempool.size() << " transactions and " << blocksSeen.size() << " blocks from the recorder state.";
+        print_msg(ss.str());
+    }
+    
     // Write timestamps for transactions and blocks that were observed in the mempool
     void recordMempool() {
         // Wait until parser stopped updating the chain
@@ -172,7 +581,7 @@ public:
         for (; lastHeight < blockCount; lastHeight++) {
             auto block = chain[lastHeight];
             time_t time;
-            auto blockIt = blocksSeen.find(block.getHash().GetHex());
+            auto blockIt = blocksSeen.find(block.getHash());
             std::stringstream ss;
             if (blockIt == blocksSeen.end()) {
                 ss << "Block at height " << lastHeight << " hasn't been observed in the network.";
@@ -190,14 +599,28 @@ public:
                 if (it != mempool.end()) {
                     txWithTimestamp += 1;
                     auto &txData = it->second;
-                    files.txTimeFile.write(txData);
+                    files.txTimeFile.write({txData.time});
+                    MempoolTxObservation observation{static_cast<int64_t>(txData.time), txData.feeRate, txData.removed, txData.replacedCount};
+                    store.writeTx(tx.txNum, &observation);
                     mempool.erase(it);
                 } else {
                     files.txTimeFile.write({0});
+                    store.writeTx(tx.txNum, nullptr);
                 }
             }
         }
 
+        // Transactions that disappeared from the mempool and were not mined up to the height at that time were removed
+        for (auto it = pendingRemovals.begin(); it != pendingRemovals.end();) {
+            if (it->second.second < lastHeight) {
+                removeTx(it->first, it->second.first);
+                it = pendingRemovals.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        store.flush();
+        
         if(newBlocks > 0) {
             files.txTimeFile.flush();
             files.blockTimeFile.flush();
@@ -239,6 +662,16 @@ public:
                 }
             }
         }
+        {
+            auto it = outpointSpenders.begin();
+            while (it != outpointSpenders.end()) {
+                if (mempool.find(it->second) == mempool.end()) {
+                    it = outpointSpenders.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
         std::stringstream ss;
         ss << "Removed " << oldBlocks << " old blocks and " << oldTxs << " old transactions.";
         print_msg(ss.str(), true);
@@ -261,12 +694,16 @@ int main(int argc, char * argv[]) {
     memset(&action, 0, sizeof(struct sigaction));
     action.sa_handler = term;
     sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
     
     std::string configFilePathString;
-    auto configFileOption = clipp::value("config file", configFilePathString) % "Path to config file";
+    std::string notificationEndpoint;
+    int pollIntervalMs = 0;
     auto cli = (
                 clipp::value("config file", configFilePathString) % "Path to config file",
-                clipp::option("-v", "--verbose").set(verbose).doc("run in verbose mode")
+                clipp::option("-v", "--verbose").set(verbose).doc("run in verbose mode"),
+                (clipp::option("--zmq") & clipp::value("endpoint", notificationEndpoint)) % "Receive new transactions and blocks from the ZeroMQ notifications of the node (-zmqpubhashtx, -zmqpubhashblock and -zmqpubsequence for removals), eg. tcp://127.0.0.1:28332",
+                (clipp::option("--poll-interval") & clipp::value("milliseconds", pollIntervalMs)) % "Interval at which the mempool of the node is polled, 250 ms by default and 60 s when notifications are received"
                 );
     
     auto res = parse(argc, argv, cli);
@@ -300,19 +737,66 @@ int main(int argc, char * argv[]) {
     
     MempoolRecorder recorder{configFilePath.str(), bitcoinAPI};
     
-    int updateCount = 0;
+    std::unique_ptr<NotificationSubscriber> subscriber;
+    if (!notificationEndpoint.empty()) {
+        subscriber = std::make_unique<NotificationSubscriber>(notificationEndpoint, std::vector<std::string>{"hashtx", "hashblock", "sequence"});
+    }
+    
+    // Without notifications every poll has to catch new transactions, with them polling only repairs missed notifications
+    auto pollInterval = milliseconds(pollIntervalMs > 0 ? pollIntervalMs : 250);
+    auto notifiedPollInterval = milliseconds(pollIntervalMs > 0 ? pollIntervalMs : 60 * 1000);
+    
+    auto now = steady_clock::now();
+    auto nextPoll = now;
+    auto nextConnect = now;
+    auto nextRecord = now + minutes(1);
+    auto nextClear = now + hours(24);
     while(!done) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(250));
-        recorder.updateMempool();
-        updateCount++;
-        if (updateCount % (4 * 60) == 0) { // every minute
+        if (subscriber && !subscriber->isConnected() && steady_clock::now() >= nextConnect) {
+            if (subscriber->connect()) {
+                recorder.print_msg("Subscribed to notifications at " + notificationEndpoint);
+                recorder.resetNotificationSequences();
+                // Catch up on transactions that arrived while no notifications were received
+                nextPoll = steady_clock::now();
+            } else {
+                recorder.print_msg("Failed to subscribe to notifications at " + notificationEndpoint + ", polling the mempool instead", true);
+                nextConnect = steady_clock::now() + seconds(30);
+            }
+        }
+        
+        now = steady_clock::now();
+        auto waitTime = std::min(duration_cast<milliseconds>(std::min({nextPoll, nextRecord, nextClear}) - now), milliseconds(250));
+        waitTime = std::max(waitTime, milliseconds(0));
+        if (subscriber && subscriber->isConnected()) {
+            auto notifications = subscriber->receive(waitTime);
+            if (!recorder.processNotifications(notifications)) {
+                recorder.print_msg("Missed notifications of the node, polling the mempool", true);
+                nextPoll = steady_clock::now();
+            }
+            if (!subscriber->isConnected()) {
+                recorder.print_msg("Lost connection to the notification publisher");
+                nextPoll = steady_clock::now();
+            }
+        } else {
+            std::this_thread::sleep_for(waitTime);
+        }
+        
+        now = steady_clock::now();
+        if (now >= nextPoll) {
+            recorder.updateMempool();
+            nextPoll = now + (subscriber && subscriber->isConnected() ? notifiedPollInterval : pollInterval);
+        }
+        if (now >= nextRecord) {
             recorder.recordMempool();
+            recorder.saveState();
+            nextRecord = now + minutes(1);
         }
-        if (updateCount % (4 * 60 * 60 * 24) == 0) { // once per day
+        if (now >= nextClear) {
             recorder.clearOldMempool();
-            updateCount = 0;
+            nextClear = now + hours(24);
         }
     }
     
+    recorder.saveState();
     std::cout << "Shut down mempool recorder\n";
 }
@@ -0,0 +1,84 @@
+//
+//  mempool_store_writer.cpp
+//  mempool_recorder
+//
+
+#include "mempool_store_writer.hpp"
+
+#include <internal/mempool_index.hpp>
+
+#include <algorithm>
+
+namespace {
+    filesystem::path storeDirectory(const filesystem::path &mempoolDirectory) {
+        auto directory = blocksci::MempoolStore::directoryPath(mempoolDirectory);
+        if (!directory.exists()) {
+            filesystem::create_directory(directory);
+        }
+        return directory;
+    }
+}
+
+MempoolStoreWriter::MempoolStoreWriter(const filesystem::path &mempoolDirectory) :
+segmentFile(storeDirectory(mempoolDirectory)/"segments"),
+txIndexFile(blocksci::MempoolStore::columnPath(mempoolDirectory, "tx_index")),
+firstSeenFile(blocksci::MempoolStore::columnPath(mempoolDirectory, "first_seen")),
+feeRateFile(blocksci::MempoolStore::columnPath(mempoolDirectory, "fee_rate")),
+removedFile(blocksci::MempoolStore::columnPath(mempoolDirectory, "removed")),
+replacedCountFile(blocksci::MempoolStore::columnPath(mempoolDirectory, "replaced_count")),
+eventFile(blocksci::MempoolStore::columnPath(mempoolDirectory, "events")) {
+    auto segmentCount = static_cast<uint32_t>(segmentFile.size());
+    segmentSlots.reserve(segmentCount);
+    for (uint32_t i = 0; i < segmentCount; i++) {
+        segmentSlots.push_back(segmentFile.read(i));
+    }
+    if (!segmentSlots.empty()) {
+        slotCount = *std::max_element(segmentSlots.begin(), segmentSlots.end());
+    }
+}
+
+uint64_t MempoolStoreWriter::rowFor(uint32_t txNum) {
+    auto segment = txNum / blocksci::mempoolSegmentSize;
+    if (segment >= segmentSlots.size()) {
+        segmentSlots.resize(segment + 1, 0);
+        segmentFile.expandToFit(segment + 1);
+    }
+    auto &slot = segmentSlots[segment];
+    if (slot == 0) {
+        // Columns are grown before the segment is registered, so readers never see a slot without rows
+        slot = ++slotCount;
+        auto rowCount = slotCount * blocksci::mempoolSegmentSize;
+        txIndexFile.expandToFit(rowCount);
+        firstSeenFile.expandToFit(rowCount);
+        feeRateFile.expandToFit(rowCount);
+        removedFile.expandToFit(rowCount);
+        replacedCountFile.expandToFit(rowCount);
+        segmentFile.updateData(segment, 0, slot);
+    }
+    return static_cast<uint64_t>(slot - 1) * blocksci::mempoolSegmentSize + txNum % blocksci::mempoolSegmentSize;
+}
+
+void MempoolStoreWriter::writeTx(uint32_t txNum, const MempoolTxObservation *observation) {
+    auto row = static_cast<uint32_t>(rowFor(txNum));
+    txIndexFile.updateData(row, 0, txNum);
+    if (observation != nullptr) {
+        firstSeenFile.updateData(row, 0, observation->firstSeen);
+        feeRateFile.updateData(row, 0, observation->feeRate);
+        removedFile.updateData(row, 0, observation->removed);
+        replacedCountFile.updateData(row, 0, observation->replacedCount);
+    }
+}
+
+void MempoolStoreWriter::writeEvent(const blocksci::MempoolEvent &event) {
+    eventFile.write(event);
+}
+
+void MempoolStoreWriter::flush() {
+    segmentFile.flush();
+    txIndexFile.flush();
+    firstSeenFile.flush();
+    feeRateFile.flush();
+    removedFile.flush();
+    replacedCountFile.flush();
+    eventFile.flush();
+}
@@ -0,0 +1,57 @@
+//
+//  mempool_store_writer.hpp
+//  mempool_recorder
+//
+
+#ifndef mempool_store_writer_hpp
+#define mempool_store_writer_hpp
+
+#include "file_writer.hpp"
+
+#include <blocksci/chain/mempool.hpp>
+
+#include <wjfilesystem/path.h>
+
+#include <cstdint>
+#include <vector>
+
+/** Observations of a mined transaction that are stored in the columns of the mempool store */
+struct MempoolTxObservation {
+    int64_t firstSeen;
+    uint64_t feeRate;
+    int64_t removed;
+    uint32_t replacedCount;
+};
+
+/** Writes the columnar mempool store that is read by blocksci::MempoolStore
+ *
+ * Rows are only written once, when the block containing the transaction has been recorded. Events are appended to
+ * the event log as they happen.
+ */
+class MempoolStoreWriter {
+    FixedSizeFileWriter<uint32_t> segmentFile;
+    FixedSizeFileWriter<uint32_t> txIndexFile;
+    FixedSizeFileWriter<int64_t> firstSeenFile;
+    FixedSizeFileWriter<uint64_t> feeRateFile;
+    FixedSizeFileWriter<int64_t> removedFile;
+    FixedSizeFileWriter<uint32_t> replacedCountFile;
+    FixedSizeFileWriter<blocksci::MempoolEvent> eventFile;
+    
+    // Slot + 1 of every segment, mirrors the segment table on disk
+    std::vector<uint32_t> segmentSlots;
+    uint32_t slotCount = 0;
+    
+    uint64_t rowFor(uint32_t txNum);
+
+public:
+    explicit MempoolStoreWriter(const filesystem::path &mempoolDirectory);
+    
+    /** Writes the row of a transaction in the chain, observation is null if the transaction was not observed */
+    void writeTx(uint32_t txNum, const MempoolTxObservation *observation);
+    
+    void writeEvent(const blocksci::MempoolEvent &event);
+    
+    void flush();
+};
+
+#endif /* mempool_store_writer_hpp */
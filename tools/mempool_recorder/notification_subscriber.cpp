@@ -0,0 +1,255 @@
+//
+//  notification_subscriber.cpp
+//  mempool_recorder
+//
+
+#include "notification_subscriber.hpp"
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+#ifdef MSG_NOSIGNAL
+    constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int sendFlags = 0;
+#endif
+
+    constexpr int handshakeTimeoutMs = 5000;
+    
+    constexpr uint8_t moreFlag = 0x01;
+    constexpr uint8_t longFlag = 0x02;
+    constexpr uint8_t commandFlag = 0x04;
+    
+    class ProtocolError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+    
+    std::string frame(uint8_t flags, const std::string &body) {
+        std::string data;
+        if (body.size() > 255) {
+            data += static_cast<char>(flags | longFlag);
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                data += static_cast<char>((static_cast<uint64_t>(body.size()) >> shift) & 0xff);
+            }
+        } else {
+            data += static_cast<char>(flags);
+            data += static_cast<char>(body.size());
+        }
+        return data + body;
+    }
+    
+    // Greeting of ZMTP 3.0: signature, version and the NULL mechanism padded to 20 bytes, followed by as-server and filler
+    std::string greeting() {
+        std::string data(64, '\0');
+        data[0] = '\xff';
+        data[9] = '\x7f';
+        data[10] = 3;
+        data[11] = 0;
+        std::memcpy(&data[12], "NULL", 4);
+        return data;
+    }
+    
+    std::string readyCommand() {
+        std::string socketType = "SUB";
+        std::string body = "\x05READY";
+        body += static_cast<char>(11);
+        body += "Socket-Type";
+        body += std::string(3, '\0');
+        body += static_cast<char>(socketType.size());
+        body += socketType;
+        return frame(commandFlag, body);
+    }
+}
+
+NotificationSubscriber::NotificationSubscriber(const std::string &endpoint, std::vector<std::string> topics_) : topics(std::move(topics_)) {
+    std::string prefix = "tcp://";
+    auto portSeparator = endpoint.rfind(':');
+    if (endpoint.compare(0, prefix.size(), prefix) != 0 || portSeparator == std::string::npos || portSeparator < prefix.size()) {
+        throw std::runtime_error("Invalid notification endpoint " + endpoint + ", expected tcp://<address>:<port>");
+    }
+    host = endpoint.substr(prefix.size(), portSeparator - prefix.size());
+    port = endpoint.substr(portSeparator + 1);
+}
+
+NotificationSubscriber::~NotificationSubscriber() {
+    disconnect();
+}
+
+bool NotificationSubscriber::connect() {
+    disconnect();
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+        return false;
+    }
+    for (auto address = addresses; address != nullptr; address = address->ai_next) {
+        int fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            socketFd = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(addresses);
+    if (socketFd < 0) {
+        return false;
+    }
+    try {
+        handshake();
+    } catch (const std::runtime_error &) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void NotificationSubscriber::disconnect() {
+    if (socketFd >= 0) {
+        ::close(socketFd);
+        socketFd = -1;
+    }
+    buffer.clear();
+    messageParts.clear();
+}
+
+void NotificationSubscriber::sendAll(const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        auto ret = ::send(socketFd, data.data() + sent, data.size() - sent, sendFlags);
+        if (ret <= 0) {
+            throw ProtocolError("Connection to notification publisher lost");
+        }
+        sent += static_cast<size_t>(ret);
+    }
+}
+
+bool NotificationSubscriber::receiveMore(int timeoutMs) {
+    pollfd pfd{socketFd, POLLIN, 0};
+    auto ready = ::poll(&pfd, 1, timeoutMs);
+    if (ready <= 0) {
+        return false;
+    }
+    char chunk[65536];
+    auto received = ::recv(socketFd, chunk, sizeof(chunk), 0);
+    if (received <= 0) {
+        throw ProtocolError("Connection to notification publisher lost");
+    }
+    buffer.append(chunk, static_cast<size_t>(received));
+    return true;
+}
+
+std::string NotificationSubscriber::receiveExactly(size_t size, int timeoutMs) {
+    while (buffer.size() < size) {
+        if (!receiveMore(timeoutMs)) {
+            throw ProtocolError("Notification publisher did not answer the handshake");
+        }
+    }
+    auto data = buffer.substr(0, size);
+    buffer.erase(0, size);
+    return data;
+}
+
+bool NotificationSubscriber::nextFrame(uint8_t &flags, std::string &data) {
+    if (buffer.size() < 2) {
+        return false;
+    }
+    flags = static_cast<uint8_t>(buffer[0]);
+    uint64_t size = 0;
+    size_t headerSize = 2;
+    if (flags & longFlag) {
+        headerSize = 9;
+        if (buffer.size() < headerSize) {
+            return false;
+        }
+        for (size_t i = 1; i < headerSize; i++) {
+            size = (size << 8) | static_cast<uint8_t>(buffer[i]);
+        }
+    } else {
+        size = static_cast<uint8_t>(buffer[1]);
+    }
+    if (buffer.size() - headerSize < size) {
+        return false;
+    }
+    data = buffer.substr(headerSize, static_cast<size_t>(size));
+    buffer.erase(0, headerSize + static_cast<size_t>(size));
+    return true;
+}
+
+void NotificationSubscriber::handshake() {
+    sendAll(greeting());
+    auto peerGreeting = receiveExactly(64, handshakeTimeoutMs);
+    if (static_cast<uint8_t>(peerGreeting[0]) != 0xff || (static_cast<uint8_t>(peerGreeting[9]) & 1) == 0 || peerGreeting[10] < 3) {
+        throw ProtocolError("Notification publisher does not speak ZMTP 3");
+    }
+    sendAll(readyCommand());
+    
+    // Wait for the READY command of the publisher before subscribing
+    uint8_t flags = 0;
+    std::string command;
+    while (!nextFrame(flags, command)) {
+        if (!receiveMore(handshakeTimeoutMs)) {
+            throw ProtocolError("Notification publisher did not answer the handshake");
+        }
+    }
+    if (!(flags & commandFlag) || command.compare(0, 6, "\x05READY") != 0) {
+        throw ProtocolError("Notification publisher sent an unexpected handshake");
+    }
+    
+    // In ZMTP 3.0 subscriptions are messages starting with 1 followed by the topic prefix
+    for (auto &topic : topics) {
+        sendAll(frame(0, "\x01" + topic));
+    }
+}
+
+std::vector<Notification> NotificationSubscriber::receive(std::chrono::milliseconds timeout) {
+    std::vector<Notification> notifications;
+    if (!isConnected()) {
+        return notifications;
+    }
+    try {
+        if (receiveMore(static_cast<int>(timeout.count()))) {
+            // Collect everything that already arrived without waiting again
+            while (receiveMore(0)) {}
+        }
+        uint8_t flags = 0;
+        std::string data;
+        while (nextFrame(flags, data)) {
+            if (flags & commandFlag) {
+                continue;
+            }
+            messageParts.push_back(std::move(data));
+            if (flags & moreFlag) {
+                continue;
+            }
+            Notification notification;
+            if (messageParts.size() >= 2) {
+                notification.topic = std::move(messageParts[0]);
+                notification.body = std::move(messageParts[1]);
+                if (messageParts.size() >= 3 && messageParts[2].size() == 4) {
+                    auto &sequence = messageParts[2];
+                    for (int i = 3; i >= 0; i--) {
+                        notification.sequence = (notification.sequence << 8) | static_cast<uint8_t>(sequence[static_cast<size_t>(i)]);
+                    }
+                    notification.hasSequence = true;
+                }
+                notifications.push_back(std::move(notification));
+            }
+            messageParts.clear();
+        }
+    } catch (const ProtocolError &) {
+        disconnect();
+    }
+    return notifications;
+}
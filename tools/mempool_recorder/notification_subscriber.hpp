@@ -0,0 +1,68 @@
+//
+//  notification_subscriber.hpp
+//  mempool_recorder
+//
+
+#ifndef notification_subscriber_hpp
+#define notification_subscriber_hpp
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Notification published by the node, eg. the hash of a transaction that entered the mempool */
+struct Notification {
+    std::string topic;
+    std::string body;
+    /** Sequence number of the notification within its topic */
+    uint32_t sequence = 0;
+    bool hasSequence = false;
+};
+
+/** Subscribes to the ZeroMQ notifications of a node (-zmqpubhashtx, -zmqpubhashblock)
+ *
+ * Implements the subscriber side of ZMTP 3.0 with the NULL security mechanism over a TCP connection, which is what
+ * bitcoind uses for its publishers.
+ */
+class NotificationSubscriber {
+    std::string host;
+    std::string port;
+    std::vector<std::string> topics;
+    int socketFd = -1;
+    
+    // Bytes received from the publisher that do not form a complete frame yet
+    std::string buffer;
+    // Frames of the message that is currently received
+    std::vector<std::string> messageParts;
+    
+    void sendAll(const std::string &data);
+    bool receiveMore(int timeoutMs);
+    bool nextFrame(uint8_t &flags, std::string &frame);
+    std::string receiveExactly(size_t size, int timeoutMs);
+    void handshake();
+
+public:
+    /** Endpoint in the format of the node configuration, eg. tcp://127.0.0.1:28332 */
+    NotificationSubscriber(const std::string &endpoint, std::vector<std::string> topics);
+    ~NotificationSubscriber();
+    
+    NotificationSubscriber(const NotificationSubscriber &) = delete;
+    NotificationSubscriber &operator=(const NotificationSubscriber &) = delete;
+    
+    bool isConnected() const {
+        return socketFd >= 0;
+    }
+    
+    /** Connects to the publisher and subscribes to the topics, returns false if the publisher is not reachable */
+    bool connect();
+    void disconnect();
+    
+    /** Waits up to timeout for notifications and returns all that were received completely
+     *
+     * The connection is closed if it broke or the publisher violated the protocol.
+     */
+    std::vector<Notification> receive(std::chrono::milliseconds timeout);
+};
+
+#endif /* notification_subscriber_hpp */
@@ -21,49 +21,30 @@
 #include "output_spend_data.hpp"
 #include "serializable_map.hpp"
 #include "file_writer.hpp"
-
-#ifdef BLOCKSCI_RPC_PARSER
-#include <bitcoinapi/bitcoinapi.h>
-#endif
+#include "raw_transaction_pool.hpp"
+#include "rpc_client.hpp"
 
 #include <boost/lockfree/spsc_queue.hpp>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <future>
 #include <iostream>
 #include <thread>
+#include <tuple>
 #include <list>
-
-std::vector<unsigned char> ParseHex(const char* psz);
+#include <memory>
 
 BlockProcessor::BlockProcessor(uint32_t startingTxCount_, uint64_t startingInputCount, uint64_t startingOutputCount, uint32_t totalTxCount_, blocksci::BlockHeight maxBlockHeight_) : startingTxCount(startingTxCount_), currentTxNum(startingTxCount_), currentInputNum(startingInputCount), currentOutputNum(startingOutputCount), totalTxCount(totalTxCount_), maxBlockHeight(maxBlockHeight_) {
     
 }
 
-std::vector<unsigned char> ParseHex(const char* psz) {
-    // convert hex dump to vector
-    std::vector<unsigned char> vch;
-    while (true) {
-        while (isspace(*psz)) {
-            psz++;
-        }
-        signed char c = blocksci::HexDigit(*psz++);
-        if (c == static_cast<signed char>(-1)) {
-            break;
-        }
-        auto n = static_cast<unsigned char>(c << 4);
-        c = blocksci::HexDigit(*psz++);
-        if (c == static_cast<signed char>(-1)) {
-            break;
-        }
-        n |= c;
-        vch.push_back(n);
-    }
-    return vch;
-}
-
 BlockFileReaderBase::~BlockFileReaderBase() = default;
 
 template <typename ParseTag>
@@ -73,14 +54,43 @@ class BlockFileReader;
 
 template <>
 class BlockFileReader<FileTag> : public BlockFileReaderBase {
-    /** Map of (blkXXXXX.dat file number) -> pair(SafeMemReader for blkXXXXX.dat file, last tx number of this blkXXXXX.dat file) */
-    std::unordered_map<int, std::pair<SafeMemReader, uint32_t>> files;
-
-    /** Map of (blkXXXXX.dat file number) -> (last tx number of this blkXXXXX.dat file) */
-    std::unordered_map<int, uint32_t> lastTxRequired;
+    /** Number of bytes of upcoming blocks for which the OS is asked to read ahead */
+    static constexpr uint64_t readaheadBytes = 128 * 1024 * 1024;
+    
+    /** Number of mapped blkXXXXX.dat files above which files are unmapped even if they are needed again soon */
+    static constexpr size_t maxMappedFiles = 8;
+    
+    struct PlannedBlock {
+        int nFile;
+        unsigned int nDataPos;
+        uint32_t size;
+    };
+    
+    struct MappedFile {
+        SafeMemReader reader;
+        /** Tx number following the last tx read from this file, the mapping must be kept until it left the pipeline */
+        uint32_t txNumAfterLastRead;
+        /** Index of the next planned block stored in this file */
+        size_t nextUse;
+    };
+    
+    /** Map of (blkXXXXX.dat file number) -> mapped file */
+    std::unordered_map<int, MappedFile> files;
+    
+    /** Blocks in the order they will be read, and for each of them the index of the next block stored in the same file */
+    std::vector<PlannedBlock> plan;
+    std::vector<size_t> nextUseOfFile;
+    size_t nextPlannedBlock = 0;
+    
+    /** Planned blocks before this index have been passed to the OS for readahead */
+    size_t readaheadEnd = 0;
+    uint64_t pendingReadaheadBytes = 0;
+    int readaheadFile = -1;
+    int readaheadFd = -1;
 
     const ParserConfiguration<FileTag> &config;
     SafeMemReader *reader = nullptr;
+    int currentFile = -1;
     
     blocksci::BlockHeight currentHeight = 0;
     uint32_t currentTxNum = 0;
@@ -104,15 +114,77 @@ class BlockFileReader<FileTag> : public BlockFileReaderBase {
         }
     }
     
+    void adviseWillNeed(int fileNum, uint64_t offset, uint64_t length) {
+        if (fileNum != readaheadFile) {
+            if (readaheadFd >= 0) {
+                close(readaheadFd);
+            }
+            readaheadFile = fileNum;
+            readaheadFd = open(config.pathForBlockFile(fileNum).str().c_str(), O_RDONLY);
+        }
+        if (readaheadFd < 0) {
+            return;
+        }
+        #if defined(POSIX_FADV_WILLNEED)
+        posix_fadvise(readaheadFd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+        #elif defined(F_RDADVISE)
+        radvisory advice{static_cast<off_t>(offset), static_cast<int>(length)};
+        fcntl(readaheadFd, F_RDADVISE, &advice);
+        #endif
+    }
+    
+    /** Keeps the readahead window a fixed number of bytes ahead of the block that is read next, merging blocks stored next to each other */
+    void extendReadahead() {
+        while (readaheadEnd < plan.size() && pendingReadaheadBytes < readaheadBytes) {
+            auto &first = plan[readaheadEnd];
+            uint64_t rangeStart = first.nDataPos;
+            uint64_t rangeEnd = rangeStart + first.size;
+            pendingReadaheadBytes += first.size;
+            readaheadEnd++;
+            while (readaheadEnd < plan.size() && pendingReadaheadBytes < readaheadBytes) {
+                auto &next = plan[readaheadEnd];
+                // Blocks are preceded by 8 bytes of magic and length
+                if (next.nFile != first.nFile || next.nDataPos < rangeEnd || next.nDataPos > rangeEnd + 8) {
+                    break;
+                }
+                rangeEnd = next.nDataPos + next.size;
+                pendingReadaheadBytes += next.size;
+                readaheadEnd++;
+            }
+            adviseWillNeed(first.nFile, rangeStart, rangeEnd - rangeStart);
+        }
+    }
+    
 public:
-    BlockFileReader(const ParserConfiguration<FileTag> &config_, std::vector<BlockInfo<FileTag>> &blocksToAdd, uint32_t firstTxNum) : config(config_) {
+    BlockFileReader(const ParserConfiguration<FileTag> &config_, std::vector<BlockInfo<FileTag>> &blocksToAdd, uint32_t) : config(config_) {
+        plan.reserve(blocksToAdd.size());
         for (auto &block : blocksToAdd) {
-            firstTxNum += block.nTx;
-            lastTxRequired[block.nFile] = firstTxNum;
+            plan.push_back(PlannedBlock{block.nFile, block.nDataPos, block.size});
+        }
+        nextUseOfFile.resize(plan.size());
+        std::unordered_map<int, size_t> laterUse;
+        for (size_t i = plan.size(); i-- > 0;) {
+            auto it = laterUse.find(plan[i].nFile);
+            nextUseOfFile[i] = it != laterUse.end() ? it->second : plan.size();
+            laterUse[plan[i].nFile] = i;
+        }
+    }
+    
+    ~BlockFileReader() override {
+        if (readaheadFd >= 0) {
+            close(readaheadFd);
         }
     }
     
+    BlockFileReader(const BlockFileReader &) = delete;
+    BlockFileReader &operator=(const BlockFileReader &) = delete;
+    
     void nextBlock(BlockInfo<FileTag> &block, uint32_t firstTxNum) {
+        auto blockIndex = nextPlannedBlock++;
+        assert(blockIndex < plan.size() && plan[blockIndex].nFile == block.nFile && plan[blockIndex].nDataPos == block.nDataPos);
+        pendingReadaheadBytes -= std::min<uint64_t>(pendingReadaheadBytes, block.size);
+        extendReadahead();
+        
         auto fileIt = files.find(block.nFile);
         if (fileIt == files.end()) {
             auto blockPath = config.pathForBlockFile(block.nFile);
@@ -121,9 +193,12 @@ public:
                 ss << "Error: Failed to open block file " << blockPath << "\n";
                 throw std::runtime_error(ss.str());
             }
-            files.insert(std::make_pair(block.nFile, std::make_pair(SafeMemReader(blockPath.str()), lastTxRequired[block.nFile])));
+            fileIt = files.emplace(block.nFile, MappedFile{SafeMemReader(blockPath.str()), 0, 0}).first;
         }
-        reader = &files.at(block.nFile).first;
+        fileIt->second.txNumAfterLastRead = firstTxNum + block.nTx;
+        fileIt->second.nextUse = nextUseOfFile[blockIndex];
+        currentFile = block.nFile;
+        reader = &fileIt->second.reader;
         reader->reset(block.nDataPos);
         reader->advance(sizeof(CBlockHeader));
         reader->readVariableLengthInteger();
@@ -140,9 +215,14 @@ public:
     }
     
     void receivedFinishedTx(RawTransaction *tx) override {
+        // Files are unmapped once all transactions read from them left the pipeline, unless they are read again
+        // within the readahead window and the number of mapped files is below the limit
         auto it = files.begin();
         while (it != files.end()) {
-            if (it->second.second < tx->txNum) {
+            auto &file = it->second;
+            bool finished = it->first != currentFile && file.txNumAfterLastRead < tx->txNum;
+            bool neededSoon = file.nextUse < readaheadEnd;
+            if (finished && (!neededSoon || files.size() > maxMappedFiles)) {
                 it = files.erase(it);
             } else {
                 ++it;
@@ -157,43 +237,71 @@ public:
 
 template <>
 class BlockFileReader<RPCTag> : public BlockFileReaderBase {
-    BitcoinAPI bapi;
+    bool rawBlocks;
+    BlockFetcher fetcher;
+    
+    /** List of pairs(fetched block, tx number following the last tx of the block). Transactions read from raw blocks point into the block data,
+     * so it is kept until all transactions of the block have left the pipeline */
+    std::list<std::pair<FetchedBlock, uint32_t>> blocks;
+    
+    std::unique_ptr<SafeMemReader> reader;
     
-    uint32_t firstTxNum = 0;
-    uint32_t currentTxOffset = 0;
     blocksci::BlockHeight currentHeight = 0;
-    BlockInfo<RPCTag> block;
+    uint32_t currentTxNum = 0;
+    uint32_t currentTxOffset = 0;
+    
+    static std::vector<blocksci::uint256> blockHashes(const std::vector<BlockInfo<RPCTag>> &blocksToAdd) {
+        std::vector<blocksci::uint256> hashes;
+        hashes.reserve(blocksToAdd.size());
+        for (auto &block : blocksToAdd) {
+            hashes.push_back(block.hash);
+        }
+        return hashes;
+    }
     
     template<bool shouldAdvance>
     void nextTxImp(RawTransaction *tx, bool isSegwit) {
-        if (currentHeight == 0) {
-            tx->outputs.clear();
-            tx->outputs.reserve(1);
-            
-            auto scriptPubKey = blocksci::CScript() << ParseHex("040184a11fa689ad5123690c81a3a49c8f13f8d45bac857fbcbc8bc4a8ead3eb4b1ff4d4614fa18dce611aaf1f471216fe1b51851b4acf21b17fc45171ac7b13af") << blocksci::OP_CHECKSIG;
-            std::vector<unsigned char> scriptBytes(scriptPubKey.begin(), scriptPubKey.end());
-            //Set the desired initial block reward
-            tx->outputs.emplace_back(scriptBytes, 50l * 100000000l);
-            tx->hash = blocksci::uint256S("0100000000000000000000000000000000000000000000000000000000000000");
-            tx->blockHeight = blocksci::BlockHeight{0};
-            tx->txNum = 0;
-            tx->isSegwit = false;
+        if (rawBlocks) {
+            try {
+                auto firstTxOffset = reader->offset();
+                tx->load(*reader, currentTxNum, currentHeight, isSegwit);
+                if (!shouldAdvance) {
+                    reader->reset(firstTxOffset);
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "Failed to load tx"
+                << " from block" << currentHeight
+                << " at offset " << reader->offset()
+                << ".\n" << e.what();
+                throw;
+            }
         } else {
-            auto txinfo = bapi.getrawtransaction(block.tx[currentTxOffset], 1);
-            tx->load(txinfo, firstTxNum + currentTxOffset, currentHeight, isSegwit);
+            tx->load(blocks.back().first.decoded.at("tx")[currentTxOffset], currentTxNum, currentHeight, isSegwit);
         }
         if (shouldAdvance) {
+            currentTxNum++;
             currentTxOffset++;
         }
     }
     
 public:
-    BlockFileReader(const ParserConfiguration<RPCTag> &config, std::vector<BlockInfo<RPCTag>> &, uint32_t) : bapi(config.createBitcoinAPI()) {}
+    BlockFileReader(const ParserConfiguration<RPCTag> &config, std::vector<BlockInfo<RPCTag>> &blocksToAdd, uint32_t) : rawBlocks(config.config.rawBlocks), fetcher(config.config, blockHashes(blocksToAdd), config.config.rawBlocks) {}
     
-    void nextBlock(BlockInfo<RPCTag> &block_, uint32_t txNum) {
-        block = block_;
+    void nextBlock(BlockInfo<RPCTag> &block, uint32_t firstTxNum) {
+        if (!rawBlocks) {
+            // Decoded transactions are copied when they are loaded, so only the current block is needed
+            blocks.clear();
+        }
+        blocks.emplace_back(fetcher.next(), firstTxNum + block.nTx);
+        if (rawBlocks) {
+            auto &data = blocks.back().first.data;
+            reader = std::make_unique<SafeMemReader>(block.hash.GetHex(), data.data(), data.data() + data.size());
+            // The serialized block has the same layout as in a blk file, skip the header and transaction count
+            reader->advance(sizeof(CBlockHeader));
+            reader->readVariableLengthInteger();
+        }
         currentHeight = block.height;
-        firstTxNum = txNum;
+        currentTxNum = firstTxNum;
         currentTxOffset = 0;
     }
     
@@ -205,7 +313,11 @@ public:
         nextTxImp<false>(tx, isSegwit);
     }
     
-    void receivedFinishedTx(RawTransaction *) override {}
+    void receivedFinishedTx(RawTransaction *tx) override {
+        while (blocks.size() > 1 && blocks.front().second < tx->txNum) {
+            blocks.pop_front();
+        }
+    }
 };
 
 #endif
@@ -225,15 +337,12 @@ blocksci::RawBlock readNewBlock(uint32_t firstTxNum, uint64_t firstInputNum, uin
     for (uint32_t j = 0; j < block.nTx; j++) {
         RawTransaction *tx = nullptr;
 
-        // Try to re-use memory from transactions that have passed the entire queue
-        if (!loadFunc(tx)) {
-            // No tx is currently available in finished_transaction_queue -> allocate new memory
-            tx = new RawTransaction();
-        } else {
-            // loadFunc(tx) set the pointer tx to memory from a finished RawTransaction -> reuse that space
-            assert(tx);
+        // Re-use memory from transactions that have passed the entire queue, loadFunc allocates a new transaction if none is available
+        if (loadFunc(tx)) {
+            // tx points to a finished RawTransaction -> all transactions up to its txNum have left the pipeline
             fileReader.receivedFinishedTx(tx);
         }
+        assert(tx);
 
         // Read next transaction into tx
         fileReader.nextTx(tx, isSegwit);
@@ -443,38 +552,138 @@ std::vector<std::function<void(RawTransaction &tx)>> SerializeAddressesStep::ste
     }};
 }
 
+namespace {
+    // Splits the transaction range into partitions holding roughly the same number of updates, using the update
+    // distribution of a sample. Returns the first transaction number of every partition after the first one.
+    std::vector<uint32_t> partitionBoundaries(const OutputLinkData *updates, size_t updateCount, size_t partitionCount) {
+        constexpr size_t samplesPerPartition = 64;
+        auto sampleCount = std::min(updateCount, partitionCount * samplesPerPartition);
+        std::vector<uint32_t> sample;
+        sample.reserve(sampleCount);
+        for (size_t i = 0; i < sampleCount; i++) {
+            sample.push_back(updates[i * updateCount / sampleCount].pointer.txNum);
+        }
+        std::sort(sample.begin(), sample.end());
+        std::vector<uint32_t> boundaries;
+        for (size_t i = 1; i < partitionCount; i++) {
+            auto boundary = sample[i * sampleCount / partitionCount];
+            if (boundaries.empty() || boundary > boundaries.back()) {
+                boundaries.push_back(boundary);
+            }
+        }
+        return boundaries;
+    }
+}
+
 void backUpdateTxes(const ParserConfigurationBase &config) {
-    std::vector<OutputLinkData> updates;
-    
     std::cout << "Updating spent outputs" << std::endl;
     
+    auto threadCount = std::max(1u, std::thread::hardware_concurrency());
+    
+    // Updates grouped by disjoint ranges of the spent transactions, so that every range can be patched by its own thread
+    std::vector<OutputLinkData> updates;
+    std::vector<size_t> partitionStarts;
     {
         blocksci::FixedSizeFileMapper<OutputLinkData> linkDataFile(config.txUpdatesFilePath());
-        updates.reserve(static_cast<size_t>(linkDataFile.size()));
+        auto updateCount = static_cast<size_t>(linkDataFile.size());
+        if (updateCount == 0) {
+            filesystem::path{config.txUpdatesFilePath() + ".dat"}.remove_file();
+            return;
+        }
+        const OutputLinkData *linkData = linkDataFile[0];
+        auto boundaries = partitionBoundaries(linkData, updateCount, threadCount * 4);
+        auto partitionCount = boundaries.size() + 1;
+        auto partitionOf = [&](const OutputLinkData &update) {
+            return static_cast<size_t>(std::upper_bound(boundaries.begin(), boundaries.end(), update.pointer.txNum) - boundaries.begin());
+        };
+        
+        // Count the updates of every partition per segment of the link file, then scatter each segment in parallel
+        auto segmentSize = (updateCount + threadCount - 1) / threadCount;
+        auto segmentCount = (updateCount + segmentSize - 1) / segmentSize;
+        std::vector<std::vector<size_t>> counts(segmentCount, std::vector<size_t>(partitionCount, 0));
+        auto forEachSegment = [&](auto func) {
+            std::vector<std::future<void>> futures;
+            for (size_t segment = 0; segment < segmentCount; segment++) {
+                futures.push_back(std::async(std::launch::async, [&, segment]() {
+                    func(segment, segment * segmentSize, std::min(updateCount, (segment + 1) * segmentSize));
+                }));
+            }
+            for (auto &future : futures) {
+                future.get();
+            }
+        };
+        forEachSegment([&](size_t segment, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                counts[segment][partitionOf(linkData[i])]++;
+            }
+        });
         
-        for (uint32_t i = 0; i < linkDataFile.size(); i++) {
-            updates.push_back(*linkDataFile[i]);
+        partitionStarts.resize(partitionCount + 1);
+        size_t offset = 0;
+        for (size_t partition = 0; partition < partitionCount; partition++) {
+            partitionStarts[partition] = offset;
+            for (auto &segmentCounts : counts) {
+                auto count = segmentCounts[partition];
+                segmentCounts[partition] = offset;
+                offset += count;
+            }
         }
+        partitionStarts[partitionCount] = offset;
         
-        std::sort(updates.begin(), updates.end(), [](const auto& a, const auto& b) {
-            return a.pointer < b.pointer;
+        updates.resize(updateCount);
+        forEachSegment([&](size_t segment, size_t begin, size_t end) {
+            auto &positions = counts[segment];
+            for (size_t i = begin; i < end; i++) {
+                updates[positions[partitionOf(linkData[i])]++] = linkData[i];
+            }
         });
     }
     
     {
         blocksci::IndexedFileMapper<mio::access_mode::write, blocksci::RawTransaction> txFile(blocksci::ChainAccess::txFilePath(config.dataConfig.chainDirectory()));
         auto progressBar = blocksci::makeProgressBar(updates.size(), [=]() {});
+        std::atomic<size_t> patchedCount{0};
+        std::atomic<size_t> nextPartition{0};
+        
+        // Every thread takes whole partitions, sorts them by spent output and patches them front to back, so that
+        // the writes of each thread move sequentially through its part of the transaction file
+        auto worker = [&]() {
+            constexpr size_t progressStep = 10000;
+            for (auto partition = nextPartition++; partition + 1 < partitionStarts.size(); partition = nextPartition++) {
+                auto begin = updates.begin() + static_cast<std::ptrdiff_t>(partitionStarts[partition]);
+                auto end = updates.begin() + static_cast<std::ptrdiff_t>(partitionStarts[partition + 1]);
+                std::sort(begin, end, [](const auto& a, const auto& b) {
+                    return a.pointer < b.pointer;
+                });
+                size_t count = 0;
+                for (auto it = begin; it != end; ++it) {
+                    auto tx = txFile.getData(it->pointer.txNum);
+                    auto &output = tx->getOutput(it->pointer.inoutNum);
+                    // Set the forward-reference to the tx number of the tx that contains the spending input
+                    output.setLinkedTxNum(it->txNum);
+                    
+                    if (++count == progressStep) {
+                        patchedCount += count;
+                        count = 0;
+                    }
+                }
+                patchedCount += count;
+            }
+        };
         
-        uint32_t count = 0;
-        for (auto &update : updates) {
-            auto tx = txFile.getData(update.pointer.txNum);
-            auto &output = tx->getOutput(update.pointer.inoutNum);
-            // Set the forward-reference to the tx number of the tx that contains the spending input
-            output.setLinkedTxNum(update.txNum);
-            
-            count++;
-            progressBar.update(count);
+        std::vector<std::future<void>> workers;
+        for (unsigned int i = 0; i < threadCount; i++) {
+            workers.push_back(std::async(std::launch::async, worker));
+        }
+        for (auto &future : workers) {
+            while (future.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+                auto done = patchedCount.load();
+                progressBar.update(done - done % 10000);
+            }
+            future.get();
         }
+        
+        // Modified pages are written back together when the transaction file is unmapped
     }
     filesystem::path{config.txUpdatesFilePath() + ".dat"}.remove_file();
 }
@@ -542,6 +751,9 @@ struct QueueStage {
     int64_t nextWaitCount;
     StepNum stepNum;
     
+    // Receives transactions that are discarded instead of being passed on
+    RawTransactionPool *txPool = nullptr;
+    
     void push(RawTransaction *tx) {
         using namespace std::chrono_literals;
         while (!nextQueue->push(tx)) {
@@ -590,7 +802,7 @@ public:
             func(*rawTx);
             // Check if advanceFunc is successful before further processing the pipeline
             if (nextQueue->write_available() == 0 || shouldDiscard(*rawTx)) {
-                delete rawTx;
+                txPool->release(rawTx);
             } else {
                 push(rawTx);
             }
@@ -736,6 +948,9 @@ struct ProcessStepQueue {
     // Queue for RawTransaction objects that have gone through the entire processing pipeline
     TxQueue finishedQueue;
     
+    // Recycles RawTransaction objects that did not fit into finishedQueue
+    RawTransactionPool txPool;
+    
     QueueStage *firstStage;
     
     std::vector<ProcessStep> steps;
@@ -775,6 +990,7 @@ struct ProcessStepQueue {
         for (const auto &stepNum : subStepList) {
             auto &stage = steps[stepNum.threadNum].stages[stepNum.subStepNum];
             stage->stepNum = stepNum;
+            stage->txPool = &txPool;
             if (prevStage != nullptr) {
                 stage->linkBack(*prevStage);
             } else {
@@ -817,9 +1033,9 @@ struct ProcessStepQueue {
             future.get();
         }
         
-        // free all RawTransaction memory slots
-        finishedQueue.consume_all([](RawTransaction *tx) {
-            delete tx;
+        // return all RawTransaction memory slots to the pool, which frees them on destruction
+        finishedQueue.consume_all([&](RawTransaction *tx) {
+            txPool.release(tx);
         });
     }
 };
@@ -846,17 +1062,17 @@ std::vector<blocksci::RawBlock> BlockProcessor::addNewBlocks(const ParserConfigu
         std::cout << ", Block " << tx.blockHeight << "/" << maxBlockHeight;
     });
     
+    // Definition of all ProcessStep objects for the processing pipeline
+    ProcessStepQueue processQueue;
+    
     /* Advance function of the last step
-     * Optimization: Only push tx to finished_transaction_queue if it meets certain conditions, otherwise de-allocate it */
+     * Optimization: Only push tx to finished_transaction_queue if its buffers are small enough to be retained, otherwise de-allocate it */
     
     auto serializeAddressDiscardFunc = [&](RawTransaction &tx) {
         progressBar.update(tx.txNum - startingTxCount, tx);
-        return tx.realSize >= 800;
+        return !processQueue.txPool.shouldRetain(tx);
     };
     
-    // Definition of all ProcessStep objects for the processing pipeline
-    ProcessStepQueue processQueue;
-    
     // 0. Step: Calculate hash of transaction and write it to the hash file (chain/tx_hashes.dat)
     processQueue.addStep(makeStandardProcessStep(std::make_unique<CalculateTxHashStep>(txHashFile), discardFunc, discardFunc));
 
@@ -915,7 +1131,13 @@ std::vector<blocksci::RawBlock> BlockProcessor::addNewBlocks(const ParserConfigu
     auto importer = std::async(std::launch::async, [&] {
         CompletionGuard guard(processQueue.importDone);
         auto loadFinishedTx = [&](RawTransaction *&tx) {
-            return processQueue.finishedQueue.pop(tx);
+            if (processQueue.finishedQueue.pop(tx)) {
+                processQueue.txPool.recordReuse();
+                return true;
+            }
+            bool reused;
+            std::tie(tx, reused) = processQueue.txPool.acquire();
+            return reused;
         };
         
         // Function that adds transaction to the first queue of the processing pipeline
@@ -953,6 +1175,9 @@ std::vector<blocksci::RawBlock> BlockProcessor::addNewBlocks(const ParserConfigu
     // Wait for all processing step threads to complete
     importer.get();
     processQueue.waitForComplete();
+    
+    processQueue.txPool.printStats(std::cout);
+    std::cout << std::endl;
 
     return blocksAdded;
 }
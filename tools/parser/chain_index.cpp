@@ -13,15 +13,22 @@
 #include "safe_mem_reader.hpp"
 #include "preproccessed_block.hpp"
 
-#ifdef BLOCKSCI_RPC_PARSER
-#include <bitcoinapi/bitcoinapi.h>
-#endif
+#include "rpc_client.hpp"
+
+#include <internal/bitcoin_uint256_hex.hpp>
+
+#include <nlohmann/json.hpp>
 
 #include <cereal/archives/binary.hpp>
 
+#include <atomic>
 #include <cmath>
+#include <fstream>
 #include <future>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <type_traits>
 
 #ifdef BLOCKSCI_FILE_PARSER
 
@@ -29,14 +36,20 @@ BlockInfoBase::BlockInfoBase(const blocksci::uint256 &hash_, const CBlockHeader
 
 BlockInfo<FileTag>::BlockInfo(const CBlockHeader &h, uint32_t size_, unsigned int numTxes, uint32_t inputCount_, uint32_t outputCount_, const ChainDiskConfiguration &config, int fileNum, unsigned int dataPos) : BlockInfoBase(config.workHashFunction(reinterpret_cast<const char *>(&h), sizeof(CBlockHeader)), h, size_, numTxes, inputCount_, outputCount_), nFile(fileNum), nDataPos(dataPos) {}
 
-// The 0 should be replaced with info.bits converted to string
-BlockInfo<RPCTag>::BlockInfo(const blockinfo_t &info, blocksci::BlockHeight height_) : 
+BlockInfo<RPCTag>::BlockInfo(const nlohmann::json &header, blocksci::BlockHeight height_) :
 BlockInfoBase(
-    blocksci::uint256S(info.hash), 
-    {info.version, blocksci::uint256S(info.previousblockhash), blocksci::uint256S(info.merkleroot), info.time, 0, info.nonce}, 
-    static_cast<uint32_t>(info.size), 
-    static_cast<uint32_t>(info.tx.size()), 0, 0
-    ), tx(info.tx) {
+    blocksci::uint256S(header.at("hash").get<std::string>()),
+    {
+        header.at("version").get<int32_t>(),
+        blocksci::uint256S(header.value("previousblockhash", std::string{})),
+        blocksci::uint256S(header.at("merkleroot").get<std::string>()),
+        header.at("time").get<uint32_t>(),
+        static_cast<uint32_t>(std::stoul(header.at("bits").get<std::string>(), nullptr, 16)),
+        header.at("nonce").get<uint32_t>()
+    },
+    header.value("size", 0u),
+    header.at("nTx").get<uint32_t>(), 0, 0
+    ) {
     height = height_;
 }
 
@@ -100,132 +113,277 @@ std::vector<BlockInfo<FileTag>> readBlocksInfo(int fileNum, const ParserConfigur
     return readBlocksImpl(reader, fileNum, config.diskConfig);
 }
 
-template <>
-void ChainIndex<FileTag>::update(const ConfigType &config, blocksci::BlockHeight /*maxblockHeight*/) {
-    int fileNum = 0;
-    unsigned int filePos = 0;
-
-    if (!blockList.empty()) {
-        fileNum = newestBlock.nFile;
-        filePos = newestBlock.nDataPos + newestBlock.size;
-    }
-
-    auto firstFile = fileNum;
-    
-    auto maxFileNum = maxBlockFileNum(fileNum, config);
-    
-    auto localConfig = config;
-    
-    std::mutex m;
-    
-    std::cout.setf(std::ios::fixed,std::ios::floatfield);
-    std::cout.precision(1);
-    auto fileCount = maxFileNum - fileNum + 1;
-    int filesDone = 0;
-    using namespace std::chrono_literals;
-    std::atomic<int> activeThreads{0};
-    {
-        std::vector<std::future<void>> blockFutures;
-        for (; fileNum <= maxFileNum; fileNum++) {
-            while (activeThreads > 20) {
-                std::this_thread::sleep_for(500ms);
+namespace {
+    // Reads the cereal serialization of the whole index, used by the RPC parser and by disk parser indexes of older versions
+    template <typename ParseTag>
+    bool loadSerializedIndex(ChainIndex<ParseTag> &index, const ParserConfiguration<ParseTag> &config) {
+        std::ifstream inFile(config.blockListPath().str(), std::ios::binary);
+        if (inFile.good()) {
+            try {
+                cereal::BinaryInputArchive ia(inFile);
+                ia(index);
+            } catch (const std::exception &) {
+                index = ChainIndex<ParseTag>{};
+                return false;
             }
-            blockFutures.emplace_back(std::async(std::launch::async, [&](int fileNum) {
-                activeThreads++;
-                // Determine block file path
-                auto blockFilePath = localConfig.pathForBlockFile(fileNum);
-                SafeMemReader reader{blockFilePath.str()};
-                // Logic for resume from last processed block, note blockStartOffset and length below
-                if (fileNum == firstFile) {
-                    reader.reset(filePos);
-                }
-                auto blocks = readBlocksImpl(reader, fileNum, localConfig.diskConfig);
-                
-                if (fileNum == maxFileNum && blocks.size() > 0) {
-                    newestBlock = blocks.back();
-                }
-                activeThreads--;
-                std::lock_guard<std::mutex> lock(m);
-                
-                for (auto &block : blocks) {
-                    blockList[block.hash] = block;
-                }
-                
-                filesDone++;
-                std::cout << "\r" << (static_cast<double>(filesDone) / static_cast<double>(fileCount)) * 100 << "% done fetching block headers" << std::flush;
-                
-            }, fileNum));
         }
+        return true;
     }
-    
-    std::cout << std::endl;
-    
-    std::unordered_multimap<blocksci::uint256, blocksci::uint256> forwardHashes;
+}
 
-    // Fill forwardHashes with pairs of ((prevBlockHash) -> (currentBlockHash)) for every block
-    for (auto &pair : blockList) {
-        forwardHashes.emplace(pair.second.header.hashPrevBlock, pair.second.hash);
-    }
-    
+template <typename ParseTag>
+void ChainIndex<ParseTag>::assignHeights(const std::vector<blocksci::uint256> &newBlocks) {
     blocksci::uint256 nullHash;
     nullHash.SetNull();
     
+    // Blocks whose parent has no height yet, keyed by the hash of the parent
+    std::unordered_multimap<blocksci::uint256, blocksci::uint256> waiting;
     std::vector<std::pair<blocksci::uint256, blocksci::BlockHeight>> queue;
     
-    queue.emplace_back(nullHash, 0);
+    auto placeBlock = [&](const blocksci::uint256 &hash) {
+        auto &block = blockList.at(hash);
+        if (block.header.hashPrevBlock == nullHash) {
+            block.height = 1;
+        } else {
+            auto parentIt = blockList.find(block.header.hashPrevBlock);
+            if (parentIt == blockList.end() || parentIt->second.height < 0) {
+                waiting.emplace(block.header.hashPrevBlock, hash);
+                return;
+            }
+            block.height = parentIt->second.height + 1;
+        }
+        queue.emplace_back(hash, block.height);
+    };
+    
+    for (auto &hash : orphanBlocks) {
+        placeBlock(hash);
+    }
+    for (auto &hash : newBlocks) {
+        placeBlock(hash);
+    }
+    
+    // Every block that received a height passes it on to the blocks that were waiting for it
     while (!queue.empty()) {
         blocksci::uint256 blockHash;
         blocksci::BlockHeight height;
         std::tie(blockHash, height) = queue.back();
         queue.pop_back();
-        for (auto ret = forwardHashes.equal_range(blockHash); ret.first != ret.second; ++ret.first) {
+        for (auto ret = waiting.equal_range(blockHash); ret.first != ret.second; ++ret.first) {
             auto &block = blockList.at(ret.first->second);
             block.height = height + 1;
             queue.emplace_back(block.hash, block.height);
         }
     }
     
+    orphanBlocks.clear();
+    for (auto &pair : waiting) {
+        if (blockList.at(pair.second).height < 0) {
+            orphanBlocks.push_back(pair.second);
+        }
+    }
+}
+
+template <>
+bool ChainIndex<FileTag>::load(const ConfigType &config) {
+    static_assert(std::is_trivially_copyable<BlockType>::value, "Block index records are stored as raw bytes");
+    std::ifstream inFile(config.blockIndexPath().str(), std::ios::binary);
+    if (!inFile.good()) {
+        // Indexes of older versions are converted to the append-only format by the next save
+        if (!loadSerializedIndex(*this, config)) {
+            return false;
+        }
+        for (auto &pair : blockList) {
+            unsavedBlocks.push_back(pair.first);
+            if (pair.second.height < 0) {
+                orphanBlocks.push_back(pair.first);
+            }
+        }
+        return true;
+    }
+    
+    // A trailing partial record left by an interrupted save is ignored and overwritten by the next save
+    BlockType block;
+    while (inFile.read(reinterpret_cast<char *>(&block), sizeof(BlockType))) {
+        blockList.emplace(block.hash, block);
+        if (savedBlockCount == 0 || std::tie(block.nFile, block.nDataPos) > std::tie(newestBlock.nFile, newestBlock.nDataPos)) {
+            newestBlock = block;
+        }
+        if (block.height < 0) {
+            orphanBlocks.push_back(block.hash);
+        }
+        savedBlockCount++;
+    }
+    
+    // Records keep the height a block had when it was saved, so orphans that were connected later are placed again
+    assignHeights({});
+    return true;
+}
+
+template <>
+void ChainIndex<FileTag>::save(const ConfigType &config) {
+    auto path = config.blockIndexPath().str();
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) {
+        file.open(path, std::ios::binary | std::ios::out);
+    }
+    file.seekp(static_cast<std::streamoff>(savedBlockCount * sizeof(BlockType)));
+    for (auto &hash : unsavedBlocks) {
+        auto &block = blockList.at(hash);
+        file.write(reinterpret_cast<const char *>(&block), sizeof(BlockType));
+    }
+    if (!file.good()) {
+        throw std::runtime_error("Failed to write block index to " + path);
+    }
+    savedBlockCount += unsavedBlocks.size();
+    unsavedBlocks.clear();
+}
+
+template <>
+bool ChainIndex<RPCTag>::load(const ConfigType &config) {
+    return loadSerializedIndex(*this, config);
+}
+
+template <>
+void ChainIndex<RPCTag>::save(const ConfigType &config) {
+    std::ofstream of(config.blockListPath().str(), std::ios::binary);
+    cereal::BinaryOutputArchive oa(of);
+    oa(*this);
+}
+
+template <>
+void ChainIndex<FileTag>::update(const ConfigType &config, blocksci::BlockHeight /*maxblockHeight*/) {
+    int firstFile = 0;
+    unsigned int filePos = 0;
+
+    if (!blockList.empty()) {
+        firstFile = newestBlock.nFile;
+        filePos = newestBlock.nDataPos + newestBlock.size;
+    }
+    
+    auto maxFileNum = maxBlockFileNum(firstFile, config);
+    auto fileCount = std::max(maxFileNum - firstFile + 1, 0);
+    
+    std::cout.setf(std::ios::fixed,std::ios::floatfield);
+    std::cout.precision(1);
+    
+    // Blocks are collected per file so that they are added to the index in file order
+    std::vector<std::vector<BlockType>> fileBlocks(static_cast<size_t>(fileCount));
+    std::atomic<int> nextFile{firstFile};
+    std::atomic<int> filesDone{0};
+    std::mutex m;
+    auto readFiles = [&]() {
+        for (int fileNum = nextFile++; fileNum <= maxFileNum; fileNum = nextFile++) {
+            SafeMemReader reader{config.pathForBlockFile(fileNum).str()};
+            // Logic for resume from last processed block, note blockStartOffset and length below
+            if (fileNum == firstFile) {
+                reader.reset(filePos);
+            }
+            fileBlocks[static_cast<size_t>(fileNum - firstFile)] = readBlocksImpl(reader, fileNum, config.diskConfig);
+            
+            auto done = ++filesDone;
+            std::lock_guard<std::mutex> lock(m);
+            std::cout << "\r" << (static_cast<double>(done) / static_cast<double>(fileCount)) * 100 << "% done fetching block headers" << std::flush;
+        }
+    };
+    
+    auto workerCount = std::min(fileCount, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    std::vector<std::future<void>> workers;
+    for (int i = 0; i < workerCount; i++) {
+        workers.push_back(std::async(std::launch::async, readFiles));
+    }
+    for (auto &worker : workers) {
+        worker.get();
+    }
+    
+    std::cout << std::endl;
+    
+    std::vector<blocksci::uint256> newBlocks;
+    for (auto &blocks : fileBlocks) {
+        for (auto &block : blocks) {
+            if (blockList.emplace(block.hash, block).second) {
+                newBlocks.push_back(block.hash);
+            }
+        }
+        if (!blocks.empty()) {
+            newestBlock = blocks.back();
+        }
+    }
+    
+    // Only the new blocks and the blocks still waiting for their parent need heights
+    assignHeights(newBlocks);
+    unsavedBlocks.insert(unsavedBlocks.end(), newBlocks.begin(), newBlocks.end());
 }
 
 template<>
 void ChainIndex<RPCTag>::update(const ConfigType &config, blocksci::BlockHeight blockHeight) {
     try {
-        BitcoinAPI bapi{config.createBitcoinAPI()};
-        
+        RPCConnectionPool rpc{config.config, rpcConnectionCount, rpcHeaderBatchSize};
         
-        auto maxBlockHeight = static_cast<blocksci::BlockHeight>(bapi.getblockcount());
-        if (blockHeight < 0) {
-            blockHeight = maxBlockHeight + blockHeight;
+        // Like the disk parser, a max block of 0 selects the whole chain and negative values leave out blocks at the tip
+        auto blockCount = rpc.client().call("getblockcount").get<blocksci::BlockHeight>() + 1;
+        if (blockHeight <= 0) {
+            blockHeight = blockCount + blockHeight;
         }
-        if (blockHeight > maxBlockHeight) {
-            blockHeight = maxBlockHeight;
+        if (blockHeight > blockCount) {
+            blockHeight = blockCount;
         }
         
         auto splitPoint = findSplitPointIndex(blockHeight, [&](blocksci::BlockHeight h) {
-            return blocksci::uint256S(bapi.getblockhash(static_cast<int>(h)));
+            return blocksci::uint256S(rpc.client().call("getblockhash", nlohmann::json::array({static_cast<int>(h)})).get<std::string>());
         });
         
         std::cout.setf(std::ios::fixed,std::ios::floatfield);
         std::cout.precision(1);
         blocksci::BlockHeight numBlocks = blockHeight - splitPoint;
-        auto percentage = static_cast<double>(static_cast<int>(numBlocks)) / 1000.0;
-        auto percentageMarker = static_cast<blocksci::BlockHeight>(std::ceil(percentage));
         
-        for (blocksci::BlockHeight i = splitPoint; i < blockHeight; i++) {
-            std::string blockhash = bapi.getblockhash(static_cast<int>(i));
-            BlockType block{bapi.getblock(blockhash), i};
-            blockList.emplace(block.hash, block);
-            auto count = i - splitPoint;
-            if (count % percentageMarker == 0) {
-                std::cout << "\r" << (static_cast<double>(static_cast<int>(count)) / static_cast<double>(static_cast<int>(numBlocks))) * 100 << "% done fetching block headers" << std::flush;
+        // Headers are fetched in windows to report progress and to bound the size of the responses held in memory
+        constexpr blocksci::BlockHeight windowSize = 20000;
+        for (blocksci::BlockHeight windowStart = splitPoint; windowStart < blockHeight; windowStart += windowSize) {
+            auto windowEnd = std::min(blockHeight, windowStart + windowSize);
+            std::vector<nlohmann::json> heightParams;
+            for (blocksci::BlockHeight i = windowStart; i < windowEnd; i++) {
+                heightParams.push_back(nlohmann::json::array({static_cast<int>(i)}));
+            }
+            auto hashes = rpc.batch("getblockhash", heightParams);
+            
+            std::vector<nlohmann::json> hashParams;
+            for (auto &hash : hashes) {
+                hashParams.push_back(nlohmann::json::array({hash}));
+            }
+            auto headers = rpc.batch("getblockheader", hashParams);
+            
+            // Nodes based on older versions of Bitcoin Core don't report the transaction count in the header
+            std::vector<size_t> missingTxCounts;
+            for (size_t i = 0; i < headers.size(); i++) {
+                if (headers[i].find("nTx") == headers[i].end()) {
+                    missingTxCounts.push_back(i);
+                }
+            }
+            if (!missingTxCounts.empty()) {
+                std::vector<nlohmann::json> blockParams;
+                for (auto i : missingTxCounts) {
+                    blockParams.push_back(nlohmann::json::array({hashes[i], 1}));
+                }
+                auto blocks = rpc.batch("getblock", blockParams);
+                for (size_t j = 0; j < missingTxCounts.size(); j++) {
+                    auto &header = headers[missingTxCounts[j]];
+                    header["nTx"] = blocks[j].at("tx").size();
+                    header["size"] = blocks[j].at("size");
+                }
             }
-            if (i == blockHeight - 1) {
+            
+            for (size_t i = 0; i < headers.size(); i++) {
+                BlockType block{headers[i], windowStart + static_cast<blocksci::BlockHeight>(i)};
+                blockList.emplace(block.hash, block);
                 newestBlock = block;
             }
+            
+            auto count = windowEnd - splitPoint;
+            std::cout << "\r" << (static_cast<double>(static_cast<int>(count)) / static_cast<double>(static_cast<int>(numBlocks))) * 100 << "% done fetching block headers" << std::flush;
         }
         
         std::cout << std::endl;
-    } catch (const BitcoinException &e) {
+    } catch (const std::exception &e) {
         std::cout << std::endl;
         std::cerr << "Error while interacting with RPC: " << e.what() << std::endl;
         throw;
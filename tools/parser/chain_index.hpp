@@ -15,6 +15,8 @@
 #include <blocksci/core/typedefs.hpp>
 #include <blocksci/core/bitcoin_uint256.hpp>
 
+#include <nlohmann/json_fwd.hpp>
+
 #include <cereal/types/base_class.hpp>
 #include <cereal/types/unordered_map.hpp>
 #include <cereal/types/vector.hpp>
@@ -27,7 +29,6 @@
 #include <limits>
 
 class CBlockIndex;
-struct blockinfo_t;
 
 namespace blocksci {
     template<class Archive>
@@ -125,10 +126,13 @@ struct BlockInfo<FileTag> : BlockInfoBase {
 
 template<>
 struct BlockInfo<RPCTag> : BlockInfoBase {
+    // Transaction hashes, only filled in indexes of older versions which fetched transactions individually
     std::vector<std::string> tx;
     
     BlockInfo() : BlockInfoBase() {}
-    BlockInfo(const blockinfo_t &info, blocksci::BlockHeight height);
+    
+    /** Creates the block from the verbose result of getblockheader, which must include nTx */
+    BlockInfo(const nlohmann::json &header, blocksci::BlockHeight height);
     
     template<class Archive>
     void serialize(Archive & archive)
@@ -142,7 +146,10 @@ struct BlockInfo<RPCTag> : BlockInfoBase {
 
 /** Holds the current set/state of blocks for the parser
  *
- * File: parser/blockList.dat
+ * File (disk parser): parser/blockIndex.dat
+ * Raw data format: BlockInfo<FileTag> records, appended in the order the blocks were found in the blk files
+ *
+ * File (RPC parser, and legacy disk parser indexes): parser/blockList.dat
  * Raw data format: ChainIndex object serialized using cereal library @see: https://uscilab.github.io/cereal/
  * @see: std::vector<blocksci::RawBlock> updateChain(const ParserConfiguration<ParserTag>, blocksci::BlockHeight, HashIndexCreator) in tools/parser/main.cpp
  */
@@ -154,6 +161,12 @@ struct ChainIndex {
     std::unordered_map<blocksci::uint256, BlockType> blockList;
     BlockType newestBlock;
     
+    /** Loads the stored index of the parser. Returns false if a stored index exists but could not be read */
+    bool load(const ConfigType &config);
+    
+    /** Stores the index. The disk parser only appends the blocks that were added since the last load or save */
+    void save(const ConfigType &config);
+    
     void update(const ConfigType &config, blocksci::BlockHeight maxblockHeight);
 
     std::vector<BlockType> generateChain(blocksci::BlockHeight maxBlockHeight) const {
@@ -221,7 +234,17 @@ private:
         );
     }
     
-    int updateHeight(size_t blockNum, const std::unordered_map<blocksci::uint256, size_t> &indexMap);
+    // Blocks that were added to blockList but not yet written by save()
+    std::vector<blocksci::uint256> unsavedBlocks;
+    
+    // Number of block records in the append-only index file
+    size_t savedBlockCount = 0;
+    
+    // Blocks whose chain does not reach back to the genesis block yet, so they have no height
+    std::vector<blocksci::uint256> orphanBlocks;
+    
+    // Assigns heights to the given blocks and all known orphans which are connected to the chain through them
+    void assignHeights(const std::vector<blocksci::uint256> &newBlocks);
 };
 
 std::vector<BlockInfo<FileTag>> readBlocksInfo(int fileNum, const ParserConfiguration<FileTag> &config);
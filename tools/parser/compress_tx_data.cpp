@@ -0,0 +1,152 @@
+//
+//  compress_tx_data.cpp
+//  blocksci_parser
+//
+
+#include "compress_tx_data.hpp"
+
+#include <internal/chain_access.hpp>
+#include <internal/compressed_tx_file.hpp>
+#include <internal/progress_bar.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    std::string temporaryPath(const filesystem::path &path) {
+        return path.str() + ".dat.tmp";
+    }
+    
+    void writeValue(std::ofstream &file, uint64_t value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+}
+
+void compressTxData(const ParserConfigurationBase &config) {
+    auto chainDirectory = config.dataConfig.chainDirectory();
+    blocksci::ChainAccess chain{chainDirectory, config.dataConfig.blocksIgnored, config.dataConfig.errorOnReorg};
+    auto txCount = static_cast<uint32_t>(chain.txCount());
+    
+    auto dataPath = blocksci::CompressedTxFile::dataFilePath(chainDirectory);
+    auto indexPath = blocksci::CompressedTxFile::indexFilePath(chainDirectory);
+    std::ofstream dataFile(temporaryPath(dataPath), std::ios::binary | std::ios::trunc);
+    std::ofstream indexFile(temporaryPath(indexPath), std::ios::binary | std::ios::trunc);
+    
+    std::cout << "Compressing " << txCount << " transactions\n";
+    // The number of transactions comes first, so a copy that is outdated after an update is recognized
+    writeValue(indexFile, txCount);
+    uint64_t rawSize = 0;
+    uint64_t offset = 0;
+    std::string frame;
+    std::vector<const blocksci::RawTransaction *> txes;
+    txes.reserve(blocksci::compressedTxFrameSize);
+    auto frameCount = (txCount + blocksci::compressedTxFrameSize - 1) / blocksci::compressedTxFrameSize;
+    auto progressBar = blocksci::makeProgressBar(frameCount, [=]() {});
+    for (uint32_t frameNum = 0; frameNum < frameCount; frameNum++) {
+        auto firstTx = frameNum * blocksci::compressedTxFrameSize;
+        auto endTx = std::min(firstTx + blocksci::compressedTxFrameSize, txCount);
+        txes.clear();
+        for (auto txNum = firstTx; txNum < endTx; txNum++) {
+            auto tx = chain.getTx(txNum);
+            rawSize += tx->serializedSize();
+            txes.push_back(tx);
+        }
+        frame.clear();
+        blocksci::encodeTxFrame(frame, firstTx, txes);
+        writeValue(indexFile, offset);
+        dataFile.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        offset += frame.size();
+        progressBar.update(frameNum);
+    }
+    writeValue(indexFile, offset);
+    dataFile.close();
+    indexFile.close();
+    if (!dataFile || !indexFile) {
+        throw std::runtime_error("Failed to write the compressed transaction data");
+    }
+    std::rename(temporaryPath(dataPath).c_str(), (dataPath.str() + ".dat").c_str());
+    std::rename(temporaryPath(indexPath).c_str(), (indexPath.str() + ".dat").c_str());
+    
+    std::cout << "\nCompressed " << rawSize << " bytes of transaction data into " << offset << " bytes";
+    if (offset > 0) {
+        std::cout << " (" << static_cast<double>(rawSize) / static_cast<double>(offset) << "x)";
+    }
+    std::cout << "\n";
+}
+
+bool compressedTxDataEnabled(const ParserConfigurationBase &config) {
+    return blocksci::CompressedTxFile::exists(config.dataConfig.chainDirectory());
+}
+
+void updateCompressedTxData(const ParserConfigurationBase &config) {
+    auto chainDirectory = config.dataConfig.chainDirectory();
+    blocksci::ChainAccess chain{chainDirectory, config.dataConfig.blocksIgnored, config.dataConfig.errorOnReorg};
+    if (blocksci::CompressedTxFile::recordedTxCount(chainDirectory) != chain.txCount()) {
+        compressTxData(config);
+    }
+}
+
+bool verifyCompressedTxData(const ParserConfigurationBase &config) {
+    auto chainDirectory = config.dataConfig.chainDirectory();
+    blocksci::ChainAccess chain{chainDirectory, config.dataConfig.blocksIgnored, config.dataConfig.errorOnReorg};
+    auto txCount = static_cast<uint32_t>(chain.txCount());
+    blocksci::CompressedTxFile compressed{chainDirectory, txCount};
+    for (uint32_t txNum = 0; txNum < txCount; txNum++) {
+        auto frame = compressed.getFrameOfTx(txNum);
+        auto expected = chain.getTx(txNum);
+        auto actual = frame->getTx(txNum);
+        if (std::memcmp(expected, actual, expected->serializedSize()) != 0) {
+            std::cout << "Compressed transaction data differs at transaction " << txNum << "\n";
+            return false;
+        }
+    }
+    std::cout << "Compressed transaction data matches all " << txCount << " transactions\n";
+    return true;
+}
+
+void benchmarkCompressedTxData(const ParserConfigurationBase &config) {
+    auto chainDirectory = config.dataConfig.chainDirectory();
+    blocksci::ChainAccess chain{chainDirectory, config.dataConfig.blocksIgnored, config.dataConfig.errorOnReorg};
+    auto txCount = static_cast<uint32_t>(chain.txCount());
+    blocksci::CompressedTxFile compressed{chainDirectory, txCount};
+    
+    auto sumOutputs = [](const blocksci::RawTransaction *tx) {
+        int64_t total = 0;
+        for (auto output = tx->beginOutputs(); output != tx->endOutputs(); ++output) {
+            total += output->getValue();
+        }
+        return total;
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    int64_t mappedTotal = 0;
+    uint64_t mappedBytes = 0;
+    for (uint32_t txNum = 0; txNum < txCount; txNum++) {
+        auto tx = chain.getTx(txNum);
+        mappedBytes += tx->serializedSize();
+        mappedTotal += sumOutputs(tx);
+    }
+    std::chrono::duration<double> mappedSeconds = std::chrono::steady_clock::now() - start;
+    
+    start = std::chrono::steady_clock::now();
+    int64_t compressedTotal = 0;
+    for (uint32_t txNum = 0; txNum < txCount;) {
+        auto frame = compressed.getFrameOfTx(txNum);
+        auto endTx = std::min(frame->firstTx() + frame->size(), txCount);
+        for (; txNum < endTx; txNum++) {
+            compressedTotal += sumOutputs(frame->getTx(txNum));
+        }
+    }
+    std::chrono::duration<double> compressedSeconds = std::chrono::steady_clock::now() - start;
+    
+    std::cout << "Scanned " << txCount << " transactions\n";
+    std::cout << "  mmapped tx_data:    " << mappedBytes << " bytes read in " << mappedSeconds.count() << " s\n";
+    std::cout << "  compressed tx_data: " << compressed.compressedSize() << " bytes read in " << compressedSeconds.count() << " s\n";
+    if (mappedTotal != compressedTotal) {
+        std::cout << "Output totals differ (" << mappedTotal << " vs " << compressedTotal << ")\n";
+    }
+}
@@ -0,0 +1,30 @@
+//
+//  compress_tx_data.hpp
+//  blocksci_parser
+//
+
+#ifndef compress_tx_data_hpp
+#define compress_tx_data_hpp
+
+#include "parser_configuration.hpp"
+
+/** Writes the compressed copy of chain/tx_data.dat that is read by blocksci::CompressedTxFile */
+void compressTxData(const ParserConfigurationBase &config);
+
+/** Returns whether compress-tx-data has been run for the data directory, which makes update refresh the copy */
+bool compressedTxDataEnabled(const ParserConfigurationBase &config);
+
+/** Rebuilds the compressed copy if it was built for a different number of transactions than the chain has */
+void updateCompressedTxData(const ParserConfigurationBase &config);
+
+/** Decodes every frame of the compressed copy and compares it with chain/tx_data.dat, returns false on a mismatch */
+bool verifyCompressedTxData(const ParserConfigurationBase &config);
+
+/** Times a scan over all transactions through the mmapped tx_data.dat and through the compressed copy
+ *
+ * Both scans sum the values of all outputs. Run it after dropping the page cache (or on a host whose RAM is smaller
+ * than tx_data.dat) to compare the cost of reading the data from disk.
+ */
+void benchmarkCompressedTxData(const ParserConfigurationBase &config);
+
+#endif /* compress_tx_data_hpp */
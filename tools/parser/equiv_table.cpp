@@ -0,0 +1,200 @@
+//
+//  equiv_table.cpp
+//  blocksci_parser
+//
+
+#include "equiv_table.hpp"
+
+#include <internal/address_info.hpp>
+#include <internal/chain_access.hpp>
+#include <internal/equiv_table_access.hpp>
+#include <internal/progress_bar.hpp>
+#include <internal/script_access.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+    std::string tablePath(const filesystem::path &scriptsDirectory, const std::string &name) {
+        return (blocksci::EquivTableAccess::tableDirectory(scriptsDirectory)/name).str() + ".dat";
+    }
+    
+    std::string statePath(const filesystem::path &scriptsDirectory) {
+        return blocksci::EquivTableAccess::stateFilePath(scriptsDirectory).str() + ".dat";
+    }
+    
+    /** Marks that the table is kept up to date by update, even while the state file is missing during a rewrite */
+    filesystem::path enabledMarkerPath(const filesystem::path &scriptsDirectory) {
+        return blocksci::EquivTableAccess::tableDirectory(scriptsDirectory)/"enabled";
+    }
+    
+    template <typename T>
+    void writeTableFile(const std::string &path, const std::vector<T> &values) {
+        std::ofstream file(path + ".tmp", std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Failed to write the equivalence table");
+        }
+        std::rename((path + ".tmp").c_str(), path.c_str());
+    }
+    
+    template <typename T>
+    std::vector<T> readTableFile(const std::string &path) {
+        std::vector<T> values;
+        filesystem::path file{path};
+        if (file.exists()) {
+            values.resize(file.file_size() / sizeof(T));
+            std::ifstream stream(path, std::ios::binary);
+            stream.read(reinterpret_cast<char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+        }
+        return values;
+    }
+    
+    /** Reads the state of a table that can be extended, the state has a txCount of 0 if the table has to be rebuilt */
+    blocksci::EquivTableState resumableState(const blocksci::ChainAccess &chain, const filesystem::path &scriptsDirectory) {
+        std::ifstream stateFile(statePath(scriptsDirectory), std::ios::binary);
+        blocksci::EquivTableState state{};
+        if (!stateFile.read(reinterpret_cast<char *>(&state), sizeof(state))) {
+            return blocksci::EquivTableState{};
+        }
+        if (state.txCount == 0 || state.txCount > chain.txCount() || *chain.getTxHash(state.txCount - 1) != state.lastTxHash) {
+            std::cout << "Equivalence table does not match the chain, rebuilding it\n";
+            return blocksci::EquivTableState{};
+        }
+        return state;
+    }
+}
+
+bool equivTableEnabled(const ParserConfigurationBase &config) {
+    auto scriptsDirectory = config.dataConfig.scriptsDirectory();
+    return enabledMarkerPath(scriptsDirectory).exists() || filesystem::path{statePath(scriptsDirectory)}.exists();
+}
+
+void updateEquivTable(const ParserConfigurationBase &config) {
+    using blocksci::DedupAddress;
+    using blocksci::DedupAddressType;
+    
+    auto scriptsDirectory = config.dataConfig.scriptsDirectory();
+    blocksci::ChainAccess chain{config.dataConfig.chainDirectory(), config.dataConfig.blocksIgnored, config.dataConfig.errorOnReorg};
+    blocksci::ScriptAccess scripts{scriptsDirectory};
+    filesystem::create_directory(blocksci::EquivTableAccess::tableDirectory(scriptsDirectory));
+    std::ofstream enabledMarker(enabledMarkerPath(scriptsDirectory).str(), std::ios::app);
+    
+    auto txCount = static_cast<uint32_t>(chain.txCount());
+    auto state = resumableState(chain, scriptsDirectory);
+    if (txCount == 0 || state.txCount == txCount) {
+        return;
+    }
+    
+    // Classes of the addresses that have equivalents, which are only a small part of all addresses
+    std::unordered_map<DedupAddress, uint32_t> classIds;
+    uint32_t classCount = 0;
+    if (state.txCount > 0) {
+        for (auto &entry : readTableFile<blocksci::EquivTableEntry>(tablePath(scriptsDirectory, "class_entry"))) {
+            classIds.emplace(entry.address, entry.classId);
+        }
+        classCount = state.classCount;
+    }
+    
+    // Without a state file readers ignore the table until it is complete, and an interrupted update rebuilds it
+    std::remove(statePath(scriptsDirectory).c_str());
+    
+    // New script hash addresses and the ones whose wrapped address was revealed by spending them in a new transaction
+    auto scriptHashCount = scripts.scriptCount(DedupAddressType::SCRIPTHASH);
+    std::vector<uint32_t> scriptNums;
+    if (state.txCount > 0) {
+        for (uint32_t txNum = state.txCount; txNum < txCount; txNum++) {
+            auto tx = chain.getTx(txNum);
+            for (auto input = tx->beginInputs(); input != tx->endInputs(); ++input) {
+                if (dedupType(input->getType()) == DedupAddressType::SCRIPTHASH && input->getAddressNum() <= state.scriptHashCount) {
+                    scriptNums.push_back(input->getAddressNum());
+                }
+            }
+        }
+    }
+    std::sort(scriptNums.begin(), scriptNums.end());
+    scriptNums.erase(std::unique(scriptNums.begin(), scriptNums.end()), scriptNums.end());
+    for (uint32_t scriptNum = state.scriptHashCount + 1; scriptNum <= scriptHashCount; scriptNum++) {
+        scriptNums.push_back(scriptNum);
+    }
+    
+    auto wrappedAddress = [&](uint32_t scriptNum) {
+        auto &wrapped = scripts.getScriptData<DedupAddressType::SCRIPTHASH>(scriptNum)->wrappedAddress;
+        return DedupAddress{wrapped.scriptNum, dedupType(wrapped.type)};
+    };
+    
+    std::cout << "Updating equivalence table for " << scriptNums.size() << " script hash addresses\n";
+    auto progressBar = blocksci::makeProgressBar(scriptNums.size(), [=]() {});
+    uint32_t progress = 0;
+    for (auto scriptNum : scriptNums) {
+        progressBar.update(progress++);
+        auto root = wrappedAddress(scriptNum);
+        if (root.scriptNum == 0) {
+            continue;
+        }
+        while (root.type == DedupAddressType::SCRIPTHASH) {
+            auto wrapped = wrappedAddress(root.scriptNum);
+            if (wrapped.scriptNum == 0) {
+                break;
+            }
+            root = wrapped;
+        }
+        auto rootClass = classIds.find(root);
+        auto classId = rootClass != classIds.end() ? rootClass->second : ++classCount;
+        classIds[root] = classId;
+        
+        DedupAddress address{scriptNum, DedupAddressType::SCRIPTHASH};
+        auto previous = classIds.find(address);
+        if (previous != classIds.end() && previous->second != classId) {
+            // The address was the innermost address of its own class until its wrapped address was revealed, which
+            // moves the addresses wrapping it into the class of the new innermost address. This is rare.
+            auto previousClassId = previous->second;
+            for (auto &entry : classIds) {
+                if (entry.second == previousClassId) {
+                    entry.second = classId;
+                }
+            }
+        }
+        classIds[address] = classId;
+    }
+    
+    std::vector<blocksci::EquivTableEntry> entries;
+    entries.reserve(classIds.size());
+    for (auto &entry : classIds) {
+        entries.push_back(blocksci::EquivTableEntry{entry.first, entry.second});
+    }
+    classIds = decltype(classIds){};
+    std::sort(entries.begin(), entries.end());
+    
+    // Classes that were merged into another class keep their id without members
+    std::vector<uint64_t> classOffsets(classCount + 1, 0);
+    for (auto &entry : entries) {
+        classOffsets[entry.classId]++;
+    }
+    for (size_t classId = 1; classId < classOffsets.size(); classId++) {
+        classOffsets[classId] += classOffsets[classId - 1];
+    }
+    std::vector<DedupAddress> classMembers(entries.size());
+    std::vector<uint64_t> nextMember(classOffsets.begin(), classOffsets.end() - 1);
+    for (auto &entry : entries) {
+        classMembers[nextMember[entry.classId - 1]++] = entry.address;
+    }
+    
+    writeTableFile(tablePath(scriptsDirectory, "class_entry"), entries);
+    writeTableFile(tablePath(scriptsDirectory, "class_offset"), classOffsets);
+    writeTableFile(tablePath(scriptsDirectory, "class_member"), classMembers);
+    
+    state.txCount = txCount;
+    state.classCount = classCount;
+    state.scriptHashCount = scriptHashCount;
+    state.lastTxHash = *chain.getTxHash(txCount - 1);
+    writeTableFile(statePath(scriptsDirectory), std::vector<blocksci::EquivTableState>{state});
+    std::cout << "\nFound " << classCount << " classes of equivalent addresses\n";
+}
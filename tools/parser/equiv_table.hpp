@@ -0,0 +1,22 @@
+//
+//  equiv_table.hpp
+//  blocksci_parser
+//
+
+#ifndef equiv_table_hpp
+#define equiv_table_hpp
+
+#include "parser_configuration.hpp"
+
+/** Brings the script-equivalence table read by blocksci::EquivTableAccess up to date with the chain
+ *
+ * Only script hash addresses that were added since the last run, or whose wrapped address was revealed by spending
+ * them in a new transaction, are resolved. The table is rebuilt from all script hash addresses if it is missing, was
+ * left incomplete or describes blocks that were removed by a reorg.
+ */
+void updateEquivTable(const ParserConfigurationBase &config);
+
+/** Returns whether equiv-table-update has been run for the data directory, which makes update refresh the table */
+bool equivTableEnabled(const ParserConfigurationBase &config);
+
+#endif /* equiv_table_hpp */
@@ -0,0 +1,194 @@
+//
+//  inout_columns.cpp
+//  blocksci_parser
+//
+
+#include "inout_columns.hpp"
+
+#include <internal/chain_access.hpp>
+#include <internal/inout_column_access.hpp>
+#include <internal/progress_bar.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+    std::string columnPath(const filesystem::path &chainDirectory, const std::string &name) {
+        return blocksci::InoutColumnAccess::columnFilePath(chainDirectory, name).str() + ".dat";
+    }
+    
+    std::string statePath(const filesystem::path &chainDirectory) {
+        return blocksci::InoutColumnAccess::stateFilePath(chainDirectory).str() + ".dat";
+    }
+    
+    /** Marks that the columns are kept up to date by update, even while the state file is missing during a rebuild */
+    filesystem::path enabledMarkerPath(const filesystem::path &chainDirectory) {
+        return blocksci::InoutColumnAccess::columnDirectory(chainDirectory)/"enabled";
+    }
+    
+    /** Buffered writer appending to one column file */
+    template <typename T>
+    class ColumnAppender {
+        std::ofstream file;
+        std::vector<T> buffer;
+    
+    public:
+        ColumnAppender(const std::string &path, bool rebuild) : file(path, std::ios::binary | (rebuild ? std::ios::trunc : std::ios::app)) {
+            buffer.reserve(1 << 16);
+        }
+        
+        void push_back(T value) {
+            buffer.push_back(value);
+            if (buffer.size() == buffer.capacity()) {
+                flush();
+            }
+        }
+        
+        void flush() {
+            file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(T)));
+            buffer.clear();
+        }
+        
+        void close() {
+            flush();
+            file.close();
+            if (!file) {
+                throw std::runtime_error("Failed to write the input and output columns");
+            }
+        }
+    };
+    
+    template <typename T>
+    uint64_t columnSize(const std::string &path) {
+        filesystem::path file{path};
+        return file.exists() ? file.file_size() / sizeof(T) : 0;
+    }
+    
+    /** Number of transactions the existing columns can be extended from, 0 if they have to be rebuilt */
+    uint32_t resumableTxCount(const blocksci::ChainAccess &chain, const filesystem::path &chainDirectory) {
+        std::ifstream stateFile(statePath(chainDirectory), std::ios::binary);
+        blocksci::InoutColumnState state;
+        if (!stateFile.read(reinterpret_cast<char *>(&state), sizeof(state))) {
+            return 0;
+        }
+        if (state.txCount == 0 || state.txCount > chain.txCount() || *chain.getTxHash(state.txCount - 1) != state.lastTxHash) {
+            std::cout << "Input and output columns do not match the chain, rebuilding them\n";
+            return 0;
+        }
+        // The state file is only replaced once all columns were written, so an interrupted update leaves columns that
+        // are longer than recorded in it
+        if (columnSize<int64_t>(columnPath(chainDirectory, "output_value")) != state.outputCount ||
+            columnSize<uint8_t>(columnPath(chainDirectory, "output_type")) != state.outputCount ||
+            columnSize<uint32_t>(columnPath(chainDirectory, "output_address")) != state.outputCount ||
+            columnSize<uint32_t>(columnPath(chainDirectory, "output_spent_tx")) != state.outputCount ||
+            columnSize<int64_t>(columnPath(chainDirectory, "input_value")) != state.inputCount ||
+            columnSize<uint8_t>(columnPath(chainDirectory, "input_type")) != state.inputCount ||
+            columnSize<uint32_t>(columnPath(chainDirectory, "input_address")) != state.inputCount ||
+            columnSize<uint32_t>(columnPath(chainDirectory, "input_spent_tx")) != state.inputCount) {
+            std::cout << "Input and output columns are incomplete, rebuilding them\n";
+            return 0;
+        }
+        return state.txCount;
+    }
+}
+
+bool inoutColumnsEnabled(const ParserConfigurationBase &config) {
+    auto chainDirectory = config.dataConfig.chainDirectory();
+    return enabledMarkerPath(chainDirectory).exists() || filesystem::path{statePath(chainDirectory)}.exists();
+}
+
+void updateInoutColumns(const ParserConfigurationBase &config) {
+    auto chainDirectory = config.dataConfig.chainDirectory();
+    blocksci::ChainAccess chain{chainDirectory, config.dataConfig.blocksIgnored, config.dataConfig.errorOnReorg};
+    filesystem::create_directory(blocksci::InoutColumnAccess::columnDirectory(chainDirectory));
+    std::ofstream enabledMarker(enabledMarkerPath(chainDirectory).str(), std::ios::app);
+    
+    auto txCount = static_cast<uint32_t>(chain.txCount());
+    auto startTx = resumableTxCount(chain, chainDirectory);
+    bool rebuild = startTx == 0;
+    if (startTx == txCount) {
+        return;
+    }
+    
+    // A rebuild truncates the columns, so readers must not rely on the old state while it runs
+    if (rebuild) {
+        std::remove(statePath(chainDirectory).c_str());
+    }
+    
+    ColumnAppender<int64_t> outputValues{columnPath(chainDirectory, "output_value"), rebuild};
+    ColumnAppender<uint8_t> outputTypes{columnPath(chainDirectory, "output_type"), rebuild};
+    ColumnAppender<uint32_t> outputAddresses{columnPath(chainDirectory, "output_address"), rebuild};
+    ColumnAppender<uint32_t> outputSpentTxes{columnPath(chainDirectory, "output_spent_tx"), rebuild};
+    ColumnAppender<int64_t> inputValues{columnPath(chainDirectory, "input_value"), rebuild};
+    ColumnAppender<uint8_t> inputTypes{columnPath(chainDirectory, "input_type"), rebuild};
+    ColumnAppender<uint32_t> inputAddresses{columnPath(chainDirectory, "input_address"), rebuild};
+    ColumnAppender<uint32_t> inputSpentTxes{columnPath(chainDirectory, "input_spent_tx"), rebuild};
+    
+    // Outputs in tx_data.dat already point to their spending transaction. Outputs that were written by an earlier
+    // run have to be patched when one of the new transactions spends them.
+    std::vector<std::pair<uint64_t, uint32_t>> spentOutputPatches;
+    
+    std::cout << "Updating input and output columns for " << (txCount - startTx) << " transactions\n";
+    auto progressBar = blocksci::makeProgressBar(txCount - startTx, [=]() {});
+    for (uint32_t txNum = startTx; txNum < txCount; txNum++) {
+        auto tx = chain.getTx(txNum);
+        auto spentOutputNums = tx->inputCount > 0 ? chain.getSpentOutputNumbers(txNum) : nullptr;
+        uint16_t inputNum = 0;
+        for (auto input = tx->beginInputs(); input != tx->endInputs(); ++input, ++inputNum) {
+            inputValues.push_back(input->getValue());
+            inputTypes.push_back(static_cast<uint8_t>(input->getType()));
+            inputAddresses.push_back(input->getAddressNum());
+            inputSpentTxes.push_back(input->getLinkedTxNum());
+            if (input->getLinkedTxNum() < startTx) {
+                spentOutputPatches.emplace_back(chain.firstOutputNum(input->getLinkedTxNum()) + spentOutputNums[inputNum], txNum);
+            }
+        }
+        for (auto output = tx->beginOutputs(); output != tx->endOutputs(); ++output) {
+            outputValues.push_back(output->getValue());
+            outputTypes.push_back(static_cast<uint8_t>(output->getType()));
+            outputAddresses.push_back(output->getAddressNum());
+            outputSpentTxes.push_back(output->getLinkedTxNum());
+        }
+        progressBar.update(txNum - startTx);
+    }
+    outputValues.close();
+    outputTypes.close();
+    outputAddresses.close();
+    outputSpentTxes.close();
+    inputValues.close();
+    inputTypes.close();
+    inputAddresses.close();
+    inputSpentTxes.close();
+    
+    if (!spentOutputPatches.empty()) {
+        std::sort(spentOutputPatches.begin(), spentOutputPatches.end());
+        std::fstream spentTxFile(columnPath(chainDirectory, "output_spent_tx"), std::ios::binary | std::ios::in | std::ios::out);
+        for (auto &patch : spentOutputPatches) {
+            spentTxFile.seekp(static_cast<std::streamoff>(patch.first * sizeof(uint32_t)));
+            spentTxFile.write(reinterpret_cast<const char *>(&patch.second), sizeof(patch.second));
+        }
+        spentTxFile.close();
+        if (!spentTxFile) {
+            throw std::runtime_error("Failed to update the spending transactions of the output column");
+        }
+    }
+    
+    blocksci::InoutColumnState state{};
+    state.txCount = txCount;
+    state.inputCount = chain.inputCount();
+    state.outputCount = chain.outputCount();
+    state.lastTxHash = *chain.getTxHash(txCount - 1);
+    auto temporaryStatePath = statePath(chainDirectory) + ".tmp";
+    std::ofstream stateFile(temporaryStatePath, std::ios::binary | std::ios::trunc);
+    stateFile.write(reinterpret_cast<const char *>(&state), sizeof(state));
+    stateFile.close();
+    if (!stateFile || std::rename(temporaryStatePath.c_str(), statePath(chainDirectory).c_str()) != 0) {
+        throw std::runtime_error("Failed to write the state of the input and output columns");
+    }
+    std::cout << "\n";
+}
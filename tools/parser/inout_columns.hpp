@@ -0,0 +1,21 @@
+//
+//  inout_columns.hpp
+//  blocksci_parser
+//
+
+#ifndef inout_columns_hpp
+#define inout_columns_hpp
+
+#include "parser_configuration.hpp"
+
+/** Brings the dense input and output columns read by blocksci::InoutColumnAccess up to date with the chain
+ *
+ * Only the transactions added since the last run are appended. The columns are rebuilt from scratch if they are
+ * missing, were left incomplete or describe blocks that were removed by a reorg.
+ */
+void updateInoutColumns(const ParserConfigurationBase &config);
+
+/** Returns whether inout-columns-update has been run for the data directory, which makes update refresh the columns */
+bool inoutColumnsEnabled(const ParserConfigurationBase &config);
+
+#endif /* inout_columns_hpp */
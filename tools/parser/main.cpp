@@ -21,6 +21,10 @@
 #include "address_writer.hpp"
 #include "utxo_address_state.hpp"
 #include "doctor.hpp"
+#include "compress_tx_data.hpp"
+#include "inout_columns.hpp"
+#include "equiv_table.hpp"
+#include "utxo_snapshots.hpp"
 
 #include <internal/bitcoin_uint256_hex.hpp>
 #include <internal/data_configuration.hpp>
@@ -94,22 +98,13 @@ std::vector<blocksci::RawBlock> updateChain(const ParserConfiguration<ParserTag>
      */
     auto chainBlocks = [&]() {
         ChainIndex<ParserTag> index;
-        std::ifstream inFile(config.blockListPath().str(), std::ios::binary);
-        if (inFile.good()) {
-            try {
-                cereal::BinaryInputArchive ia(inFile);
-                ia(index);
-            } catch (const std::exception &) {
-                std::cout << "Error loading chain index. Reparsing from scratch\n";
-                index = ChainIndex<ParserTag>{};
-            }
+        if (!index.load(config)) {
+            std::cout << "Error loading chain index. Reparsing from scratch\n";
         }
         
         index.update(config, maxBlockNum);
         auto blocks = index.generateChain(maxBlockNum);
-        std::ofstream of(config.blockListPath().str(), std::ios::binary);
-        cereal::BinaryOutputArchive oa(of);
-        oa(index);
+        index.save(config);
         return blocks;
     }();
 
@@ -278,6 +273,22 @@ void updateChain(const filesystem::path &configFilePath, bool fullParse) {
         updateHashDB(config, hashDb);
         updateAddressDB(config);
     }
+    
+    if (inoutColumnsEnabled(config)) {
+        updateInoutColumns(config);
+    }
+    
+    if (compressedTxDataEnabled(config)) {
+        updateCompressedTxData(config);
+    }
+    
+    if (equivTableEnabled(config)) {
+        updateEquivTable(config);
+    }
+    
+    if (utxoSnapshotsEnabled(config)) {
+        updateUtxoSnapshots(config, 0);
+    }
 }
 
 int main(int argc, char * argv[]) {
@@ -289,7 +300,7 @@ int main(int argc, char * argv[]) {
     //    --data-directory /Users/hkalodner/bitcoin-samp
     //    --coin-directory /Users/hkalodner/Library/Application\ Support/Bitcoin
     
-    enum class mode {generateConfig, update, updateCore, updateIndexes, updateHashIndex, updateAddressIndex, compactIndexes, help, doctor};
+    enum class mode {generateConfig, update, updateCore, updateIndexes, updateHashIndex, updateAddressIndex, compactIndexes, compressTxData, updateInoutColumns, updateEquivTable, updateUtxoSnapshots, help, doctor};
     mode selected = mode::help;
     
     bool enableRPC = false;
@@ -353,12 +364,26 @@ int main(int argc, char * argv[]) {
     auto addressIndexUpdateCommand = clipp::command("address-index-update").set(selected,mode::updateAddressIndex) % "Update address index to latest state";
     auto hashIndexUpdateCommand = clipp::command("hash-index-update").set(selected,mode::updateHashIndex) % "Update hash index to latest state";
     auto compactIndexesCommand = clipp::command("compact-indexes").set(selected, mode::compactIndexes) % "Compact indexes to speed up blockchain construction";
+    bool verifyCompression = false;
+    bool benchmarkCompression = false;
+    auto compressTxDataCommand = (
+        clipp::command("compress-tx-data").set(selected, mode::compressTxData) % "Write a compressed, randomly accessible copy of the transaction data",
+        clipp::option("--verify").set(verifyCompression) % "Check the compressed copy against the transaction data",
+        clipp::option("--benchmark").set(benchmarkCompression) % "Compare a scan of the compressed copy with a scan of the mmapped transaction data"
+    );
+    auto inoutColumnsUpdateCommand = clipp::command("inout-columns-update").set(selected, mode::updateInoutColumns) % "Write dense per-field columns of all inputs and outputs, which are then kept up to date by update";
+    auto equivTableUpdateCommand = clipp::command("equiv-table-update").set(selected, mode::updateEquivTable) % "Write the table of script-equivalent addresses used by EquivAddress, which is then kept up to date by update";
+    int utxoSnapshotInterval = 0;
+    auto utxoSnapshotsUpdateCommand = (
+        clipp::command("utxo-snapshots-update").set(selected, mode::updateUtxoSnapshots) % "Materialize the UTXO set every few blocks, new snapshots are then added by update",
+        (clipp::option("--interval") & clipp::value("blocks", utxoSnapshotInterval)) % "Number of blocks between two snapshots (default 10000 or the interval of the existing snapshots)"
+    );
     auto doctorCommand = clipp::command("doctor").set(selected,mode::doctor) % "Diagnose issues with BlockSci or the provided config file.";
     
     std::string configFilePathString;
     auto configFileOpt = clipp::value("config file", configFilePathString) % "Path to config file";
     
-    auto commands = (generateConfigCommand, configOptions) | updateCommand | updateCoreCommand | indexUpdateCommand | addressIndexUpdateCommand | hashIndexUpdateCommand | compactIndexesCommand | doctorCommand;
+    auto commands = (generateConfigCommand, configOptions) | updateCommand | updateCoreCommand | indexUpdateCommand | addressIndexUpdateCommand | hashIndexUpdateCommand | compactIndexesCommand | compressTxDataCommand | inoutColumnsUpdateCommand | equivTableUpdateCommand | utxoSnapshotsUpdateCommand | doctorCommand;
     
     auto cli = (configFileOpt, commands);
     
@@ -407,6 +432,7 @@ int main(int argc, char * argv[]) {
             } else if (coinType == "bitcoin_regtest") {
                 chainConfig = blocksci::ChainConfiguration::bitcoinRegtest(dataDirectory);
                 diskConfig = ChainDiskConfiguration::bitcoinRegtest(coinDirectoryString);
+                rpcConfig.rawBlocks = true;
             } else if (coinType == "bitcoin_cash") {
                 chainConfig = blocksci::ChainConfiguration::bitcoinCash(dataDirectory);
                 diskConfig = ChainDiskConfiguration::bitcoinCash(coinDirectoryString);
@@ -418,6 +444,7 @@ int main(int argc, char * argv[]) {
             } else if (coinType == "bitcoin_cash_regtest") {
                 chainConfig = blocksci::ChainConfiguration::bitcoinCashRegtest(dataDirectory);
                 diskConfig = ChainDiskConfiguration::bitcoinCashRegtest(coinDirectoryString);
+                rpcConfig.rawBlocks = true;
             } else if (coinType == "dash") {
                 chainConfig = blocksci::ChainConfiguration::dash(dataDirectory);
                 rpcConfig = blocksci::ChainRPCConfiguration::dash(username, password);
@@ -435,6 +462,7 @@ int main(int argc, char * argv[]) {
             } else if (coinType == "litecoin_regtest") {
                 chainConfig = blocksci::ChainConfiguration::litecoinRegtest(dataDirectory);
                 diskConfig = ChainDiskConfiguration::litecoinRegtest(coinDirectoryString);
+                rpcConfig.rawBlocks = true;
             } else if (coinType == "namecoin") {
                 chainConfig = blocksci::ChainConfiguration::namecoin(dataDirectory);
                 rpcConfig = blocksci::ChainRPCConfiguration::namecoin(username, password);
@@ -545,6 +573,44 @@ int main(int argc, char * argv[]) {
             break;
         }
 
+        case mode::compressTxData: {
+            auto config = getBaseConfig(configFilePath);
+            lockDataDirectory(config);
+            compressTxData(config);
+            unlockDataDirectory(config);
+            if (verifyCompression && !verifyCompressedTxData(config)) {
+                return 1;
+            }
+            if (benchmarkCompression) {
+                benchmarkCompressedTxData(config);
+            }
+            break;
+        }
+
+        case mode::updateInoutColumns: {
+            auto config = getBaseConfig(configFilePath);
+            lockDataDirectory(config);
+            updateInoutColumns(config);
+            unlockDataDirectory(config);
+            break;
+        }
+
+        case mode::updateEquivTable: {
+            auto config = getBaseConfig(configFilePath);
+            lockDataDirectory(config);
+            updateEquivTable(config);
+            unlockDataDirectory(config);
+            break;
+        }
+
+        case mode::updateUtxoSnapshots: {
+            auto config = getBaseConfig(configFilePath);
+            lockDataDirectory(config);
+            updateUtxoSnapshots(config, utxoSnapshotInterval);
+            unlockDataDirectory(config);
+            break;
+        }
+
         case mode::doctor: {
             auto doctor = BlockSciDoctor(configFilePath);
             doctor.checkDiskSpace();
@@ -61,6 +61,14 @@ struct ParserConfigurationBase {
     filesystem::path blockListPath() const {
         return parserDirectory()/"blockList.dat";
     }
+    
+    /** Append-only index of the disk parser, stores one raw BlockInfo<FileTag> record per block
+     *
+     * Replaces blockList.dat for the disk parser, which is only read to convert indexes of older versions
+     */
+    filesystem::path blockIndexPath() const {
+        return parserDirectory()/"blockIndex.dat";
+    }
 
     /** Stores serialized OutputLinkData, memory-mapped as blocksci::FixedSizeFileMapper<OutputLinkData>
      *
@@ -18,6 +18,10 @@
 
 #ifdef BLOCKSCI_RPC_PARSER
 #include <bitcoinapi/types.h>
+
+#include <internal/bitcoin_uint256_hex.hpp>
+
+#include <nlohmann/json.hpp>
 #endif
 
 #include <openssl/sha.h>
@@ -41,6 +45,12 @@ std::vector<CharType> hexStringToVec(const std::string &scripthex) {
 
 #ifdef BLOCKSCI_FILE_PARSER
 RawInput::RawInput(SafeMemReader &reader) : utxo{} {
+    load(reader);
+}
+
+void RawInput::load(SafeMemReader &reader) {
+    utxo = UTXO{};
+    witnessStack.clear();
     rawOutputPointer.hash = reader.readNext<blocksci::uint256>();
     uint32_t rawOutputNum = reader.readNext<uint32_t>();
     rawOutputPointer.outputNum = static_cast<uint16_t>(rawOutputNum);
@@ -58,6 +68,10 @@ void RawInput::readWitnessStack(SafeMemReader &reader) {
 }
 
 RawOutput::RawOutput(SafeMemReader &reader) {
+    load(reader);
+}
+
+void RawOutput::load(SafeMemReader &reader) {
     value = static_cast<int64_t>(reader.readNext<Value>());
     scriptLength = reader.readVariableLengthInteger();
     scriptBegin = reinterpret_cast<const unsigned char*>(reader.unsafePos());
@@ -90,18 +104,17 @@ void RawTransaction::load(SafeMemReader &reader, uint32_t txNum_, blocksci::Bloc
         curOffset = reader.offset();
         inputCount = reader.readVariableLengthInteger();
     }
-    inputs.clear();
-    inputs.reserve(inputCount);
+    // Inputs and outputs of a recycled transaction are overwritten in place so that their buffers are reused
+    inputs.resize(inputCount);
     for (decltype(inputCount) i = 0; i < inputCount; i++) {
-        inputs.emplace_back(reader);
+        inputs[i].load(reader);
     }
     
     auto outputCount = reader.readVariableLengthInteger();
     
-    outputs.clear();
-    outputs.reserve(outputCount);
+    outputs.resize(outputCount);
     for (decltype(outputCount) i = 0; i < outputCount; i++) {
-        outputs.emplace_back(reader);
+        outputs[i].load(reader);
     }
     baseSize += static_cast<uint32_t>(reader.offset() - curOffset);
     txHashLength = static_cast<uint32_t>(reader.unsafePos() - txHashStart);
@@ -188,9 +201,32 @@ RawInput::RawInput(const vin_t &vin) {
     }
 }
 
+RawInput::RawInput(const nlohmann::json &vin) {
+    // Coinbase inputs carry their script in a separate field and spend no output
+    auto coinbaseIt = vin.find("coinbase");
+    if (coinbaseIt != vin.end()) {
+        rawOutputPointer = {blocksci::uint256{}, std::numeric_limits<uint16_t>::max()};
+        scriptBytes = hexStringToVec<unsigned char>(coinbaseIt->get<std::string>());
+    } else {
+        rawOutputPointer = {blocksci::uint256S(vin.at("txid").get<std::string>()), static_cast<uint16_t>(vin.at("vout").get<uint32_t>())};
+        scriptBytes = hexStringToVec<unsigned char>(vin.at("scriptSig").at("hex").get<std::string>());
+    }
+    sequenceNum = vin.at("sequence").get<uint32_t>();
+    scriptLength = 0;
+    rpcWitnessStack.clear();
+    auto witnessIt = vin.find("txinwitness");
+    if (witnessIt != vin.end()) {
+        for (const auto &item : *witnessIt) {
+            rpcWitnessStack.push_back(hexStringToVec<char>(item.get<std::string>()));
+        }
+    }
+}
+
 RawOutput::RawOutput(std::vector<unsigned char> scriptBytes_, int64_t value_) : scriptBytes(std::move(scriptBytes_)), value(value_)  {
 }
 
+RawOutput::RawOutput(const nlohmann::json &vout) : RawOutput(hexStringToVec<unsigned char>(vout.at("scriptPubKey").at("hex").get<std::string>()), static_cast<int64_t>(vout.at("value").get<double>() * 1e8 + (vout.at("value").get<double>() < 0.0 ? -.5 : .5))) {}
+
 RawOutput::RawOutput(const vout_t &vout) : RawOutput(hexStringToVec<unsigned char>(vout.scriptPubKey.hex), static_cast<int64_t>(vout.value * 1e8 + (vout.value < 0.0 ? -.5 : .5))) {}
 
 void RawTransaction::load(const getrawtransaction_t &txinfo, uint32_t txNum_, blocksci::BlockHeight blockHeight_, bool witnessActivated) {
@@ -216,6 +252,29 @@ void RawTransaction::load(const getrawtransaction_t &txinfo, uint32_t txNum_, bl
     hash = blocksci::uint256S(txinfo.txid);;
 }
 
+void RawTransaction::load(const nlohmann::json &txinfo, uint32_t txNum_, blocksci::BlockHeight blockHeight_, bool witnessActivated) {
+    txNum = txNum_;
+    isSegwit = witnessActivated;
+    blockHeight = blockHeight_;
+    version = txinfo.at("version").get<int32_t>();
+    locktime = txinfo.at("locktime").get<uint32_t>();
+    auto hexIt = txinfo.find("hex");
+    realSize = hexIt != txinfo.end() ? static_cast<uint32_t>(hexIt->get_ref<const std::string &>().size() / 2) : txinfo.at("size").get<uint32_t>();
+    auto &vin = txinfo.at("vin");
+    inputs.clear();
+    inputs.reserve(vin.size());
+    for (const auto &input : vin) {
+        inputs.emplace_back(input);
+    }
+    auto &vout = txinfo.at("vout");
+    outputs.clear();
+    outputs.reserve(vout.size());
+    for (const auto &output : vout) {
+        outputs.emplace_back(output);
+    }
+    hash = blocksci::uint256S(txinfo.at("txid").get<std::string>());
+}
+
 #endif
 
 blocksci::RawTransaction RawTransaction::getRawTransaction() const {
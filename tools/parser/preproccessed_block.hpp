@@ -18,6 +18,10 @@
 
 #include <boost/container/small_vector.hpp>
 
+#ifdef BLOCKSCI_RPC_PARSER
+#include <nlohmann/json_fwd.hpp>
+#endif
+
 struct getrawtransaction_t;
 struct vout_t;
 struct vin_t;
@@ -88,11 +92,15 @@ public:
     
     #ifdef BLOCKSCI_FILE_PARSER
     RawInput(SafeMemReader &reader);
+    /** Reads the input in place, keeping the capacity of the witness stack of a recycled input */
+    void load(SafeMemReader &reader);
     void readWitnessStack(SafeMemReader &reader);
     #endif
     
     #ifdef BLOCKSCI_RPC_PARSER
     RawInput(const vin_t &vin);
+    /** Creates the input from an element of vin of a transaction decoded by the node */
+    explicit RawInput(const nlohmann::json &vin);
     #endif
 };
 
@@ -103,14 +111,19 @@ private:
     
     std::vector<unsigned char> scriptBytes;
 public:
-    int64_t value;
+    int64_t value = 0;
+    
+    RawOutput() = default;
 
     #ifdef BLOCKSCI_FILE_PARSER
     RawOutput(SafeMemReader &reader);
+    void load(SafeMemReader &reader);
     #endif
     
     #ifdef BLOCKSCI_RPC_PARSER
     RawOutput(const vout_t &vout);
+    /** Creates the output from an element of vout of a transaction decoded by the node */
+    explicit RawOutput(const nlohmann::json &vout);
     RawOutput(std::vector<unsigned char> scriptBytes_, int64_t value_);
     #endif
     
@@ -166,6 +179,8 @@ struct RawTransaction {
     
     #ifdef BLOCKSCI_RPC_PARSER
     void load(const getrawtransaction_t &txinfo, uint32_t txNum, blocksci::BlockHeight blockHeight, bool witnessActivated);
+    /** Loads a transaction decoded by the node, as contained in the result of getblock with verbosity 2 */
+    void load(const nlohmann::json &txinfo, uint32_t txNum, blocksci::BlockHeight blockHeight, bool witnessActivated);
     #endif
     
     void calculateHash();
@@ -0,0 +1,86 @@
+//
+//  raw_transaction_pool.hpp
+//  blocksci_parser
+//
+
+#ifndef raw_transaction_pool_hpp
+#define raw_transaction_pool_hpp
+
+#include "preproccessed_block.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/** Recycles RawTransaction objects that left the processing pipeline
+ *
+ * Reused transactions keep the capacity of their input, output and witness containers, so parsing
+ * transactions of typical size needs no heap allocations once the pipeline is saturated.
+ * Transactions with unusually large containers are freed instead of pooled to bound the retained memory.
+ */
+class RawTransactionPool {
+    std::mutex mutex;
+    std::vector<RawTransaction *> freeTransactions;
+    size_t maxPooledCount;
+    size_t maxRetainedItems;
+    
+    std::atomic<uint64_t> allocatedCount{0};
+    std::atomic<uint64_t> reusedCount{0};
+    std::atomic<uint64_t> freedCount{0};
+
+public:
+    explicit RawTransactionPool(size_t maxPooledCount_ = 10000, size_t maxRetainedItems_ = 256) : maxPooledCount(maxPooledCount_), maxRetainedItems(maxRetainedItems_) {}
+    
+    RawTransactionPool(const RawTransactionPool &) = delete;
+    RawTransactionPool &operator=(const RawTransactionPool &) = delete;
+    
+    ~RawTransactionPool() {
+        for (auto tx : freeTransactions) {
+            delete tx;
+        }
+    }
+    
+    /** Whether the transaction is small enough to be kept for reuse */
+    bool shouldRetain(const RawTransaction &tx) const {
+        return tx.inputs.capacity() <= maxRetainedItems && tx.outputs.capacity() <= maxRetainedItems;
+    }
+    
+    /** Returns a pooled transaction, allocating a new one if the pool is empty. The second value is true if the transaction was reused */
+    std::pair<RawTransaction *, bool> acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!freeTransactions.empty()) {
+                auto tx = freeTransactions.back();
+                freeTransactions.pop_back();
+                reusedCount++;
+                return {tx, true};
+            }
+        }
+        allocatedCount++;
+        return {new RawTransaction(), false};
+    }
+    
+    /** Records that a transaction was reused without passing through the pool */
+    void recordReuse() {
+        reusedCount++;
+    }
+    
+    void release(RawTransaction *tx) {
+        if (shouldRetain(*tx)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (freeTransactions.size() < maxPooledCount) {
+                freeTransactions.push_back(tx);
+                return;
+            }
+        }
+        freedCount++;
+        delete tx;
+    }
+    
+    void printStats(std::ostream &os) const {
+        os << "Transaction buffers: " << allocatedCount << " allocated, " << reusedCount << " reused, " << freedCount << " freed";
+    }
+};
+
+#endif /* raw_transaction_pool_hpp */
@@ -0,0 +1,477 @@
+//
+//  rpc_client.cpp
+//  blocksci_parser
+//
+
+#include "rpc_client.hpp"
+
+#ifdef BLOCKSCI_RPC_PARSER
+
+#include <internal/chain_configuration.hpp>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+#ifdef MSG_NOSIGNAL
+    constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int sendFlags = 0;
+#endif
+
+    // Raised if the connection to the node broke, requests failing with it are retried once on a new connection
+    class RPCConnectionError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+    
+    std::string base64Encode(const std::string &input) {
+        static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string output;
+        output.reserve((input.size() + 2) / 3 * 4);
+        size_t i = 0;
+        for (; i + 2 < input.size(); i += 3) {
+            auto n = (static_cast<uint32_t>(static_cast<uint8_t>(input[i])) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(input[i + 1])) << 8) | static_cast<uint8_t>(input[i + 2]);
+            output.push_back(alphabet[(n >> 18) & 63]);
+            output.push_back(alphabet[(n >> 12) & 63]);
+            output.push_back(alphabet[(n >> 6) & 63]);
+            output.push_back(alphabet[n & 63]);
+        }
+        if (i < input.size()) {
+            auto n = static_cast<uint32_t>(static_cast<uint8_t>(input[i])) << 16;
+            if (i + 1 < input.size()) {
+                n |= static_cast<uint32_t>(static_cast<uint8_t>(input[i + 1])) << 8;
+            }
+            output.push_back(alphabet[(n >> 18) & 63]);
+            output.push_back(alphabet[(n >> 12) & 63]);
+            output.push_back(i + 1 < input.size() ? alphabet[(n >> 6) & 63] : '=');
+            output.push_back('=');
+        }
+        return output;
+    }
+    
+    std::vector<char> decodeHex(const std::string &hex) {
+        static const std::array<int8_t, 256> digits = []() {
+            std::array<int8_t, 256> table;
+            table.fill(-1);
+            for (int i = 0; i < 10; i++) {
+                table[static_cast<size_t>('0' + i)] = static_cast<int8_t>(i);
+            }
+            for (int i = 0; i < 6; i++) {
+                table[static_cast<size_t>('a' + i)] = static_cast<int8_t>(10 + i);
+                table[static_cast<size_t>('A' + i)] = static_cast<int8_t>(10 + i);
+            }
+            return table;
+        }();
+        if (hex.size() % 2 != 0) {
+            throw std::runtime_error("Received block data with an odd number of hex digits");
+        }
+        std::vector<char> data(hex.size() / 2);
+        for (size_t i = 0; i < data.size(); i++) {
+            auto high = digits[static_cast<uint8_t>(hex[2 * i])];
+            auto low = digits[static_cast<uint8_t>(hex[2 * i + 1])];
+            if (high < 0 || low < 0) {
+                throw std::runtime_error("Received block data with invalid hex digits");
+            }
+            data[i] = static_cast<char>((high << 4) | low);
+        }
+        return data;
+    }
+    
+    std::string lowercase(std::string str) {
+        std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return str;
+    }
+    
+    nlohmann::json callBody(const std::string &method, const nlohmann::json &params, size_t id) {
+        return {{"jsonrpc", "1.0"}, {"id", id}, {"method", method}, {"params", params}};
+    }
+    
+    const nlohmann::json &checkedResult(const nlohmann::json &response, const std::string &method) {
+        auto errorIt = response.find("error");
+        if (errorIt != response.end() && !errorIt->is_null()) {
+            std::stringstream ss;
+            ss << "RPC call " << method << " failed: " << errorIt->value("message", errorIt->dump());
+            throw std::runtime_error(ss.str());
+        }
+        return response.at("result");
+    }
+}
+
+BatchRPCClient::BatchRPCClient(const blocksci::ChainRPCConfiguration &config) : host(config.address), port(config.port), authorization(base64Encode(config.username + ":" + config.password)) {}
+
+BatchRPCClient::~BatchRPCClient() {
+    disconnect();
+}
+
+void BatchRPCClient::connect() {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    auto portString = std::to_string(port);
+    auto ret = getaddrinfo(host.c_str(), portString.c_str(), &hints, &addresses);
+    if (ret != 0) {
+        throw std::runtime_error("Failed to resolve RPC address " + host + ": " + gai_strerror(ret));
+    }
+    for (auto address = addresses; address != nullptr; address = address->ai_next) {
+        int fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            socketFd = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(addresses);
+    if (socketFd < 0) {
+        throw std::runtime_error("Failed to connect to RPC server at " + host + ":" + portString);
+    }
+    int flag = 1;
+    setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+#ifdef SO_NOSIGPIPE
+    setsockopt(socketFd, SOL_SOCKET, SO_NOSIGPIPE, &flag, sizeof(flag));
+#endif
+    buffer.clear();
+}
+
+void BatchRPCClient::disconnect() {
+    if (socketFd >= 0) {
+        ::close(socketFd);
+        socketFd = -1;
+    }
+    buffer.clear();
+}
+
+void BatchRPCClient::sendAll(const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        auto ret = ::send(socketFd, data.data() + sent, data.size() - sent, sendFlags);
+        if (ret < 0) {
+            throw RPCConnectionError("Failed to send request to RPC server");
+        }
+        sent += static_cast<size_t>(ret);
+    }
+}
+
+bool BatchRPCClient::receiveMore() {
+    char chunk[1 << 16];
+    auto ret = ::recv(socketFd, chunk, sizeof(chunk), 0);
+    if (ret < 0) {
+        throw RPCConnectionError("Failed to receive response from RPC server");
+    }
+    buffer.append(chunk, static_cast<size_t>(ret));
+    return ret > 0;
+}
+
+void BatchRPCClient::receiveUntil(size_t size) {
+    while (buffer.size() < size) {
+        if (!receiveMore()) {
+            throw RPCConnectionError("RPC server closed the connection");
+        }
+    }
+}
+
+std::pair<int, std::string> BatchRPCClient::readResponse() {
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!receiveMore()) {
+            throw RPCConnectionError("RPC server closed the connection");
+        }
+    }
+    std::istringstream headers(buffer.substr(0, headerEnd));
+    size_t pos = headerEnd + 4;
+    
+    std::string statusLine;
+    std::getline(headers, statusLine);
+    auto statusStart = statusLine.find(' ');
+    if (statusStart == std::string::npos) {
+        throw std::runtime_error("Received malformed response from RPC server");
+    }
+    int status = std::stoi(statusLine.substr(statusStart + 1));
+    
+    bool chunked = false;
+    bool closeConnection = false;
+    bool hasLength = false;
+    size_t contentLength = 0;
+    std::string line;
+    while (std::getline(headers, line)) {
+        auto separator = line.find(':');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        auto name = lowercase(line.substr(0, separator));
+        auto value = lowercase(line.substr(separator + 1));
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+        if (name == "content-length") {
+            hasLength = true;
+            contentLength = std::stoul(value);
+        } else if (name == "transfer-encoding") {
+            chunked = value.find("chunked") != std::string::npos;
+        } else if (name == "connection") {
+            closeConnection = value == "close";
+        }
+    }
+    
+    std::string body;
+    if (chunked) {
+        while (true) {
+            size_t lineEnd;
+            while ((lineEnd = buffer.find("\r\n", pos)) == std::string::npos) {
+                receiveUntil(buffer.size() + 1);
+            }
+            auto chunkSize = std::stoul(buffer.substr(pos, lineEnd - pos), nullptr, 16);
+            pos = lineEnd + 2;
+            receiveUntil(pos + chunkSize + 2);
+            body.append(buffer, pos, chunkSize);
+            pos += chunkSize + 2;
+            if (chunkSize == 0) {
+                break;
+            }
+        }
+    } else if (hasLength) {
+        receiveUntil(pos + contentLength);
+        body = buffer.substr(pos, contentLength);
+        pos += contentLength;
+    } else {
+        // Without a length the body extends to the end of the connection
+        while (receiveMore()) {}
+        body = buffer.substr(pos);
+        pos = buffer.size();
+        closeConnection = true;
+    }
+    buffer.erase(0, pos);
+    
+    if (closeConnection) {
+        disconnect();
+    }
+    return {status, std::move(body)};
+}
+
+std::pair<int, std::string> BatchRPCClient::post(const std::string &body) {
+    std::stringstream ss;
+    ss << "POST / HTTP/1.1\r\n"
+    << "Host: " << host << ":" << port << "\r\n"
+    << "Authorization: Basic " << authorization << "\r\n"
+    << "Content-Type: application/json\r\n"
+    << "Content-Length: " << body.size() << "\r\n"
+    << "Connection: keep-alive\r\n\r\n"
+    << body;
+    auto requestData = ss.str();
+    
+    // The node may have closed an idle connection, so the first failure is retried on a new connection
+    for (int attempt = 0; ; attempt++) {
+        if (socketFd < 0) {
+            connect();
+        }
+        try {
+            sendAll(requestData);
+            return readResponse();
+        } catch (const RPCConnectionError &) {
+            disconnect();
+            if (attempt > 0) {
+                throw;
+            }
+        }
+    }
+}
+
+nlohmann::json BatchRPCClient::request(const nlohmann::json &body) {
+    auto response = post(body.dump());
+    if (response.first == 401 || response.first == 403) {
+        throw std::runtime_error("RPC server rejected the credentials, check the RPC username and password");
+    }
+    try {
+        return nlohmann::json::parse(response.second);
+    } catch (const std::exception &) {
+        std::stringstream ss;
+        ss << "Received invalid response from RPC server (HTTP status " << response.first << ")";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+nlohmann::json BatchRPCClient::call(const std::string &method, const nlohmann::json &params) {
+    auto response = request(callBody(method, params, 0));
+    return checkedResult(response, method);
+}
+
+std::vector<nlohmann::json> BatchRPCClient::batch(const std::string &method, const std::vector<nlohmann::json> &paramsList) {
+    return batchResults(method, paramsList, false);
+}
+
+std::vector<nlohmann::json> BatchRPCClient::batchAllowingErrors(const std::string &method, const std::vector<nlohmann::json> &paramsList) {
+    return batchResults(method, paramsList, true);
+}
+
+std::vector<nlohmann::json> BatchRPCClient::batchResults(const std::string &method, const std::vector<nlohmann::json> &paramsList, bool allowErrors) {
+    if (paramsList.empty()) {
+        return {};
+    }
+    auto body = nlohmann::json::array();
+    for (size_t i = 0; i < paramsList.size(); i++) {
+        body.push_back(callBody(method, paramsList[i], i));
+    }
+    auto response = request(body);
+    if (!response.is_array() || response.size() != paramsList.size()) {
+        // Nodes answer malformed batches with a single error object
+        if (response.is_object()) {
+            checkedResult(response, method);
+        }
+        throw std::runtime_error("RPC server returned an incomplete batch response for " + method);
+    }
+    
+    // Responses of a batch may arrive in any order
+    std::vector<nlohmann::json> results(paramsList.size());
+    for (auto &item : response) {
+        auto id = item.at("id").get<size_t>();
+        if (id >= results.size()) {
+            throw std::runtime_error("RPC server returned an unknown response id for " + method);
+        }
+        auto errorIt = item.find("error");
+        if (allowErrors && errorIt != item.end() && !errorIt->is_null()) {
+            continue;
+        }
+        results[id] = checkedResult(item, method);
+    }
+    return results;
+}
+
+RPCConnectionPool::RPCConnectionPool(const blocksci::ChainRPCConfiguration &config, size_t connectionCount, size_t batchSize_) : batchSize(batchSize_) {
+    for (size_t i = 0; i < std::max<size_t>(connectionCount, 1); i++) {
+        clients.push_back(std::make_unique<BatchRPCClient>(config));
+    }
+}
+
+std::vector<nlohmann::json> RPCConnectionPool::batch(const std::string &method, const std::vector<nlohmann::json> &paramsList) {
+    std::vector<nlohmann::json> results(paramsList.size());
+    auto batchCount = (paramsList.size() + batchSize - 1) / batchSize;
+    auto connectionCount = std::min(clients.size(), batchCount);
+    
+    // Connection i sends the batches i, i + connectionCount, ...
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < connectionCount; i++) {
+        futures.push_back(std::async(std::launch::async, [&, i]() {
+            for (size_t batchNum = i; batchNum < batchCount; batchNum += connectionCount) {
+                auto start = batchNum * batchSize;
+                auto end = std::min(paramsList.size(), start + batchSize);
+                std::vector<nlohmann::json> batchParams(paramsList.begin() + static_cast<std::ptrdiff_t>(start), paramsList.begin() + static_cast<std::ptrdiff_t>(end));
+                auto batchResults = clients[i]->batch(method, batchParams);
+                std::move(batchResults.begin(), batchResults.end(), results.begin() + static_cast<std::ptrdiff_t>(start));
+            }
+        }));
+    }
+    for (auto &future : futures) {
+        future.get();
+    }
+    return results;
+}
+
+BlockFetcher::BlockFetcher(const blocksci::ChainRPCConfiguration &config, std::vector<blocksci::uint256> hashes_, bool rawBlocks_, size_t connectionCount, size_t batchSize_) : hashes(std::move(hashes_)), rawBlocks(rawBlocks_), batchSize(batchSize_), maxBatchesAhead(2 * connectionCount) {
+    auto batchCount = (hashes.size() + batchSize - 1) / batchSize;
+    connectionCount = std::min(connectionCount, batchCount);
+    for (size_t i = 0; i < connectionCount; i++) {
+        clients.push_back(std::make_unique<BatchRPCClient>(config));
+    }
+    for (auto &client : clients) {
+        workers.emplace_back([this, &client]() {
+            fetchBatches(*client);
+        });
+    }
+}
+
+BlockFetcher::~BlockFetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void BlockFetcher::fetchBatches(BatchRPCClient &client) {
+    try {
+        while (true) {
+            size_t batchNum;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]() {
+                    return stopping || nextBatch < consumedBlockCount / batchSize + maxBatchesAhead;
+                });
+                if (stopping || nextBatch * batchSize >= hashes.size()) {
+                    return;
+                }
+                batchNum = nextBatch++;
+            }
+            
+            auto start = batchNum * batchSize;
+            auto end = std::min(hashes.size(), start + batchSize);
+            std::vector<nlohmann::json> paramsList;
+            for (size_t i = start; i < end; i++) {
+                // Verbosity 0 returns the serialized block as hex, verbosity 2 the block with decoded transactions
+                paramsList.push_back(nlohmann::json::array({hashes[i].GetHex(), rawBlocks ? 0 : 2}));
+            }
+            auto results = client.batch("getblock", paramsList);
+            std::vector<FetchedBlock> blocks(results.size());
+            for (size_t i = 0; i < results.size(); i++) {
+                if (rawBlocks) {
+                    blocks[i].data = decodeHex(results[i].get_ref<const std::string &>());
+                } else {
+                    blocks[i].decoded = std::move(results[i]);
+                }
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                fetchedBatches.emplace(batchNum, std::move(blocks));
+            }
+            condition.notify_all();
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+        }
+        condition.notify_all();
+    }
+}
+
+FetchedBlock BlockFetcher::next() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (consumedBlockCount >= hashes.size()) {
+        throw std::out_of_range("Requested more blocks than were fetched");
+    }
+    auto batchNum = consumedBlockCount / batchSize;
+    condition.wait(lock, [&]() {
+        return error || fetchedBatches.find(batchNum) != fetchedBatches.end();
+    });
+    auto batchIt = fetchedBatches.find(batchNum);
+    if (batchIt == fetchedBatches.end()) {
+        std::rethrow_exception(error);
+    }
+    auto block = std::move(batchIt->second[consumedBlockCount % batchSize]);
+    consumedBlockCount++;
+    if (consumedBlockCount % batchSize == 0 || consumedBlockCount == hashes.size()) {
+        fetchedBatches.erase(batchIt);
+        lock.unlock();
+        condition.notify_all();
+    }
+    return block;
+}
+
+#endif
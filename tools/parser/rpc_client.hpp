@@ -0,0 +1,143 @@
+//
+//  rpc_client.hpp
+//  blocksci_parser
+//
+
+#ifndef rpc_client_hpp
+#define rpc_client_hpp
+
+#include "config.hpp"
+
+#ifdef BLOCKSCI_RPC_PARSER
+
+#include <blocksci/core/bitcoin_uint256.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace blocksci {
+    struct ChainRPCConfiguration;
+}
+
+/** Number of connections that are used in parallel to fetch data from the node */
+constexpr size_t rpcConnectionCount = 4;
+
+/** Number of calls that are sent in a single request when fetching block headers */
+constexpr size_t rpcHeaderBatchSize = 1000;
+
+/** Number of raw blocks that are sent in a single request */
+constexpr size_t rpcBlockBatchSize = 8;
+
+/** JSON-RPC client for bitcoind compatible nodes which can send many calls in a single HTTP request
+ *
+ * The connection is kept open between requests and is reopened if the node closed it in the meantime.
+ */
+class BatchRPCClient {
+    std::string host;
+    int port;
+    std::string authorization;
+    int socketFd = -1;
+    
+    // Bytes received from the node that were not consumed by the last response
+    std::string buffer;
+    
+    void connect();
+    void disconnect();
+    void sendAll(const std::string &data);
+    bool receiveMore();
+    void receiveUntil(size_t size);
+    std::pair<int, std::string> readResponse();
+    std::pair<int, std::string> post(const std::string &body);
+    nlohmann::json request(const nlohmann::json &body);
+    std::vector<nlohmann::json> batchResults(const std::string &method, const std::vector<nlohmann::json> &paramsList, bool allowErrors);
+
+public:
+    explicit BatchRPCClient(const blocksci::ChainRPCConfiguration &config);
+    ~BatchRPCClient();
+    
+    BatchRPCClient(const BatchRPCClient &) = delete;
+    BatchRPCClient &operator=(const BatchRPCClient &) = delete;
+    
+    /** Calls a single method and returns its result */
+    nlohmann::json call(const std::string &method, const nlohmann::json &params = nlohmann::json::array());
+    
+    /** Calls the method once for every parameter list in a single array request, results are in the order of the parameter lists */
+    std::vector<nlohmann::json> batch(const std::string &method, const std::vector<nlohmann::json> &paramsList);
+    
+    /** Like batch, but calls that the node answered with an error have a null result instead of failing the whole batch */
+    std::vector<nlohmann::json> batchAllowingErrors(const std::string &method, const std::vector<nlohmann::json> &paramsList);
+};
+
+/** Splits calls into batches which are sent concurrently over several connections */
+class RPCConnectionPool {
+    std::vector<std::unique_ptr<BatchRPCClient>> clients;
+    size_t batchSize;
+
+public:
+    RPCConnectionPool(const blocksci::ChainRPCConfiguration &config, size_t connectionCount, size_t batchSize);
+    
+    /** Connection for calls that are not batched */
+    BatchRPCClient &client() {
+        return *clients.front();
+    }
+    
+    /** Calls the method once for every parameter list, results are in the order of the parameter lists */
+    std::vector<nlohmann::json> batch(const std::string &method, const std::vector<nlohmann::json> &paramsList);
+};
+
+/** Block received from the node */
+struct FetchedBlock {
+    /** Serialized block, laid out like a block in a blk file so it can be parsed with SafeMemReader like blocks read from disk */
+    std::vector<char> data;
+    /** Block with decoded transactions, used for nodes whose serialization format differs from Bitcoin */
+    nlohmann::json decoded;
+};
+
+/** Downloads a list of blocks in the background
+ *
+ * Blocks are requested in batches over several connections, at most a bounded number of batches ahead
+ * of the block that is currently consumed.
+ */
+class BlockFetcher {
+    std::vector<blocksci::uint256> hashes;
+    bool rawBlocks;
+    size_t batchSize;
+    size_t maxBatchesAhead;
+    std::vector<std::unique_ptr<BatchRPCClient>> clients;
+    
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t nextBatch = 0;
+    size_t consumedBlockCount = 0;
+    std::map<size_t, std::vector<FetchedBlock>> fetchedBatches;
+    std::exception_ptr error;
+    bool stopping = false;
+    
+    std::vector<std::thread> workers;
+    
+    void fetchBatches(BatchRPCClient &client);
+
+public:
+    /** Fetches serialized blocks if rawBlocks is set and blocks with decoded transactions otherwise */
+    BlockFetcher(const blocksci::ChainRPCConfiguration &config, std::vector<blocksci::uint256> hashes, bool rawBlocks, size_t connectionCount = rpcConnectionCount, size_t batchSize = rpcBlockBatchSize);
+    ~BlockFetcher();
+    
+    BlockFetcher(const BlockFetcher &) = delete;
+    BlockFetcher &operator=(const BlockFetcher &) = delete;
+    
+    /** Returns the next block, in the order of the hashes given to the constructor */
+    FetchedBlock next();
+};
+
+#endif
+
+#endif /* rpc_client_hpp */
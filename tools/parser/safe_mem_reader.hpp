@@ -33,6 +33,9 @@ public:
         pos = begin;
     }
     
+    /** Reads from memory owned by the caller, which must stay valid as long as data read from it is used. The name is used in error messages */
+    SafeMemReader(std::string name, iterator begin_, iterator end_) : path(std::move(name)), pos(begin_), begin(begin_), end(end_) {}
+    
     std::string getPath() const {
         return path;
     }
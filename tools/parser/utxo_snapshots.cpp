@@ -0,0 +1,116 @@
+//
+//  utxo_snapshots.cpp
+//  blocksci_parser
+//
+
+#include "utxo_snapshots.hpp"
+
+#include <internal/chain_access.hpp>
+#include <internal/utxo_snapshot_access.hpp>
+
+#include <blocksci/core/raw_block.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string indexPath(const filesystem::path &chainDirectory) {
+        return blocksci::UtxoSnapshotAccess::indexFilePath(chainDirectory).str() + ".dat";
+    }
+    
+    std::string dataPath(const filesystem::path &chainDirectory) {
+        return blocksci::UtxoSnapshotAccess::dataFilePath(chainDirectory).str() + ".dat";
+    }
+    
+    uint64_t fileSize(const std::string &path) {
+        filesystem::path file{path};
+        return file.exists() ? file.file_size() : 0;
+    }
+    
+    /** Existing snapshots up to the first one that no longer matches the chain or was not written completely */
+    std::vector<blocksci::UtxoSnapshotEntry> validSnapshots(const blocksci::ChainAccess &chain, const filesystem::path &chainDirectory) {
+        std::vector<blocksci::UtxoSnapshotEntry> entries;
+        auto dataSize = fileSize(dataPath(chainDirectory));
+        std::ifstream indexFile(indexPath(chainDirectory), std::ios::binary);
+        blocksci::UtxoSnapshotEntry entry;
+        while (indexFile.read(reinterpret_cast<char *>(&entry), sizeof(entry))) {
+            bool valid = entry.height < chain.blockCount() && chain.getBlock(entry.height)->hash == entry.blockHash;
+            if (!valid || entry.offset + entry.size > dataSize) {
+                std::cout << "Dropping UTXO snapshots from height " << entry.height << " on, they do not match the chain\n";
+                break;
+            }
+            entries.push_back(entry);
+        }
+        return entries;
+    }
+    
+    blocksci::UtxoSet readSnapshot(const filesystem::path &chainDirectory, const blocksci::UtxoSnapshotEntry &entry) {
+        std::ifstream dataFile(dataPath(chainDirectory), std::ios::binary);
+        std::string data(entry.size, '\0');
+        dataFile.seekg(static_cast<std::streamoff>(entry.offset));
+        if (!dataFile.read(&data[0], static_cast<std::streamsize>(data.size()))) {
+            throw std::runtime_error("Failed to read UTXO snapshot at height " + std::to_string(entry.height));
+        }
+        return blocksci::decodeUtxoSet(data.data(), data.size(), entry.utxoCount, entry.height);
+    }
+}
+
+bool utxoSnapshotsEnabled(const ParserConfigurationBase &config) {
+    return filesystem::path{indexPath(config.dataConfig.chainDirectory())}.exists();
+}
+
+void updateUtxoSnapshots(const ParserConfigurationBase &config, blocksci::BlockHeight interval) {
+    auto chainDirectory = config.dataConfig.chainDirectory();
+    blocksci::ChainAccess chain{chainDirectory, config.dataConfig.blocksIgnored, config.dataConfig.errorOnReorg};
+    filesystem::create_directory(blocksci::UtxoSnapshotAccess::snapshotDirectory(chainDirectory));
+    
+    auto entries = validSnapshots(chain, chainDirectory);
+    if (interval <= 0) {
+        interval = entries.empty() ? blocksci::defaultUtxoSnapshotInterval : static_cast<blocksci::BlockHeight>(entries.back().interval);
+    }
+    
+    // Data is written before its index entry, so anything after the last valid entry is left over from a reorg or
+    // an interrupted update
+    uint64_t dataEnd = entries.empty() ? 0 : entries.back().offset + entries.back().size;
+    {
+        std::ofstream createIndex(indexPath(chainDirectory), std::ios::binary | std::ios::app);
+        std::ofstream createData(dataPath(chainDirectory), std::ios::binary | std::ios::app);
+    }
+    filesystem::path{indexPath(chainDirectory)}.resize_file(entries.size() * sizeof(blocksci::UtxoSnapshotEntry));
+    filesystem::path{dataPath(chainDirectory)}.resize_file(dataEnd);
+    
+    blocksci::UtxoSet utxos;
+    utxos.height = -1;
+    if (!entries.empty()) {
+        utxos = readSnapshot(chainDirectory, entries.back());
+    }
+    
+    std::ofstream indexFile(indexPath(chainDirectory), std::ios::binary | std::ios::app);
+    std::ofstream dataFile(dataPath(chainDirectory), std::ios::binary | std::ios::app);
+    std::string encoded;
+    for (auto height = utxos.height < 0 ? interval : utxos.height + interval; height < chain.blockCount(); height += interval) {
+        utxos = blocksci::applyBlocksForward(utxos, height, chain);
+        encoded.clear();
+        blocksci::encodeUtxoSet(encoded, utxos);
+        
+        blocksci::UtxoSnapshotEntry entry{};
+        entry.height = height;
+        entry.interval = static_cast<uint32_t>(interval);
+        entry.offset = dataEnd;
+        entry.size = encoded.size();
+        entry.utxoCount = utxos.size();
+        entry.blockHash = chain.getBlock(height)->hash;
+        dataFile.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+        dataFile.flush();
+        indexFile.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        indexFile.flush();
+        if (!dataFile || !indexFile) {
+            throw std::runtime_error("Failed to write the UTXO snapshots");
+        }
+        dataEnd += encoded.size();
+        std::cout << "Wrote UTXO snapshot at height " << height << " with " << utxos.size() << " outputs in " << encoded.size() << " bytes\n";
+    }
+}
@@ -0,0 +1,24 @@
+//
+//  utxo_snapshots.hpp
+//  blocksci_parser
+//
+
+#ifndef utxo_snapshots_hpp
+#define utxo_snapshots_hpp
+
+#include "parser_configuration.hpp"
+
+#include <blocksci/core/typedefs.hpp>
+
+/** Materializes the UTXO set every interval blocks for blocksci::UtxoSnapshotAccess
+ *
+ * Existing snapshots stay valid as the chain grows, so only snapshots for the new blocks are added, each derived from
+ * the previous one. Snapshots of blocks that were removed by a reorg are dropped first. An interval of 0 keeps the
+ * interval of the existing snapshots.
+ */
+void updateUtxoSnapshots(const ParserConfigurationBase &config, blocksci::BlockHeight interval);
+
+/** Returns whether utxo-snapshots-update has been run for the data directory, which makes update add new snapshots */
+bool utxoSnapshotsEnabled(const ParserConfigurationBase &config);
+
+#endif /* utxo_snapshots_hpp */